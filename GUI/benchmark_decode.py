@@ -0,0 +1,82 @@
+import argparse
+import time
+import numpy as np
+from result_frame import ResultAssembler, decode_result_frame, encode_result_frame, FRAME_HEADER_LEN
+
+# measures the decoding of the time results read by Sensor.read_signal from the text
+# gatttool prints, before: the former walk of the hex characters with np.append per
+# sample, after: bytes.fromhex and np.frombuffer into the preallocated array
+DEFAULT_SIZES = (1000, 10000, 100000, 1000000)
+DEFAULT_MTU = 247
+# np.append copies the whole array per sample, above this size the former decoding
+# takes minutes and is not run
+DEFAULT_BEFORE_MAX = 100000
+ATT_HEADER_LEN = 3
+
+def generate_frames(size, mtu):
+    # text of the read responses of the sine with noise around the zero value
+    rng = np.random.default_rng(1)
+    samples = np.round(2048 + 400 * np.sin(2 * np.pi * np.arange(size) / 20.0) +
+                       rng.integers(-32, 33, size)).astype(np.uint16)
+    frames = []
+    offset = 0
+    while True:
+        frame = encode_result_frame(samples, offset, mtu - ATT_HEADER_LEN, 2)
+        frames.append(frame.hex(' '))
+        offset += (len(frame) - FRAME_HEADER_LEN) // 2
+        if offset >= size:
+            return samples, frames
+
+def decode_before(frames):
+    # former read_signal: two hex characters at a time, np.append copies the array
+    result_array = np.array([])
+    for result in frames:
+        for x in range(3 * FRAME_HEADER_LEN, len(result), 6):
+            current_element = str((result[x+3:x+5] + result[x:x+2]))
+            result_array = np.append(result_array, int(current_element, 16))
+    return result_array
+
+def decode_after(frames, expected_size):
+    # read_signal: each frame converted once and put at its offset
+    samples = ResultAssembler(expected_size)
+    for result in frames:
+        control, offset, payload = decode_result_frame(bytes.fromhex(result), 2)
+        samples.put(offset, payload)
+    return samples.result()
+
+def measure(function, min_time):
+    # best time of the repetitions filling min_time, at least one
+    best = float('inf')
+    start = time.perf_counter()
+    while True:
+        iteration_start = time.perf_counter()
+        result = function()
+        best = min(best, time.perf_counter() - iteration_start)
+        if time.perf_counter() - start >= min_time:
+            return best, result
+
+def main():
+    parser = argparse.ArgumentParser(description="decode time of the time results")
+    parser.add_argument("--sizes", type=int, nargs='+', default=DEFAULT_SIZES)
+    parser.add_argument("--mtu", type=int, default=DEFAULT_MTU)
+    parser.add_argument("--before-max", type=int, default=DEFAULT_BEFORE_MAX)
+    parser.add_argument("--min-time", type=float, default=0.2)
+    args = parser.parse_args()
+
+    print("{:>8} {:>7} {:>12} {:>12} {:>9}".format("samples", "frames", "before ms", "after ms", "speedup"))
+    for size in args.sizes:
+        samples, frames = generate_frames(size, args.mtu)
+        after, result = measure(lambda: decode_after(frames, size), args.min_time)
+        if not np.array_equal(result, samples):
+            raise ValueError("after decoding of {0} samples differs".format(size))
+        if size <= args.before_max:
+            before, result = measure(lambda: decode_before(frames), args.min_time)
+            if not np.array_equal(result, samples):
+                raise ValueError("before decoding of {0} samples differs".format(size))
+            print("{:>8} {:>7} {:>12.2f} {:>12.2f} {:>9.0f}".format(size, len(frames), 1e3 * before,
+                                                                  1e3 * after, before / after))
+        else:
+            print("{:>8} {:>7} {:>12} {:>12.2f} {:>9}".format(size, len(frames), "-", 1e3 * after, "-"))
+
+if __name__ == '__main__':
+    main()
@@ -0,0 +1,76 @@
+import argparse
+import asyncio
+import time
+import numpy as np
+import ble_client
+from fake_peripheral import FakePeripheral
+
+# measures the AsyncSensor through the pluggable transport against the in process fake
+# peripheral: the latency of the trigger to the finished indication and of the single
+# read, and the throughput of the read polled and the streamed time results. The link
+# delay is paid per packet, 0 measures the client and the decoding only
+DEFAULT_MTUS = (23, 247, 517)
+# the client falls back to the reads when the stream takes over 10 s, the default sizes
+# stream within it at 1 ms per packet of mtu 23
+DEFAULT_SIZES = (1000, 10000)
+DEFAULT_LINK_DELAYS = (0.0, 0.001)
+SAMPLING_FREQUENCY = 1000
+LATENCY_REPEATS = 20
+
+
+async def measure_latency(sensor):
+    # mean seconds of the trigger to the finished indication and of one read
+    trigger = 0.0
+    read = 0.0
+    for i in range(LATENCY_REPEATS):
+        start = time.perf_counter()
+        await sensor.trigger_measurement(SAMPLING_FREQUENCY, 0.01)
+        await sensor.wait_for_measurement(10)
+        trigger += time.perf_counter() - start
+        start = time.perf_counter()
+        await sensor.read_calculated_value("rms")
+        read += time.perf_counter() - start
+    return trigger / LATENCY_REPEATS, read / LATENCY_REPEATS
+
+
+async def measure_throughput(sensor, peripheral, size, stream):
+    # samples per second of the whole time results, checked against the measured ones
+    await sensor.trigger_measurement(SAMPLING_FREQUENCY, size / float(SAMPLING_FREQUENCY))
+    await sensor.wait_for_measurement(10)
+    start = time.perf_counter()
+    samples = await (sensor.read_signal_stream(compressed=False) if stream else sensor.read_signal())
+    elapsed = time.perf_counter() - start
+    if not np.array_equal(samples, peripheral.samples):
+        raise ValueError("{0} samples of the {1} differ".format(size, "stream" if stream else "read"))
+    return size / elapsed
+
+
+async def run(args):
+    print("{:>5} {:>8} {:>8} {:>10} {:>9} {:>14} {:>14}".format(
+        "mtu", "delay ms", "samples", "trigger ms", "read ms", "read samples/s", "stream samples/s"))
+    for link_delay in args.link_delays:
+        for mtu in args.mtus:
+            peripheral = FakePeripheral(mtu=mtu, link_delay=link_delay)
+            sensor = ble_client.AsyncSensor(peripheral)
+            if not await sensor.connect("fake"):
+                raise RuntimeError("fake peripheral not connected")
+            trigger, read = await measure_latency(sensor)
+            for size in args.sizes:
+                polled = await measure_throughput(sensor, peripheral, size, False)
+                streamed = await measure_throughput(sensor, peripheral, size, True)
+                print("{:>5} {:>8.1f} {:>8} {:>10.3f} {:>9.3f} {:>14.0f} {:>14.0f}".format(
+                    mtu, 1e3 * link_delay, size, 1e3 * trigger, 1e3 * read, polled, streamed))
+            await sensor.disconnect()
+
+
+def main():
+    parser = argparse.ArgumentParser(description="latency and throughput of the ble client")
+    parser.add_argument("--mtus", type=int, nargs='+', default=DEFAULT_MTUS)
+    parser.add_argument("--sizes", type=int, nargs='+', default=DEFAULT_SIZES)
+    parser.add_argument("--link-delays", type=float, nargs='+', default=DEFAULT_LINK_DELAYS,
+                        help="seconds paid by every packet")
+    asyncio.run(run(parser.parse_args()))
+
+
+if __name__ == '__main__':
+    main()
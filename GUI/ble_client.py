@@ -0,0 +1,332 @@
+import asyncio
+import struct
+import numpy as np
+from result_frame import FRAME_NO_MORE, ResultAssembler, decode_result_frame
+
+# the sensor builds its 128 bit uuids from the 16 bit ones as 0000xxxx-0000-1000-8000-00805f9b0000
+def sensor_uuid(uuid16):
+    return "0000{:04x}-0000-1000-8000-00805f9b0000".format(uuid16)
+
+THRESHOLD_EXCEEDED_UUID = sensor_uuid(0x0101)
+CALCULATED_VALUE_UUIDS = {
+    "rms" : sensor_uuid(0x0201),
+    "average" : sensor_uuid(0x0202),
+    "max_val" : sensor_uuid(0x0203),
+    "min_val" : sensor_uuid(0x0204),
+    "amplitude" : sensor_uuid(0x0205),
+    "crest_factor" : sensor_uuid(0x0206),
+    "ac_rms" : sensor_uuid(0x0207),
+    "peak" : sensor_uuid(0x0208),
+    "peak_to_peak" : sensor_uuid(0x0209),
+    "ac_crest_factor" : sensor_uuid(0x020a),
+    "velocity_rms" : sensor_uuid(0x020b),
+    "displacement_peak_to_peak" : sensor_uuid(0x020c),
+    "skewness" : sensor_uuid(0x020d),
+    "kurtosis" : sensor_uuid(0x020e)
+}
+TRIGGER_MEASUREMENT_UUID = sensor_uuid(0x0301)
+TIME_RESULTS_UUID = sensor_uuid(0x0401)
+TIME_RESULTS_STREAM_UUID = sensor_uuid(0x0402)
+FFT_RESULTS_UUID = sensor_uuid(0x0501)
+ENVELOPE_PEAKS_UUID = sensor_uuid(0x0502)
+BAND_TABLE_UUID = sensor_uuid(0x0503)
+BAND_RMS_UUID = sensor_uuid(0x0504)
+
+# calculated values sent as integers in the low bytes of the float sized characteristic
+INTEGER_CALCULATED_VALUES = ("max_val", "min_val", "amplitude")
+
+# the sensor takes the command from the second byte of the write, the first one is the
+# padding gatttool produces for the 0x prefix
+WRITE_PADDING = b'\x00'
+TRIGGER_MEASUREMENT_WRITE_VALUE = 0x01
+TRIGGER_STREAM_MEASUREMENT_WRITE_VALUE = 0x02
+# the measurement which can not be taken is indicated by the single byte of the error in
+# place of the two bytes of the zero value
+MEASUREMENT_ERROR_INDICATION_LEN = 1
+MEASUREMENT_ERRORS = {1: "not supported", 2: "no memory", 3: "too long"}
+THRESHOLD_MONITORING_WRITE_VALUE = 0x01
+THRESHOLD_ALARM_WRITE_VALUE = 0x02
+# the alarm level changes share the characteristic with the exceeded threshold, they are
+# indicated as (0x02, level, rms) with the level 0 normal, 1 warning and 2 alarm, the
+# threshold as the exceeding conversion only
+THRESHOLD_ALARM_INDICATION_LEN = 4
+# spectrum bins are uint16 codes in 1/256 dB, code = (level in dB + 100) * 256, the level
+# is 20*log10(counts) of the amplitude or 10*log10(counts^2/Hz) of the density, code 0 is
+# no power
+SPECTRUM_DB_CODE_SCALE = 256
+SPECTRUM_DB_OFFSET = 100
+MAX_FFT_BINS = 1025
+# envelope spectrum peaks, frequency in 0.1 Hz and amplitude in 0.1 mg, largest first
+ENVELOPE_PEAK_COUNT = 5
+ENVELOPE_FREQUENCY_UNIT = 0.1
+ENVELOPE_AMPLITUDE_UNIT = 0.0001
+# band table of (low, high) edges in Hz, the high one excluded, kept by the sensor in nvs,
+# and the rms of the acceleration in every band in mg
+BAND_MAX = 8
+BAND_RMS_UNIT = 0.001
+
+
+def decode_envelope_peaks(data):
+    # list of (frequency in Hz, amplitude in g), the unused peaks are left out
+    peaks = []
+    for i in range(ENVELOPE_PEAK_COUNT):
+        frequency, amplitude = struct.unpack_from('<HH', data, 4 * i)
+        if amplitude:
+            peaks.append((frequency * ENVELOPE_FREQUENCY_UNIT, amplitude * ENVELOPE_AMPLITUDE_UNIT))
+    return peaks
+
+
+def decode_spectrum_level(codes):
+    # level of every bin in dB
+    return np.asarray(codes, dtype=float) / SPECTRUM_DB_CODE_SCALE - SPECTRUM_DB_OFFSET
+
+
+def decode_spectrum_amplitude(codes):
+    # amplitude of every bin in adc counts
+    codes = np.asarray(codes)
+    return np.where(codes > 0, 10 ** (decode_spectrum_level(codes) / 20), 0.0)
+
+
+def encode_spectrum_level(level):
+    # counterpart of the sensor coding, used by the fake peripheral
+    with np.errstate(invalid='ignore'):
+        code = np.round((np.asarray(level, dtype=float) + SPECTRUM_DB_OFFSET) * SPECTRUM_DB_CODE_SCALE)
+    return np.clip(np.nan_to_num(code, nan=0.0, neginf=0.0), 0, 0xffff).astype(np.uint16)
+
+
+def encode_band_table(bands):
+    return b''.join(struct.pack('<HH', int(low), int(high)) for low, high in bands)
+
+
+def decode_band_table(data):
+    return [struct.unpack_from('<HH', data, 4 * i) for i in range(len(data) // 4)]
+
+
+def decode_band_rms(data):
+    # rms in g of every band of the table the measurement was taken with
+    return [value * BAND_RMS_UNIT for value in struct.unpack_from('<{0}H'.format(len(data) // 2), data)]
+
+
+class MeasurementError(Exception):
+    # the sensor indicated that the requested measurement was not taken
+    def __init__(self, code):
+        super().__init__("measurement failed: {0}".format(MEASUREMENT_ERRORS.get(code, code)))
+        self.code = code
+
+
+class Transport:
+    # interface of the link to the sensor, the characteristics are addressed by uuid
+    async def connect(self, address):
+        raise NotImplementedError
+
+    async def disconnect(self):
+        raise NotImplementedError
+
+    async def read(self, uuid):
+        raise NotImplementedError
+
+    async def write(self, uuid, data, response=False):
+        raise NotImplementedError
+
+    async def start_notify(self, uuid, callback):
+        # callback is called with the bytes of every notification
+        raise NotImplementedError
+
+    async def stop_notify(self, uuid):
+        raise NotImplementedError
+
+
+class BleakTransport(Transport):
+    # transport talking to the sensor through the bleak library (BlueZ D-Bus on linux)
+    def __init__(self):
+        self._client = None
+
+    async def connect(self, address):
+        from bleak import BleakClient
+        self._client = BleakClient(address)
+        await self._client.connect()
+        return self._client.is_connected
+
+    async def disconnect(self):
+        if self._client is not None:
+            await self._client.disconnect()
+
+    async def read(self, uuid):
+        return bytes(await self._client.read_gatt_char(uuid))
+
+    async def write(self, uuid, data, response=False):
+        await self._client.write_gatt_char(uuid, data, response=response)
+
+    async def start_notify(self, uuid, callback):
+        await self._client.start_notify(uuid, lambda sender, data: callback(bytes(data)))
+
+    async def stop_notify(self, uuid):
+        await self._client.stop_notify(uuid)
+
+
+class AsyncSensor:
+    # asynchronous counterpart of communication.Sensor, notifications are delivered by
+    # callbacks instead of being polled
+    def __init__(self, transport=None):
+        self.transport = transport if transport is not None else BleakTransport()
+        self._zero_val_offset = 0
+        self._expected_samples = 0
+        self._measurement_finished = asyncio.Event()
+        self._measurement_error = None
+        self._threshold_exceeded = asyncio.Event()
+        self.on_measurement_finished = None
+        self.on_threshold_exceeded = None
+        self.on_threshold_alarm = None
+
+    async def connect(self, address):
+        try:
+            if not await self.transport.connect(address):
+                return False
+            await self.transport.start_notify(TRIGGER_MEASUREMENT_UUID, self._handle_measurement_finished)
+            await self.transport.start_notify(THRESHOLD_EXCEEDED_UUID, self._handle_threshold_exceeded)
+        except Exception:
+            return False
+        return True
+
+    async def disconnect(self):
+        await self.transport.disconnect()
+
+    async def trigger_measurement(self, frequency, duration, stream=False, segment_size=0, overlap=0, window=0,
+                                  decimation=0, oversampling=0):
+        command = TRIGGER_STREAM_MEASUREMENT_WRITE_VALUE if stream else TRIGGER_MEASUREMENT_WRITE_VALUE
+        data = WRITE_PADDING + struct.pack('>BHf', command, int(frequency), float(duration))
+        if segment_size > 0 or decimation > 1 or oversampling > 1:
+            data += struct.pack('>HBB', int(segment_size), int(overlap), int(window))
+        # the adc converts at decimation times the frequency and the sensor keeps the
+        # low pass filtered samples at the frequency only
+        if decimation > 1 or oversampling > 1:
+            data += struct.pack('>B', int(decimation))
+        # sums of oversampling conversions are kept, the samples are up to 16 bit wide
+        if oversampling > 1:
+            data += struct.pack('>B', int(oversampling))
+        self._expected_samples = 0 if stream else int(frequency * duration)
+        self._measurement_finished.clear()
+        self._measurement_error = None
+        await self.transport.write(TRIGGER_MEASUREMENT_UUID, data)
+
+    async def wait_for_measurement(self, timeout=None):
+        await asyncio.wait_for(self._measurement_finished.wait(), timeout)
+        if self._measurement_error is not None:
+            raise MeasurementError(self._measurement_error)
+        return self._zero_val_offset
+
+    async def read_calculated_value(self, chosen_value):
+        data = await self.transport.read(CALCULATED_VALUE_UUIDS[chosen_value])
+        if chosen_value in INTEGER_CALCULATED_VALUES:
+            return struct.unpack_from('<H', data)[0]
+        return struct.unpack_from('<f', data)[0]
+
+    async def read_signal(self):
+        return await self._read_frames(TIME_RESULTS_UUID, 2, self._expected_samples)
+
+    async def read_signal_stream(self, compressed=True):
+        samples = ResultAssembler(self._expected_samples)
+        finished = asyncio.get_running_loop().create_future()
+
+        def handle_frame(frame):
+            if finished.done():
+                return
+            try:
+                control, offset, payload = decode_result_frame(frame, 2)
+            except ValueError as error:
+                finished.set_exception(error)
+                return
+            if offset != samples.size:
+                finished.set_exception(ValueError("samples from {0} lost".format(samples.size)))
+                return
+            samples.put(offset, payload)
+            if control == FRAME_NO_MORE:
+                finished.set_result(True)
+
+        await self.transport.write(TIME_RESULTS_STREAM_UUID, bytes([1 if compressed else 0]), response=True)
+        await self.transport.start_notify(TIME_RESULTS_STREAM_UUID, handle_frame)
+        try:
+            await asyncio.wait_for(finished, 10)
+        except (asyncio.TimeoutError, ValueError):
+            await self.transport.stop_notify(TIME_RESULTS_STREAM_UUID)
+            return await self.read_signal()
+        await self.transport.stop_notify(TIME_RESULTS_STREAM_UUID)
+        return samples.result()
+
+    async def read_fft(self):
+        # amplitude spectrum in adc counts, the mean was removed by the sensor
+        result_array = decode_spectrum_amplitude(await self._read_frames(FFT_RESULTS_UUID, 2, MAX_FFT_BINS))
+        if len(result_array):
+            result_array[0] = 0
+        return result_array
+
+    async def read_psd(self):
+        # power spectral density in dB of counts^2/Hz
+        return decode_spectrum_level(await self._read_frames(FFT_RESULTS_UUID, 2, MAX_FFT_BINS))
+
+    async def read_envelope_peaks(self):
+        return decode_envelope_peaks(await self.transport.read(ENVELOPE_PEAKS_UUID))
+
+    async def read_band_table(self):
+        return decode_band_table(await self.transport.read(BAND_TABLE_UUID))
+
+    async def write_band_table(self, bands):
+        # the sensor refuses the table of no or more than BAND_MAX bands or low >= high
+        await self.transport.write(BAND_TABLE_UUID, encode_band_table(bands), response=True)
+
+    async def read_band_rms(self):
+        return decode_band_rms(await self.transport.read(BAND_RMS_UUID))
+
+    async def set_threshold_for_threshold_exceeded_monitoring(self, threshold):
+        data = WRITE_PADDING + struct.pack('>BH', THRESHOLD_MONITORING_WRITE_VALUE, int(threshold))
+        await self.transport.write(THRESHOLD_EXCEEDED_UUID, data)
+
+    async def set_threshold_alarm(self, window_ms, warning, alarm, hysteresis=0, hold_off_ms=0,
+                                  min_interval_ms=0):
+        # ac rms levels in adc counts over the sliding window, 0 for no level, both 0 stop
+        # the alarm. The level changes are passed to on_threshold_alarm as (level, rms)
+        data = WRITE_PADDING + struct.pack('>B6H', THRESHOLD_ALARM_WRITE_VALUE, int(window_ms),
+                                           int(warning), int(alarm), int(hysteresis),
+                                           int(hold_off_ms), int(min_interval_ms))
+        await self.transport.write(THRESHOLD_EXCEEDED_UUID, data)
+
+    def monitor_threshold_exceeded(self):
+        exceeded = self._threshold_exceeded.is_set()
+        self._threshold_exceeded.clear()
+        return exceeded
+
+    def is_measurement_finished(self):
+        if self._measurement_error is not None:
+            raise MeasurementError(self._measurement_error)
+        return self._measurement_finished.is_set()
+
+    def get_offset(self):
+        return self._zero_val_offset
+
+    async def _read_frames(self, uuid, element_size, expected_size):
+        control = 0
+        result = ResultAssembler(expected_size)
+        while (control != FRAME_NO_MORE):
+            control, offset, payload = decode_result_frame(await self.transport.read(uuid), element_size)
+            result.put(offset, payload)
+        return result.result()
+
+    def _handle_measurement_finished(self, data):
+        if len(data) == MEASUREMENT_ERROR_INDICATION_LEN:
+            self._measurement_error = data[0]
+            self._measurement_finished.set()
+            return
+        self._zero_val_offset = struct.unpack_from('>H', data)[0]
+        self._measurement_finished.set()
+        if self.on_measurement_finished is not None:
+            self.on_measurement_finished(self._zero_val_offset)
+
+    def _handle_threshold_exceeded(self, data):
+        if len(data) == THRESHOLD_ALARM_INDICATION_LEN:
+            level, rms = struct.unpack_from('>BH', data, 1)
+            if self.on_threshold_alarm is not None:
+                self.on_threshold_alarm(level, rms)
+            return
+        self._threshold_exceeded.set()
+        if self.on_threshold_exceeded is not None:
+            self.on_threshold_exceeded(struct.unpack_from('>H', data)[0])
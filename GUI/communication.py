@@ -3,6 +3,9 @@ import time
 import struct
 import binascii
 import numpy as np
+from result_frame import FRAME_NO_MORE, ResultAssembler, decode_result_frame
+from ble_client import decode_envelope_peaks, decode_band_table, encode_band_table, decode_band_rms
+from ble_client import decode_spectrum_amplitude, decode_spectrum_level
 
 def hexStrToFloat(hexstr):
     val = struct.unpack('>f', binascii.unhexlify(hexstr))
@@ -26,6 +29,7 @@ class Sensor:
         self.hnd_trigger_measurement = "0x86"
         self.hnd_set_threshold_for_monitoring = "0x2a"
         self.trigger_measurement_write_value = "0x01"
+        self.trigger_stream_measurement_write_value = "0x02"
         self.threshold_monitoring_write_value = "0x01"
         self.read_calculated_value_hnd_dict = {
             "rms" : "0x58",
@@ -33,11 +37,27 @@ class Sensor:
             "max_val" : "0x5c",
             "min_val" : "0x5e",
             "amplitude" : "0x60",
-            "crest_factor" : "0x62"
+            "crest_factor" : "0x62",
+            "ac_rms" : "0x64",
+            "peak" : "0x66",
+            "peak_to_peak" : "0x68",
+            "ac_crest_factor" : "0x6a",
+            "velocity_rms" : "0x6c",
+            "displacement_peak_to_peak" : "0x6e",
+            "skewness" : "0x70",
+            "kurtosis" : "0x72"
         }
         self.read_signal_hnd = "0xb4"
+        self.stream_signal_hnd = "0x00b7"
+        self.stream_signal_write_hnd = "0xb7"
+        self.stream_signal_ccc_hnd = "0xb8"
         self.read_fft_hnd = "0xe2"
+        self.read_envelope_peaks_hnd = "0xe5"
+        self.band_table_hnd = "0xe8"
+        self.read_band_rms_hnd = "0xeb"
         self._zero_val_offset = 0
+        self._expected_samples = 0
+        self.max_fft_bins = 1025
         
         self.child = pexpect.spawn("gatttool -I")
 
@@ -52,8 +72,23 @@ class Sensor:
     def disconnect(self):
         self.child.sendline("disconnect")
 
-    def trigger_measurement(self, frequency, duration):
-        command = "char-write-cmd " + self.hnd_trigger_measurement + " " + self.trigger_measurement_write_value + '{:04x}'.format(int(frequency)) + float_to_hex(float(duration))[2:]
+    def trigger_measurement(self, frequency, duration, stream=False, segment_size=0, overlap=0, window=0,
+                            decimation=0, oversampling=0):
+        # in the stream mode the samples are not stored on the sensor, so only the
+        # calculated values are available afterwards, but the duration is unbounded
+        write_value = self.trigger_stream_measurement_write_value if stream else self.trigger_measurement_write_value
+        self._expected_samples = 0 if stream else int(frequency * duration)
+        command = "char-write-cmd " + self.hnd_trigger_measurement + " " + write_value + '{:04x}'.format(int(frequency)) + float_to_hex(float(duration))[2:].zfill(8)
+        # non zero segment size requests the welch power spectral density instead of the
+        # single fft, overlap is given in percents and window is 0 for hann, 1 for flat top
+        if segment_size > 0 or decimation > 1 or oversampling > 1:
+            command += '{:04x}{:02x}{:02x}'.format(int(segment_size), int(overlap), int(window))
+        # decimation factor of the sampler, the adc converts at decimation times the frequency
+        if decimation > 1 or oversampling > 1:
+            command += '{:02x}'.format(int(decimation))
+        # oversampling factor, 4 to 64, the sensor keeps the sums of the conversions
+        if oversampling > 1:
+            command += '{:02x}'.format(int(oversampling))
         self.child.sendline(command)
 
     def read_calculated_value(self, chosen_value):
@@ -70,40 +105,90 @@ class Sensor:
         result = int(response[-4:],16)
         return result
 
+    def _read_frame(self):
+        self.child.expect("\r\n", timeout=10)
+        before = self.child.before
+        if isinstance(before, bytes):
+            before = before.decode()
+        return bytes.fromhex(before)
+
     def read_signal(self):
         command = "char-read-hnd " + self.read_signal_hnd
-        control = '00'
-        result_array = np.array([])
-        while (control != '03'):
+        control = 0
+        samples = ResultAssembler(self._expected_samples)
+        while (control != FRAME_NO_MORE):
             self.child.sendline(command)
             self.child.expect("Characteristic value/descriptor: ", timeout=10)
-            self.child.expect("\r\n", timeout=10)
-            result = str(self.child.before)
- 
-            for x in range(3, len(result),6):
-                current_element = str((result[x+3:x+5] + result[x:x+2]))
-                if current_element != 'ffff':
-                    result_array = np.append(result_array, hexStrToInt16(current_element))
-            control = result[0:2]
-        return result_array
+            control, offset, payload = decode_result_frame(self._read_frame(), 2)
+            samples.put(offset, payload)
+        return samples.result()
 
-    def read_fft(self):
+    def read_signal_stream(self, compressed=True):
+        # subscription starts the transfer, the sensor pushes mtu sized notifications
+        # whose header carries the offset of the first sample of the frame
+        self.child.sendline("char-write-req " + self.stream_signal_write_hnd + (" 01" if compressed else " 00"))
+        self.child.sendline("char-write-req " + self.stream_signal_ccc_hnd + " 0100")
+        control = 0
+        samples = ResultAssembler(self._expected_samples)
+        try:
+            while (control != FRAME_NO_MORE):
+                self.child.expect("Notification handle = " + self.stream_signal_hnd + " value: ", timeout=10)
+                control, offset, payload = decode_result_frame(self._read_frame(), 2)
+                if offset != samples.size:
+                    raise ValueError("samples from {0} lost".format(samples.size))
+                samples.put(offset, payload)
+        except (pexpect.TIMEOUT, ValueError):
+            # fall back to the read polled transfer
+            self.child.sendline("char-write-req " + self.stream_signal_ccc_hnd + " 0000")
+            return self.read_signal()
+        self.child.sendline("char-write-req " + self.stream_signal_ccc_hnd + " 0000")
+        return samples.result()
+
+    def _read_spectrum_codes(self):
         command = "char-read-hnd " + self.read_fft_hnd
-        control = '00'
-        result_array = np.array([])
-        while (control != '03'):
+        control = 0
+        bins = ResultAssembler(self.max_fft_bins)
+        while (control != FRAME_NO_MORE):
             self.child.sendline(command)
             self.child.expect("Characteristic value/descriptor: ", timeout=10)
-            self.child.expect("\r\n", timeout=10)
-            result = str(self.child.before)
-            for x in range(3, len(result),3):
-                current_element = str((result[x:x+2]))
-                if current_element != 'ff':
-                    result_array = np.append(result_array, hexStrToInt8(current_element))
-            control = result[0:2]
-        result_array[0] = 0
+            control, offset, payload = decode_result_frame(self._read_frame(), 2)
+            bins.put(offset, payload)
+        return bins.result()
+
+    def read_fft(self):
+        # amplitude spectrum in adc counts, the mean was removed by the sensor
+        result_array = decode_spectrum_amplitude(self._read_spectrum_codes())
+        if len(result_array):
+            result_array[0] = 0
         return result_array
 
+    def read_psd(self):
+        # the psd bins are coded as (10*log10(counts^2/Hz) + 100) * 256
+        return decode_spectrum_level(self._read_spectrum_codes())
+
+    def read_envelope_peaks(self):
+        # list of (frequency in Hz, amplitude in g) of the envelope spectrum, largest first
+        self.child.sendline("char-read-hnd " + self.read_envelope_peaks_hnd)
+        self.child.expect("Characteristic value/descriptor: ", timeout=10)
+        return decode_envelope_peaks(self._read_frame())
+
+    def read_band_table(self):
+        # list of (low, high) band edges in Hz
+        self.child.sendline("char-read-hnd " + self.band_table_hnd)
+        self.child.expect("Characteristic value/descriptor: ", timeout=10)
+        return decode_band_table(self._read_frame())
+
+    def write_band_table(self, bands):
+        # the table is persisted by the sensor and applies from the next measurement
+        command = "char-write-req " + self.band_table_hnd + " " + binascii.hexlify(encode_band_table(bands)).decode()
+        self.child.sendline(command)
+
+    def read_band_rms(self):
+        # rms in g of every band of the table
+        self.child.sendline("char-read-hnd " + self.read_band_rms_hnd)
+        self.child.expect("Characteristic value/descriptor: ", timeout=10)
+        return decode_band_rms(self._read_frame())
+
     def set_threshold_for_threshold_exceeded_monitoring(self, threshold):
             command = "char-write-cmd " + self.hnd_set_threshold_for_monitoring + " " + self.threshold_monitoring_write_value + '{:04x}'.format(int(threshold))
             self.child.sendline(command)
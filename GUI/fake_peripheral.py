@@ -0,0 +1,185 @@
+import asyncio
+import struct
+import numpy as np
+import ble_client
+from result_frame import FRAME_ABORTED_FLAG, encode_result_frame
+
+class FakePeripheral(ble_client.Transport):
+    # in process stand-in of the sensor implementing the transport interface, so the
+    # client can be exercised and timed without the radio. The measurement is a sine
+    # wave with noise around the zero value, frames are sized as for the given mtu.
+    def __init__(self, mtu=247, zero_val=2048, signal_frequency=50.0, link_delay=0.0,
+                 sensitivity=0.0244140625):
+        self.mtu = mtu
+        self.sensitivity = sensitivity
+        self.zero_val = zero_val
+        self.signal_frequency = signal_frequency
+        self.link_delay = link_delay
+        self.samples = np.array([], dtype=np.uint16)
+        self.fft = np.array([], dtype=np.uint16)
+        self.envelope_peaks = bytes(4 * ble_client.ENVELOPE_PEAK_COUNT)
+        self.band_table = [(45, 55), (95, 105), (150, 500), (500, 5000)]
+        self.band_rms = b''
+        self.calculated_values = {}
+        self.threshold = 0
+        self._callbacks = {}
+        self._read_positions = {}
+        self._stream_task = None
+
+    async def connect(self, address):
+        return True
+
+    async def disconnect(self):
+        self._callbacks.clear()
+
+    async def read(self, uuid):
+        await self._link()
+        for name, value_uuid in ble_client.CALCULATED_VALUE_UUIDS.items():
+            if uuid == value_uuid:
+                value = self.calculated_values.get(name, 0)
+                if name in ble_client.INTEGER_CALCULATED_VALUES:
+                    return struct.pack('<HH', int(value), 0)
+                return struct.pack('<f', value)
+        if uuid == ble_client.TIME_RESULTS_UUID:
+            return self._next_frame(uuid, self.samples, 2)
+        if uuid == ble_client.FFT_RESULTS_UUID:
+            return self._next_frame(uuid, self.fft, 2)
+        if uuid == ble_client.ENVELOPE_PEAKS_UUID:
+            return self.envelope_peaks
+        if uuid == ble_client.BAND_TABLE_UUID:
+            return ble_client.encode_band_table(self.band_table)
+        if uuid == ble_client.BAND_RMS_UUID:
+            return self.band_rms
+        return b''
+
+    async def write(self, uuid, data, response=False):
+        await self._link()
+        if uuid == ble_client.TRIGGER_MEASUREMENT_UUID:
+            command, frequency, duration = struct.unpack_from('>BHf', data, 1)
+            asyncio.get_running_loop().call_soon(self._measure, frequency, duration)
+        elif uuid == ble_client.THRESHOLD_EXCEEDED_UUID:
+            command, value = struct.unpack_from('>BH', data, 1)
+            # the rms alarm is not simulated, it only stops the threshold monitoring
+            self.threshold = value if command == ble_client.THRESHOLD_MONITORING_WRITE_VALUE else 0
+        elif uuid == ble_client.BAND_TABLE_UUID:
+            bands = ble_client.decode_band_table(data)
+            if (len(data) % 4 == 0 and 0 < len(bands) <= ble_client.BAND_MAX
+                    and all(low < high for low, high in bands)):
+                self.band_table = bands
+
+    async def start_notify(self, uuid, callback):
+        self._callbacks[uuid] = callback
+        if uuid == ble_client.TIME_RESULTS_STREAM_UUID:
+            self._stream_task = asyncio.ensure_future(self._stream())
+
+    async def stop_notify(self, uuid):
+        self._callbacks.pop(uuid, None)
+
+    def _measure(self, frequency, duration):
+        n = int(frequency * duration)
+        t = np.arange(n) / float(frequency)
+        signal = self.zero_val + 400 * np.sin(2 * np.pi * self.signal_frequency * t) + np.random.normal(0, 8, n)
+        self.samples = np.clip(np.round(signal), 0, 4095).astype(np.uint16)
+        values = self.samples.astype(float)
+        rms = np.sqrt(np.mean(values ** 2)) if n else 0.0
+        average = np.mean(values) if n else 0.0
+        ac_rms = np.std(values) if n else 0.0
+        peak = max(values.max() - average, average - values.min()) if n else 0.0
+        moment2 = np.mean((values - average) ** 2) if n else 0.0
+        omega = 2 * np.pi * self.signal_frequency
+        self.calculated_values = {
+            "rms" : rms,
+            "average" : average,
+            "max_val" : values.max() if n else 0,
+            "min_val" : values.min() if n else 0,
+            "amplitude" : max(values.max() - average, average - values.min()) if n else 0,
+            "crest_factor" : values.max() / rms if rms else 0.0,
+            "ac_rms" : ac_rms * self.sensitivity,
+            "peak" : peak * self.sensitivity,
+            "peak_to_peak" : (values.max() - values.min()) * self.sensitivity if n else 0.0,
+            "ac_crest_factor" : peak / ac_rms if ac_rms else 0.0,
+            # analytic severity of the generated sine, velocity in mm/s, displacement in um
+            "velocity_rms" : 400 * self.sensitivity * 9806.65 / omega / np.sqrt(2),
+            "displacement_peak_to_peak" : 2 * 400 * self.sensitivity * 9806.65 / omega ** 2 * 1000,
+            "skewness" : np.mean((values - average) ** 3) / moment2 ** 1.5 if moment2 else 0.0,
+            "kurtosis" : np.mean((values - average) ** 4) / moment2 ** 2 if moment2 else 0.0
+        }
+        if n:
+            size = 1 << int(np.log2(min(n, 2048)))
+            magnitude = np.abs(np.fft.rfft(self.samples[:size] - average)) * 2 / size
+            with np.errstate(divide='ignore'):
+                self.fft = ble_client.encode_spectrum_level(20 * np.log10(magnitude))
+            self.band_rms = self._band_rms(self.samples[:size] - np.mean(self.samples[:size]), frequency)
+        self.envelope_peaks = self._envelope_peaks(values - average if n else values, frequency)
+        self._read_positions.clear()
+        self._notify(ble_client.TRIGGER_MEASUREMENT_UUID, struct.pack('>H', self.zero_val))
+        if self.threshold and self.calculated_values["amplitude"] > self.threshold:
+            self._notify(ble_client.THRESHOLD_EXCEEDED_UUID, struct.pack('>H', int(self.calculated_values["max_val"])))
+
+    def _envelope_peaks(self, acceleration, frequency):
+        # envelope of the band between 1/8 and 3/8 of the sampling frequency taken as the
+        # magnitude of the analytic signal, decimated by 4 as on the sensor
+        peaks = []
+        if len(acceleration) >= 64:
+            spectrum = np.fft.fft(acceleration * self.sensitivity)
+            bins = np.fft.fftfreq(len(acceleration), 1.0 / frequency)
+            spectrum[(bins < frequency / 8) | (bins > 3 * frequency / 8)] = 0
+            envelope = np.abs(np.fft.ifft(2 * spectrum))[::4]
+            size = 1 << int(np.log2(min(len(envelope), 512)))
+            envelope = envelope[:size] - np.mean(envelope[:size])
+            amplitude = np.abs(np.fft.rfft(envelope * np.hanning(size))) * 4 / size
+            maxima = [k for k in range(2, len(amplitude) - 1)
+                      if amplitude[k] > amplitude[k - 1] and amplitude[k] >= amplitude[k + 1]]
+            maxima.sort(key=lambda k: amplitude[k], reverse=True)
+            peaks = [(k * frequency / 4.0 / size, amplitude[k]) for k in maxima[:ble_client.ENVELOPE_PEAK_COUNT]]
+        peaks += [(0.0, 0.0)] * (ble_client.ENVELOPE_PEAK_COUNT - len(peaks))
+        return b''.join(struct.pack('<HH',
+                                    int(min(round(f / ble_client.ENVELOPE_FREQUENCY_UNIT), 0xffff)),
+                                    int(min(round(a / ble_client.ENVELOPE_AMPLITUDE_UNIT), 0xffff)))
+                        for f, a in peaks)
+
+    def _band_rms(self, acceleration, frequency):
+        # mean square of the Hann windowed spectrum summed over the bins of every band
+        size = len(acceleration)
+        window = 0.5 - 0.5 * np.cos(2 * np.pi * np.arange(size) / size)
+        power = np.abs(np.fft.rfft(acceleration * window)) ** 2 / (size * np.sum(window ** 2))
+        power[1:(size + 1) // 2] *= 2
+        bins = np.arange(len(power)) * float(frequency) / size
+        rms = [np.sqrt(np.sum(power[(bins >= low) & (bins < high)])) * self.sensitivity
+               for low, high in self.band_table]
+        return b''.join(struct.pack('<H', int(min(round(value / ble_client.BAND_RMS_UNIT), 0xffff)))
+                        for value in rms)
+
+    def _next_frame(self, uuid, data, element_size):
+        offset = self._read_positions.get(uuid, 0)
+        frame = encode_result_frame(data, offset, self.mtu - 3, element_size)
+        offset += struct.unpack_from('<H', frame, 5)[0]
+        self._read_positions[uuid] = 0 if offset >= len(data) else offset
+        return frame
+
+    async def _stream(self):
+        offset = 0
+        samples = self.samples
+        while ble_client.TIME_RESULTS_STREAM_UUID in self._callbacks:
+            if samples is not self.samples:
+                # a new measurement replaced the samples, end with the empty aborted frame
+                frame = bytearray(encode_result_frame(samples[:offset], offset, self.mtu - 3, 2))
+                frame[0] |= FRAME_ABORTED_FLAG
+                await self._link()
+                self._notify(ble_client.TIME_RESULTS_STREAM_UUID, bytes(frame))
+                break
+            frame = encode_result_frame(samples, offset, self.mtu - 3, 2)
+            await self._link()
+            self._notify(ble_client.TIME_RESULTS_STREAM_UUID, frame)
+            offset += struct.unpack_from('<H', frame, 5)[0]
+            if offset >= len(samples):
+                break
+
+    def _notify(self, uuid, data):
+        callback = self._callbacks.get(uuid)
+        if callback is not None:
+            callback(data)
+
+    async def _link(self):
+        # every packet costs the configured link delay, zero only yields to the loop
+        await asyncio.sleep(self.link_delay)
@@ -67,6 +67,7 @@ class ControlScreen(Screen):
         self.time_signal_x = np.array([])
         self.fft_signal = np.array([])
         self.fft_signal_x = np.array([])
+        self.frequency = 0.0
 
     def measurement_control_progressbar_callback(self, dt):
         if(self.ids.progressbar_measurement.value != 100):
@@ -98,7 +99,7 @@ class ControlScreen(Screen):
             #to see the progress
             sensor.trigger_measurement(frequency, length)
             self.time_signal_x = np.linspace(0.0, float(length), num=float(length)*float(frequency), endpoint=False)
-            self.fft_signal_x = (float(frequency)/2)*np.linspace(0.0, 1.0, num=((float(length)*float(frequency))/2+1), endpoint=True)
+            self.frequency = float(frequency)
             Clock.schedule_interval(
                 self.measurement_control_progressbar_callback, float(length)/100)
             self.ids.progressbar_measurement.value = 0
@@ -106,32 +107,54 @@ class ControlScreen(Screen):
             self.ids.progressbar_measurement.value = 0
 
     def download_results(self):
-        self.rms = sensor.read_calculated_value("rms")
+        self.rms = sensor.read_calculated_value("ac_rms")
         self.average = sensor.read_calculated_value("average")
         self.max_val = sensor.read_calculated_value("max_val")
         self.min_val = sensor.read_calculated_value("min_val")
-        self.amplitude = sensor.read_calculated_value("amplitude")
-        self.crest_factor = sensor.read_calculated_value("crest_factor")
-        self.time_signal = sensor.read_signal()
-        # self.fft_signal = sensor.read_fft()
+        self.amplitude = sensor.read_calculated_value("peak")
+        self.peak_to_peak = sensor.read_calculated_value("peak_to_peak")
+        self.crest_factor = sensor.read_calculated_value("ac_crest_factor")
+        self.velocity_rms = sensor.read_calculated_value("velocity_rms")
+        self.displacement = sensor.read_calculated_value("displacement_peak_to_peak")
+        self.skewness = sensor.read_calculated_value("skewness")
+        self.kurtosis = sensor.read_calculated_value("kurtosis")
+        self.envelope_peaks = sensor.read_envelope_peaks()
+        self.band_rms = sensor.read_band_rms()
+        self.time_signal = sensor.read_signal_stream()
+        self.fft_signal = sensor.read_fft()
         
     def update_gui(self):
+        # rms, amplitude, peak to peak and crest factor come in g about the mean of the
+        # measurement, only the raw average and extremes are converted here
         offset = sensor.get_offset()
-        self.rms = convert_raw_to_g(self.rms, offset)
         self.average = convert_raw_to_g(self.average, offset)
         self.max_val = convert_raw_to_g(self.max_val, offset)
         self.min_val = convert_raw_to_g(self.min_val, offset)
-        self.amplitude = convert_raw_to_g(self.amplitude, 0)
         self.time_signal = convert_raw_to_g(self.time_signal, offset)
+        # the sensor serves the amplitude spectrum in adc counts of the largest power
+        # of two number of samples, so the bins span 0 to frequency/2
+        self.fft_signal = convert_raw_to_g(self.fft_signal, 0)
+        self.fft_signal_x = (self.frequency/2)*np.linspace(0.0, 1.0, num=len(self.fft_signal), endpoint=True)
 
         self.ids.accordion_time_results.update_figure(self.time_signal_x, self.time_signal)
-        # self.ids.accordion_fourier_results.update_figure(self.fft_signal_x, self.fft_signal)
+        self.ids.accordion_fourier_results.update_figure(self.fft_signal_x, self.fft_signal)
         self.ids.textinput_indicator_rms.text = str((self.rms))
         self.ids.textinput_indicator_average.text = str((self.average))
         self.ids.textinput_indicator_maxval.text = str((self.max_val))
         self.ids.textinput_indicator_minval.text = str((self.min_val))
         self.ids.textinput_indicator_amplitude.text = str((self.amplitude))
+        self.ids.textinput_indicator_peaktopeak.text = str((self.peak_to_peak))
         self.ids.textinput_indicator_crestfactor.text = str((self.crest_factor)) 
+        self.ids.textinput_indicator_velocity.text = str((self.velocity_rms))
+        self.ids.textinput_indicator_displacement.text = str((self.displacement))
+        self.ids.textinput_indicator_skewness.text = str((self.skewness))
+        self.ids.textinput_indicator_kurtosis.text = str((self.kurtosis))
+        # largest peak of the envelope spectrum, the repetition frequency of the impacts
+        if len(self.envelope_peaks):
+            self.ids.textinput_indicator_envelope.text = "{0:.1f} Hz, {1:.4f} g".format(*self.envelope_peaks[0])
+        else:
+            self.ids.textinput_indicator_envelope.text = ''
+        self.ids.textinput_indicator_bands.text = ", ".join("{0:.3f}".format(value) for value in self.band_rms)
 
     def set_monitoring_threshold(self, threshold):
         sensor.set_threshold_for_threshold_exceeded_monitoring(convert_g_to_raw_for_th_monitoring(threshold))
@@ -0,0 +1,74 @@
+import struct
+import numpy as np
+
+# result frame: control byte, little endian uint32 offset and uint16 count of elements
+FRAME_HEADER_LEN = 7
+FRAME_FIRST = 1
+FRAME_MORE = 2
+FRAME_NO_MORE = 3
+FRAME_COMPRESSED_FLAG = 0x80
+FRAME_ABORTED_FLAG = 0x40
+CODEC_BLOCK_LEN = 16
+
+def decode_compressed_samples(payload, count):
+    # reverses the sample codec: little endian zero value, then blocks of 16 zig-zag
+    # coded differences, each block led by its bit width
+    zero_val = payload[0] | (payload[1] << 8)
+    codes = np.empty(count, dtype=np.int32)
+    pos = 2
+    decoded = 0
+    while decoded < count:
+        block_len = min(count - decoded, CODEC_BLOCK_LEN)
+        width = payload[pos]
+        pos += 1
+        nbytes = (block_len * width + 7) // 8
+        if width:
+            bits = np.unpackbits(np.frombuffer(payload, dtype=np.uint8, count=nbytes, offset=pos), bitorder='little')
+            codes[decoded:decoded + block_len] = bits[:block_len * width].reshape(block_len, width).dot(1 << np.arange(width))
+        else:
+            codes[decoded:decoded + block_len] = 0
+        pos += nbytes
+        decoded += block_len
+    deltas = (codes >> 1) ^ -(codes & 1)
+    return ((zero_val + np.cumsum(deltas)) & 0xffff).astype(np.uint16)
+
+def decode_result_frame(frame, element_size):
+    control, offset, count = struct.unpack_from('<BIH', frame)
+    if control & FRAME_ABORTED_FLAG:
+        # the stream ended early, a new trigger replaced the result being sent
+        raise ValueError("result replaced at {0}".format(offset))
+    if control & FRAME_COMPRESSED_FLAG:
+        return control & ~FRAME_COMPRESSED_FLAG, offset, decode_compressed_samples(frame[FRAME_HEADER_LEN:], count)
+    element_type = '<u2' if element_size == 2 else 'u1'
+    payload = np.frombuffer(frame, dtype=element_type, count=count, offset=FRAME_HEADER_LEN)
+    return control, offset, payload
+
+class ResultAssembler:
+    # collects the frame payloads at their offsets into an array preallocated for the
+    # expected size, which is grown only if the sensor sends more elements
+    def __init__(self, expected_size):
+        self.data = np.empty(max(int(expected_size), 1), dtype=float)
+        self.size = 0
+
+    def put(self, offset, payload):
+        end = offset + len(payload)
+        if end > len(self.data):
+            self.data = np.resize(self.data, max(end, 2 * len(self.data)))
+        self.data[offset:end] = payload
+        self.size = max(self.size, end)
+
+    def result(self):
+        return self.data[:self.size]
+
+def encode_result_frame(data, offset, max_frame_len, element_size):
+    # counterpart of result_frame_encode on the sensor, used by the fake peripheral
+    count = max(0, min(len(data) - offset, (max_frame_len - FRAME_HEADER_LEN) // element_size))
+    if offset + count >= len(data):
+        control = FRAME_NO_MORE
+    elif offset == 0:
+        control = FRAME_FIRST
+    else:
+        control = FRAME_MORE
+    element_type = '<u2' if element_size == 2 else 'u1'
+    payload = np.asarray(data[offset:offset + count]).astype(element_type).tobytes()
+    return struct.pack('<BIH', control, offset, count) + payload
@@ -5,9 +5,15 @@
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "ble_communication.h"
 #include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "esp_log.h"
+#include "nvs.h"
 #include <string.h>
 #include "../threshold_exceeded_notification/threshold_exceeded_notification.h"
+#include "../measurement/measurement.h"
+#include "../../main/task_controller.h"
+#include "result_frame.h"
 
 /** bluetooth specific includes */
 #include "bt.h"
@@ -37,6 +43,9 @@
 #define GATTS_CHAR_UUID_THRESHOLD_EXCEEDED_NOTIFICATION		((uint16_t) \
 				(GATTS_SERVICE_UUID_THRESHOLD_EXCEEDED_NOTIFICATION + 0x0001))
 #define THRESHOLD_EXCEEDED_WRITE_VAL						(0x01)
+/** version 2 of the write, the windowed rms alarm configuration, and its length **/
+#define THRESHOLD_ALARM_WRITE_VAL							(0x02)
+#define THRESHOLD_ALARM_WRITE_LEN							(14)
 
 /** profile_get_calculated_values parameters */
 #define PROFILE_GET_CALCULATED_VALUES 1
@@ -53,6 +62,22 @@
 				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x0005))
 #define GATTS_CHAR_UUID_GET_CREST_FACTOR_VALUE		((uint16_t) \
 				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x0006))
+#define GATTS_CHAR_UUID_GET_AC_RMS_VALUE			((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x0007))
+#define GATTS_CHAR_UUID_GET_PEAK_VALUE				((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x0008))
+#define GATTS_CHAR_UUID_GET_PEAK_TO_PEAK_VALUE		((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x0009))
+#define GATTS_CHAR_UUID_GET_AC_CREST_FACTOR_VALUE	((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x000a))
+#define GATTS_CHAR_UUID_GET_VELOCITY_RMS_VALUE		((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x000b))
+#define GATTS_CHAR_UUID_GET_DISPLACEMENT_PEAK_TO_PEAK_VALUE	((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x000c))
+#define GATTS_CHAR_UUID_GET_SKEWNESS_VALUE			((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x000d))
+#define GATTS_CHAR_UUID_GET_KURTOSIS_VALUE			((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_CALCULATED_VALUES + 0x000e))
 
 /** profile_trigger_measurement */
 #define PROFILE_TRIGGER_MEASUREMENT 2
@@ -60,21 +85,55 @@
 #define GATTS_CHAR_UUID_TRIGGER_MEASUREMENT		((uint16_t) \
 				(GATTS_SERVICE_UUID_TRIGGER_MEASUREMENT+0x0001))
 #define MEASUREMENT_TRIGGER_WRITE_VAL			(0x01)
+#define MEASUREMENT_STREAM_TRIGGER_WRITE_VAL	(0x02)
+/** length of the trigger write carrying also the welch psd configuration */
+#define MEASUREMENT_TRIGGER_PSD_WRITE_LEN		(12)
+/** length of the trigger write carrying also the decimation factor */
+#define MEASUREMENT_TRIGGER_DECIMATION_WRITE_LEN	(13)
+/** length of the trigger write carrying also the oversampling factor */
+#define MEASUREMENT_TRIGGER_OVERSAMPLING_WRITE_LEN	(14)
 
 /** profile_get_time_results */
 #define PROFILE_GET_TIME_RESULTS 3
 #define GATTS_SERVICE_UUID_GET_TIME_RESULTS ((uint16_t)0x0400)
 #define GATTS_CHAR_UUID_GET_TIME_RESULTS	((uint16_t) \
 				(GATTS_SERVICE_UUID_GET_TIME_RESULTS+0x0001))
+#define GATTS_CHAR_UUID_STREAM_TIME_RESULTS	((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_TIME_RESULTS+0x0002))
+/** value written to the stream characteristic selecting the payload encoding **/
+#define STREAM_ENCODING_RAW_WRITE_VAL			(0x00)
+#define STREAM_ENCODING_COMPRESSED_WRITE_VAL	(0x01)
+/** time to wait for the end of congestion before the state is checked again **/
+#define STREAM_CONGEST_WAIT_MS				(100)
 
 /** profile_get_fft_results */
 #define PROFILE_GET_FFT_RESULTS 4
 #define GATTS_SERVICE_UUID_GET_FFT_RESULTS	 	((uint16_t)0x0500)
 #define GATTS_CHAR_UUID_GET_FFT_RESULTS			((uint16_t) \
 				(GATTS_SERVICE_UUID_GET_FFT_RESULTS+0x0001))
+#define GATTS_CHAR_UUID_GET_ENVELOPE_PEAKS		((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_FFT_RESULTS+0x0002))
+/** bytes of one envelope peak, frequency and amplitude **/
+#define ENVELOPE_PEAK_LEN						(2 * sizeof(uint16_t))
+#define GATTS_CHAR_UUID_BAND_TABLE				((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_FFT_RESULTS+0x0003))
+#define GATTS_CHAR_UUID_GET_BAND_RMS			((uint16_t) \
+				(GATTS_SERVICE_UUID_GET_FFT_RESULTS+0x0004))
+/** bytes of one band of the table, lower and upper edge **/
+#define BAND_LEN								(2 * sizeof(uint16_t))
+/** band table used until the client writes one, edges in Hz of the 1x and 2x of the
+ * 3000 rpm shaft, of the bearing defect band and of the high frequency band **/
+#define BAND_DEFAULT_TABLE						{45, 55, 95, 105, 150, 500, 500, 5000}
 
 #define GATTS_CHAR_VAL_LEN_MAX 0x40
 
+/** mtu values **/
+#define BLE_LOCAL_MTU				(500)
+#define BLE_DEFAULT_MTU				(23)
+
+/** maximal number of simultaneous connections tracked in the mtu table **/
+#define BLE_MAX_CONNECTIONS			(4)
+
 /** device BLE TAG */
 #define GATTS_TAG "VIBRATION SENSOR"
 
@@ -278,6 +337,129 @@ This function sets static variable containing threshold exceed montoring val.
 \****************************************************************************************/
 static void set_threshold_exceed_monitoring_val(uint16_t threshold);
 
+/****************************************************************************************\
+Function:
+set_threshold_alarm_config
+******************************************************************************************
+Parameters:
+const uint8_t value[] - version 2 write of the threshold characteristic
+******************************************************************************************
+Abstract:
+This function decodes the big endian alarm configuration following the version, window
+in ms, warning, alarm and hysteresis in adc counts, hold off and minimal interval of
+the indications in ms, and stores it as the requested one.
+\****************************************************************************************/
+static void set_threshold_alarm_config(const uint8_t value[]);
+
+/****************************************************************************************\
+Function:
+set_connection_mtu
+******************************************************************************************
+Parameters:
+uint16_t conn_id - id of the connection
+uint16_t mtu - mtu negotiated by the connection
+******************************************************************************************
+Abstract:
+This function stores the mtu of the connection in the mtu table.
+\****************************************************************************************/
+static void set_connection_mtu(uint16_t conn_id, uint16_t mtu);
+
+/****************************************************************************************\
+Function:
+get_connection_mtu
+******************************************************************************************
+Parameters:
+uint16_t conn_id - id of the connection
+******************************************************************************************
+Abstract:
+This function returns the mtu negotiated by the connection, or the default mtu if the
+connection is unknown.
+\****************************************************************************************/
+static uint16_t get_connection_mtu(uint16_t conn_id);
+
+/****************************************************************************************\
+Function:
+reset_time_stream_struct
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function resets the connection state of the time measured data stream.
+\****************************************************************************************/
+static void reset_time_stream_struct(void);
+
+/****************************************************************************************\
+Function:
+stream_time_measured_data
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function sends the whole time measured data as back to back notifications filling
+the negotiated mtu. Every frame carries the offset and the count of its samples, so the
+client can detect lost frames. The payload is compressed with the sample codec if the
+client selected it by the write to the stream characteristic. Sending is paused while the
+stack reports congestion and stops when the client unsubscribes. The stream is bound to
+the capture present at its start, if a new trigger replaces the capture meanwhile, the
+stream ends with the empty no more frame marked by the aborted flag.
+\****************************************************************************************/
+static void stream_time_measured_data(void);
+
+/****************************************************************************************\
+Function:
+encode_saturated
+******************************************************************************************
+Parameters:
+float units - value in the units of the characteristic
+uint8_t code[] - two bytes of the uint16 little endian code
+******************************************************************************************
+Abstract:
+This function rounds the value to uint16 saturated to its range, the negative values
+are 0.
+\****************************************************************************************/
+static void encode_saturated(float units, uint8_t code[]);
+
+/****************************************************************************************\
+Function:
+set_band_table
+******************************************************************************************
+Parameters:
+const uint8_t value[] - bands as the lower and upper edge in Hz, uint16 little endian
+uint16_t len - length of the value
+******************************************************************************************
+Abstract:
+This function replaces the band table by the value. It returns false and keeps the table
+if the value does not hold 1 to BLE_BAND_MAX bands or a band is empty.
+\****************************************************************************************/
+static bool set_band_table(const uint8_t value[], uint16_t len);
+
+/****************************************************************************************\
+Function:
+load_band_table
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function loads the band table stored in the nvs, or the default one if there is no
+valid table stored.
+\****************************************************************************************/
+static void load_band_table(void);
+
+/****************************************************************************************\
+Function:
+store_band_table
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function stores the band table in the nvs, so it is used after the restart.
+\****************************************************************************************/
+static void store_band_table(void);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -394,7 +576,15 @@ static const uint16_t calculated_values_char_uuid[MAX_CALCULATED_VALUES] =
 	GATTS_CHAR_UUID_GET_MAX_VALUE,
 	GATTS_CHAR_UUID_GET_MIN_VALUE,
 	GATTS_CHAR_UUID_GET_AMPLITUDE_VALUE,
-	GATTS_CHAR_UUID_GET_CREST_FACTOR_VALUE
+	GATTS_CHAR_UUID_GET_CREST_FACTOR_VALUE,
+	GATTS_CHAR_UUID_GET_AC_RMS_VALUE,
+	GATTS_CHAR_UUID_GET_PEAK_VALUE,
+	GATTS_CHAR_UUID_GET_PEAK_TO_PEAK_VALUE,
+	GATTS_CHAR_UUID_GET_AC_CREST_FACTOR_VALUE,
+	GATTS_CHAR_UUID_GET_VELOCITY_RMS_VALUE,
+	GATTS_CHAR_UUID_GET_DISPLACEMENT_PEAK_TO_PEAK_VALUE,
+	GATTS_CHAR_UUID_GET_SKEWNESS_VALUE,
+	GATTS_CHAR_UUID_GET_KURTOSIS_VALUE
 };
 
 /** array conatining calc values attributes vals **/
@@ -408,24 +598,77 @@ static struct _measurement_trigger_request{
 	uint16_t frequency;
 	float duration;
 	bool is_requested;
+	bool is_stream;
+	uint16_t segment_size;
+	uint8_t segment_overlap;
+	uint8_t segment_window;
+	uint8_t decimation;
+	uint8_t oversampling;
 } measurement_trigger_request;
 
 /** structure contating time measured data **/
 static struct _time_measured_data{
-	uint16_t size;
+	uint32_t size;
 	uint16_t *data;
-	uint16_t current_pos;
+	uint32_t current_pos;
+	uint16_t zero_val;
+	uint32_t generation;
 } time_measured_data;
 
-/** structure contating fft data **/
+/** structure contating fft data, the dB codes of the spectrum **/
 static struct _fft_data{
 	uint16_t size;
-	uint8_t *data;
+	uint16_t *data;
 	uint16_t current_pos;
 } fft_data;
 
-/** static var containing threshold monitoring exceed val **/
-static uint16_t threshold_exceed_monitoring_val = 0;
+/** structure containing the peaks of the envelope spectrum **/
+static struct _envelope_peaks{
+	uint16_t char_handle;
+	uint8_t value[BLE_ENVELOPE_PEAK_COUNT * ENVELOPE_PEAK_LEN];
+} envelope_peaks;
+
+/** structure containing the band table and the rms of its bands **/
+static struct _bands{
+	uint16_t table_char_handle;
+	uint16_t rms_char_handle;
+	uint8_t count;
+	uint8_t table[BLE_BAND_MAX * BAND_LEN];
+	uint8_t rms_count;
+	uint8_t rms[BLE_BAND_MAX * sizeof(uint16_t)];
+} bands;
+
+/** structure containing state of the time measured data notification stream **/
+static struct _time_stream{
+	uint16_t char_handle;
+	uint16_t descr_handle;
+	uint16_t conn_id;
+	volatile bool is_subscribed;
+	volatile bool is_requested;
+	volatile bool is_congested;
+	bool is_compressed;
+} time_stream;
+
+/** mutex guarding time_measured_data and fft_data against the update during the transfer **/
+static SemaphoreHandle_t time_measured_data_mutex = NULL;
+
+/** mutex guarding the band table against the write of the client during its copy **/
+static SemaphoreHandle_t band_table_mutex = NULL;
+
+/** frame sent with the time measured data notification **/
+static uint8_t stream_frame[BLE_LOCAL_MTU - RESULT_FRAME_ATT_HEADER_LEN];
+
+/** table of the mtu negotiated by each connection **/
+static uint16_t connection_mtu_tab[BLE_MAX_CONNECTIONS];
+
+/** threshold monitoring request, the peak threshold of the version 1 write or the alarm
+ * configuration of the version 2 one **/
+static struct _threshold_request{
+	bool is_requested;
+	bool is_alarm;
+	uint16_t threshold;
+	threshold_alarm_config alarm;
+} threshold_request;
 
 /** configuration struct needed to create characteristics **/
 static uint8_t char_str[] = {0x11};
@@ -446,6 +689,10 @@ void ble_communication_init()
 	reset_time_measured_struct();
 	reset_fft_data_struct();
 	reset_threshold_exceed_monitoring_val();
+	reset_time_stream_struct();
+	band_table_mutex = xSemaphoreCreateMutex();
+	load_band_table();
+	time_measured_data_mutex = xSemaphoreCreateMutex();
 	/** BT controller initialization */
 	esp_bt_controller_config_t bt_cfg = BT_CONTROLLER_INIT_CONFIG_DEFAULT();
 	esp_bt_controller_init(&bt_cfg);
@@ -477,7 +724,7 @@ void ble_communication_init()
 	esp_ble_gatts_app_register(PROFILE_GET_FFT_RESULTS);
 
 	/** set mtu */
-	esp_ble_gatt_set_local_mtu(500);
+	esp_ble_gatt_set_local_mtu(BLE_LOCAL_MTU);
 }
 /****************************************************************************************/
 
@@ -491,18 +738,54 @@ void ble_communication_threshold_exceeded_notification_send(uint16_t exceeded_va
 }
 /****************************************************************************************/
 
+void ble_communication_threshold_alarm_notification_send(uint8_t level, uint16_t rms)
+{
+	uint8_t val[4] = {THRESHOLD_ALARM_WRITE_VAL, level, (rms>>8)&0xff, rms&0xff};
+	esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_THRESHOLD_EXCEEDED_NOTIFICATION].gatts_if,
+				   	gl_profile_tab[PROFILE_THRESHOLD_EXCEEDED_NOTIFICATION].conn_id,
+					gl_profile_tab[PROFILE_THRESHOLD_EXCEEDED_NOTIFICATION].char_handle,
+					sizeof(val), val, false);
+}
+/****************************************************************************************/
+
 void ble_communication_update_calculated_value(calculated_value type, float val)
 {
 	calculated_vals_response_tab[type].float_type = val;
 }
 /****************************************************************************************/
 
+void ble_communication_update_envelope_peak(uint8_t index, float frequency, float amplitude)
+{
+	if (index >= BLE_ENVELOPE_PEAK_COUNT) {
+		return;
+	}
+	uint8_t *peak = envelope_peaks.value + index * ENVELOPE_PEAK_LEN;
+	encode_saturated(frequency / BLE_ENVELOPE_FREQUENCY_UNIT, peak);
+	encode_saturated(amplitude / BLE_ENVELOPE_AMPLITUDE_UNIT, peak + sizeof(uint16_t));
+}
+/****************************************************************************************/
+
+void ble_communication_update_band_rms(const float rms[], uint8_t count)
+{
+	bands.rms_count = (count > BLE_BAND_MAX) ? BLE_BAND_MAX : count;
+	for (uint8_t i = 0; i < bands.rms_count; ++i) {
+		encode_saturated(rms[i] / BLE_BAND_RMS_UNIT, bands.rms + i * sizeof(uint16_t));
+	}
+}
+/****************************************************************************************/
+
 bool ble_communication_is_measurement_requested(void)
 {
 	return measurement_trigger_request.is_requested;
 }
 /****************************************************************************************/
 
+bool ble_communication_is_stream_measurement_requested(void)
+{
+	return measurement_trigger_request.is_stream;
+}
+/****************************************************************************************/
+
 float ble_communication_get_requested_measurement_duration(void)
 {
 	return measurement_trigger_request.duration;
@@ -515,25 +798,77 @@ uint16_t ble_communication_get_requested_measurement_frequency(void)
 }
 /****************************************************************************************/
 
+uint16_t ble_communication_get_requested_segment_size(void)
+{
+	return measurement_trigger_request.segment_size;
+}
+/****************************************************************************************/
+
+uint8_t ble_communication_get_requested_segment_overlap(void)
+{
+	return measurement_trigger_request.segment_overlap;
+}
+/****************************************************************************************/
+
+uint8_t ble_communication_get_requested_segment_window(void)
+{
+	return measurement_trigger_request.segment_window;
+}
+/****************************************************************************************/
+
+uint8_t ble_communication_get_requested_decimation(void)
+{
+	return measurement_trigger_request.decimation;
+}
+/****************************************************************************************/
+
+uint8_t ble_communication_get_requested_oversampling(void)
+{
+	return measurement_trigger_request.oversampling;
+}
+/****************************************************************************************/
+
+uint8_t ble_communication_get_bands(uint16_t low[], uint16_t high[], uint8_t max_count)
+{
+	xSemaphoreTake(band_table_mutex, portMAX_DELAY);
+	uint8_t count = (bands.count < max_count) ? bands.count : max_count;
+	for (uint8_t i = 0; i < count; ++i) {
+		const uint8_t *band = bands.table + i * BAND_LEN;
+		low[i] = band[0] | band[1] << 8;
+		high[i] = band[2] | band[3] << 8;
+	}
+	xSemaphoreGive(band_table_mutex);
+	return count;
+}
+/****************************************************************************************/
+
 void ble_communication_measurement_request_handled(void)
 {
 	reset_measurement_request_struct();
 }
 /****************************************************************************************/
 
-void ble_communication_update_time_measured_data(uint16_t *data, uint16_t size)
+void ble_communication_update_time_measured_data(uint16_t *data, uint32_t size,
+				uint16_t zero_val)
 {
+	xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
 	time_measured_data.current_pos = 0;
 	time_measured_data.data = data;
 	time_measured_data.size = size;
+	time_measured_data.zero_val = zero_val;
+	/** running stream compares it to detect the replaced capture **/
+	++time_measured_data.generation;
+	xSemaphoreGive(time_measured_data_mutex);
 }
 /****************************************************************************************/
 
-void ble_communication_update_fft_data(uint8_t *data, uint16_t size)
+void ble_communication_update_fft_data(uint16_t *data, uint16_t size)
 {
+	xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
 	fft_data.current_pos = 0;
 	fft_data.data = data;
 	fft_data.size = size;
+	xSemaphoreGive(time_measured_data_mutex);
 }
 /****************************************************************************************/
 
@@ -548,9 +883,20 @@ void ble_communication_calculation_completed_notification_send(uint16_t zero_val
 }
 /****************************************************************************************/
 
+void ble_communication_measurement_failed_notification_send(ble_measurement_error error)
+{
+	uint8_t val[1] = {(uint8_t)error};
+	esp_ble_gatts_send_indicate(
+			gl_profile_tab[PROFILE_TRIGGER_MEASUREMENT].gatts_if,
+			gl_profile_tab[PROFILE_TRIGGER_MEASUREMENT].conn_id,
+			gl_profile_tab[PROFILE_TRIGGER_MEASUREMENT].char_handle,
+			sizeof(val), val, false);
+}
+/****************************************************************************************/
+
 bool ble_communication_is_threshold_exceed_monitoring_requested()
 {
-	return (threshold_exceed_monitoring_val ? true : false);
+	return threshold_request.is_requested;
 }
 /****************************************************************************************/
 
@@ -562,7 +908,33 @@ void ble_communication_threshold_exceeded_monitoring_handled()
 
 uint16_t ble_communication_get_threshold_exceed_monitoring_val(void)
 {
-	return threshold_exceed_monitoring_val;
+	return threshold_request.threshold;
+}
+/****************************************************************************************/
+
+bool ble_communication_is_threshold_alarm_requested(void)
+{
+	return threshold_request.is_requested && threshold_request.is_alarm;
+}
+/****************************************************************************************/
+
+void ble_communication_get_threshold_alarm_config(threshold_alarm_config *config)
+{
+	*config = threshold_request.alarm;
+}
+/****************************************************************************************/
+
+void ble_communication_stream_task(void *pvParameter)
+{
+	while(true){
+		/** woken up by the subscription of the client, the congestion end notified after
+		 * the last frame wakes the task too, it must not stream the data again **/
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (time_stream.is_requested) {
+			time_stream.is_requested = false;
+			stream_time_measured_data();
+		}
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -623,6 +995,12 @@ static void gap_event_handler(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param
 static void gatts_event_handler(esp_gatts_cb_event_t event, 
 				esp_gatt_if_t gatts_if, esp_ble_gatts_cb_param_t *param)
 {
+    /* The mtu is negotiated once per connection, so it is tracked for all the profiles */
+    if (event == ESP_GATTS_CONNECT_EVT) {
+        set_connection_mtu(param->connect.conn_id, BLE_DEFAULT_MTU);
+    } else if (event == ESP_GATTS_MTU_EVT) {
+        set_connection_mtu(param->mtu.conn_id, param->mtu.mtu);
+    }
     /* If event is register event, store the gatts_if for each profile */
     if (event == ESP_GATTS_REG_EVT) {
         if (param->reg.status == ESP_GATT_OK) {
@@ -674,6 +1052,11 @@ static void gatts_profile_threshold_exceeded_notification(esp_gatts_cb_event_t e
 			uint16_t threshold = param->write.value[2] << 8
 					| param->write.value[3];
 			set_threshold_exceed_monitoring_val(threshold);
+			controller_event_post(THRESHOLD_MONITORING_REQUESTED_EVENT);
+		} else if ((param->write.value[1] == THRESHOLD_ALARM_WRITE_VAL) &&
+				(param->write.len >= THRESHOLD_ALARM_WRITE_LEN)) {
+			set_threshold_alarm_config(param->write.value);
+			controller_event_post(THRESHOLD_MONITORING_REQUESTED_EVENT);
 		}
 		break;
 	case ESP_GATTS_EXEC_WRITE_EVT:
@@ -768,6 +1151,14 @@ static void gatts_profile_get_calculated_values(esp_gatts_cb_event_t event,
 #define MIN_VALUE_HANDLE			0x5e
 #define AMPLITUDE_VALUE_HANDLE		0x60
 #define CREST_FACTOR_VALUE_HANDLE	0x62
+#define AC_RMS_VALUE_HANDLE			0x64
+#define PEAK_VALUE_HANDLE			0x66
+#define PEAK_TO_PEAK_VALUE_HANDLE	0x68
+#define AC_CREST_FACTOR_VALUE_HANDLE	0x6a
+#define VELOCITY_RMS_VALUE_HANDLE	0x6c
+#define DISPLACEMENT_PEAK_TO_PEAK_VALUE_HANDLE	0x6e
+#define SKEWNESS_VALUE_HANDLE		0x70
+#define KURTOSIS_VALUE_HANDLE		0x72
 		esp_gatt_rsp_t rsp;
 		memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
 		rsp.attr_value.handle = param->read.handle;
@@ -797,6 +1188,41 @@ static void gatts_profile_get_calculated_values(esp_gatts_cb_event_t event,
 			memcpy(rsp.attr_value.value, calculated_vals_response_tab[CREST_FACTOR_VALUE].int_type,
 								rsp.attr_value.len);
 			break;
+		case AC_RMS_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value, calculated_vals_response_tab[AC_RMS_VALUE].int_type,
+								rsp.attr_value.len);
+			break;
+		case PEAK_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value, calculated_vals_response_tab[PEAK_VALUE].int_type,
+								rsp.attr_value.len);
+			break;
+		case PEAK_TO_PEAK_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value, calculated_vals_response_tab[PEAK_TO_PEAK_VALUE].int_type,
+								rsp.attr_value.len);
+			break;
+		case AC_CREST_FACTOR_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value,
+					calculated_vals_response_tab[AC_CREST_FACTOR_VALUE].int_type,
+					rsp.attr_value.len);
+			break;
+		case VELOCITY_RMS_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value,
+					calculated_vals_response_tab[VELOCITY_RMS_VALUE].int_type,
+					rsp.attr_value.len);
+			break;
+		case DISPLACEMENT_PEAK_TO_PEAK_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value,
+					calculated_vals_response_tab[DISPLACEMENT_PEAK_TO_PEAK_VALUE].int_type,
+					rsp.attr_value.len);
+			break;
+		case SKEWNESS_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value, calculated_vals_response_tab[SKEWNESS_VALUE].int_type,
+					rsp.attr_value.len);
+			break;
+		case KURTOSIS_VALUE_HANDLE:
+			memcpy(rsp.attr_value.value, calculated_vals_response_tab[KURTOSIS_VALUE].int_type,
+					rsp.attr_value.len);
+			break;
 		}
 		esp_ble_gatts_send_response(gatts_if, param->read.conn_id, param->read.trans_id,
 				ESP_GATT_OK, &rsp);
@@ -901,13 +1327,41 @@ switch(event){
 		/* for some reason 0 element is always 0 no matter what is written,
 		 * also when char-write-cmd in gatttool the value has to be 0x01 not 0x1
 		 * */
-		if(param->write.value[1] == MEASUREMENT_TRIGGER_WRITE_VAL){
-			/*trigger measurement */
-			measurement_trigger_request.is_requested = true;
-			measurement_trigger_request.frequency = param->write.value[2]<<8 | param->write.value[3];
-			uint32_t *ptr = (uint32_t*)&(measurement_trigger_request.duration);
+		if((param->write.value[1] == MEASUREMENT_TRIGGER_WRITE_VAL) ||
+				(param->write.value[1] == MEASUREMENT_STREAM_TRIGGER_WRITE_VAL)){
+			/* the request is decoded and checked aside, the refused one leaves the
+			 * pending request untouched */
+			struct _measurement_trigger_request request = {0};
+			request.is_stream = (param->write.value[1] == MEASUREMENT_STREAM_TRIGGER_WRITE_VAL);
+			request.frequency = param->write.value[2]<<8 | param->write.value[3];
+			uint32_t *ptr = (uint32_t*)&(request.duration);
 			*ptr = (param->write.value[4]<<24 | param->write.value[5]<<16 |
 						   	param->write.value[6]<<8 | param->write.value[7]);
+			if (param->write.len >= MEASUREMENT_TRIGGER_PSD_WRITE_LEN) {
+				request.segment_size = param->write.value[8]<<8 | param->write.value[9];
+				request.segment_overlap = param->write.value[10];
+				request.segment_window = param->write.value[11];
+			}
+			if (param->write.len >= MEASUREMENT_TRIGGER_DECIMATION_WRITE_LEN) {
+				request.decimation = param->write.value[12];
+			}
+			if (param->write.len >= MEASUREMENT_TRIGGER_OVERSAMPLING_WRITE_LEN) {
+				request.oversampling = param->write.value[13];
+			}
+			/* the buffered samples have to fit the arena, the longer measurement is
+			 * refused here and never reaches the controller */
+			if (!request.is_stream && (request.frequency * request.duration >=
+					(float)(MEASUREMENT_MAX_SAMPLES + 1))) {
+				ESP_LOGE(GATTS_TAG, "measurement of %f samples over %u refused",
+						request.frequency * request.duration, MEASUREMENT_MAX_SAMPLES);
+				ble_communication_measurement_failed_notification_send(
+						BLE_MEASUREMENT_ERROR_TOO_LONG);
+				break;
+			}
+			/*trigger measurement */
+			request.is_requested = true;
+			measurement_trigger_request = request;
+			controller_event_post(MEASUREMENT_REQUESTED_EVENT);
 		}
 		break;
 	}
@@ -1001,39 +1455,38 @@ static void gatts_profile_get_time_results(esp_gatts_cb_event_t event, esp_gatt_
 
 		break;
 	case ESP_GATTS_READ_EVT:{
-#define FIRST_FRAME_IDN		0x1
-#define MORE_DATA_IDN 		0x2
-#define NO_MORE_DATA_IDN	0x3
-#define FRAME_SIZE	21
 		esp_gatt_rsp_t rsp;
-		if(NULL != time_measured_data.data){
-			if(time_measured_data.current_pos >= (time_measured_data.size-((time_measured_data.size)%10)-1)){
-				memset(rsp.attr_value.value, 0xff, FRAME_SIZE);
-				rsp.attr_value.value[0] = NO_MORE_DATA_IDN;
-				memcpy(rsp.attr_value.value+1, time_measured_data.data+(time_measured_data.current_pos),
-							   	2*(time_measured_data.size - time_measured_data.current_pos));
-				time_measured_data.current_pos = 0;
-			} else if (0 == time_measured_data.current_pos) {
-				rsp.attr_value.value[0] = FIRST_FRAME_IDN;
-				memcpy(rsp.attr_value.value+1, time_measured_data.data, 20);
-				time_measured_data.current_pos += 10;
-			} else {
-				rsp.attr_value.value[0] = MORE_DATA_IDN;
-				memcpy(rsp.attr_value.value+1, time_measured_data.data+(time_measured_data.current_pos), 20);
-				time_measured_data.current_pos += 10;
-			}
-		} else {
-			memset(rsp.attr_value.value, 0xff, FRAME_SIZE);
-			rsp.attr_value.value[0] = NO_MORE_DATA_IDN;
+		uint16_t frame_len = result_frame_get_max_len(get_connection_mtu(param->read.conn_id));
+		xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
+		time_measured_data.current_pos += result_frame_encode(rsp.attr_value.value, &frame_len,
+				time_measured_data.data, sizeof(uint16_t), time_measured_data.size,
+				time_measured_data.current_pos);
+		if (RESULT_FRAME_NO_MORE == rsp.attr_value.value[0]) {
+			time_measured_data.current_pos = 0;
 		}
+		xSemaphoreGive(time_measured_data_mutex);
 		rsp.attr_value.handle = param->read.handle;
-		rsp.attr_value.len = FRAME_SIZE;
+		rsp.attr_value.len = frame_len;
 
 		esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
 				param->read.trans_id, ESP_GATT_OK, &rsp);
 		break;
 	}
 	case ESP_GATTS_WRITE_EVT:
+		if ((param->write.handle == time_stream.descr_handle) && (2 == param->write.len)) {
+			time_stream.is_subscribed = (param->write.value[0] & 0x01) ? true : false;
+			if (time_stream.is_subscribed) {
+				time_stream.is_requested = true;
+				xTaskNotifyGive(get_task_handle(BLE_STREAM_TASK_HANDLE));
+			}
+		} else if ((param->write.handle == time_stream.char_handle) && (param->write.len >= 1)) {
+			time_stream.is_compressed =
+					(STREAM_ENCODING_COMPRESSED_WRITE_VAL == param->write.value[0]);
+		}
+		if (param->write.need_rsp) {
+			esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+					param->write.trans_id, ESP_GATT_OK, NULL);
+		}
 		break;
 	case ESP_GATTS_EXEC_WRITE_EVT:
 		break;
@@ -1065,7 +1518,12 @@ static void gatts_profile_get_time_results(esp_gatts_cb_event_t event, esp_gatt_
 	case ESP_GATTS_ADD_CHAR_EVT:;
 		uint16_t length = 0;
 		const uint8_t *prf_char;
-		gl_profile_tab[PROFILE_GET_TIME_RESULTS].char_handle = param->add_char.attr_handle;
+		/** the read characteristic is added first, the stream one after its descriptor **/
+		if (0 == gl_profile_tab[PROFILE_GET_TIME_RESULTS].char_handle) {
+			gl_profile_tab[PROFILE_GET_TIME_RESULTS].char_handle = param->add_char.attr_handle;
+		} else {
+			time_stream.char_handle = param->add_char.attr_handle;
+		}
 		gl_profile_tab[PROFILE_GET_TIME_RESULTS].descr_uuid.len = ESP_UUID_LEN_16;
 		gl_profile_tab[PROFILE_GET_TIME_RESULTS].descr_uuid.uuid.uuid16 =
 				ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
@@ -1075,6 +1533,18 @@ static void gatts_profile_get_time_results(esp_gatts_cb_event_t event, esp_gatt_
 				ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, NULL, NULL);
 		break;
 	case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+		if (0 == time_stream.char_handle) {
+			/** stream characteristic keeps the handles of the read one unchanged **/
+			esp_bt_uuid_t stream_char_uuid = {.len = ESP_UUID_LEN_128};
+			set_uuid(GATTS_CHAR_UUID_STREAM_TIME_RESULTS, stream_char_uuid.uuid.uuid128);
+			esp_ble_gatts_add_char(
+					gl_profile_tab[PROFILE_GET_TIME_RESULTS].service_handle,
+					&stream_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+					ESP_GATT_CHAR_PROP_BIT_WRITE | ESP_GATT_CHAR_PROP_BIT_NOTIFY,
+					&gatts_char_val, NULL);
+		} else {
+			time_stream.descr_handle = param->add_char_descr.attr_handle;
+		}
 		break;
 	case ESP_GATTS_DELETE_EVT:
 		break;
@@ -1083,8 +1553,12 @@ static void gatts_profile_get_time_results(esp_gatts_cb_event_t event, esp_gatt_
 	case ESP_GATTS_STOP_EVT:
 		break;
 	case ESP_GATTS_CONNECT_EVT:
+		time_stream.conn_id = param->connect.conn_id;
 		break;
 	case ESP_GATTS_DISCONNECT_EVT:
+		time_stream.is_subscribed = false;
+		time_stream.is_congested = false;
+		xTaskNotifyGive(get_task_handle(BLE_STREAM_TASK_HANDLE));
 		break;
 	case ESP_GATTS_OPEN_EVT:
 		break;
@@ -1095,6 +1569,10 @@ static void gatts_profile_get_time_results(esp_gatts_cb_event_t event, esp_gatt_
 	case ESP_GATTS_LISTEN_EVT:
 		break;
 	case ESP_GATTS_CONGEST_EVT:
+		time_stream.is_congested = param->congest.congested;
+		if (!time_stream.is_congested) {
+			xTaskNotifyGive(get_task_handle(BLE_STREAM_TASK_HANDLE));
+		}
 		break;
 	case ESP_GATTS_RESPONSE_EVT:
 		break;
@@ -1123,38 +1601,59 @@ static void gatts_profile_get_fft_results(esp_gatts_cb_event_t event, esp_gatt_i
 				&gl_profile_tab[PROFILE_GET_FFT_RESULTS].service_id, 0x2e);
 		break;
 	case ESP_GATTS_READ_EVT:{
-#define FIRST_FRAME_IDN		0x1
-#define MORE_DATA_IDN 		0x2
-#define NO_MORE_DATA_IDN	0x3
-#define FRAME_SIZE	21
 		esp_gatt_rsp_t rsp;
-		if(NULL != fft_data.data){
-			if(fft_data.current_pos >= (fft_data.size-((fft_data.size)%20)-1)){
-				memset(rsp.attr_value.value, 0xff, FRAME_SIZE);
-				rsp.attr_value.value[0] = NO_MORE_DATA_IDN;
-				memcpy(rsp.attr_value.value+1, fft_data.data+(fft_data.current_pos), 
-								(fft_data.size - fft_data.current_pos));
-				fft_data.current_pos = 0;
-			} else if (0 == fft_data.current_pos) {
-				rsp.attr_value.value[0] = FIRST_FRAME_IDN;
-				memcpy(rsp.attr_value.value+1, fft_data.data, 20);
-				fft_data.current_pos += 20;
+		if (param->read.handle == envelope_peaks.char_handle) {
+			memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
+			rsp.attr_value.handle = param->read.handle;
+			rsp.attr_value.len = sizeof(envelope_peaks.value);
+			memcpy(rsp.attr_value.value, envelope_peaks.value, sizeof(envelope_peaks.value));
+			esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
+					param->read.trans_id, ESP_GATT_OK, &rsp);
+			break;
+		}
+		if ((param->read.handle == bands.table_char_handle) ||
+				(param->read.handle == bands.rms_char_handle)) {
+			memset(&rsp, 0, sizeof(esp_gatt_rsp_t));
+			rsp.attr_value.handle = param->read.handle;
+			if (param->read.handle == bands.table_char_handle) {
+				xSemaphoreTake(band_table_mutex, portMAX_DELAY);
+				rsp.attr_value.len = bands.count * BAND_LEN;
+				memcpy(rsp.attr_value.value, bands.table, rsp.attr_value.len);
+				xSemaphoreGive(band_table_mutex);
 			} else {
-				rsp.attr_value.value[0] = MORE_DATA_IDN;
-				memcpy(rsp.attr_value.value+1, fft_data.data+(fft_data.current_pos), 20);
-				fft_data.current_pos += 20;
+				rsp.attr_value.len = bands.rms_count * sizeof(uint16_t);
+				memcpy(rsp.attr_value.value, bands.rms, rsp.attr_value.len);
 			}
-		} else {
-			memset(rsp.attr_value.value, 0xff, FRAME_SIZE);
-			rsp.attr_value.value[0] = NO_MORE_DATA_IDN;
+			esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
+					param->read.trans_id, ESP_GATT_OK, &rsp);
+			break;
 		}
+		uint16_t frame_len = result_frame_get_max_len(get_connection_mtu(param->read.conn_id));
+		xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
+		fft_data.current_pos += result_frame_encode(rsp.attr_value.value, &frame_len,
+				fft_data.data, sizeof(uint16_t), fft_data.size, fft_data.current_pos);
+		if (RESULT_FRAME_NO_MORE == rsp.attr_value.value[0]) {
+			fft_data.current_pos = 0;
+		}
+		xSemaphoreGive(time_measured_data_mutex);
 		rsp.attr_value.handle = param->read.handle;
-		rsp.attr_value.len = FRAME_SIZE;
+		rsp.attr_value.len = frame_len;
 		esp_ble_gatts_send_response(gatts_if, param->read.conn_id,
 				param->read.trans_id, ESP_GATT_OK, &rsp);
 		break;
 	}
 	case ESP_GATTS_WRITE_EVT:
+		if (param->write.handle == bands.table_char_handle) {
+			esp_gatt_status_t status = ESP_GATT_OUT_OF_RANGE;
+			if (set_band_table(param->write.value, param->write.len)) {
+				store_band_table();
+				status = ESP_GATT_OK;
+			}
+			if (param->write.need_rsp) {
+				esp_ble_gatts_send_response(gatts_if, param->write.conn_id,
+						param->write.trans_id, status, NULL);
+			}
+		}
 		break;
 	case ESP_GATTS_EXEC_WRITE_EVT:
 		break;
@@ -1186,7 +1685,17 @@ static void gatts_profile_get_fft_results(esp_gatts_cb_event_t event, esp_gatt_i
 	case ESP_GATTS_ADD_CHAR_EVT:;
 		uint16_t length = 0;
 		const uint8_t *prf_char;
-		gl_profile_tab[PROFILE_GET_FFT_RESULTS].char_handle = param->add_char.attr_handle;
+		/** the fft characteristic is added first, the envelope, band table and band rms
+		 * ones after the descriptor of the previous one **/
+		if (0 == gl_profile_tab[PROFILE_GET_FFT_RESULTS].char_handle) {
+			gl_profile_tab[PROFILE_GET_FFT_RESULTS].char_handle = param->add_char.attr_handle;
+		} else if (0 == envelope_peaks.char_handle) {
+			envelope_peaks.char_handle = param->add_char.attr_handle;
+		} else if (0 == bands.table_char_handle) {
+			bands.table_char_handle = param->add_char.attr_handle;
+		} else {
+			bands.rms_char_handle = param->add_char.attr_handle;
+		}
 		gl_profile_tab[PROFILE_GET_FFT_RESULTS].descr_uuid.len = ESP_UUID_LEN_16;
 		gl_profile_tab[PROFILE_GET_FFT_RESULTS].descr_uuid.uuid.uuid16 =
 				ESP_GATT_UUID_CHAR_CLIENT_CONFIG;
@@ -1195,8 +1704,34 @@ static void gatts_profile_get_fft_results(esp_gatts_cb_event_t event, esp_gatt_i
 				&gl_profile_tab[PROFILE_GET_FFT_RESULTS].descr_uuid,
 				ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE, NULL, NULL);
 		break;
-	case ESP_GATTS_ADD_CHAR_DESCR_EVT:
+	case ESP_GATTS_ADD_CHAR_DESCR_EVT:{
+		/** the next characteristics keep the handles of the fft one unchanged **/
+		esp_bt_uuid_t next_char_uuid = {.len = ESP_UUID_LEN_128};
+		esp_attr_control_t next_response_config = {.auto_rsp = ESP_GATT_RSP_BY_APP};
+		if (0 == envelope_peaks.char_handle) {
+			set_uuid(GATTS_CHAR_UUID_GET_ENVELOPE_PEAKS, next_char_uuid.uuid.uuid128);
+			esp_ble_gatts_add_char(
+					gl_profile_tab[PROFILE_GET_FFT_RESULTS].service_handle,
+					&next_char_uuid, ESP_GATT_PERM_READ,
+					ESP_GATT_CHAR_PROP_BIT_READ, &gatts_char_val,
+					&next_response_config);
+		} else if (0 == bands.table_char_handle) {
+			set_uuid(GATTS_CHAR_UUID_BAND_TABLE, next_char_uuid.uuid.uuid128);
+			esp_ble_gatts_add_char(
+					gl_profile_tab[PROFILE_GET_FFT_RESULTS].service_handle,
+					&next_char_uuid, ESP_GATT_PERM_READ | ESP_GATT_PERM_WRITE,
+					ESP_GATT_CHAR_PROP_BIT_READ | ESP_GATT_CHAR_PROP_BIT_WRITE,
+					&gatts_char_val, &next_response_config);
+		} else if (0 == bands.rms_char_handle) {
+			set_uuid(GATTS_CHAR_UUID_GET_BAND_RMS, next_char_uuid.uuid.uuid128);
+			esp_ble_gatts_add_char(
+					gl_profile_tab[PROFILE_GET_FFT_RESULTS].service_handle,
+					&next_char_uuid, ESP_GATT_PERM_READ,
+					ESP_GATT_CHAR_PROP_BIT_READ, &gatts_char_val,
+					&next_response_config);
+		}
 		break;
+	}
 	case ESP_GATTS_DELETE_EVT:
 		break;
 	case ESP_GATTS_START_EVT:
@@ -1250,6 +1785,12 @@ static void reset_measurement_request_struct(void)
 	measurement_trigger_request.duration = 0;
 	measurement_trigger_request.frequency = 0;
 	measurement_trigger_request.is_requested = false;
+	measurement_trigger_request.is_stream = false;
+	measurement_trigger_request.segment_size = 0;
+	measurement_trigger_request.segment_overlap = 0;
+	measurement_trigger_request.segment_window = 0;
+	measurement_trigger_request.decimation = 0;
+	measurement_trigger_request.oversampling = 0;
 }
 /****************************************************************************************/
 
@@ -1258,6 +1799,7 @@ static void reset_time_measured_struct(void)
 	time_measured_data.current_pos = 0;
 	time_measured_data.data = NULL;
 	time_measured_data.size = 0;
+	time_measured_data.zero_val = 0;
 }
 /****************************************************************************************/
 
@@ -1271,13 +1813,178 @@ static void reset_fft_data_struct(void)
 
 static void reset_threshold_exceed_monitoring_val(void)
 {
-	threshold_exceed_monitoring_val = 0;
+	threshold_request.is_requested = false;
 }
 /****************************************************************************************/
 
 static void set_threshold_exceed_monitoring_val(uint16_t threshold)
 {
-	threshold_exceed_monitoring_val = threshold;
+	threshold_request.threshold = threshold;
+	threshold_request.is_alarm = false;
+	threshold_request.is_requested = true;
+}
+/****************************************************************************************/
+
+static void set_threshold_alarm_config(const uint8_t value[])
+{
+	const uint8_t *field = value + 2;
+	threshold_request.alarm.window_ms = field[0] << 8 | field[1];
+	threshold_request.alarm.warning = field[2] << 8 | field[3];
+	threshold_request.alarm.alarm = field[4] << 8 | field[5];
+	threshold_request.alarm.hysteresis = field[6] << 8 | field[7];
+	threshold_request.alarm.hold_off_ms = field[8] << 8 | field[9];
+	threshold_request.alarm.min_interval_ms = field[10] << 8 | field[11];
+	threshold_request.is_alarm = true;
+	threshold_request.is_requested = true;
+}
+/****************************************************************************************/
+
+static void set_connection_mtu(uint16_t conn_id, uint16_t mtu)
+{
+	if (conn_id < BLE_MAX_CONNECTIONS) {
+		connection_mtu_tab[conn_id] = (mtu > BLE_LOCAL_MTU) ? BLE_LOCAL_MTU : mtu;
+	}
+}
+/****************************************************************************************/
+
+static uint16_t get_connection_mtu(uint16_t conn_id)
+{
+	return ((conn_id < BLE_MAX_CONNECTIONS) && (0 != connection_mtu_tab[conn_id])) ?
+			connection_mtu_tab[conn_id] : BLE_DEFAULT_MTU;
+}
+/****************************************************************************************/
+
+static void reset_time_stream_struct(void)
+{
+	time_stream.conn_id = 0;
+	time_stream.is_subscribed = false;
+	time_stream.is_requested = false;
+	time_stream.is_congested = false;
+	time_stream.is_compressed = false;
+}
+/****************************************************************************************/
+
+static void stream_time_measured_data(void)
+{
+	uint32_t current_pos = 0;
+	bool is_last = false;
+
+	xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
+	uint32_t generation = time_measured_data.generation;
+	xSemaphoreGive(time_measured_data_mutex);
+
+	while (time_stream.is_subscribed && !is_last) {
+		if (time_stream.is_congested) {
+			ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STREAM_CONGEST_WAIT_MS));
+			continue;
+		}
+		uint16_t frame_len = result_frame_get_max_len(get_connection_mtu(time_stream.conn_id));
+
+		xSemaphoreTake(time_measured_data_mutex, portMAX_DELAY);
+		uint32_t count;
+		if (generation != time_measured_data.generation) {
+			/* capture was replaced, the remaining frames would mix two captures */
+			count = result_frame_encode(stream_frame, &frame_len, NULL, sizeof(uint16_t),
+					current_pos, current_pos);
+			stream_frame[0] |= RESULT_FRAME_ABORTED_FLAG;
+		} else if (time_stream.is_compressed) {
+			count = result_frame_encode_compressed(stream_frame, &frame_len,
+					time_measured_data.data, time_measured_data.size, current_pos,
+					time_measured_data.zero_val);
+		} else {
+			count = result_frame_encode(stream_frame, &frame_len, time_measured_data.data,
+					sizeof(uint16_t), time_measured_data.size, current_pos);
+		}
+		xSemaphoreGive(time_measured_data_mutex);
+
+		if (ESP_OK == esp_ble_gatts_send_indicate(gl_profile_tab[PROFILE_GET_TIME_RESULTS].gatts_if,
+				time_stream.conn_id, time_stream.char_handle, frame_len, stream_frame, false)) {
+			current_pos += count;
+			is_last = (RESULT_FRAME_NO_MORE == (stream_frame[0] &
+					~(RESULT_FRAME_COMPRESSED_FLAG | RESULT_FRAME_ABORTED_FLAG)));
+		} else {
+			/** stack queue is full, give it time to send the pending frames **/
+			vTaskDelay(1);
+		}
+	}
+}
+/****************************************************************************************/
+
+static void encode_saturated(float units, uint8_t code[])
+{
+	uint16_t value = 0;
+	if (units >= UINT16_MAX) {
+		value = UINT16_MAX;
+	} else if (units > 0) {
+		value = (uint16_t)(units + 0.5f);
+	}
+	code[0] = (uint8_t)value;
+	code[1] = (uint8_t)(value >> 8);
+}
+/****************************************************************************************/
+
+static bool set_band_table(const uint8_t value[], uint16_t len)
+{
+	if ((0 == len) || (0 != len % BAND_LEN) || (len > sizeof(bands.table))) {
+		return false;
+	}
+	for (uint16_t i = 0; i < len; i += BAND_LEN) {
+		uint16_t low = value[i] | value[i+1] << 8;
+		uint16_t high = value[i+2] | value[i+3] << 8;
+		if (low >= high) {
+			return false;
+		}
+	}
+	xSemaphoreTake(band_table_mutex, portMAX_DELAY);
+	memcpy(bands.table, value, len);
+	bands.count = len / BAND_LEN;
+	xSemaphoreGive(band_table_mutex);
+	return true;
+}
+/****************************************************************************************/
+
+static void load_band_table(void)
+{
+	uint8_t value[sizeof(bands.table)];
+	size_t len = sizeof(value);
+	nvs_handle handle;
+	bool is_loaded = false;
+	if (ESP_OK == nvs_open(BLE_BAND_TABLE_NVS_NAMESPACE, NVS_READONLY, &handle)) {
+		is_loaded = (ESP_OK == nvs_get_blob(handle, BLE_BAND_TABLE_NVS_KEY, value, &len)) &&
+				set_band_table(value, len);
+		nvs_close(handle);
+	}
+	if (!is_loaded) {
+		const uint16_t edges[] = BAND_DEFAULT_TABLE;
+		for (uint8_t i = 0; i < sizeof(edges) / sizeof(edges[0]); ++i) {
+			value[2*i] = (uint8_t)edges[i];
+			value[2*i + 1] = (uint8_t)(edges[i] >> 8);
+		}
+		set_band_table(value, sizeof(edges));
+	}
+}
+/****************************************************************************************/
+
+static void store_band_table(void)
+{
+	/* the table is copied, so the mutex is not held during the nvs write */
+	uint8_t value[sizeof(bands.table)];
+	xSemaphoreTake(band_table_mutex, portMAX_DELAY);
+	size_t len = bands.count * BAND_LEN;
+	memcpy(value, bands.table, len);
+	xSemaphoreGive(band_table_mutex);
+	nvs_handle handle;
+	esp_err_t result = nvs_open(BLE_BAND_TABLE_NVS_NAMESPACE, NVS_READWRITE, &handle);
+	if (ESP_OK == result) {
+		result = nvs_set_blob(handle, BLE_BAND_TABLE_NVS_KEY, value, len);
+		if (ESP_OK == result) {
+			result = nvs_commit(handle);
+		}
+		nvs_close(handle);
+	}
+	if (ESP_OK != result) {
+		ESP_LOGE(GATTS_TAG, "Band table not stored, error 0x%x", result);
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -8,10 +8,26 @@
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "stdint.h"
 #include "stdbool.h"
+#include "../threshold_exceeded_notification/threshold_exceeded_notification.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
+/** number of the envelope spectrum peaks served, each as the frequency in 0.1 Hz and the
+ * amplitude in 0.1 mg, both uint16 little endian, so all fit the default mtu **/
+#define BLE_ENVELOPE_PEAK_COUNT			(5)
+#define BLE_ENVELOPE_FREQUENCY_UNIT		(0.1f)
+#define BLE_ENVELOPE_AMPLITUDE_UNIT		(0.0001f)
+
+/** maximal number of the spectrum bands, the table is written as the lower and upper edge
+ * in Hz of every band, the feature vector is read as the rms of every band in mg, all
+ * uint16 little endian. The table of more than 4 bands needs the mtu above the default **/
+#define BLE_BAND_MAX					(8)
+#define BLE_BAND_RMS_UNIT				(0.001f)
+
+/** nvs entry keeping the band table over the restarts **/
+#define BLE_BAND_TABLE_NVS_NAMESPACE	"ble_comm"
+#define BLE_BAND_TABLE_NVS_KEY			"band_table"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global typedefs																		//
@@ -24,6 +40,18 @@ typedef union _calculated_val_rsp{
 	float float_type;
 } calculated_val_rsp;
 
+/** errors of the measurement which can not be taken, indicated on the trigger
+ * characteristic as the single byte, the finished calculation is indicated by the two
+ * bytes of the zero val **/
+typedef enum _ble_measurement_error{
+	/** the frequency, duration, decimation or oversampling is not supported **/
+	BLE_MEASUREMENT_ERROR_NOT_SUPPORTED = 1,
+	/** no calculation object is free **/
+	BLE_MEASUREMENT_ERROR_NO_MEMORY = 2,
+	/** the buffered measurement takes more than MEASUREMENT_MAX_SAMPLES **/
+	BLE_MEASUREMENT_ERROR_TOO_LONG = 3,
+} ble_measurement_error;
+
 /** enum determining values which available for the user through ble interface **/
 typedef enum _calculated_value{
 	RMS_VALUE = 0,
@@ -32,7 +60,18 @@ typedef enum _calculated_value{
 	MIN_VALUE = 3,
 	AMPLITUDE_VALUE = 4,
 	CREST_FACTOR_VALUE = 5,
-	MAX_CALCULATED_VALUES = 6
+	/** ac values about the measured mean, in g **/
+	AC_RMS_VALUE = 6,
+	PEAK_VALUE = 7,
+	PEAK_TO_PEAK_VALUE = 8,
+	AC_CREST_FACTOR_VALUE = 9,
+	/** vibration severity, velocity in mm/s and displacement in um **/
+	VELOCITY_RMS_VALUE = 10,
+	DISPLACEMENT_PEAK_TO_PEAK_VALUE = 11,
+	/** shape of the distribution of the samples, kurtosis is 3 for the gaussian noise **/
+	SKEWNESS_VALUE = 12,
+	KURTOSIS_VALUE = 13,
+	MAX_CALCULATED_VALUES = 14
 } calculated_value;
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -68,6 +107,21 @@ characteristic as a source of notification.
 \****************************************************************************************/
 void ble_communication_threshold_exceeded_notification_send(uint16_t exceeded_value);
 
+/****************************************************************************************\
+Function:
+ble_communication_threshold_alarm_notification_send
+******************************************************************************************
+Parameters:
+uint8_t level - level of the alarm, 0 normal, 1 warning, 2 alarm
+uint16_t rms - ac rms of the window in adc counts
+******************************************************************************************
+Abstract:
+This function sends the indication of the alarm level change with the threshold
+monitoring characteristic as a source, the version 2 byte is followed by the level and
+the big endian rms.
+\****************************************************************************************/
+void ble_communication_threshold_alarm_notification_send(uint8_t level, uint16_t rms);
+
 /****************************************************************************************\
 Function:
 ble_communication_update_calculated_value
@@ -82,6 +136,36 @@ calculated indicators. The stored values are accessible by the ble interface.
 \****************************************************************************************/
 void ble_communication_update_calculated_value(calculated_value type, float val);
 
+/****************************************************************************************\
+Function:
+ble_communication_update_envelope_peak
+******************************************************************************************
+Parameters:
+uint8_t index - position of the peak, 0 is the largest one
+float frequency - frequency of the peak in Hz
+float amplitude - amplitude of the peak in g
+******************************************************************************************
+Abstract:
+This function updates the peak of the envelope spectrum accessible by the ble interface.
+The values are saturated to the range of the characteristic, the index not lower than
+BLE_ENVELOPE_PEAK_COUNT is ignored.
+\****************************************************************************************/
+void ble_communication_update_envelope_peak(uint8_t index, float frequency, float amplitude);
+
+/****************************************************************************************\
+Function:
+ble_communication_update_band_rms
+******************************************************************************************
+Parameters:
+const float rms[] - rms of every band in g
+uint8_t count - number of the bands, at most BLE_BAND_MAX
+******************************************************************************************
+Abstract:
+This function updates the feature vector accessible by the ble interface. The values are
+saturated to the range of the characteristic.
+\****************************************************************************************/
+void ble_communication_update_band_rms(const float rms[], uint8_t count);
+
 /****************************************************************************************\
 Function:
 ble_communication_is_measurement_requested
@@ -95,6 +179,19 @@ returns true if yes or false if not.
 \****************************************************************************************/
 bool ble_communication_is_measurement_requested(void);
 
+/****************************************************************************************\
+Function:
+ble_communication_is_stream_measurement_requested
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns true if the requested measurement should run in the streaming
+mode, in which the samples are not stored.
+\****************************************************************************************/
+bool ble_communication_is_stream_measurement_requested(void);
+
 /****************************************************************************************\
 Function:
 ble_communication_get_requested_measurement_duration
@@ -119,6 +216,87 @@ This function returns the requested measurement frequency value.
 \****************************************************************************************/
 uint16_t ble_communication_get_requested_measurement_frequency(void);
 
+/****************************************************************************************\
+Function:
+ble_communication_get_requested_segment_size
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the requested welch segment size, 0 if the power spectral density
+was not requested.
+\****************************************************************************************/
+uint16_t ble_communication_get_requested_segment_size(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_requested_segment_overlap
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the requested overlap of the welch segments in percents.
+\****************************************************************************************/
+uint8_t ble_communication_get_requested_segment_overlap(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_requested_segment_window
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the requested window of the welch segments, 0 for Hann and 1 for
+flat top.
+\****************************************************************************************/
+uint8_t ble_communication_get_requested_segment_window(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_requested_decimation
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the requested decimation factor of the sampler, 0 if the
+measurement is taken without the decimation.
+\****************************************************************************************/
+uint8_t ble_communication_get_requested_decimation(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_requested_oversampling
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the requested oversampling factor of the sampler, 0 if the
+measurement is taken without the oversampling.
+\****************************************************************************************/
+uint8_t ble_communication_get_requested_oversampling(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_bands
+******************************************************************************************
+Parameters:
+uint16_t low[] - lower edges of the bands in Hz
+uint16_t high[] - upper edges of the bands in Hz
+uint8_t max_count - number of the bands the arrays hold
+******************************************************************************************
+Abstract:
+This function copies the edges of the table written by the client, or of the default one,
+and returns the number of the copied bands. The table is copied at once, so it is not
+mixed with the one written meanwhile. It is loaded from the nvs by
+ble_communication_init, which has to be called after nvs_flash_init.
+\****************************************************************************************/
+uint8_t ble_communication_get_bands(uint16_t low[], uint16_t high[], uint8_t max_count);
+
 /****************************************************************************************\
 Function:
 ble_communication_measurement_request_handled
@@ -137,25 +315,30 @@ ble_communication_update_time_measured_data
 ******************************************************************************************
 Parameters:
 uint16_t *data - pointer to the data which should be accessible with the ble interface
-uint16_t size - size of the data
+uint32_t size - size of the data
+uint16_t zero_val - zero value of the sensor used by the compressed stream encoding
 ******************************************************************************************
 Abstract:
 This function updates the time measured data inside the ble module.
 \****************************************************************************************/
-void ble_communication_update_time_measured_data(uint16_t *data, uint16_t size);
+void ble_communication_update_time_measured_data(uint16_t *data, uint32_t size,
+				uint16_t zero_val);
 
 /****************************************************************************************\
 Function:
 ble_communication_update_fft_data
 ******************************************************************************************
 Parameters:
-uint16_t *data - pointer to the data which should be accessible with the ble interface
-uint16_t size - size of the data
+uint16_t *data - pointer to the dB codes of the spectrum which should be accessible with
+the ble interface, NULL detaches the previous ones
+uint16_t size - number of the bins
 ******************************************************************************************
 Abstract:
-This function updates the fft data inside the ble module.
+This function updates the fft data inside the ble module. The data are guarded by the
+mutex of the time measured data, so they have to be detached before the spectrum is
+calculated again.
 \****************************************************************************************/
-void ble_communication_update_fft_data(uint8_t *data, uint16_t size);
+void ble_communication_update_fft_data(uint16_t *data, uint16_t size);
 
 /****************************************************************************************\
 Function:
@@ -169,6 +352,19 @@ This function sends notification to the user about data accessibility in the sen
 \****************************************************************************************/
 void ble_communication_calculation_completed_notification_send(uint16_t zero_val_offset);
 
+/****************************************************************************************\
+Function:
+ble_communication_measurement_failed_notification_send
+******************************************************************************************
+Parameters:
+ble_measurement_error error - reason of the failure
+******************************************************************************************
+Abstract:
+This function sends notification to the user that the requested measurement was not
+taken, in place of the one of the completed calculation.
+\****************************************************************************************/
+void ble_communication_measurement_failed_notification_send(ble_measurement_error error);
+
 /****************************************************************************************\
 Function:
 ble_communication_is_threshold_exceed_monitoring_requested
@@ -207,6 +403,45 @@ interface.
 \****************************************************************************************/
 uint16_t ble_communication_get_threshold_exceed_monitoring_val(void);
 
+/****************************************************************************************\
+Function:
+ble_communication_is_threshold_alarm_requested
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns true if the requested monitoring is the windowed rms alarm of the
+version 2 write, false for the peak threshold of the version 1 one.
+\****************************************************************************************/
+bool ble_communication_is_threshold_alarm_requested(void);
+
+/****************************************************************************************\
+Function:
+ble_communication_get_threshold_alarm_config
+******************************************************************************************
+Parameters:
+threshold_alarm_config *config - destination of the requested alarm configuration
+******************************************************************************************
+Abstract:
+This function returns the alarm configuration of the last version 2 write.
+\****************************************************************************************/
+void ble_communication_get_threshold_alarm_config(threshold_alarm_config *config);
+
+/****************************************************************************************\
+Function:
+ble_communication_stream_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This is the task sending the time measured data as notifications. It blocks until the
+client subscribes to the stream characteristic and then pushes all the frames back to
+back.
+\****************************************************************************************/
+void ble_communication_stream_task(void *pvParameter);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
 //////////////////////////////////////////////////////////////////////////////////////////
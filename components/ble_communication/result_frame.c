@@ -0,0 +1,167 @@
+/** result_frame.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "result_frame.h"
+#include <stddef.h>
+#include "../sample_codec/sample_codec.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+write_header
+******************************************************************************************
+Parameters:
+uint8_t frame[] - destination of the header
+uint32_t offset - index of the first element of the frame
+uint32_t count - number of elements in the frame
+uint32_t total_count - number of elements of the result
+uint8_t flags - bits added to the control byte
+******************************************************************************************
+Abstract:
+This function writes the control byte, the offset and the count into the frame.
+\****************************************************************************************/
+static void write_header(uint8_t frame[], uint32_t offset, uint32_t count,
+				uint32_t total_count, uint8_t flags);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint16_t result_frame_get_max_len(uint16_t mtu)
+{
+	return mtu - RESULT_FRAME_ATT_HEADER_LEN;
+}
+/****************************************************************************************/
+
+uint32_t result_frame_encode(uint8_t frame[], uint16_t *frame_len, const void *data,
+				uint8_t element_size, uint32_t total_count, uint32_t offset)
+{
+	uint32_t count = 0;
+	if ((NULL != data) && (offset < total_count)) {
+		count = total_count - offset;
+		uint32_t capacity = (*frame_len - RESULT_FRAME_HEADER_LEN) / element_size;
+		if (count > capacity) {
+			count = capacity;
+		}
+	}
+
+	write_header(frame, offset, count, total_count, 0);
+
+	uint8_t *payload = frame + RESULT_FRAME_HEADER_LEN;
+	if (sizeof(uint16_t) == element_size) {
+		const uint16_t *elements = (const uint16_t *)data + offset;
+		for (uint32_t i = 0; i < count; ++i) {
+			payload[2 * i] = (uint8_t)(elements[i]);
+			payload[2 * i + 1] = (uint8_t)(elements[i] >> 8);
+		}
+	} else {
+		const uint8_t *elements = (const uint8_t *)data + offset;
+		for (uint32_t i = 0; i < count; ++i) {
+			payload[i] = elements[i];
+		}
+	}
+
+	*frame_len = RESULT_FRAME_HEADER_LEN + count * element_size;
+	return count;
+}
+/****************************************************************************************/
+
+uint32_t result_frame_encode_compressed(uint8_t frame[], uint16_t *frame_len,
+				const uint16_t data[], uint32_t total_count, uint32_t offset, uint16_t zero_val)
+{
+	uint8_t *payload = frame + RESULT_FRAME_HEADER_LEN;
+	uint32_t payload_len = *frame_len - RESULT_FRAME_HEADER_LEN - RESULT_FRAME_ZERO_VAL_LEN;
+	uint32_t count = 0;
+	if ((NULL != data) && (offset < total_count)) {
+		uint32_t remaining = total_count - offset;
+		/** count field of the header limits the samples of one frame **/
+		if (remaining > UINT16_MAX) {
+			remaining = UINT16_MAX;
+		}
+		count = sample_codec_encode(data + offset, remaining, zero_val,
+				payload + RESULT_FRAME_ZERO_VAL_LEN, &payload_len);
+	} else {
+		payload_len = 0;
+	}
+
+	write_header(frame, offset, count, total_count, RESULT_FRAME_COMPRESSED_FLAG);
+	payload[0] = (uint8_t)(zero_val);
+	payload[1] = (uint8_t)(zero_val >> 8);
+
+	*frame_len = RESULT_FRAME_HEADER_LEN + RESULT_FRAME_ZERO_VAL_LEN + payload_len;
+	return count;
+}
+/****************************************************************************************/
+
+const uint8_t * result_frame_decode(const uint8_t frame[], uint16_t frame_len,
+				uint8_t element_size, result_frame_header *header)
+{
+	if (frame_len < RESULT_FRAME_HEADER_LEN) {
+		return NULL;
+	}
+	header->is_compressed = (frame[0] & RESULT_FRAME_COMPRESSED_FLAG) ? true : false;
+	header->is_aborted = (frame[0] & RESULT_FRAME_ABORTED_FLAG) ? true : false;
+	header->control = (result_frame_control)(frame[0] &
+			~(RESULT_FRAME_COMPRESSED_FLAG | RESULT_FRAME_ABORTED_FLAG));
+	header->offset = (uint32_t)frame[1] | ((uint32_t)frame[2] << 8) |
+			((uint32_t)frame[3] << 16) | ((uint32_t)frame[4] << 24);
+	header->count = (uint16_t)(frame[5] | (frame[6] << 8));
+	if ((header->control < RESULT_FRAME_FIRST) || (header->control > RESULT_FRAME_NO_MORE)) {
+		return NULL;
+	}
+	if (header->is_aborted && ((RESULT_FRAME_NO_MORE != header->control) ||
+			(0 != header->count))) {
+		return NULL;
+	}
+	if (header->is_compressed) {
+		if (frame_len < RESULT_FRAME_HEADER_LEN + RESULT_FRAME_ZERO_VAL_LEN) {
+			return NULL;
+		}
+	} else if (RESULT_FRAME_HEADER_LEN + (uint32_t)header->count * element_size != frame_len) {
+		return NULL;
+	}
+	return frame + RESULT_FRAME_HEADER_LEN;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void write_header(uint8_t frame[], uint32_t offset, uint32_t count,
+				uint32_t total_count, uint8_t flags)
+{
+	if (offset + count >= total_count) {
+		frame[0] = RESULT_FRAME_NO_MORE | flags;
+	} else if (0 == offset) {
+		frame[0] = RESULT_FRAME_FIRST | flags;
+	} else {
+		frame[0] = RESULT_FRAME_MORE | flags;
+	}
+	frame[1] = (uint8_t)(offset);
+	frame[2] = (uint8_t)(offset >> 8);
+	frame[3] = (uint8_t)(offset >> 16);
+	frame[4] = (uint8_t)(offset >> 24);
+	frame[5] = (uint8_t)(count);
+	frame[6] = (uint8_t)(count >> 8);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,132 @@
+/** result_frame.h **/
+
+#ifndef COMPONENTS_BLE_COMMUNICATION_RESULT_FRAME_H_
+#define COMPONENTS_BLE_COMMUNICATION_RESULT_FRAME_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** frame header: control byte, little endian uint32 offset and uint16 count of elements **/
+#define RESULT_FRAME_HEADER_LEN		(7)
+/** att header taken from the mtu by the read response and the notification **/
+#define RESULT_FRAME_ATT_HEADER_LEN	(3)
+/** bit of the control byte marking the payload encoded with the sample codec **/
+#define RESULT_FRAME_COMPRESSED_FLAG	(0x80)
+/** bit of the no more control byte ending the stream early, the result was replaced **/
+#define RESULT_FRAME_ABORTED_FLAG	(0x40)
+/** compressed payload starts with the little endian zero value used by the codec **/
+#define RESULT_FRAME_ZERO_VAL_LEN	(2)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** enum determining the control byte of the frame **/
+typedef enum{
+	RESULT_FRAME_FIRST = 0x01,
+	RESULT_FRAME_MORE = 0x02,
+	RESULT_FRAME_NO_MORE = 0x03
+} result_frame_control;
+
+/** decoded header of the frame **/
+typedef struct _result_frame_header{
+	result_frame_control control;
+	uint32_t offset;
+	uint16_t count;
+	bool is_compressed;
+	bool is_aborted;
+} result_frame_header;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+result_frame_get_max_len
+******************************************************************************************
+Parameters:
+uint16_t mtu - mtu negotiated for the connection
+******************************************************************************************
+Abstract:
+This function returns the length of the frame which fits into a single att packet.
+\****************************************************************************************/
+uint16_t result_frame_get_max_len(uint16_t mtu);
+
+/****************************************************************************************\
+Function:
+result_frame_encode
+******************************************************************************************
+Parameters:
+uint8_t frame[] - destination of the frame
+uint16_t *frame_len - maximal length of the frame on input, length of the encoded frame
+on output
+const void *data - all the elements of the result
+uint8_t element_size - size of one element in bytes, 1 or 2
+uint32_t total_count - number of elements of the result
+uint32_t offset - index of the first element to be put into the frame
+******************************************************************************************
+Abstract:
+This function encodes as many elements starting at the offset as fit into the frame. The
+elements are stored little endian. It returns the number of encoded elements, the next
+frame starts at the offset increased by this number. The last frame is marked with the
+no more control byte, also when it is the first one.
+\****************************************************************************************/
+uint32_t result_frame_encode(uint8_t frame[], uint16_t *frame_len, const void *data,
+				uint8_t element_size, uint32_t total_count, uint32_t offset);
+
+/****************************************************************************************\
+Function:
+result_frame_encode_compressed
+******************************************************************************************
+Parameters:
+uint8_t frame[] - destination of the frame
+uint16_t *frame_len - maximal length of the frame on input, length of the encoded frame
+on output
+const uint16_t data[] - all the samples of the result
+uint32_t total_count - number of samples of the result
+uint32_t offset - index of the first sample to be put into the frame
+uint16_t zero_val - zero value of the sensor used for the prediction of the first sample
+******************************************************************************************
+Abstract:
+This function works as result_frame_encode, but the payload is compressed with the
+sample codec. The zero value is stored in the frame, so every frame can be decoded on
+its own. It returns the number of encoded samples.
+\****************************************************************************************/
+uint32_t result_frame_encode_compressed(uint8_t frame[], uint16_t *frame_len,
+				const uint16_t data[], uint32_t total_count, uint32_t offset, uint16_t zero_val);
+
+/****************************************************************************************\
+Function:
+result_frame_decode
+******************************************************************************************
+Parameters:
+const uint8_t frame[] - received frame
+uint16_t frame_len - length of the received frame
+uint8_t element_size - size of one element in bytes
+result_frame_header *header - destination of the decoded header
+******************************************************************************************
+Abstract:
+This function decodes the header of the frame. It returns pointer to the first element
+of the payload or NULL if the frame is malformed. The payload of the compressed frame
+starts with the zero value followed by the codec bytes. The aborted flag is accepted on
+the empty no more frame only.
+\****************************************************************************************/
+const uint8_t * result_frame_decode(const uint8_t frame[], uint16_t frame_len,
+				uint8_t element_size, result_frame_header *header);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_BLE_COMMUNICATION_RESULT_FRAME_H_ */
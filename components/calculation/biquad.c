@@ -0,0 +1,49 @@
+/** biquad.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "biquad.h"
+#include <math.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define BIQUAD_PI					(3.14159265358979f)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void biquad_set(biquad *section, float b0, float b1, float b2, float a1, float a2)
+{
+	section->b0 = b0;
+	section->b1 = b1;
+	section->b2 = b2;
+	section->a1 = a1;
+	section->a2 = a2;
+	section->z1 = 0;
+	section->z2 = 0;
+}
+/****************************************************************************************/
+
+void biquad_set_low_pass(biquad *section, float frequency, float sampling_frequency)
+{
+	float k = tanf(BIQUAD_PI * frequency / sampling_frequency);
+	float norm = 1 / (1 + k / BIQUAD_BUTTERWORTH_Q + k * k);
+	biquad_set(section, k * k * norm, 2 * k * k * norm, k * k * norm,
+			2 * (k * k - 1) * norm, (1 - k / BIQUAD_BUTTERWORTH_Q + k * k) * norm);
+}
+/****************************************************************************************/
+
+void biquad_set_high_pass(biquad *section, float frequency, float sampling_frequency)
+{
+	float k = tanf(BIQUAD_PI * frequency / sampling_frequency);
+	float norm = 1 / (1 + k / BIQUAD_BUTTERWORTH_Q + k * k);
+	biquad_set(section, norm, -2 * norm, norm,
+			2 * (k * k - 1) * norm, (1 - k / BIQUAD_BUTTERWORTH_Q + k * k) * norm);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
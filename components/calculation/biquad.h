@@ -0,0 +1,107 @@
+/** biquad.h **/
+
+#ifndef COMPONENTS_CALCULATION_BIQUAD_H_
+#define COMPONENTS_CALCULATION_BIQUAD_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** quality factor of the second order butterworth sections **/
+#define BIQUAD_BUTTERWORTH_Q		(0.70710678f)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** second order section in the transposed direct form II **/
+typedef struct {
+	float b0;
+	float b1;
+	float b2;
+	float a1;
+	float a2;
+	float z1;
+	float z2;
+} biquad;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+biquad_set
+******************************************************************************************
+Parameters:
+biquad *section - section to be initialized
+float b0, b1, b2, a1, a2 - coefficients, a0 normalized to 1
+******************************************************************************************
+Abstract:
+This function sets the coefficients of the section and clears its state.
+\****************************************************************************************/
+void biquad_set(biquad *section, float b0, float b1, float b2, float a1, float a2);
+
+/****************************************************************************************\
+Function:
+biquad_set_low_pass
+******************************************************************************************
+Parameters:
+biquad *section - section to be initialized
+float frequency - corner frequency
+float sampling_frequency - sampling frequency
+******************************************************************************************
+Abstract:
+This function designs the second order butterworth low pass by the bilinear transform
+prewarped at the corner.
+\****************************************************************************************/
+void biquad_set_low_pass(biquad *section, float frequency, float sampling_frequency);
+
+/****************************************************************************************\
+Function:
+biquad_set_high_pass
+******************************************************************************************
+Parameters:
+biquad *section - section to be initialized
+float frequency - corner frequency
+float sampling_frequency - sampling frequency
+******************************************************************************************
+Abstract:
+This function designs the second order butterworth high pass by the bilinear transform
+prewarped at the corner.
+\****************************************************************************************/
+void biquad_set_high_pass(biquad *section, float frequency, float sampling_frequency);
+
+/****************************************************************************************\
+Function:
+biquad_process
+******************************************************************************************
+Parameters:
+biquad *section - section processing the sample
+float x - input sample
+******************************************************************************************
+Abstract:
+This function returns the next output of the section. It is defined here, so the per
+sample loops of the other modules can inline it.
+\****************************************************************************************/
+static inline float biquad_process(biquad *section, float x)
+{
+	float y = section->b0 * x + section->z1;
+	section->z1 = section->b1 * x - section->a1 * y + section->z2;
+	section->z2 = section->b2 * x - section->a2 * y;
+	return y;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* COMPONENTS_CALCULATION_BIQUAD_H_ */
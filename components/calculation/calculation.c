@@ -2,9 +2,13 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "calculation.h"
+#include "spectrum.h"
+#include "integration.h"
+#include "envelope.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/queue.h"
 #include <math.h>
+#include <stdbool.h>
 #include <stdlib.h>
 #include <string.h>
 #include "freertos/task.h"
@@ -13,37 +17,114 @@
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
-#define CALC_FINISH_RMS_FLAG		((uint8_t)0x1<<0)
-#define CALC_FINISH_AVERAGE_FLAG	((uint8_t)0x1<<1)
-#define CALC_FINISH_RANGE_FLAG		((uint8_t)0x1<<2)
-#define CALC_FINISH_AMPLITUDE_FLAG	((uint8_t)0x1<<3)
-#define CALC_FINISH_CREST_FLAG		((uint8_t)0x1<<4)
-#define is_calc_finished(x)			((0x1f) == x ? CALCULATION_FINISHED : CALCULATION_IN_PROGRESS)
+/** depth of the queue passing objects to the calculation task **/
+#define CALCULATION_QUEUE_LENGTH	((uint8_t)1)
+/** number of samples taken from the block source at once **/
+#define CALCULATION_STREAM_BLOCK_LEN	((uint32_t)256)
+/** number of samples whose exact integer power sums are taken at once, the sum of the
+ * cubes of 16 bit deviations fits 64 bits, the sum of the fourth powers keeps the carries
+ * out of 64 bits. The float build merges them into the central moments, the fixed point
+ * one adds them to the wide sums of the capture **/
+#define CALCULATION_MOMENT_BLOCK_LEN	((uint32_t)256)
+/** number of the objects which exist at once, the controller deletes the finished object
+ * before it creates the next one **/
+#define CALCULATION_OBJ_POOL_LEN		((uint8_t)2)
+/** overlap in percents of the Hann segments averaged for the band features when no power
+ * spectral density is requested **/
+#define CALCULATION_BAND_OVERLAP		((uint8_t)50)
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Local typedefs																		//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+/** type of the non integer factors **/
+#if CALCULATION_FIXED_POINT
+typedef uint32_t calculation_real;
+#else
+typedef float calculation_real;
+#endif
+
+#if CALCULATION_FIXED_POINT
+/** signed 128 bit sum kept in two words, the target has no wider integer type **/
+typedef struct {
+	uint64_t low;
+	int64_t high;
+} wide_sum;
+#endif
+
+/** running sums collected by the single pass statistics kernel, the second to fourth
+ * central moments are the sums of the powers of the deviations from the mean. The fixed
+ * point build keeps the exact power sums of the deviations from the shift of the whole
+ * capture instead and turns them to the moments once, in the finalize **/
+typedef struct {
+	uint32_t count;
+	uint64_t sum;
+	uint64_t sum_of_squares;
+	uint16_t max_val;
+	uint16_t min_val;
+	uint16_t shift;
+#if CALCULATION_FIXED_POINT
+	int64_t sum_of_deviations;
+	uint64_t sum_of_deviation_squares;
+	wide_sum sum_of_deviation_cubes;
+	wide_sum sum_of_deviation_fourth_powers;
+#else
+	double mean;
+	double moment2;
+	double moment3;
+	double moment4;
+#endif
+} statistics_accumulator;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
 
 /** obj structure implementation hidden under handle **/
 struct Calculation_obj {
-	uint16_t size;
-	float rms;
-	float average;
+	uint32_t size;
+	calculation_real rms;
+	calculation_real average;
 	uint16_t max_val;
 	uint16_t min_val;
 	uint16_t amplitude;
-	float crest_factor;
+	calculation_real crest_factor;
+	calculation_real ac_rms;
+	calculation_real peak;
+	calculation_real peak_to_peak;
+	calculation_real ac_crest_factor;
+	calculation_real velocity_rms;
+	calculation_real displacement_peak_to_peak;
+	calculation_real skewness;
+	calculation_real kurtosis;
+	envelope_peak envelope_peaks[ENVELOPE_PEAK_COUNT];
+	float band_rms[CALCULATION_MAX_BANDS];
+	uint16_t frequency;
 	calculation_state state;
-	uint8_t finish_flags;
 	uint16_t * data;
+	calculation_block_source source;
+	calculation_psd_config psd;
+	calculation_band_config band_config;
+	bool is_allocated;
 };
 
-/** queues handles for calculation tasks **/
-static QueueHandle_t xQueue_rms, xQueue_average, xQueue_range, xQueue_amplitude, xQueue_crest_factor;
+/** objects are taken from the pool reserved at boot, so the cycles do not use the heap **/
+static struct Calculation_obj obj_pool[CALCULATION_OBJ_POOL_LEN];
+
+/** queue handle passing objects to the calculation task **/
+static QueueHandle_t xQueue_calculation = NULL;
+
+/** g per adc count, Q15 in the fixed point build, the integration and the envelope take it
+ * in float **/
+#if CALCULATION_FIXED_POINT
+static uint32_t sensitivity = (uint32_t)(CALCULATION_DEFAULT_SENSITIVITY * CALCULATION_Q15_ONE);
+#else
+static float sensitivity = CALCULATION_DEFAULT_SENSITIVITY;
+#endif
+static float float_sensitivity = CALCULATION_DEFAULT_SENSITIVITY;
+
+/** block taken from the source of the streamed objects **/
+static uint16_t stream_block[CALCULATION_STREAM_BLOCK_LEN];
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static functions prototypes															//
@@ -51,38 +132,230 @@ static QueueHandle_t xQueue_rms, xQueue_average, xQueue_range, xQueue_amplitude,
 
 /****************************************************************************************\
 Function:
-sum_array
+accumulator_reset
+******************************************************************************************
+Parameters:
+statistics_accumulator *acc - accumulator to be reset
+******************************************************************************************
+Abstract:
+This function clears the running sums of the accumulator.
+\****************************************************************************************/
+static void accumulator_reset(statistics_accumulator *acc);
+
+/****************************************************************************************\
+Function:
+accumulator_update
+******************************************************************************************
+Parameters:
+statistics_accumulator *acc - accumulator to be updated
+const uint16_t data[] - pointer to the block of samples
+uint32_t size - number of samples in the block
+******************************************************************************************
+Abstract:
+This function walks the block once and updates sum, sum of squares, min and max and the
+power sums of the deviations at the same time, so every sample is loaded from memory
+only once.
+\****************************************************************************************/
+static void accumulator_update(statistics_accumulator *acc, const uint16_t data[],
+				uint32_t size);
+
+/****************************************************************************************\
+Function:
+central_moments
+******************************************************************************************
+Parameters:
+uint32_t count - number of the samples
+double sum1, sum2, sum3, sum4 - sums of the powers of the deviations from the shift
+double moments[3] - second to fourth central moments
+******************************************************************************************
+Abstract:
+This function turns the power sums of the deviations from any shift into the sums of the
+powers of the deviations from the mean.
+\****************************************************************************************/
+static void central_moments(uint32_t count, double sum1, double sum2, double sum3,
+				double sum4, double moments[3]);
+
+#if !CALCULATION_FIXED_POINT
+/****************************************************************************************\
+Function:
+accumulator_merge_moments
+******************************************************************************************
+Parameters:
+statistics_accumulator *acc - accumulator to be updated
+uint32_t count - number of samples of the block
+int64_t sum1, sum2, sum3 - exact sums of the powers of the block deviations from
+	acc->shift
+double sum4 - sum of the fourth powers of the deviations, wider than 64 bits
+******************************************************************************************
+Abstract:
+This function turns the power sums of the block into its central moments and merges them
+into the moments of the accumulator by the pairwise update of Chan and Terriberry. The
+shift follows the rounded mean, so the deviations stay small and the conversion of the
+block sums does not cancel.
+\****************************************************************************************/
+static void accumulator_merge_moments(statistics_accumulator *acc, uint32_t count,
+				int64_t sum1, int64_t sum2, int64_t sum3, double sum4);
+#endif
+
+/****************************************************************************************\
+Function:
+accumulator_finalize
+******************************************************************************************
+Parameters:
+const statistics_accumulator *acc - accumulator holding the running sums
+Calculation_obj_handle obj - handle to object where the factors are stored
+******************************************************************************************
+Abstract:
+This function derives all the factors of the obj from the running sums. The ac factors
+are taken about the mean, so the dc bias of the sensor does not enter them.
+\****************************************************************************************/
+static void accumulator_finalize(const statistics_accumulator *acc,
+				Calculation_obj_handle obj);
+
+#if CALCULATION_FIXED_POINT
+/****************************************************************************************\
+Function:
+wide_sum_add
+******************************************************************************************
+Parameters:
+wide_sum *sum - sum to be updated
+int64_t high - upper word of the added value
+uint64_t low - lower word of the added value
+******************************************************************************************
+Abstract:
+This function adds the 128 bit value to the sum, the carry of the lower words goes to
+the upper one.
+\****************************************************************************************/
+static void wide_sum_add(wide_sum *sum, int64_t high, uint64_t low);
+
+/****************************************************************************************\
+Function:
+wide_sum_to_double
 ******************************************************************************************
 Parameters:
-uint16_t data[] - pointer to data array which will be summed
-uint16_t size - size of data
+const wide_sum *sum - sum to be converted
 ******************************************************************************************
 Abstract:
-This function sums all the elements of the data array.
+This function returns the sum as double. The sum fitting 64 bits is converted from one
+word, so the words of the small negative sum do not cancel.
 \****************************************************************************************/
-static uint32_t sum_array(uint16_t data[], uint16_t size);
+static double wide_sum_to_double(const wide_sum *sum);
+
+/****************************************************************************************\
+Function:
+square_root
+******************************************************************************************
+Parameters:
+uint64_t value - radicand
+******************************************************************************************
+Abstract:
+This function returns the integer square root of the value rounded down. It is computed
+bit by bit with shifts and subtractions only.
+\****************************************************************************************/
+static uint32_t square_root(uint64_t value);
+
+/****************************************************************************************\
+Function:
+float_to_q15
+******************************************************************************************
+Parameters:
+float value - non negative value
+******************************************************************************************
+Abstract:
+This function converts the result of the float integration stage to Q15, saturated at
+the largest Q15 value.
+\****************************************************************************************/
+static uint32_t float_to_q15(float value);
+
+/****************************************************************************************\
+Function:
+float_to_signed_q15
+******************************************************************************************
+Parameters:
+float value - value of any sign
+******************************************************************************************
+Abstract:
+This function converts the signed factor to Q15 stored as int32 in the bits of the
+unsigned fixed point factor, saturated at the int32 range.
+\****************************************************************************************/
+static uint32_t float_to_signed_q15(float value);
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global functions definitions															//
 //////////////////////////////////////////////////////////////////////////////////////////
 
-Calculation_obj_handle calculation_new_obj(uint16_t data[], uint16_t size)
+void calculation_init(void)
+{
+	if (NULL == xQueue_calculation) {
+		xQueue_calculation = xQueueCreate(CALCULATION_QUEUE_LENGTH,
+						sizeof(Calculation_obj_handle));
+	}
+	spectrum_init();
+}
+/****************************************************************************************/
+
+void calculation_set_sensitivity(float g_per_count)
+{
+#if CALCULATION_FIXED_POINT
+	sensitivity = (uint32_t)(g_per_count * CALCULATION_Q15_ONE + 0.5f);
+#else
+	sensitivity = g_per_count;
+#endif
+	float_sensitivity = g_per_count;
+}
+/****************************************************************************************/
+
+Calculation_obj_handle calculation_new_obj(uint16_t data[], uint32_t size)
+{
+	for (uint8_t i = 0; i < CALCULATION_OBJ_POOL_LEN; ++i) {
+		struct Calculation_obj * instance = &obj_pool[i];
+		if (!instance->is_allocated) {
+			memset(instance, 0, sizeof(struct Calculation_obj));
+			instance->data = data;
+			instance->size = size;
+			instance->state = CALCULATION_INITIALIZED;
+			instance->is_allocated = true;
+			return instance;
+		}
+	}
+	return NULL;
+}
+/****************************************************************************************/
+
+Calculation_obj_handle calculation_new_stream_obj(calculation_block_source source)
 {
-	struct Calculation_obj * instance = malloc(sizeof(struct Calculation_obj));
-	instance->data = data;
-	instance->size = size;
-	instance->state = CALCULATION_INITIALIZED;
-	instance->finish_flags = 0;
-	xQueue_rms = xQueueCreate(1, sizeof(Calculation_obj_handle));
-	xQueue_average = xQueueCreate(1, sizeof(Calculation_obj_handle));
-	xQueue_range = xQueueCreate(1, sizeof(Calculation_obj_handle));
-	xQueue_amplitude = xQueueCreate(1, sizeof(Calculation_obj_handle));
-	xQueue_crest_factor = xQueueCreate(1, sizeof(Calculation_obj_handle));
+	Calculation_obj_handle instance = calculation_new_obj(NULL, 0);
+	if (NULL != instance) {
+		instance->source = source;
+	}
 	return instance;
 }
 /****************************************************************************************/
 
-uint16_t calculation_get_size(Calculation_obj_handle obj)
+void calculation_set_psd_config(Calculation_obj_handle obj, const calculation_psd_config *config)
+{
+	obj->psd = *config;
+}
+/****************************************************************************************/
+
+void calculation_set_band_config(Calculation_obj_handle obj,
+				const calculation_band_config *config)
+{
+	obj->band_config = *config;
+	if (obj->band_config.count > CALCULATION_MAX_BANDS) {
+		obj->band_config.count = CALCULATION_MAX_BANDS;
+	}
+}
+/****************************************************************************************/
+
+void calculation_set_frequency(Calculation_obj_handle obj, uint16_t frequency)
+{
+	obj->frequency = frequency;
+}
+/****************************************************************************************/
+
+uint32_t calculation_get_size(Calculation_obj_handle obj)
 {
 	return obj->size;
 }
@@ -96,26 +369,8 @@ uint16_t * calculation_get_data_ptr(Calculation_obj_handle obj)
 
 void calculation_calculate_factors(Calculation_obj_handle obj)
 {
-	xQueueSend(xQueue_rms, (void *)&obj, 0);
-	xQueueSend(xQueue_average, (void *)&obj, 0);
-	xQueueSend(xQueue_range, (void *)&obj, 0);
-	xQueueSend(xQueue_amplitude, (void *)&obj, 0);
-	xQueueSend(xQueue_crest_factor, (void *)&obj, 0);
-
-	while(xQueue_rms == 0 ||
-			xQueue_average == 0 ||
-			xQueue_range == 0 ||
-			xQueue_amplitude == 0 ||
-			xQueue_crest_factor == 0){
-
-	}
-
-	vTaskResume(get_task_handle(CALCULATION_RMS_TASK_HANDLE));
-	vTaskResume(get_task_handle(CALCULATION_AVERAGE_TASK_HANDLE));
-	vTaskResume(get_task_handle(CALCULATION_RANGE_TASK_HANDLE));
-	vTaskResume(get_task_handle(CALCULATION_AMPLITUDE_TASK_HANDLE));
-	vTaskResume(get_task_handle(CALCULATION_CREST_FACTOR_TASK_HANDLE));
-
+	obj->state = CALCULATION_IN_PROGRESS;
+	xQueueSend(xQueue_calculation, (void *)&obj, portMAX_DELAY);
 }
 /****************************************************************************************/
 
@@ -140,6 +395,30 @@ calculation_factor_type calculation_get_factor(Calculation_obj_handle obj, calcu
 	case CALCULATION_CREST_FACTOR:
 		return (calculation_factor_type)obj->crest_factor;
 		break;
+	case CALCULATION_AC_RMS:
+		return (calculation_factor_type)obj->ac_rms;
+		break;
+	case CALCULATION_PEAK:
+		return (calculation_factor_type)obj->peak;
+		break;
+	case CALCULATION_PEAK_TO_PEAK:
+		return (calculation_factor_type)obj->peak_to_peak;
+		break;
+	case CALCULATION_AC_CREST_FACTOR:
+		return (calculation_factor_type)obj->ac_crest_factor;
+		break;
+	case CALCULATION_VELOCITY_RMS:
+		return (calculation_factor_type)obj->velocity_rms;
+		break;
+	case CALCULATION_DISPLACEMENT_PEAK_TO_PEAK:
+		return (calculation_factor_type)obj->displacement_peak_to_peak;
+		break;
+	case CALCULATION_SKEWNESS:
+		return (calculation_factor_type)obj->skewness;
+		break;
+	case CALCULATION_KURTOSIS:
+		return (calculation_factor_type)obj->kurtosis;
+		break;
 	default:
 		return (calculation_factor_type)(uint16_t)0;
 		break;
@@ -147,6 +426,24 @@ calculation_factor_type calculation_get_factor(Calculation_obj_handle obj, calcu
 }
 /****************************************************************************************/
 
+const envelope_peak * calculation_get_envelope_peaks(Calculation_obj_handle obj)
+{
+	return obj->envelope_peaks;
+}
+/****************************************************************************************/
+
+const float * calculation_get_band_rms(Calculation_obj_handle obj)
+{
+	return obj->band_rms;
+}
+/****************************************************************************************/
+
+uint8_t calculation_get_band_count(Calculation_obj_handle obj)
+{
+	return obj->band_config.count;
+}
+/****************************************************************************************/
+
 calculation_state calculation_get_state(Calculation_obj_handle obj)
 {
 	return obj == NULL ? CALCULATION_NOT_INITIALIZED : obj->state;
@@ -155,121 +452,396 @@ calculation_state calculation_get_state(Calculation_obj_handle obj)
 
 void calculation_delete_obj(Calculation_obj_handle * obj)
 {
-	vQueueDelete(xQueue_rms);
-	vQueueDelete(xQueue_average);
-	vQueueDelete(xQueue_range);
-	vQueueDelete(xQueue_amplitude);
-	vQueueDelete(xQueue_crest_factor);
-	free(*obj);
+	if (NULL != *obj) {
+		(*obj)->is_allocated = false;
+	}
 	*obj = NULL;
 }
 /****************************************************************************************/
 
-void calculation_rms(void *pvParameter)
+void calculation_task(void *pvParameter)
 {
 	while(true){
 		Calculation_obj_handle obj;
-			if(xQueue_rms != 0 && xQueueReceive(xQueue_rms, &obj, 0)){
-			float sum = 0;
-			for (int16_t iterator = (obj->size - 1); iterator >= 0; --iterator) {
-				sum += pow((obj->data[iterator]), 2.0);
-				vTaskDelay(1 / portTICK_PERIOD_MS);
+		if(xQueueReceive(xQueue_calculation, &obj, portMAX_DELAY)){
+			statistics_accumulator acc;
+			accumulator_reset(&acc);
+			bool is_psd = (0 != obj->psd.segment_size) &&
+					(0 != spectrum_welch_start(obj->psd.segment_size, obj->psd.overlap,
+							(spectrum_window)obj->psd.window, obj->psd.frequency));
+			/* without the psd the band features are averaged over the segments of the
+			 * whole capture of the largest transform size, not taken from the one
+			 * transform of the amplitude spectrum */
+			bool is_band_welch = !is_psd && (0 != obj->band_config.count) &&
+					(0 != spectrum_welch_start((NULL != obj->data) ? obj->size :
+							SPECTRUM_MAX_FFT_SIZE, CALCULATION_BAND_OVERLAP,
+							SPECTRUM_WINDOW_HANN, obj->frequency));
+			bool is_integration = (0 != obj->frequency) &&
+					integration_start(obj->frequency, float_sensitivity);
+			bool is_envelope = (0 != obj->frequency) &&
+					envelope_start(obj->frequency, float_sensitivity);
+			if (NULL != obj->source) {
+				uint32_t block_size;
+				while (0 != (block_size = obj->source(stream_block,
+								CALCULATION_STREAM_BLOCK_LEN))) {
+					accumulator_update(&acc, stream_block, block_size);
+					if (is_psd || is_band_welch) {
+						spectrum_welch_feed(stream_block, block_size);
+					}
+					if (is_integration) {
+						integration_feed(stream_block, block_size);
+					}
+					if (is_envelope) {
+						envelope_feed(stream_block, block_size);
+					}
+				}
+				obj->size = acc.count;
+			} else {
+				accumulator_update(&acc, obj->data, obj->size);
+				if (is_psd || is_band_welch) {
+					spectrum_welch_feed(obj->data, obj->size);
+				}
+				if (is_integration) {
+					integration_feed(obj->data, obj->size);
+				}
+				if (is_envelope) {
+					envelope_feed(obj->data, obj->size);
+				}
+			}
+			if (is_psd) {
+				spectrum_welch_finish();
+			} else {
+				/* streamed samples are not kept, so the stream obj gets no spectrum */
+				spectrum_calculate(obj->data, (NULL != obj->data) ? obj->size : 0);
+				if (is_band_welch) {
+					spectrum_welch_finish_bands();
+				}
 			}
-			obj->rms = sqrt(sum/obj->size);
-			obj->finish_flags |= CALC_FINISH_RMS_FLAG;
-			obj->state = is_calc_finished(obj->finish_flags);
+			for (uint8_t i = 0; i < obj->band_config.count; ++i) {
+				const calculation_band *band = &obj->band_config.bands[i];
+				obj->band_rms[i] = sqrtf(spectrum_band_mean_square(band->low, band->high,
+						obj->frequency)) * float_sensitivity;
+			}
+			if (is_integration) {
+				float velocity_rms;
+				float displacement_peak_to_peak;
+				integration_finish(&velocity_rms, &displacement_peak_to_peak);
+#if CALCULATION_FIXED_POINT
+				obj->velocity_rms = float_to_q15(velocity_rms);
+				obj->displacement_peak_to_peak = float_to_q15(displacement_peak_to_peak);
+#else
+				obj->velocity_rms = velocity_rms;
+				obj->displacement_peak_to_peak = displacement_peak_to_peak;
+#endif
+			}
+			if (is_envelope) {
+				envelope_finish(obj->envelope_peaks);
+			}
+			accumulator_finalize(&acc, obj);
+			obj->state = CALCULATION_FINISHED;
+			controller_event_post(CALCULATION_FINISHED_EVENT);
 		}
-		vTaskSuspend(NULL);
 	}
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void accumulator_reset(statistics_accumulator *acc)
+{
+	acc->count = 0;
+	acc->sum = 0;
+	acc->sum_of_squares = 0;
+	acc->max_val = 0;
+	acc->min_val = UINT16_MAX;
+	acc->shift = 0;
+#if CALCULATION_FIXED_POINT
+	acc->sum_of_deviations = 0;
+	acc->sum_of_deviation_squares = 0;
+	acc->sum_of_deviation_cubes.low = 0;
+	acc->sum_of_deviation_cubes.high = 0;
+	acc->sum_of_deviation_fourth_powers.low = 0;
+	acc->sum_of_deviation_fourth_powers.high = 0;
+#else
+	acc->mean = 0;
+	acc->moment2 = 0;
+	acc->moment3 = 0;
+	acc->moment4 = 0;
+#endif
+}
 /****************************************************************************************/
 
-void calculation_average(void *pvParameter)
+static void accumulator_update(statistics_accumulator *acc, const uint16_t data[],
+				uint32_t size)
 {
-	while(true){
-		Calculation_obj_handle obj;
-		if(xQueue_average != 0 && xQueueReceive(xQueue_average, &obj, 0)){
-			uint32_t sum = sum_array(obj->data, obj->size);
-			obj->average = sum/obj->size;
-			obj->finish_flags |= CALC_FINISH_AVERAGE_FLAG;
-			obj->state = is_calc_finished(obj->finish_flags);
+	/* the deviations are taken from the rounded mean of the first block, the fixed point
+	 * build keeps this shift for the whole capture */
+	if ((0 == acc->count) && (0 != size)) {
+		uint32_t first_size = (size > CALCULATION_MOMENT_BLOCK_LEN) ?
+				CALCULATION_MOMENT_BLOCK_LEN : size;
+		uint32_t first_sum = 0;
+		for (uint32_t i = 0; i < first_size; ++i) {
+			first_sum += data[i];
 		}
-		vTaskSuspend(NULL);
+		acc->shift = (uint16_t)((first_sum + first_size / 2) / first_size);
+	}
+
+	while (size > 0) {
+		uint32_t block_size = (size > CALCULATION_MOMENT_BLOCK_LEN) ?
+				CALCULATION_MOMENT_BLOCK_LEN : size;
+		uint32_t sum = 0;
+		uint64_t sum_of_squares = 0;
+		int64_t sum_of_cubes = 0;
+		uint64_t sum_of_fourth_powers = 0;
+		uint32_t fourth_power_carries = 0;
+		uint16_t max_val = acc->max_val;
+		uint16_t min_val = acc->min_val;
+		int32_t shift = acc->shift;
+
+		for (uint32_t i = 0; i < block_size; ++i) {
+			uint32_t sample = data[i];
+			int32_t deviation = (int32_t)sample - shift;
+			uint32_t deviation_square = (uint32_t)deviation * (uint32_t)deviation;
+			uint64_t fourth_power = (uint64_t)deviation_square * deviation_square;
+			sum += sample;
+			sum_of_squares += sample * sample;
+			sum_of_cubes += (int64_t)deviation_square * deviation;
+			sum_of_fourth_powers += fourth_power;
+			fourth_power_carries += (sum_of_fourth_powers < fourth_power);
+			if (sample > max_val) {
+				max_val = sample;
+			}
+			if (sample < min_val) {
+				min_val = sample;
+			}
+		}
+
+		/* the first two power sums of the deviations follow from the raw ones exactly */
+		int64_t sum_of_deviations = (int64_t)sum - (int64_t)shift * block_size;
+		int64_t sum_of_deviation_squares = (int64_t)sum_of_squares -
+				2 * (int64_t)shift * sum + (int64_t)shift * shift * block_size;
+#if CALCULATION_FIXED_POINT
+		/* the capture of 32 bit count of 16 bit deviations keeps the squares in 64 bits,
+		 * the cubes and the fourth powers in the wide sums */
+		acc->sum_of_deviations += sum_of_deviations;
+		acc->sum_of_deviation_squares += (uint64_t)sum_of_deviation_squares;
+		wide_sum_add(&acc->sum_of_deviation_cubes, (sum_of_cubes < 0) ? -1 : 0,
+				(uint64_t)sum_of_cubes);
+		wide_sum_add(&acc->sum_of_deviation_fourth_powers, fourth_power_carries,
+				sum_of_fourth_powers);
+#else
+		accumulator_merge_moments(acc, block_size, sum_of_deviations,
+				sum_of_deviation_squares, sum_of_cubes,
+				ldexp(fourth_power_carries, 64) + (double)sum_of_fourth_powers);
+#endif
+
+		acc->count += block_size;
+		acc->sum += sum;
+		acc->sum_of_squares += sum_of_squares;
+		acc->max_val = max_val;
+		acc->min_val = min_val;
+		data += block_size;
+		size -= block_size;
 	}
 }
 /****************************************************************************************/
 
-void calculation_range(void *pvParameter)
+static void central_moments(uint32_t count, double sum1, double sum2, double sum3,
+				double sum4, double moments[3])
 {
-	while(true){
-		Calculation_obj_handle obj;
-		if(xQueue_range != 0 && xQueueReceive(xQueue_range, &obj, 0)){
-		obj->max_val = obj->data[0];
-		obj->min_val = obj->data[0];
-		for (int16_t iterator = (obj->size - 1); iterator >= 0; --iterator){
-			if(obj->data[iterator] > obj->max_val){
-				obj->max_val = obj->data[iterator];
-			}else if(obj->data[iterator] < obj->min_val){
-				obj->min_val = obj->data[iterator];
-			}
-			vTaskDelay(1 / portTICK_PERIOD_MS);
-		}
-		obj->finish_flags |= CALC_FINISH_RANGE_FLAG;
-		obj->state = is_calc_finished(obj->finish_flags);
-		}
-		vTaskSuspend(NULL);
+	/* the mean is shift + d */
+	double n = count;
+	double d = sum1 / n;
+	moments[0] = sum2 - d * sum1;
+	moments[1] = sum3 - 3 * d * sum2 + 2 * n * d * d * d;
+	moments[2] = sum4 - 4 * d * sum3 + 6 * d * d * sum2 - 3 * n * d * d * d * d;
+}
+/****************************************************************************************/
+
+#if !CALCULATION_FIXED_POINT
+static void accumulator_merge_moments(statistics_accumulator *acc, uint32_t count,
+				int64_t sum1, int64_t sum2, int64_t sum3, double sum4)
+{
+	double block_moments[3];
+	central_moments(count, sum1, sum2, sum3, sum4, block_moments);
+	double block_moment2 = block_moments[0];
+	double block_moment3 = block_moments[1];
+	double block_moment4 = block_moments[2];
+	double n = count;
+	double block_mean = acc->shift + sum1 / n;
+
+	if (0 == acc->count) {
+		acc->mean = block_mean;
+		acc->moment2 = block_moment2;
+		acc->moment3 = block_moment3;
+		acc->moment4 = block_moment4;
+	} else {
+		double na = acc->count;
+		double total = na + n;
+		double delta = block_mean - acc->mean;
+		double delta_n = delta / total;
+		double delta_n2 = delta_n * delta_n;
+		double product = na * n;
+		acc->moment4 += block_moment4 +
+				delta * delta_n * delta_n2 * product * (na * na - product + n * n) +
+				6 * delta_n2 * (na * na * block_moment2 + n * n * acc->moment2) +
+				4 * delta_n * (na * block_moment3 - n * acc->moment3);
+		acc->moment3 += block_moment3 +
+				delta * delta_n2 * product * (na - n) +
+				3 * delta_n * (na * block_moment2 - n * acc->moment2);
+		acc->moment2 += block_moment2 + delta * delta_n * product;
+		acc->mean += delta_n * n;
 	}
+	acc->shift = (uint16_t)(acc->mean + 0.5);
 }
 /****************************************************************************************/
+#endif
 
-void calculation_amplitude(void *pvParameter)
+static void accumulator_finalize(const statistics_accumulator *acc,
+				Calculation_obj_handle obj)
 {
-	while(true){
-		Calculation_obj_handle obj;
-		if(xQueue_amplitude != 0 && xQueueReceive(xQueue_amplitude, &obj, 0)){
-			while (!(obj->finish_flags & (CALC_FINISH_AVERAGE_FLAG | CALC_FINISH_RANGE_FLAG))) {
-				vTaskDelay(100 / portTICK_PERIOD_MS);
-			}
+	if (0 == acc->count) {
+		return;
+	}
+	/** the sum of squares about the integer part of the mean is exact in 64 bits and
+	 * small, sum((x - q)^2) = sum_of_squares - 2*q*sum + q*q*count, so the variance does
+	 * not suffer from the cancellation of the large raw sums of a quiet signal on the dc
+	 * bias. The intermediate terms may wrap around, the result does not. **/
+	uint64_t mean_floor = acc->sum / acc->count;
+	uint64_t mean_remainder = acc->sum % acc->count;
+	uint64_t centered_sum_of_squares = acc->sum_of_squares - 2 * mean_floor * acc->sum +
+			mean_floor * mean_floor * acc->count;
 
-			uint16_t amplitude = (abs(obj->max_val - obj->average) >= abs(obj->min_val - obj->average) ?
-					abs(obj->max_val - obj->average) : abs(obj->min_val - obj->average));
-			obj->amplitude = amplitude;
-			obj->finish_flags |= CALC_FINISH_AMPLITUDE_FLAG;
-			obj->state = is_calc_finished(obj->finish_flags);
-		}
-		vTaskSuspend(NULL);
+	/** skewness and kurtosis, not the excess one, from the central moments, the fixed
+	 * point build turns its exact power sums to them here, once per capture **/
+	double moments[3];
+#if CALCULATION_FIXED_POINT
+	central_moments(acc->count, acc->sum_of_deviations, acc->sum_of_deviation_squares,
+			wide_sum_to_double(&acc->sum_of_deviation_cubes),
+			wide_sum_to_double(&acc->sum_of_deviation_fourth_powers), moments);
+#else
+	moments[0] = acc->moment2;
+	moments[1] = acc->moment3;
+	moments[2] = acc->moment4;
+#endif
+	float skewness = 0;
+	float kurtosis = 0;
+	if (moments[0] > 0) {
+		skewness = (float)(sqrt((double)acc->count) * moments[1] /
+				(moments[0] * sqrt(moments[0])));
+		kurtosis = (float)(acc->count * moments[2] / (moments[0] * moments[0]));
+	}
+#if CALCULATION_FIXED_POINT
+	/** the mean square is split to the integer part and the remainder, so the Q30 value
+	 * does not overflow 64 bits for any count **/
+	uint64_t mean_square = acc->sum_of_squares / acc->count;
+	uint64_t remainder = acc->sum_of_squares % acc->count;
+	mean_square = (mean_square << (2 * CALCULATION_Q15_SHIFT)) +
+			((remainder << (2 * CALCULATION_Q15_SHIFT)) / acc->count);
+	uint32_t max_val = (uint32_t)acc->max_val << CALCULATION_Q15_SHIFT;
+	uint32_t min_val = (uint32_t)acc->min_val << CALCULATION_Q15_SHIFT;
+
+	obj->average = (uint32_t)((acc->sum << CALCULATION_Q15_SHIFT) / acc->count);
+	obj->rms = square_root(mean_square);
+	obj->max_val = acc->max_val;
+	obj->min_val = acc->min_val;
+	uint32_t peak = ((max_val - obj->average) > (obj->average - min_val)) ?
+			(max_val - obj->average) : (obj->average - min_val);
+	obj->amplitude = (uint16_t)(peak >> CALCULATION_Q15_SHIFT);
+	obj->crest_factor = (0 != obj->rms) ?
+			(uint32_t)(((uint64_t)max_val << CALCULATION_Q15_SHIFT) / obj->rms) : 0;
+
+	/** variance = centered_sum_of_squares/count - fraction^2 in Q30 **/
+	uint64_t fraction = (mean_remainder << CALCULATION_Q15_SHIFT) / acc->count;
+	uint64_t variance = ((centered_sum_of_squares / acc->count) << (2 * CALCULATION_Q15_SHIFT)) +
+			(((centered_sum_of_squares % acc->count) << (2 * CALCULATION_Q15_SHIFT)) /
+					acc->count);
+	uint32_t ac_rms = (variance > fraction * fraction) ?
+			square_root(variance - fraction * fraction) : 0;
+	obj->ac_rms = (uint32_t)(((uint64_t)ac_rms * sensitivity) >> CALCULATION_Q15_SHIFT);
+	obj->peak = (uint32_t)(((uint64_t)peak * sensitivity) >> CALCULATION_Q15_SHIFT);
+	obj->peak_to_peak = (uint32_t)(acc->max_val - acc->min_val) * sensitivity;
+	obj->ac_crest_factor = (0 != ac_rms) ?
+			(uint32_t)(((uint64_t)peak << CALCULATION_Q15_SHIFT) / ac_rms) : 0;
+	obj->skewness = float_to_signed_q15(skewness);
+	obj->kurtosis = float_to_q15(kurtosis);
+#else
+	obj->average = (float)acc->sum / acc->count;
+	obj->rms = sqrtf((float)acc->sum_of_squares / acc->count);
+	obj->max_val = acc->max_val;
+	obj->min_val = acc->min_val;
+	obj->amplitude = (uint16_t)fmaxf(acc->max_val - obj->average,
+					obj->average - acc->min_val);
+	obj->crest_factor = (0 != obj->rms) ? (acc->max_val / obj->rms) : 0;
+
+	/** variance = (centered_sum_of_squares - remainder^2/count)/count **/
+	float variance = ((float)centered_sum_of_squares -
+			(float)mean_remainder * mean_remainder / acc->count) / acc->count;
+	float ac_rms = (variance > 0) ? sqrtf(variance) : 0;
+	float peak = fmaxf(acc->max_val - obj->average, obj->average - acc->min_val);
+	obj->ac_rms = ac_rms * sensitivity;
+	obj->peak = peak * sensitivity;
+	obj->peak_to_peak = (acc->max_val - acc->min_val) * sensitivity;
+	obj->ac_crest_factor = (0 != ac_rms) ? (peak / ac_rms) : 0;
+	obj->skewness = skewness;
+	obj->kurtosis = kurtosis;
+#endif
+}
+#if CALCULATION_FIXED_POINT
+/****************************************************************************************/
+
+static void wide_sum_add(wide_sum *sum, int64_t high, uint64_t low)
+{
+	sum->low += low;
+	sum->high += high + (sum->low < low);
+}
+/****************************************************************************************/
+
+static double wide_sum_to_double(const wide_sum *sum)
+{
+	if (sum->high == (((int64_t)sum->low < 0) ? -1 : 0)) {
+		return (double)(int64_t)sum->low;
 	}
+	return ldexp((double)sum->high, 64) + (double)sum->low;
 }
 /****************************************************************************************/
 
-void calculation_crest_factor(void *pvParameter)
+static uint32_t square_root(uint64_t value)
 {
-	while(true){
-		Calculation_obj_handle obj;
-		if(xQueue_crest_factor != 0 && xQueueReceive(xQueue_crest_factor, &obj, 0)){
-			while(!(obj->finish_flags & (CALC_FINISH_RANGE_FLAG | CALC_FINISH_RMS_FLAG))){
-				vTaskDelay(100 / portTICK_PERIOD_MS);
-			}
-			obj->crest_factor = obj->max_val/obj->rms;
-			obj->finish_flags |= CALC_FINISH_CREST_FLAG;
-			obj->state = is_calc_finished(obj->finish_flags);
+	uint64_t root = 0;
+	uint64_t bit = (uint64_t)1 << 62;
+
+	while (bit > value) {
+		bit >>= 2;
+	}
+	while (0 != bit) {
+		if (value >= root + bit) {
+			value -= root + bit;
+			root = (root >> 1) + bit;
+		} else {
+			root >>= 1;
 		}
-		vTaskSuspend(NULL);
+		bit >>= 2;
 	}
+	return (uint32_t)root;
 }
+/****************************************************************************************/
 
-//////////////////////////////////////////////////////////////////////////////////////////
-//Static functions definitions															//
-//////////////////////////////////////////////////////////////////////////////////////////
+static uint32_t float_to_q15(float value)
+{
+	return (value < (float)(UINT32_MAX >> CALCULATION_Q15_SHIFT)) ?
+			(uint32_t)(value * CALCULATION_Q15_ONE) : UINT32_MAX;
+}
+/****************************************************************************************/
 
-static uint32_t sum_array(uint16_t data[], uint16_t size)
+static uint32_t float_to_signed_q15(float value)
 {
-	int32_t sum = 0;
-	for (int16_t iterator = (size - 1); iterator >= 0; --iterator) {
-		sum += data[iterator];
-	}
-	return sum;
+	float limit = (float)(INT32_MAX >> CALCULATION_Q15_SHIFT);
+	value = fminf(fmaxf(value, -limit), limit);
+	return (uint32_t)(int32_t)(value * CALCULATION_Q15_ONE);
 }
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
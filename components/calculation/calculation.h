@@ -5,10 +5,36 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include <stdint.h>
+#include "envelope.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
+/** set to 1 to derive rms, average and crest factor from the integer sums in fixed point,
+ * without any float operation, the factors are then returned as Q15 numbers **/
+#ifndef CALCULATION_FIXED_POINT
+#define CALCULATION_FIXED_POINT		(0)
+#endif
+
+/** number of fractional bits of the fixed point factors **/
+#define CALCULATION_Q15_SHIFT		(15)
+#define CALCULATION_Q15_ONE			((uint32_t)1 << CALCULATION_Q15_SHIFT)
+
+/** maximal number of the spectrum bands whose rms is calculated **/
+#define CALCULATION_MAX_BANDS		(8)
+
+/** default sensitivity of the accelerometer in g per adc count **/
+#define CALCULATION_DEFAULT_SENSITIVITY	(0.0244140625f)
+
+/** converts the non integer factor returned by calculation_get_factor to float **/
+#if CALCULATION_FIXED_POINT
+#define CALCULATION_FACTOR_TO_FLOAT(factor)	((float)(factor).fixed_type / CALCULATION_Q15_ONE)
+#define CALCULATION_SIGNED_FACTOR_TO_FLOAT(factor)	\
+				((float)(factor).signed_fixed_type / CALCULATION_Q15_ONE)
+#else
+#define CALCULATION_FACTOR_TO_FLOAT(factor)	((factor).float_type)
+#define CALCULATION_SIGNED_FACTOR_TO_FLOAT(factor)	((factor).float_type)
+#endif
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global typedefs																		//
@@ -16,6 +42,31 @@
 /** typedef of module object definition **/
 typedef struct Calculation_obj *Calculation_obj_handle;
 
+/** typedef of the function providing the blocks of the streamed data. It fills the block
+ * with up to max_size samples and returns their number, 0 marks the end of the data **/
+typedef uint32_t (*calculation_block_source)(uint16_t block[], uint32_t max_size);
+
+/** configuration of the welch power spectral density, segment_size 0 disables it and
+ * the amplitude spectrum of the whole data is calculated instead **/
+typedef struct _calculation_psd_config {
+	uint16_t segment_size;
+	uint8_t overlap;
+	uint8_t window;
+	uint16_t frequency;
+} calculation_psd_config;
+
+/** band of the spectrum in Hz, the lower edge is included and the upper one excluded **/
+typedef struct _calculation_band {
+	uint16_t low;
+	uint16_t high;
+} calculation_band;
+
+/** table of the bands whose rms forms the feature vector of the measurement **/
+typedef struct _calculation_band_config {
+	uint8_t count;
+	calculation_band bands[CALCULATION_MAX_BANDS];
+} calculation_band_config;
+
 /** enum determining available factors which are calculated by the module **/
 typedef enum {
 	CALCULATION_RMS = 0,
@@ -23,7 +74,15 @@ typedef enum {
 	CALCULATION_MAXVAL,
 	CALCULATION_MINVAL,
 	CALCULATION_AMPLITUDE,
-	CALCULATION_CREST_FACTOR
+	CALCULATION_CREST_FACTOR,
+	CALCULATION_AC_RMS,
+	CALCULATION_PEAK,
+	CALCULATION_PEAK_TO_PEAK,
+	CALCULATION_AC_CREST_FACTOR,
+	CALCULATION_VELOCITY_RMS,
+	CALCULATION_DISPLACEMENT_PEAK_TO_PEAK,
+	CALCULATION_SKEWNESS,
+	CALCULATION_KURTOSIS
 } calculation_factors;
 
 /** enum determining the state of the object **/
@@ -38,6 +97,8 @@ typedef enum {
 typedef union _calculation_factor_type {
 	uint16_t integer_type;
 	float float_type;
+	uint32_t fixed_type;
+	int32_t signed_fixed_type;
 } calculation_factor_type;
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -48,18 +109,108 @@ typedef union _calculation_factor_type {
 //Global functions prototypes															//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+/****************************************************************************************\
+Function:
+calculation_init
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function initializes the calculation module. It has to be called before the
+calculation task is created.
+\****************************************************************************************/
+void calculation_init(void);
+
+/****************************************************************************************\
+Function:
+calculation_set_sensitivity
+******************************************************************************************
+Parameters:
+float g_per_count - sensitivity of the accelerometer in g per adc count
+******************************************************************************************
+Abstract:
+This function sets the sensitivity used to express the ac factors in g, it is
+CALCULATION_DEFAULT_SENSITIVITY until set. It applies to the calculations triggered
+afterwards.
+\****************************************************************************************/
+void calculation_set_sensitivity(float g_per_count);
+
 /****************************************************************************************\
 Function:
 calculation_NewObj
 ******************************************************************************************
 Parameters:
 uint16_t data[] - pointer to the data array
-uint16_t size - size of the data
+uint32_t size - size of the data
+******************************************************************************************
+Abstract:
+This function creates an object of calculation and returns a pointer to that object. The
+object is taken from the static pool, NULL is returned when all of them are in use.
+Objects are created and deleted by one task only.
+\****************************************************************************************/
+Calculation_obj_handle calculation_new_obj(uint16_t data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+calculation_new_stream_obj
+******************************************************************************************
+Parameters:
+calculation_block_source source - function providing the blocks of the data
+******************************************************************************************
+Abstract:
+This function creates an object of calculation for the data which is not stored in
+memory. After the calculation is triggered, the calculation task takes the blocks from
+the source and updates the factors incrementally until the source returns 0.
+\****************************************************************************************/
+Calculation_obj_handle calculation_new_stream_obj(calculation_block_source source);
+
+/****************************************************************************************\
+Function:
+calculation_set_psd_config
+******************************************************************************************
+Parameters:
+Calculation_obj_handle obj - handle to object on which the function should operate
+const calculation_psd_config *config - welch power spectral density configuration
+******************************************************************************************
+Abstract:
+This function requests the welch power spectral density instead of the amplitude
+spectrum. The segments are processed as the data arrives, so it is also available for
+the stream obj. It has to be called before calculation_calculate_factors.
+\****************************************************************************************/
+void calculation_set_psd_config(Calculation_obj_handle obj, const calculation_psd_config *config);
+
+/****************************************************************************************\
+Function:
+calculation_set_band_config
+******************************************************************************************
+Parameters:
+Calculation_obj_handle obj - handle to object on which the function should operate
+const calculation_band_config *config - bands of the feature vector
 ******************************************************************************************
 Abstract:
-This function creates an object of calculation and returns a pointer to that object.
+This function sets the bands whose rms is summed from the spectrum of the obj after the
+calculation, see calculation_get_band_rms. The frequency has to be set as well. It has to
+be called before calculation_calculate_factors.
 \****************************************************************************************/
-Calculation_obj_handle calculation_new_obj(uint16_t data[], uint16_t size);
+void calculation_set_band_config(Calculation_obj_handle obj,
+				const calculation_band_config *config);
+
+/****************************************************************************************\
+Function:
+calculation_set_frequency
+******************************************************************************************
+Parameters:
+Calculation_obj_handle obj - handle to object on which the function should operate
+uint16_t frequency - sampling frequency of the data
+******************************************************************************************
+Abstract:
+This function enables the integration of the acceleration to the velocity rms and the
+displacement peak to peak in the vibration severity band, see integration.h, and the
+envelope analysis, see envelope.h. It has to be called before
+calculation_calculate_factors.
+\****************************************************************************************/
+void calculation_set_frequency(Calculation_obj_handle obj, uint16_t frequency);
 
 /****************************************************************************************\
 Function:
@@ -69,9 +220,10 @@ Parameters:
 Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-Thus function returns the size of data stored inside the obj.
+Thus function returns the size of data stored inside the obj. For the stream obj it is
+the number of processed samples.
 \****************************************************************************************/
-uint16_t calculation_get_size(Calculation_obj_handle obj);
+uint32_t calculation_get_size(Calculation_obj_handle obj);
 
 /****************************************************************************************\
 Function:
@@ -93,7 +245,8 @@ Parameters:
 Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-This funtion triggers calculation of the factors.
+This funtion triggers calculation of the factors by passing the obj to the calculation
+task.
 \****************************************************************************************/
 void calculation_calculate_factors(Calculation_obj_handle obj);
 
@@ -107,93 +260,100 @@ calculation_factors factor - desired factor to be returned
 ******************************************************************************************
 Abstract:
 This function returns the desired factor from the obj. It should be called when the 
-calculation is finished
+calculation is finished. Max, min and amplitude are integer adc counts, the other factors
+are float, or Q15 fixed point if CALCULATION_FIXED_POINT is set, see
+CALCULATION_FACTOR_TO_FLOAT. Rms, average and crest factor are taken from the raw adc
+counts. The ac factors are taken about the measured mean and expressed in g: ac rms,
+peak as the largest deviation from the mean, peak to peak and the ac crest factor as the
+ratio of the peak to the ac rms. Skewness and kurtosis are the third and fourth
+standardized central moments, the kurtosis of the gaussian noise is 3, they are 0 for
+the constant data. Skewness is signed, see CALCULATION_SIGNED_FACTOR_TO_FLOAT. Velocity
+rms in mm/s and displacement peak to peak in um are 0 unless the frequency was set.
 \****************************************************************************************/
 calculation_factor_type calculation_get_factor(Calculation_obj_handle obj, calculation_factors factor);
 
 /****************************************************************************************\
 Function:
-calculation_get_state
+calculation_get_envelope_peaks
 ******************************************************************************************
 Parameters:
 Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-This function returns the state of obj.
+This function returns the ENVELOPE_PEAK_COUNT largest peaks of the envelope spectrum of
+the obj, sorted by the amplitude. They are float also in the fixed point build and all
+0 unless the frequency was set.
 \****************************************************************************************/
-calculation_state calculation_get_state(Calculation_obj_handle obj);
+const envelope_peak * calculation_get_envelope_peaks(Calculation_obj_handle obj);
 
 /****************************************************************************************\
 Function:
-calculation_delete_obj
+calculation_get_band_rms
 ******************************************************************************************
 Parameters:
 Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-This function deletes the obj.
+This function returns the rms in g of every band of the band config, averaged over the
+welch segments of the whole capture, the requested ones or the Hann ones of the largest
+transform not exceeding the size and SPECTRUM_MAX_FFT_SIZE overlapping by a half. The
+sum of their squares over the bands covering the whole spectrum is the square of the ac
+rms. The samples after the last segment, fewer than its step, are left out and the values
+are 0 without the frequency or a complete segment. They are float also in the fixed point
+build.
 \****************************************************************************************/
-void calculation_delete_obj(Calculation_obj_handle * obj);
+const float * calculation_get_band_rms(Calculation_obj_handle obj);
 
 /****************************************************************************************\
 Function:
-calculation_rms
+calculation_get_band_count
 ******************************************************************************************
 Parameters:
-void *pvParameter - standard parameter for freertos task
-******************************************************************************************
-Abstract:
-rms calculation task function
-\****************************************************************************************/
-void calculation_rms(void *pvParameter);
-
-/****************************************************************************************\
-Function:
-calculation_average
-******************************************************************************************
-Parameters:
-void *pvParameter - standard parameter for freertos task
+Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-average calculation task function
+This function returns the number of the bands of the band config of the obj.
 \****************************************************************************************/
-void calculation_average(void *pvParameter);
+uint8_t calculation_get_band_count(Calculation_obj_handle obj);
 
 /****************************************************************************************\
 Function:
-calculation_range
+calculation_get_state
 ******************************************************************************************
 Parameters:
-void *pvParameter - standard parameter for freertos task
+Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-range calculation task function
+This function returns the state of obj.
 \****************************************************************************************/
-void calculation_range(void *pvParameter);
+calculation_state calculation_get_state(Calculation_obj_handle obj);
 
 /****************************************************************************************\
 Function:
-calculation_amplitude
+calculation_delete_obj
 ******************************************************************************************
 Parameters:
-void *pvParameter - standard parameter for freertos task
+Calculation_obj_handle obj - handle to object on which the function should operate
 ******************************************************************************************
 Abstract:
-amplitude calculation task function
+This function deletes the obj and returns it to the pool. The NULL obj is ignored.
 \****************************************************************************************/
-void calculation_amplitude(void *pvParameter);
+void calculation_delete_obj(Calculation_obj_handle * obj);
 
 /****************************************************************************************\
 Function:
-calculation_crest_factor
+calculation_task
 ******************************************************************************************
 Parameters:
 void *pvParameter - standard parameter for freertos task
 ******************************************************************************************
 Abstract:
-crest factor calculation task function
+Calculation task function. It blocks until an object is passed by
+calculation_calculate_factors and then computes all the factors, raw and ac, in a single
+pass over the data. For the obj holding the data in memory also the amplitude spectrum is
+calculated, or the welch power spectral density if it was configured, see spectrum.h.
 \****************************************************************************************/
-void calculation_crest_factor(void *pvParameter);
+void calculation_task(void *pvParameter);
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
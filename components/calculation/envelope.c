@@ -0,0 +1,218 @@
+/** envelope.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "envelope.h"
+#include "biquad.h"
+#include "spectrum.h"
+#include <math.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define ENVELOPE_PI					(3.14159265358979f)
+/** mean of the rectified sine is 2/pi of its amplitude, the envelope is scaled back **/
+#define ENVELOPE_RECTIFIER_GAIN		(ENVELOPE_PI / 2)
+/** amplitude correction of the Hann window coherent gain (0.5) and one sided spectrum **/
+#define ENVELOPE_HANN_AMPLITUDE_GAIN	(4.0f)
+/** the lowest bins hold the leakage of the removed mean of the envelope **/
+#define ENVELOPE_MIN_PEAK_BIN		((uint32_t)2)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** state of the envelope analysis **/
+static struct _envelope_state{
+	bool is_started;
+	float scale;
+	float decimated_frequency;
+	uint16_t first_sample;
+	uint32_t count;
+	uint32_t fill;
+	uint32_t segments;
+	biquad band_high_pass;
+	biquad band_low_pass;
+	biquad envelope_low_pass[2];
+	float segment[ENVELOPE_SEGMENT_SIZE];
+	float power_sum[ENVELOPE_SEGMENT_SIZE/2 + 1];
+} envelope;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+process_segment
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function transforms the complete segment of the decimated envelope in place, adds
+its power to the sum and starts the next segment.
+\****************************************************************************************/
+static void process_segment(void);
+
+/****************************************************************************************\
+Function:
+insert_peak
+******************************************************************************************
+Parameters:
+envelope_peak peaks[] - peaks sorted by the amplitude, descending
+const envelope_peak *peak - candidate peak
+******************************************************************************************
+Abstract:
+This function inserts the candidate to its place in the sorted peaks, the smallest one
+drops out. The candidate smaller than all the peaks is ignored.
+\****************************************************************************************/
+static void insert_peak(envelope_peak peaks[], const envelope_peak *peak);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool envelope_start(uint16_t frequency, float sensitivity)
+{
+	memset(&envelope, 0, sizeof(envelope));
+	if (0 == frequency) {
+		return false;
+	}
+
+	/* band pass of the resonance as the butterworth high pass followed by the low pass */
+	biquad_set_high_pass(&envelope.band_high_pass,
+			ENVELOPE_BAND_LOW_RELATIVE * frequency, frequency);
+	biquad_set_low_pass(&envelope.band_low_pass,
+			ENVELOPE_BAND_HIGH_RELATIVE * frequency, frequency);
+
+	/* fourth order low pass of the rectified signal, it removes the carrier harmonics
+	 * from twice the band low corner and serves as the anti aliasing of the decimation */
+	envelope.decimated_frequency = (float)frequency / ENVELOPE_DECIMATION;
+	for (uint8_t i = 0; i < 2; ++i) {
+		biquad_set_low_pass(&envelope.envelope_low_pass[i],
+				envelope.decimated_frequency / 4, frequency);
+	}
+
+	envelope.scale = sensitivity * ENVELOPE_RECTIFIER_GAIN;
+	envelope.is_started = true;
+	return true;
+}
+/****************************************************************************************/
+
+void envelope_feed(const uint16_t data[], uint32_t size)
+{
+	if (!envelope.is_started || 0 == size) {
+		return;
+	}
+	if (0 == envelope.count) {
+		envelope.first_sample = data[0];
+	}
+
+	for (uint32_t i = 0; i < size; ++i) {
+		float x = (float)((int32_t)data[i] - envelope.first_sample);
+		x = biquad_process(&envelope.band_high_pass, x);
+		x = biquad_process(&envelope.band_low_pass, x);
+		x = biquad_process(&envelope.envelope_low_pass[0], fabsf(x));
+		x = biquad_process(&envelope.envelope_low_pass[1], x);
+
+		/* every ENVELOPE_DECIMATION-th sample after the settling is kept */
+		if ((++envelope.count <= ENVELOPE_SETTLING_SAMPLES) ||
+				(0 != envelope.count % ENVELOPE_DECIMATION)) {
+			continue;
+		}
+		envelope.segment[envelope.fill++] = x * envelope.scale;
+		if (ENVELOPE_SEGMENT_SIZE == envelope.fill) {
+			process_segment();
+		}
+	}
+}
+/****************************************************************************************/
+
+void envelope_finish(envelope_peak peaks[])
+{
+	memset(peaks, 0, ENVELOPE_PEAK_COUNT * sizeof(envelope_peak));
+	if (!envelope.is_started) {
+		return;
+	}
+	envelope.is_started = false;
+
+	uint32_t fft_size = ENVELOPE_SEGMENT_SIZE;
+	if (0 == envelope.segments) {
+		/* short data, the collected part is transformed on its own */
+		fft_size = spectrum_power(envelope.segment, envelope.fill);
+		if (0 == fft_size) {
+			return;
+		}
+		memcpy(envelope.power_sum, envelope.segment, (fft_size/2 + 1) * sizeof(float));
+		envelope.segments = 1;
+	}
+
+	/* amplitude spectrum in place of the averaged power */
+	uint32_t half = fft_size / 2;
+	float scale = ENVELOPE_HANN_AMPLITUDE_GAIN / fft_size;
+	for (uint32_t k = 0; k <= half; ++k) {
+		envelope.power_sum[k] = sqrtf(envelope.power_sum[k] / envelope.segments) * scale;
+	}
+
+	float resolution = envelope.decimated_frequency / fft_size;
+	const float *amplitude = envelope.power_sum;
+	for (uint32_t k = ENVELOPE_MIN_PEAK_BIN; k < half; ++k) {
+		if ((amplitude[k] <= amplitude[k-1]) || (amplitude[k] < amplitude[k+1])) {
+			continue;
+		}
+		/* parabolic interpolation of the offset from the bin, the amplitude is corrected
+		 * by the response of the Hann window at that offset, sinc(d)/(1 - d^2) */
+		float denominator = amplitude[k-1] - 2 * amplitude[k] + amplitude[k+1];
+		float offset = (0 != denominator) ?
+				0.5f * (amplitude[k-1] - amplitude[k+1]) / denominator : 0;
+		offset = fminf(fmaxf(offset, -0.5f), 0.5f);
+		float response = 1;
+		if (0 != offset) {
+			response = sinf(ENVELOPE_PI * offset) / (ENVELOPE_PI * offset) /
+					(1 - offset * offset);
+		}
+		envelope_peak peak = {
+			.frequency = (k + offset) * resolution,
+			.amplitude = amplitude[k] / response,
+		};
+		insert_peak(peaks, &peak);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void process_segment(void)
+{
+	spectrum_power(envelope.segment, ENVELOPE_SEGMENT_SIZE);
+	for (uint32_t k = 0; k <= ENVELOPE_SEGMENT_SIZE/2; ++k) {
+		envelope.power_sum[k] += envelope.segment[k];
+	}
+	++envelope.segments;
+	envelope.fill = 0;
+}
+/****************************************************************************************/
+
+static void insert_peak(envelope_peak peaks[], const envelope_peak *peak)
+{
+	int32_t i = ENVELOPE_PEAK_COUNT - 1;
+	if (peak->amplitude <= peaks[i].amplitude) {
+		return;
+	}
+	for (; (i > 0) && (peak->amplitude > peaks[i-1].amplitude); --i) {
+		peaks[i] = peaks[i-1];
+	}
+	peaks[i] = *peak;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
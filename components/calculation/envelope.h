@@ -0,0 +1,103 @@
+/** envelope.h **/
+
+#ifndef COMPONENTS_CALCULATION_ENVELOPE_H_
+#define COMPONENTS_CALCULATION_ENVELOPE_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** band of the resonance excited by the impacts, relative to the sampling frequency **/
+#define ENVELOPE_BAND_LOW_RELATIVE		(0.125f)
+#define ENVELOPE_BAND_HIGH_RELATIVE		(0.375f)
+
+/** decimation of the envelope, it is low pass filtered at a quarter of the decimated
+ * sampling frequency before **/
+#define ENVELOPE_DECIMATION				((uint32_t)4)
+
+/** number of the decimated samples in one segment of the envelope spectrum, it has to be
+ * a power of two not exceeding SPECTRUM_MAX_FFT_SIZE **/
+#define ENVELOPE_SEGMENT_SIZE			((uint32_t)512)
+
+/** number of the envelope spectrum peaks reported **/
+#define ENVELOPE_PEAK_COUNT				(5)
+
+/** samples taken after the start which are not evaluated, the filters settle from the
+ * step of the dc bias meanwhile **/
+#define ENVELOPE_SETTLING_SAMPLES		((uint32_t)256)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** peak of the envelope spectrum **/
+typedef struct _envelope_peak {
+	float frequency;
+	float amplitude;
+} envelope_peak;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+envelope_start
+******************************************************************************************
+Parameters:
+uint16_t frequency - sampling frequency
+float sensitivity - sensitivity of the accelerometer in g per adc count
+******************************************************************************************
+Abstract:
+This function starts the envelope analysis. The acceleration is band pass filtered
+between ENVELOPE_BAND_LOW_RELATIVE and ENVELOPE_BAND_HIGH_RELATIVE of the sampling
+frequency, rectified, low pass filtered and decimated by ENVELOPE_DECIMATION. The
+decimated envelope is collected in segments of ENVELOPE_SEGMENT_SIZE whose power spectra
+are averaged, so the memory used does not depend on the length of the data. The spectrum
+module has to be initialized. It returns false if the frequency is 0.
+\****************************************************************************************/
+bool envelope_start(uint16_t frequency, float sensitivity);
+
+/****************************************************************************************\
+Function:
+envelope_feed
+******************************************************************************************
+Parameters:
+const uint16_t data[] - pointer to the block of samples
+uint32_t size - number of samples in the block
+******************************************************************************************
+Abstract:
+This function passes the next block of samples through the envelope stages and
+transforms every complete segment of the decimated envelope.
+\****************************************************************************************/
+void envelope_feed(const uint16_t data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+envelope_finish
+******************************************************************************************
+Parameters:
+envelope_peak peaks[] - ENVELOPE_PEAK_COUNT largest peaks of the envelope spectrum
+******************************************************************************************
+Abstract:
+This function stores the largest local maxima of the averaged envelope spectrum, sorted
+by the amplitude in g, with the frequency in Hz interpolated between the bins. If no
+segment was completed, the spectrum of the collected part is taken. The unused peaks
+are 0.
+\****************************************************************************************/
+void envelope_finish(envelope_peak peaks[]);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* COMPONENTS_CALCULATION_ENVELOPE_H_ */
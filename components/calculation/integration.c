@@ -0,0 +1,174 @@
+/** integration.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "integration.h"
+#include "biquad.h"
+#include <math.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define INTEGRATION_PI				(3.14159265358979f)
+/** standard gravity, converts g to mm/s^2 **/
+#define INTEGRATION_G_MM_S2			(9806.65f)
+#define INTEGRATION_MM_TO_UM		(1000.0f)
+/** the low pass is used only below this fraction of the sampling frequency **/
+#define INTEGRATION_MAX_RELATIVE_FREQUENCY	(0.45f)
+/** the squares are summed in float over blocks of this length and then in double **/
+#define INTEGRATION_PARTIAL_SUM_LEN	((uint32_t)256)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** state of the integration **/
+static struct _integration_state{
+	bool is_started;
+	bool has_low_pass;
+	float scale;
+	uint16_t first_sample;
+	uint32_t count;
+	uint32_t settling_samples;
+	biquad low_pass;
+	biquad velocity;
+	biquad displacement;
+	double velocity_sum_of_squares;
+	float displacement_max;
+	float displacement_min;
+} integration;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+set_integrating_high_pass
+******************************************************************************************
+Parameters:
+biquad *section - section to be initialized
+float frequency - corner frequency of the high pass
+float sampling_frequency - sampling frequency
+******************************************************************************************
+Abstract:
+This function designs the integrator followed by the second order butterworth high pass
+as one section. The high pass is the bilinear transform prewarped at the corner, its
+double zero at dc cancels the pole of the integrator, so the state of the section stays
+bounded. The integrator is the al-alaoui one, T*7/8*(1 + z^-1/7)/(1 - z^-1), the blend of
+the trapezoidal and the rectangular rule, whose gain stays within 2 % of 1/w up to 0.3 of
+the sampling frequency, where the trapezoidal rule alone loses 30 %.
+\****************************************************************************************/
+static void set_integrating_high_pass(biquad *section, float frequency,
+				float sampling_frequency);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool integration_start(uint16_t frequency, float sensitivity)
+{
+	memset(&integration, 0, sizeof(integration));
+	if (frequency * INTEGRATION_MAX_RELATIVE_FREQUENCY <= 2 * INTEGRATION_LOW_FREQUENCY) {
+		return false;
+	}
+
+	integration.has_low_pass =
+			(INTEGRATION_HIGH_FREQUENCY < frequency * INTEGRATION_MAX_RELATIVE_FREQUENCY);
+	if (integration.has_low_pass) {
+		biquad_set_low_pass(&integration.low_pass, INTEGRATION_HIGH_FREQUENCY, frequency);
+	}
+	set_integrating_high_pass(&integration.velocity, INTEGRATION_LOW_FREQUENCY, frequency);
+	set_integrating_high_pass(&integration.displacement, INTEGRATION_LOW_FREQUENCY, frequency);
+
+	integration.scale = sensitivity * INTEGRATION_G_MM_S2;
+	integration.settling_samples =
+			(uint32_t)(INTEGRATION_SETTLING_PERIODS * frequency / INTEGRATION_LOW_FREQUENCY);
+	integration.displacement_max = -INFINITY;
+	integration.displacement_min = INFINITY;
+	integration.is_started = true;
+	return true;
+}
+/****************************************************************************************/
+
+void integration_feed(const uint16_t data[], uint32_t size)
+{
+	if (!integration.is_started || 0 == size) {
+		return;
+	}
+	/* the first sample is taken as the dc bias, the step of the remaining offset decays
+	 * during the settling */
+	if (0 == integration.count) {
+		integration.first_sample = data[0];
+	}
+
+	uint32_t i = 0;
+	while (i < size) {
+		uint32_t end = (size - i > INTEGRATION_PARTIAL_SUM_LEN) ?
+				(i + INTEGRATION_PARTIAL_SUM_LEN) : size;
+		float partial_sum = 0;
+		for (; i < end; ++i) {
+			float acceleration = ((int32_t)data[i] - integration.first_sample) *
+					integration.scale;
+			if (integration.has_low_pass) {
+				acceleration = biquad_process(&integration.low_pass, acceleration);
+			}
+			float velocity = biquad_process(&integration.velocity, acceleration);
+			float displacement = biquad_process(&integration.displacement, velocity);
+
+			if (integration.count++ < integration.settling_samples) {
+				continue;
+			}
+			partial_sum += velocity * velocity;
+			if (displacement > integration.displacement_max) {
+				integration.displacement_max = displacement;
+			}
+			if (displacement < integration.displacement_min) {
+				integration.displacement_min = displacement;
+			}
+		}
+		integration.velocity_sum_of_squares += partial_sum;
+	}
+}
+/****************************************************************************************/
+
+void integration_finish(float *velocity_rms, float *displacement_peak_to_peak)
+{
+	*velocity_rms = 0;
+	*displacement_peak_to_peak = 0;
+	if (!integration.is_started || integration.count <= integration.settling_samples) {
+		return;
+	}
+	*velocity_rms = (float)sqrt(integration.velocity_sum_of_squares /
+			(integration.count - integration.settling_samples));
+	*displacement_peak_to_peak = (integration.displacement_max - integration.displacement_min) *
+			INTEGRATION_MM_TO_UM;
+	integration.is_started = false;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void set_integrating_high_pass(biquad *section, float frequency,
+				float sampling_frequency)
+{
+	/* high pass (1 - z^-1)^2 / ((1 + k/Q + k^2) + 2*(k^2 - 1)*z^-1 + (1 - k/Q + k^2)*z^-2)
+	 * with k = tan(w0*T/2), times the integrator gives the numerator
+	 * T/8 * (7 - 6*z^-1 - z^-2) */
+	float k = tanf(INTEGRATION_PI * frequency / sampling_frequency);
+	float norm = 1 / (1 + k / BIQUAD_BUTTERWORTH_Q + k * k);
+	float gain = norm / (8 * sampling_frequency);
+	biquad_set(section, 7 * gain, -6 * gain, -gain, 2 * (k * k - 1) * norm,
+			(1 - k / BIQUAD_BUTTERWORTH_Q + k * k) * norm);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,85 @@
+/** integration.h **/
+
+#ifndef COMPONENTS_CALCULATION_INTEGRATION_H_
+#define COMPONENTS_CALCULATION_INTEGRATION_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** band of the vibration severity, ISO 10816 **/
+#define INTEGRATION_LOW_FREQUENCY		(10.0f)
+#define INTEGRATION_HIGH_FREQUENCY		(1000.0f)
+
+/** samples taken within this number of periods of the low frequency after the start are
+ * not evaluated, the filters settle from the step of the dc bias meanwhile **/
+#define INTEGRATION_SETTLING_PERIODS	(3)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+integration_start
+******************************************************************************************
+Parameters:
+uint16_t frequency - sampling frequency
+float sensitivity - sensitivity of the accelerometer in g per adc count
+******************************************************************************************
+Abstract:
+This function starts the integration of the acceleration to the velocity and the
+displacement. The acceleration is low pass filtered at INTEGRATION_HIGH_FREQUENCY when
+the sampling frequency allows it and every integration is followed by the second order
+butterworth high pass at INTEGRATION_LOW_FREQUENCY which removes the drift.
+The integration and the high pass are done by one biquad per stage, so no samples are
+stored. It returns false if the frequency is too low for the band.
+\****************************************************************************************/
+bool integration_start(uint16_t frequency, float sensitivity);
+
+/****************************************************************************************\
+Function:
+integration_feed
+******************************************************************************************
+Parameters:
+const uint16_t data[] - pointer to the block of samples
+uint32_t size - number of samples in the block
+******************************************************************************************
+Abstract:
+This function passes the next block of samples through the integration stages and
+updates the velocity sum of squares and the displacement extremes.
+\****************************************************************************************/
+void integration_feed(const uint16_t data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+integration_finish
+******************************************************************************************
+Parameters:
+float *velocity_rms - rms of the velocity in mm/s
+float *displacement_peak_to_peak - peak to peak of the displacement in um
+******************************************************************************************
+Abstract:
+This function stores the results of the integration. Both are 0 if the integration was
+not started or no sample was fed after the settling.
+\****************************************************************************************/
+void integration_finish(float *velocity_rms, float *displacement_peak_to_peak);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* COMPONENTS_CALCULATION_INTEGRATION_H_ */
@@ -0,0 +1,532 @@
+/** spectrum.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "spectrum.h"
+#include <math.h>
+#include <stdbool.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define SPECTRUM_PI					(3.14159265358979f)
+/** amplitude correction of the Hann window coherent gain (0.5) and one sided spectrum **/
+#define SPECTRUM_HANN_AMPLITUDE_GAIN	(4.0f)
+/** mean of the squared Hann window **/
+#define SPECTRUM_HANN_POWER_GAIN	(0.375f)
+/** minimal number of samples to be transformed **/
+#define SPECTRUM_MIN_FFT_SIZE		((uint32_t)4)
+
+/** coefficients of the flat top window **/
+#define FLAT_TOP_A0					(0.21557895f)
+#define FLAT_TOP_A1					(0.41663158f)
+#define FLAT_TOP_A2					(0.277263158f)
+#define FLAT_TOP_A3					(0.083578947f)
+#define FLAT_TOP_A4					(0.006947368f)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** twiddle table, element k holds cos and sin of 2*pi*k/SPECTRUM_MAX_FFT_SIZE **/
+static float twiddle_cos[SPECTRUM_MAX_FFT_SIZE/2];
+static float twiddle_sin[SPECTRUM_MAX_FFT_SIZE/2];
+static bool is_twiddle_table_ready = false;
+
+/** work buffer holding interleaved real and imaginary parts of the half size transform **/
+static float work_buffer[SPECTRUM_MAX_FFT_SIZE];
+
+/** dB codes of the last calculation **/
+static uint16_t magnitude[SPECTRUM_MAX_BINS];
+static uint32_t bin_count = 0;
+
+/** sample counts per adc count, the encoded spectra are in adc counts **/
+static float sample_scale = 1;
+
+/** power of the last calculation kept for the band features, the scale turns the sum of
+ * the power of the bins to the mean square **/
+static struct _band_source{
+	const float *power;
+	uint32_t fft_size;
+	float scale;
+} band_source;
+
+/** state of the welch estimation **/
+static struct _welch_state{
+	uint32_t segment_size;
+	uint32_t step;
+	uint32_t fill;
+	uint32_t segments;
+	spectrum_window window;
+	uint16_t frequency;
+	float window_power;
+	uint16_t segment[SPECTRUM_MAX_FFT_SIZE];
+	float power_sum[SPECTRUM_MAX_BINS];
+} welch;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+fft_size_for
+******************************************************************************************
+Parameters:
+uint32_t size - number of available samples
+******************************************************************************************
+Abstract:
+This function returns the largest supported power of two not exceeding size, or 0 if
+there is not enough samples.
+\****************************************************************************************/
+static uint32_t fft_size_for(uint32_t size);
+
+/****************************************************************************************\
+Function:
+table_cos
+******************************************************************************************
+Parameters:
+uint32_t n - index of the angle
+uint32_t fft_size - number of transformed samples
+******************************************************************************************
+Abstract:
+This function returns cos(2*pi*n/fft_size) taken from the twiddle table.
+\****************************************************************************************/
+static float table_cos(uint32_t n, uint32_t fft_size);
+
+/****************************************************************************************\
+Function:
+window_value
+******************************************************************************************
+Parameters:
+spectrum_window window - window type
+uint32_t n - index of the sample
+uint32_t fft_size - number of transformed samples
+******************************************************************************************
+Abstract:
+This function returns the value of the window for the sample n.
+\****************************************************************************************/
+static float window_value(spectrum_window window, uint32_t n, uint32_t fft_size);
+
+/****************************************************************************************\
+Function:
+welch_process_segment
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function transforms the complete welch segment, adds its power to the sum and
+keeps the overlapping part of the segment for the next one.
+\****************************************************************************************/
+static void welch_process_segment(void);
+
+/****************************************************************************************\
+Function:
+complex_fft
+******************************************************************************************
+Parameters:
+float z[] - interleaved complex data, transformed in place
+uint32_t size - number of complex points, power of two
+******************************************************************************************
+Abstract:
+This function performs in place iterative radix-2 decimation in time fft.
+\****************************************************************************************/
+static void complex_fft(float z[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+real_fft_power
+******************************************************************************************
+Parameters:
+float z[] - output of the half size complex fft of the packed real data
+uint32_t fft_size - number of real samples
+******************************************************************************************
+Abstract:
+This function splits the half size complex transform into the spectrum of the real data
+and stores the squared magnitude of bin k in z[k] for k = 0..fft_size/2.
+\****************************************************************************************/
+static void real_fft_power(float z[], uint32_t fft_size);
+
+/****************************************************************************************\
+Function:
+db_code
+******************************************************************************************
+Parameters:
+float power - power of the bin, squared amplitude or density
+******************************************************************************************
+Abstract:
+This function returns the dB code of the power, 10*log10(power) offset and scaled as
+described by SPECTRUM_DB_CODE_SCALE and clamped to the range of the code.
+\****************************************************************************************/
+static uint16_t db_code(float power);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void spectrum_init(void)
+{
+	if (is_twiddle_table_ready) {
+		return;
+	}
+	for (uint32_t k = 0; k < SPECTRUM_MAX_FFT_SIZE/2; ++k) {
+		float angle = 2 * SPECTRUM_PI * k / SPECTRUM_MAX_FFT_SIZE;
+		twiddle_cos[k] = cosf(angle);
+		twiddle_sin[k] = sinf(angle);
+	}
+	is_twiddle_table_ready = true;
+}
+/****************************************************************************************/
+
+void spectrum_set_sample_scale(uint16_t scale)
+{
+	sample_scale = (0 != scale) ? scale : 1;
+}
+/****************************************************************************************/
+
+uint32_t spectrum_calculate(const uint16_t data[], uint32_t size)
+{
+	uint32_t fft_size = fft_size_for(size);
+	bin_count = 0;
+	band_source.power = NULL;
+	if (0 == fft_size || !is_twiddle_table_ready) {
+		return 0;
+	}
+
+	/* remove the mean, so the dc does not leak into the low bins through the window */
+	uint32_t sum = 0;
+	for (uint32_t n = 0; n < fft_size; ++n) {
+		sum += data[n];
+	}
+	float mean = (float)sum / fft_size;
+
+	/* pack even samples as real and odd samples as imaginary parts */
+	for (uint32_t n = 0; n < fft_size; ++n) {
+		work_buffer[n] = (data[n] - mean) * window_value(SPECTRUM_WINDOW_HANN, n, fft_size);
+	}
+	complex_fft(work_buffer, fft_size/2);
+	real_fft_power(work_buffer, fft_size);
+
+	bin_count = fft_size/2 + 1;
+	/* 20*log10 of the amplitude is 10*log10 of its square, the dc and nyquist bins are
+	 * not doubled by the one sided spectrum */
+	float scale = SPECTRUM_HANN_AMPLITUDE_GAIN / (fft_size * sample_scale);
+	for (uint32_t k = 0; k < bin_count; ++k) {
+		float power = work_buffer[k] * scale * scale;
+		magnitude[k] = db_code((0 == k || bin_count - 1 == k) ? power / 4 : power);
+	}
+
+	/* sum of the squared Hann window is 3/8 of its length */
+	band_source.power = work_buffer;
+	band_source.fft_size = fft_size;
+	band_source.scale = 1.0f / (fft_size * SPECTRUM_HANN_POWER_GAIN * fft_size);
+	return bin_count;
+}
+/****************************************************************************************/
+
+uint32_t spectrum_power(float data[], uint32_t size)
+{
+	uint32_t fft_size = fft_size_for(size);
+	if (0 == fft_size || !is_twiddle_table_ready) {
+		return 0;
+	}
+	float sum = 0;
+	for (uint32_t n = 0; n < fft_size; ++n) {
+		sum += data[n];
+	}
+	float mean = sum / fft_size;
+	for (uint32_t n = 0; n < fft_size; ++n) {
+		data[n] = (data[n] - mean) * window_value(SPECTRUM_WINDOW_HANN, n, fft_size);
+	}
+	complex_fft(data, fft_size/2);
+	real_fft_power(data, fft_size);
+	return fft_size;
+}
+/****************************************************************************************/
+
+uint32_t spectrum_welch_start(uint32_t segment_size, uint8_t overlap, spectrum_window window,
+				uint16_t frequency)
+{
+	welch.segment_size = fft_size_for(segment_size);
+	welch.fill = 0;
+	welch.segments = 0;
+	welch.window = window;
+	welch.frequency = frequency;
+	if (0 == welch.segment_size || 0 == frequency || overlap > SPECTRUM_MAX_OVERLAP ||
+			!is_twiddle_table_ready) {
+		welch.segment_size = 0;
+		return 0;
+	}
+	welch.step = welch.segment_size - (welch.segment_size * overlap) / 100;
+
+	welch.window_power = 0;
+	for (uint32_t n = 0; n < welch.segment_size; ++n) {
+		float w = window_value(window, n, welch.segment_size);
+		welch.window_power += w * w;
+	}
+	for (uint32_t k = 0; k <= welch.segment_size/2; ++k) {
+		welch.power_sum[k] = 0;
+	}
+	return welch.segment_size/2 + 1;
+}
+/****************************************************************************************/
+
+void spectrum_welch_feed(const uint16_t data[], uint32_t size)
+{
+	if (0 == welch.segment_size) {
+		return;
+	}
+	while (size > 0) {
+		uint32_t chunk = welch.segment_size - welch.fill;
+		if (chunk > size) {
+			chunk = size;
+		}
+		memcpy(welch.segment + welch.fill, data, chunk * sizeof(uint16_t));
+		welch.fill += chunk;
+		data += chunk;
+		size -= chunk;
+		if (welch.fill == welch.segment_size) {
+			welch_process_segment();
+		}
+	}
+}
+/****************************************************************************************/
+
+uint32_t spectrum_welch_finish(void)
+{
+	bin_count = 0;
+	if (0 == spectrum_welch_finish_bands()) {
+		return 0;
+	}
+
+	/* one sided density, the dc and nyquist bins are not doubled */
+	uint32_t half = welch.segment_size / 2;
+	float scale = 1.0f / (welch.segments * welch.frequency * welch.window_power *
+			sample_scale * sample_scale);
+	for (uint32_t k = 0; k <= half; ++k) {
+		magnitude[k] = db_code(welch.power_sum[k] * scale *
+				((0 == k || half == k) ? 1.0f : 2.0f));
+	}
+	bin_count = half + 1;
+	return bin_count;
+}
+/****************************************************************************************/
+
+uint32_t spectrum_welch_finish_bands(void)
+{
+	band_source.power = NULL;
+	if (0 == welch.segment_size || 0 == welch.segments) {
+		return 0;
+	}
+	band_source.power = welch.power_sum;
+	band_source.fft_size = welch.segment_size;
+	band_source.scale = 1.0f / (welch.segments * welch.segment_size * welch.window_power);
+	return welch.segments;
+}
+/****************************************************************************************/
+
+float spectrum_band_mean_square(float low, float high, uint16_t frequency)
+{
+	if (NULL == band_source.power || 0 == frequency) {
+		return 0;
+	}
+
+	/* one sided sum, the bins other than dc and nyquist hold also the negative ones */
+	uint32_t half = band_source.fft_size / 2;
+	float resolution = (float)frequency / band_source.fft_size;
+	float sum = 0;
+	for (uint32_t k = (low > 0) ? (uint32_t)ceilf(low / resolution) : 0;
+			(k <= half) && (k * resolution < high); ++k) {
+		sum += band_source.power[k] * ((0 == k || half == k) ? 1.0f : 2.0f);
+	}
+	return sum * band_source.scale;
+}
+/****************************************************************************************/
+
+uint16_t * spectrum_get_magnitude_ptr(void)
+{
+	return magnitude;
+}
+/****************************************************************************************/
+
+uint32_t spectrum_get_bin_count(void)
+{
+	return bin_count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static uint32_t fft_size_for(uint32_t size)
+{
+	if (size < SPECTRUM_MIN_FFT_SIZE) {
+		return 0;
+	}
+	uint32_t fft_size = SPECTRUM_MAX_FFT_SIZE;
+	while (fft_size > size) {
+		fft_size >>= 1;
+	}
+	return fft_size;
+}
+/****************************************************************************************/
+
+static float table_cos(uint32_t n, uint32_t fft_size)
+{
+	uint32_t index = n % fft_size;
+	if (index > fft_size/2) {
+		index = fft_size - index;
+	}
+	if (index == fft_size/2) {
+		/* cos(pi) is not in the table */
+		return -1.0f;
+	}
+	return twiddle_cos[index * (SPECTRUM_MAX_FFT_SIZE / fft_size)];
+}
+/****************************************************************************************/
+
+static float window_value(spectrum_window window, uint32_t n, uint32_t fft_size)
+{
+	switch (window) {
+	case SPECTRUM_WINDOW_FLAT_TOP:
+		return FLAT_TOP_A0 - FLAT_TOP_A1 * table_cos(n, fft_size)
+				+ FLAT_TOP_A2 * table_cos(2*n, fft_size)
+				- FLAT_TOP_A3 * table_cos(3*n, fft_size)
+				+ FLAT_TOP_A4 * table_cos(4*n, fft_size);
+	case SPECTRUM_WINDOW_HANN:
+	default:
+		return 0.5f - 0.5f * table_cos(n, fft_size);
+	}
+}
+/****************************************************************************************/
+
+static void welch_process_segment(void)
+{
+	uint32_t size = welch.segment_size;
+	uint32_t sum = 0;
+	for (uint32_t n = 0; n < size; ++n) {
+		sum += welch.segment[n];
+	}
+	float mean = (float)sum / size;
+	for (uint32_t n = 0; n < size; ++n) {
+		work_buffer[n] = (welch.segment[n] - mean) * window_value(welch.window, n, size);
+	}
+	complex_fft(work_buffer, size/2);
+	real_fft_power(work_buffer, size);
+	for (uint32_t k = 0; k <= size/2; ++k) {
+		welch.power_sum[k] += work_buffer[k];
+	}
+	++welch.segments;
+
+	/* keep the overlapping tail as the beginning of the next segment */
+	uint32_t kept = size - welch.step;
+	memmove(welch.segment, welch.segment + welch.step, kept * sizeof(uint16_t));
+	welch.fill = kept;
+}
+/****************************************************************************************/
+
+static void complex_fft(float z[], uint32_t size)
+{
+	/* bit reversal permutation */
+	for (uint32_t i = 1, j = 0; i < size; ++i) {
+		uint32_t bit = size >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) {
+			float re = z[2*i];
+			float im = z[2*i+1];
+			z[2*i] = z[2*j];
+			z[2*i+1] = z[2*j+1];
+			z[2*j] = re;
+			z[2*j+1] = im;
+		}
+	}
+
+	/* butterflies, twiddle W_len^m = exp(-2*pi*i*m/len) */
+	for (uint32_t len = 2; len <= size; len <<= 1) {
+		uint32_t half = len >> 1;
+		uint32_t stride = SPECTRUM_MAX_FFT_SIZE / len;
+		for (uint32_t m = 0; m < half; ++m) {
+			float w_re = twiddle_cos[m * stride];
+			float w_im = -twiddle_sin[m * stride];
+			for (uint32_t i = m; i < size; i += len) {
+				uint32_t a = 2*i;
+				uint32_t b = 2*(i + half);
+				float t_re = w_re * z[b] - w_im * z[b+1];
+				float t_im = w_re * z[b+1] + w_im * z[b];
+				z[b] = z[a] - t_re;
+				z[b+1] = z[a+1] - t_im;
+				z[a] += t_re;
+				z[a+1] += t_im;
+			}
+		}
+	}
+}
+/****************************************************************************************/
+
+static void real_fft_power(float z[], uint32_t fft_size)
+{
+	uint32_t half = fft_size / 2;
+	uint32_t stride = SPECTRUM_MAX_FFT_SIZE / fft_size;
+
+	/* dc and nyquist bins are real */
+	float dc = z[0] + z[1];
+	float nyquist = z[0] - z[1];
+
+	for (uint32_t k = 1; k <= half/2; ++k) {
+		uint32_t m = half - k;
+		float zk_re = z[2*k], zk_im = z[2*k+1];
+		float zm_re = z[2*m], zm_im = z[2*m+1];
+
+		/* even and odd parts, E = (Zk + conj(Zm))/2, O = -i(Zk - conj(Zm))/2 */
+		float e_re = 0.5f * (zk_re + zm_re);
+		float e_im = 0.5f * (zk_im - zm_im);
+		float o_re = 0.5f * (zk_im + zm_im);
+		float o_im = -0.5f * (zk_re - zm_re);
+
+		/* X[k] = E + W^k O and X[m] = conj(E) - conj(W^k O), W^k = exp(-2*pi*i*k/N) */
+		float w_re = twiddle_cos[k * stride];
+		float w_im = -twiddle_sin[k * stride];
+		float wo_re = w_re * o_re - w_im * o_im;
+		float wo_im = w_re * o_im + w_im * o_re;
+
+		float xk_re = e_re + wo_re, xk_im = e_im + wo_im;
+		float xm_re = e_re - wo_re, xm_im = wo_im - e_im;
+
+		z[2*k] = xk_re * xk_re + xk_im * xk_im;
+		z[2*m] = xm_re * xm_re + xm_im * xm_im;
+	}
+
+	/* squared magnitudes were stored at even positions, compact them */
+	for (uint32_t k = 1; k < half; ++k) {
+		z[k] = z[2*k];
+	}
+	z[0] = dc * dc;
+	z[half] = nyquist * nyquist;
+}
+/****************************************************************************************/
+
+static uint16_t db_code(float power)
+{
+	if (!(power > 0)) {
+		return 0;
+	}
+	float code = (10.0f * log10f(power) + SPECTRUM_DB_OFFSET) * SPECTRUM_DB_CODE_SCALE;
+	if (code <= 0) {
+		return 0;
+	}
+	return (code >= SPECTRUM_CODE_MAX) ? SPECTRUM_CODE_MAX : (uint16_t)(code + 0.5f);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,217 @@
+/** spectrum.h **/
+
+#ifndef COMPONENTS_CALCULATION_SPECTRUM_H_
+#define COMPONENTS_CALCULATION_SPECTRUM_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** maximal number of samples transformed at once, it has to be a power of two **/
+#define SPECTRUM_MAX_FFT_SIZE		((uint32_t)2048)
+#define SPECTRUM_MAX_BINS			(SPECTRUM_MAX_FFT_SIZE/2 + 1)
+
+/** bins are coded in 1/256 dB, code = (level in dB + offset) * SPECTRUM_DB_CODE_SCALE,
+ * the amplitude level is 20*log10(counts) and the density one 10*log10(counts^2/Hz), code
+ * 0 stands for the level at or below -SPECTRUM_DB_OFFSET dB including no power **/
+#define SPECTRUM_DB_CODE_SCALE		(256)
+#define SPECTRUM_DB_OFFSET			(100)
+#define SPECTRUM_CODE_MAX			((uint16_t)0xffff)
+
+/** maximal overlap of the welch segments in percents **/
+#define SPECTRUM_MAX_OVERLAP		((uint8_t)90)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** enum determining the window applied to the welch segments **/
+typedef enum {
+	SPECTRUM_WINDOW_HANN = 0,
+	SPECTRUM_WINDOW_FLAT_TOP
+} spectrum_window;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+spectrum_init
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function precomputes the twiddle table used by every transform. It has to be called
+once before the first spectrum_calculate.
+\****************************************************************************************/
+void spectrum_init(void);
+
+/****************************************************************************************\
+Function:
+spectrum_set_sample_scale
+******************************************************************************************
+Parameters:
+uint16_t scale - sample counts per adc count, 1 for the plain conversions
+******************************************************************************************
+Abstract:
+This function sets the width of the following samples, the oversampled ones are larger
+than the adc counts. The amplitude spectrum and the power spectral density are divided
+by it, so they stay in adc counts, the band power stays in the sample counts.
+\****************************************************************************************/
+void spectrum_set_sample_scale(uint16_t scale);
+
+/****************************************************************************************\
+Function:
+spectrum_calculate
+******************************************************************************************
+Parameters:
+const uint16_t data[] - pointer to the measured data
+uint32_t size - size of the data
+******************************************************************************************
+Abstract:
+This function calculates the amplitude spectrum of the data. The largest power of two
+number of samples not exceeding size and SPECTRUM_MAX_FFT_SIZE is taken, the mean is
+removed, Hann window is applied and the real fft is done as a half size complex radix-2
+fft in the module work buffer. The amplitude of every bin in adc counts is stored as the
+dB code, so neither the full scale peaks saturate nor the small components vanish. It
+returns the number of bins.
+\****************************************************************************************/
+uint32_t spectrum_calculate(const uint16_t data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+spectrum_power
+******************************************************************************************
+Parameters:
+float data[] - samples, overwritten by the power spectrum
+uint32_t size - number of samples
+******************************************************************************************
+Abstract:
+This function transforms the samples of the other processing stages in place, taking
+the largest power of two number of them as spectrum_calculate does. The mean is removed,
+Hann window is applied and the squared magnitude of bin k, not scaled, is stored in
+data[k] for k = 0..fft_size/2. It returns fft_size, or 0 if there is not enough samples.
+\****************************************************************************************/
+uint32_t spectrum_power(float data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+spectrum_welch_start
+******************************************************************************************
+Parameters:
+uint32_t segment_size - number of samples in one segment, rounded down to a power of two
+uint8_t overlap - overlap of the consecutive segments in percents
+spectrum_window window - window applied to every segment
+uint16_t frequency - sampling frequency
+******************************************************************************************
+Abstract:
+This function starts the welch power spectral density estimation. The memory used does
+not depend on the number of fed samples, only one segment is kept. It returns the
+number of bins or 0 if the parameters are invalid.
+\****************************************************************************************/
+uint32_t spectrum_welch_start(uint32_t segment_size, uint8_t overlap, spectrum_window window,
+				uint16_t frequency);
+
+/****************************************************************************************\
+Function:
+spectrum_welch_feed
+******************************************************************************************
+Parameters:
+const uint16_t data[] - pointer to the block of samples
+uint32_t size - number of samples in the block
+******************************************************************************************
+Abstract:
+This function passes the next block of samples to the welch estimation. Every complete
+segment is detrended, windowed, transformed and added to the averaged spectrum.
+\****************************************************************************************/
+void spectrum_welch_feed(const uint16_t data[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+spectrum_welch_finish
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function averages the accumulated segments and stores the one sided power spectral
+density in adc counts^2/Hz, stored as the dB code in place of the amplitude spectrum. It
+returns the number of bins, 0 if no complete segment was fed.
+\****************************************************************************************/
+uint32_t spectrum_welch_finish(void);
+
+/****************************************************************************************\
+Function:
+spectrum_welch_finish_bands
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function averages the accumulated segments for spectrum_band_mean_square only, the
+dB codes of the last calculation are kept. So the band features cover every segment of the
+capture while the amplitude spectrum of spectrum_calculate covers its first transform. It
+has to be called after spectrum_calculate and returns the number of the averaged segments,
+0 if no complete segment was fed. The samples after the last complete segment, fewer than
+its step, are not included.
+\****************************************************************************************/
+uint32_t spectrum_welch_finish_bands(void);
+
+/****************************************************************************************\
+Function:
+spectrum_band_mean_square
+******************************************************************************************
+Parameters:
+float low - lower edge of the band in Hz, included
+float high - upper edge of the band in Hz, excluded
+uint16_t frequency - sampling frequency
+******************************************************************************************
+Abstract:
+This function sums the power of the bins of the last spectrum_calculate,
+spectrum_welch_finish or spectrum_welch_finish_bands whose frequency falls in the band. The sum is normalized by the
+window power, so it is the mean square of the band in sample counts^2 and the sum over all
+the bins is the variance of the data. It returns 0 if there is no spectrum, the power is
+valid until the next transform of the module.
+\****************************************************************************************/
+float spectrum_band_mean_square(float low, float high, uint16_t frequency);
+
+/****************************************************************************************\
+Function:
+spectrum_get_magnitude_ptr
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns pointer to the dB codes of the last calculation, the amplitude
+spectrum or the power spectral density.
+\****************************************************************************************/
+uint16_t * spectrum_get_magnitude_ptr(void);
+
+/****************************************************************************************\
+Function:
+spectrum_get_bin_count
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the number of bins of the last calculation, 0 if there was none.
+\****************************************************************************************/
+uint32_t spectrum_get_bin_count(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* COMPONENTS_CALCULATION_SPECTRUM_H_ */
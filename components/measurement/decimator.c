@@ -0,0 +1,157 @@
+/** decimator.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "decimator.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define DECIMATOR_PI					(3.14159265358979f)
+/** the taps are Q15, the dc gain of 1 is their sum of 2^15 **/
+#define DECIMATOR_COEFFICIENT_BITS		(15)
+#define DECIMATOR_COEFFICIENT_ONE		((int32_t)1 << DECIMATOR_COEFFICIENT_BITS)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+design_tap
+******************************************************************************************
+Parameters:
+uint32_t n - index of the tap in the filter
+uint32_t length - number of the taps
+uint8_t factor - decimation factor
+******************************************************************************************
+Abstract:
+This function returns the unnormalized tap of the Blackman windowed sinc with the cut
+off at the half of the output sampling frequency.
+\****************************************************************************************/
+static float design_tap(uint32_t n, uint32_t length, uint8_t factor);
+
+/****************************************************************************************\
+Function:
+tap_index
+******************************************************************************************
+Parameters:
+const decimator *filter - decimator being designed
+uint32_t n - index of the tap in the filter
+******************************************************************************************
+Abstract:
+This function returns the position of the tap in the coefficients. The output completed
+by the conversion of the phase r takes it by the tap (P - 1) * factor + r, the q-th
+following output by the tap (P - 1 - q) * factor + r.
+\****************************************************************************************/
+static uint32_t tap_index(const decimator *filter, uint32_t n);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool decimator_init(decimator *filter, uint8_t factor)
+{
+	if (factor < 2 || factor > DECIMATOR_MAX_FACTOR) {
+		return false;
+	}
+	filter->factor = factor;
+
+	/* the taps are designed twice, for the sum and for the quantization, so no float
+	 * copy of the filter is kept on the stack */
+	uint32_t length = DECIMATOR_TAPS_PER_PHASE * factor;
+	float sum = 0;
+	for (uint32_t n = 0; n < length; ++n) {
+		sum += design_tap(n, length, factor);
+	}
+
+	/* the rounding error of the quantized taps goes to the central one, so the average of
+	 * the conversions is kept exactly */
+	int32_t quantized_sum = 0;
+	for (uint32_t n = 0; n < length; ++n) {
+		int16_t tap = (int16_t)lroundf(design_tap(n, length, factor) / sum *
+				DECIMATOR_COEFFICIENT_ONE);
+		filter->coefficients[tap_index(filter, n)] = tap;
+		quantized_sum += tap;
+	}
+	filter->coefficients[tap_index(filter, length / 2)] +=
+			(int16_t)(DECIMATOR_COEFFICIENT_ONE - quantized_sum);
+
+	decimator_reset(filter);
+	return true;
+}
+/****************************************************************************************/
+
+void decimator_reset(decimator *filter)
+{
+	for (uint32_t q = 0; q < DECIMATOR_TAPS_PER_PHASE; ++q) {
+		filter->accumulators[q] = 0;
+	}
+	filter->phase = 0;
+	filter->settling = DECIMATOR_TAPS_PER_PHASE - 1;
+}
+/****************************************************************************************/
+
+bool IRAM_ATTR decimator_push(decimator *filter, uint16_t sample, uint16_t *output)
+{
+	/* the conversion is added to every output whose taps it falls in, the product of the
+	 * Q15 tap and the 12 bit conversion summed over the filter fits in 31 bits */
+	const int16_t *taps = filter->coefficients + filter->phase * DECIMATOR_TAPS_PER_PHASE;
+	for (uint32_t q = 0; q < DECIMATOR_TAPS_PER_PHASE; ++q) {
+		filter->accumulators[q] += taps[q] * (int32_t)sample;
+	}
+	if (++filter->phase < filter->factor) {
+		return false;
+	}
+
+	/* the oldest output is complete, the following ones move up */
+	filter->phase = 0;
+	int32_t value = (filter->accumulators[0] + (DECIMATOR_COEFFICIENT_ONE >> 1)) >>
+			DECIMATOR_COEFFICIENT_BITS;
+	for (uint32_t q = 1; q < DECIMATOR_TAPS_PER_PHASE; ++q) {
+		filter->accumulators[q-1] = filter->accumulators[q];
+	}
+	filter->accumulators[DECIMATOR_TAPS_PER_PHASE - 1] = 0;
+	if (0 != filter->settling) {
+		--filter->settling;
+		return false;
+	}
+	*output = (uint16_t)((value < 0) ? 0 :
+			(value > DECIMATOR_MAX_VALUE) ? DECIMATOR_MAX_VALUE : value);
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static float design_tap(uint32_t n, uint32_t length, uint8_t factor)
+{
+	float x = DECIMATOR_PI * (n - (length - 1) / 2.0f) / factor;
+	float window = 0.42f - 0.5f * cosf(2 * DECIMATOR_PI * n / (length - 1))
+			+ 0.08f * cosf(4 * DECIMATOR_PI * n / (length - 1));
+	return window * ((0 != x) ? sinf(x) / x : 1);
+}
+/****************************************************************************************/
+
+static uint32_t tap_index(const decimator *filter, uint32_t n)
+{
+	uint32_t phase = n % filter->factor;
+	uint32_t output = DECIMATOR_TAPS_PER_PHASE - 1 - n / filter->factor;
+	return phase * DECIMATOR_TAPS_PER_PHASE + output;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,103 @@
+/** decimator.h **/
+
+#ifndef COMPONENTS_MEASUREMENT_DECIMATOR_H_
+#define COMPONENTS_MEASUREMENT_DECIMATOR_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** maximal decimation factor, the conversions are taken at the factor times the output
+ * sampling frequency **/
+#define DECIMATOR_MAX_FACTOR			((uint8_t)16)
+
+/** number of the filter taps per output sample, the filter is the factor times longer. It
+ * passes up to DECIMATOR_PASSBAND_RELATIVE of the output sampling frequency within
+ * 0.01 dB and attenuates from DECIMATOR_STOPBAND_RELATIVE, whose aliases would fall into
+ * the passband, by more than 60 dB **/
+#define DECIMATOR_TAPS_PER_PHASE		((uint32_t)24)
+#define DECIMATOR_PASSBAND_RELATIVE		(0.38f)
+#define DECIMATOR_STOPBAND_RELATIVE		(0.62f)
+
+/** largest output value, the range of the 12 bit conversions **/
+#define DECIMATOR_MAX_VALUE				((int32_t)0x0fff)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** polyphase FIR decimator. Every conversion is multiplied by the taps of its phase and
+ * added to the DECIMATOR_TAPS_PER_PHASE outputs it belongs to, so the work is the same
+ * for every conversion and no history of the conversions is kept. **/
+typedef struct _decimator{
+	uint8_t factor;
+	uint8_t phase;
+	uint32_t settling;
+	int32_t accumulators[DECIMATOR_TAPS_PER_PHASE];
+	/** Q15 taps ordered by the phase and by the accumulator within the phase **/
+	int16_t coefficients[DECIMATOR_MAX_FACTOR * DECIMATOR_TAPS_PER_PHASE];
+} decimator;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+decimator_init
+******************************************************************************************
+Parameters:
+decimator *filter - decimator to be initialized
+uint8_t factor - decimation factor, 2 to DECIMATOR_MAX_FACTOR
+******************************************************************************************
+Abstract:
+This function designs the Blackman windowed sinc low pass with the cut off at half of the
+output sampling frequency, quantizes it to Q15 with the dc gain of exactly 1 and clears
+the state. It uses the floating point, so it must not be called from the interrupt. It
+returns false if the factor is out of the range.
+\****************************************************************************************/
+bool decimator_init(decimator *filter, uint8_t factor);
+
+/****************************************************************************************\
+Function:
+decimator_reset
+******************************************************************************************
+Parameters:
+decimator *filter - initialized decimator
+******************************************************************************************
+Abstract:
+This function clears the state before the next measurement. The first
+DECIMATOR_TAPS_PER_PHASE - 1 outputs, whose taps reach before the first conversion, are
+not returned.
+\****************************************************************************************/
+void decimator_reset(decimator *filter);
+
+/****************************************************************************************\
+Function:
+decimator_push
+******************************************************************************************
+Parameters:
+decimator *filter - initialized decimator
+uint16_t sample - next conversion
+uint16_t *output - destination of the decimated sample
+******************************************************************************************
+Abstract:
+This function passes the conversion through the filter. It returns true when the
+decimated sample is stored to the output, once per factor conversions after the filter
+settled. It uses the integer arithmetic only and is safe to use from the interrupt.
+\****************************************************************************************/
+bool decimator_push(decimator *filter, uint16_t sample, uint16_t *output);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_MEASUREMENT_DECIMATOR_H_ */
@@ -0,0 +1,120 @@
+/** event_capture.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "event_capture.h"
+#include "freertos/FreeRTOS.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool event_capture_init(event_capture *capture, uint16_t storage[], uint32_t capacity,
+				uint32_t pre_size, uint32_t post_size)
+{
+	capture->state = EVENT_CAPTURE_IDLE;
+	if ((0 == post_size) || (pre_size + post_size > capacity)) {
+		return false;
+	}
+	capture->storage = storage;
+	capture->mask = capacity - 1;
+	capture->pre_size = pre_size;
+	capture->post_size = post_size;
+	capture->head = 0;
+	capture->trigger = 0;
+	capture->is_wrapped = false;
+	return true;
+}
+/****************************************************************************************/
+
+void event_capture_arm(event_capture *capture)
+{
+	capture->head = 0;
+	capture->trigger = 0;
+	capture->is_wrapped = false;
+	capture->state = EVENT_CAPTURE_ARMED;
+}
+/****************************************************************************************/
+
+void IRAM_ATTR event_capture_trigger(event_capture *capture)
+{
+	if (EVENT_CAPTURE_ARMED == capture->state) {
+		capture->trigger = capture->head;
+		capture->state = EVENT_CAPTURE_TRIGGERED;
+	}
+}
+/****************************************************************************************/
+
+bool IRAM_ATTR event_capture_push(event_capture *capture, uint16_t sample)
+{
+	event_capture_state state = capture->state;
+	if ((EVENT_CAPTURE_ARMED != state) && (EVENT_CAPTURE_TRIGGERED != state)) {
+		return false;
+	}
+	capture->storage[capture->head & capture->mask] = sample;
+	if (0 == ++capture->head) {
+		capture->is_wrapped = true;
+	}
+	if ((EVENT_CAPTURE_TRIGGERED != state) ||
+			(capture->head - capture->trigger < capture->post_size)) {
+		return false;
+	}
+	capture->state = EVENT_CAPTURE_FROZEN;
+	return true;
+}
+/****************************************************************************************/
+
+uint32_t event_capture_read(event_capture *capture, uint16_t block[], uint32_t max_size,
+				uint32_t *pre_count)
+{
+	*pre_count = 0;
+	if (EVENT_CAPTURE_FROZEN != capture->state) {
+		return 0;
+	}
+
+	/* the samples before the trigger stored since the arming, at most the kept ones */
+	uint32_t pre = (!capture->is_wrapped && (capture->trigger < capture->pre_size)) ?
+			capture->trigger : capture->pre_size;
+	uint32_t start = capture->trigger - pre;
+	uint32_t count = pre + capture->post_size;
+	if (count > max_size) {
+		count = max_size;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		block[i] = capture->storage[(start + i) & capture->mask];
+	}
+	*pre_count = (pre < count) ? pre : count;
+	capture->state = EVENT_CAPTURE_IDLE;
+	return count;
+}
+/****************************************************************************************/
+
+event_capture_state event_capture_get_state(const event_capture *capture)
+{
+	return capture->state;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,146 @@
+/** event_capture.h **/
+
+#ifndef COMPONENTS_MEASUREMENT_EVENT_CAPTURE_H_
+#define COMPONENTS_MEASUREMENT_EVENT_CAPTURE_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** states of the capture, the samples are stored while it is armed or triggered **/
+typedef enum _event_capture_state{
+	EVENT_CAPTURE_IDLE = 0,
+	EVENT_CAPTURE_ARMED,
+	EVENT_CAPTURE_TRIGGERED,
+	EVENT_CAPTURE_FROZEN
+} event_capture_state;
+
+/** capture of the samples around the event. While armed, the samples overwrite the oldest
+ * ones of the storage, so the last ones before the event are always kept. The trigger
+ * marks the next sample as the first one of the event, the capture freezes once the
+ * samples after it are stored and is kept until it is read or armed again. **/
+typedef struct _event_capture{
+	uint16_t *storage;
+	uint32_t mask;
+	uint32_t pre_size;
+	uint32_t post_size;
+	/** number of the samples stored since armed and the one of the trigger, the wrapped
+	 * head means the storage is full **/
+	uint32_t head;
+	uint32_t trigger;
+	bool is_wrapped;
+	volatile event_capture_state state;
+} event_capture;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+event_capture_init
+******************************************************************************************
+Parameters:
+event_capture *capture - capture to be initialized
+uint16_t storage[] - memory used by the capture
+uint32_t capacity - number of samples in the storage, it has to be a power of two
+uint32_t pre_size - number of the samples kept before the trigger
+uint32_t post_size - number of the samples stored from the trigger on, at least 1
+******************************************************************************************
+Abstract:
+This function initializes the idle capture on top of the given storage. It returns false
+if the samples before and after the trigger do not fit in the storage.
+\****************************************************************************************/
+bool event_capture_init(event_capture *capture, uint16_t storage[], uint32_t capacity,
+				uint32_t pre_size, uint32_t post_size);
+
+/****************************************************************************************\
+Function:
+event_capture_arm
+******************************************************************************************
+Parameters:
+event_capture *capture - initialized capture
+******************************************************************************************
+Abstract:
+This function drops the stored samples and starts storing the pushed ones. It must not
+be called while the samples are pushed.
+\****************************************************************************************/
+void event_capture_arm(event_capture *capture);
+
+/****************************************************************************************\
+Function:
+event_capture_trigger
+******************************************************************************************
+Parameters:
+event_capture *capture - initialized capture
+******************************************************************************************
+Abstract:
+This function marks the next pushed sample as the first one of the event, if the capture
+is armed. It is called by the producer only and is safe to use from the interrupt.
+\****************************************************************************************/
+void event_capture_trigger(event_capture *capture);
+
+/****************************************************************************************\
+Function:
+event_capture_push
+******************************************************************************************
+Parameters:
+event_capture *capture - initialized capture
+uint16_t sample - next sample
+******************************************************************************************
+Abstract:
+This function stores the sample while the capture is armed or triggered. It returns true
+when the sample completes the capture, which freezes it. It is called by the producer
+only and is safe to use from the interrupt.
+\****************************************************************************************/
+bool event_capture_push(event_capture *capture, uint16_t sample);
+
+/****************************************************************************************\
+Function:
+event_capture_read
+******************************************************************************************
+Parameters:
+event_capture *capture - frozen capture
+uint16_t block[] - destination for the samples
+uint32_t max_size - maximal number of samples to be copied
+uint32_t *pre_count - destination of the number of the samples before the trigger
+******************************************************************************************
+Abstract:
+This function copies the frozen capture into the block in the order of the samples and
+makes it idle. Fewer than pre_size samples precede the trigger if it came sooner after
+the capture was armed. It returns the number of the copied samples, 0 if the capture is
+not frozen.
+\****************************************************************************************/
+uint32_t event_capture_read(event_capture *capture, uint16_t block[], uint32_t max_size,
+				uint32_t *pre_count);
+
+/****************************************************************************************\
+Function:
+event_capture_get_state
+******************************************************************************************
+Parameters:
+const event_capture *capture - initialized capture
+******************************************************************************************
+Abstract:
+This function returns the state of the capture.
+\****************************************************************************************/
+event_capture_state event_capture_get_state(const event_capture *capture);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_MEASUREMENT_EVENT_CAPTURE_H_ */
@@ -4,8 +4,16 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "measurement.h"
+#include "sample_ring_buffer.h"
+#include "decimator.h"
+#include "event_capture.h"
+#include "memory_arena.h"
 #include "driver/timer.h"
+#include "driver/i2s.h"
 #include "esp_intr_alloc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "../../main/task_controller.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
@@ -14,8 +22,32 @@
  *  it has minimal value due to size of timer counter (64b) 
  **/
 #define TIMER_DIVIDER_VALUE			((uint16_t)2) 
+#define TIMER_ALARM_VALUE(frequency)	((uint64_t)APB_CLK_FREQ/(TIMER_DIVIDER_VALUE*(frequency)))
 #define ZERO_VAL_AVERAGING_SAMPLES_NO 	((uint8_t)10)
-#define ACCELEROMETER_ADC_CHANNEL 	(ADC1_CHANNEL_7)
+
+/** I2S peripheral driving the built-in ADC in DMA mode **/
+#define MEASUREMENT_I2S_PORT			(I2S_NUM_0)
+/** number of samples in each DMA buffer, two buffers are used as ping-pong pair **/
+#define MEASUREMENT_DMA_BUFFER_LEN		((uint16_t)512)
+#define MEASUREMENT_DMA_BUFFER_COUNT	((uint8_t)2)
+/** the I2S samples carry the channel number in the upper nibble **/
+#define MEASUREMENT_DMA_SAMPLE_MASK		((uint16_t)0x0fff)
+
+/** capacity of the streaming ring buffer, it has to be a power of two **/
+#define MEASUREMENT_RING_BUFFER_LEN		((uint32_t)4096)
+/** number of produced samples after which the stream consumer is woken up **/
+#define MEASUREMENT_STREAM_NOTIFY_LEN	((uint32_t)256)
+/** timeout of the stream consumer waiting for the samples **/
+#define MEASUREMENT_STREAM_WAIT_TICKS	(10 / portTICK_PERIOD_MS)
+
+/** storage of the event capture, a power of two holding the samples before and after the
+ * trigger **/
+#define MEASUREMENT_CAPTURE_LEN			((uint32_t)2048)
+
+/** results of the monitoring of the conversion, the caller notifies the monitoring task
+ * and posts the finished capture **/
+#define MONITORING_NOTIFY				((uint8_t)0x01)
+#define MONITORING_CAPTURE_FROZEN		((uint8_t)0x02)
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Local typedefs																		//
@@ -24,11 +56,74 @@
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
-static uint16_t max_measurement_number;
+static uint32_t max_measurement_number;
 static uint16_t * measurement_ptr;
-static uint16_t current_measurement;
+static uint32_t current_measurement;
 static measurement_status current_status = MEASUREMENT_NOT_INITIALIZED;
 static uint16_t zero_val = 0;
+static adc1_channel_t measurement_channel = ADC1_CHANNEL_7;
+static measurement_backend current_backend = MEASUREMENT_BACKEND_TIMER;
+static uint16_t last_sample = 0;
+
+/** block read from the I2S driver by the DMA task **/
+static uint16_t dma_block[MEASUREMENT_DMA_BUFFER_LEN];
+
+/** streaming mode variables, the samples are passed through the ring buffer instead of
+ * being stored in the measurement buffer **/
+static bool is_streaming = false;
+static uint16_t stream_ring_storage[MEASUREMENT_RING_BUFFER_LEN];
+static sample_ring_buffer stream_ring;
+static volatile TaskHandle_t stream_consumer = NULL;
+
+/** decimation of the conversions taken at the factor times the sampling frequency, only
+ * the filtered samples are stored **/
+static bool is_decimating = false;
+static decimator sampler_decimator;
+
+/** oversampling, the sum of the factor conversions is stored as one sample shifted down
+ * to MEASUREMENT_MAX_SAMPLE_BITS, 0 factor for none **/
+static uint8_t oversampling_factor = 0;
+static uint8_t oversampling_shift = 0;
+static uint8_t oversampling_count = 0;
+static uint32_t oversampling_sum = 0;
+
+/** monitoring of the limits and by the monitor, every conversion is compared within the
+ * sampler. The conversions between the measurements are taken at the monitoring
+ * frequency, the ones of the measurements converted at the rate are resampled to it by
+ * the phase counting the monitoring periods **/
+static struct _monitoring{
+	volatile bool is_active;
+	volatile uint16_t low;
+	volatile uint16_t high;
+	measurement_monitor monitor;
+	uint16_t frequency;
+	volatile uint32_t rate;
+	uint32_t phase;
+	volatile uint16_t exceeded_sample;
+	volatile uint16_t max_val;
+	TaskHandle_t task;
+} monitoring;
+
+/** the monitoring is replaced by the tasks while the interrupt or the DMA task compares
+ * the conversions, both sides update it under this spinlock **/
+static portMUX_TYPE monitoring_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/** conversion frequency of the running measurement **/
+static uint32_t acquisition_frequency = 0;
+
+/** capture of the conversions passed to the monitor around the first one exceeding the
+ * limits, armed with the monitoring and frozen until it is read **/
+static uint16_t capture_storage[MEASUREMENT_CAPTURE_LEN];
+static event_capture capture;
+static volatile uint32_t capture_frequency = 0;
+
+/** storage reserved at boot for the buffered measurement or the read event capture, the
+ * buffer of the previous cycle is released when the next one is carved **/
+static uint64_t arena_storage[MEASUREMENT_ARENA_SIZE / sizeof(uint64_t)];
+static memory_arena arena;
+
+/** the I2S peripheral owns ADC1 while the DMA task reads the blocks **/
+static volatile bool is_dma_running = false;
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static functions prototypes															//
@@ -48,40 +143,219 @@ into the buffer.
 //TODO: convert to static??
 static void IRAM_ATTR measurement_timer_interrupt_function(void *param);
 
+/****************************************************************************************\
+Function:
+timer_backend_init
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function configures the timer which triggers one adc conversion per interrupt.
+\****************************************************************************************/
+static void timer_backend_init(void);
+
+/****************************************************************************************\
+Function:
+timer_backend_start
+******************************************************************************************
+Parameters:
+uint32_t frequency - desired conversion frequency
+******************************************************************************************
+Abstract:
+This function starts the timer with the alarm set to the conversion period.
+\****************************************************************************************/
+static void timer_backend_start(uint32_t frequency);
+
+/****************************************************************************************\
+Function:
+dma_backend_init
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function installs the I2S driver in the built-in ADC mode, so the conversions are
+moved to the DMA buffers without a per sample interrupt.
+\****************************************************************************************/
+static void dma_backend_init(void);
+
+/****************************************************************************************\
+Function:
+dma_backend_start
+******************************************************************************************
+Parameters:
+uint32_t frequency - desired conversion frequency
+******************************************************************************************
+Abstract:
+This function sets the I2S sample rate and wakes up the DMA task.
+\****************************************************************************************/
+static void dma_backend_start(uint32_t frequency);
+
+/****************************************************************************************\
+Function:
+dma_block_copy
+******************************************************************************************
+Parameters:
+const uint16_t block[] - block read from the I2S driver
+uint16_t dest[] - destination in the measurement buffer
+uint32_t size - number of samples to copy
+******************************************************************************************
+Abstract:
+This function copies the samples from the DMA block into the measurement buffer. The
+I2S peripheral stores every pair of 16 bit samples in swapped order and puts the channel
+number in the upper bits, so both are corrected during the copy.
+\****************************************************************************************/
+static void dma_block_copy(const uint16_t block[], uint16_t dest[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+dma_block_stream
+******************************************************************************************
+Parameters:
+const uint16_t block[] - block read from the I2S driver
+uint32_t size - number of samples to pass
+******************************************************************************************
+Abstract:
+Streaming counterpart of dma_block_copy. It pushes the corrected samples into the ring
+buffer and wakes up the stream consumer.
+\****************************************************************************************/
+static void dma_block_stream(const uint16_t block[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+dma_block_reduce
+******************************************************************************************
+Parameters:
+const uint16_t block[] - block read from the I2S driver
+uint32_t size - number of conversions in the block
+******************************************************************************************
+Abstract:
+Decimating and oversampling counterpart of dma_block_copy and dma_block_stream. It passes
+the corrected conversions through sampler_reduce and stores the resulting samples into
+the measurement buffer or the ring buffer until the measurement is complete. The
+conversions of the block left after that are dropped.
+\****************************************************************************************/
+static void dma_block_reduce(const uint16_t block[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+sampler_reduce
+******************************************************************************************
+Parameters:
+uint16_t *sample - conversion on input, sample to be stored on output
+******************************************************************************************
+Abstract:
+This function passes the conversion through the decimator and the oversampling
+accumulator, if they are set. It returns true when the sample is to be stored, once per
+decimation times oversampling conversions. It uses the integer arithmetic only and is
+safe to use from the interrupt.
+\****************************************************************************************/
+static bool IRAM_ATTR sampler_reduce(uint16_t *sample);
+
+/****************************************************************************************\
+Function:
+monitor_conversion
+******************************************************************************************
+Parameters:
+uint16_t conversion - raw adc conversion
+******************************************************************************************
+Abstract:
+This function compares the conversion with the limits while the monitoring is active,
+keeps the largest one and passes the ones ending a period of the monitoring frequency
+to the event capture and, with the number of the periods ended, to the monitor. The first conversion outside of the limits is stored, clears them and triggers
+the capture, the monitoring goes on until the capture is frozen. The function returns
+MONITORING_NOTIFY when the task is to be notified and MONITORING_CAPTURE_FROZEN when the
+capture is complete, the caller notifies the task and posts the event. It is safe to use
+from the interrupt.
+\****************************************************************************************/
+static uint8_t IRAM_ATTR monitor_conversion(uint16_t conversion);
+
+/****************************************************************************************\
+Function:
+signal_monitoring_from_isr
+******************************************************************************************
+Parameters:
+uint8_t result - result of monitor_conversion
+BaseType_t *higher_priority_task_woken - set if the notified task has to run
+******************************************************************************************
+Abstract:
+This function notifies the monitoring task and posts the finished capture to the
+controller from the interrupt, as requested by the result.
+\****************************************************************************************/
+static void IRAM_ATTR signal_monitoring_from_isr(uint8_t result,
+				BaseType_t *higher_priority_task_woken);
+
+/****************************************************************************************\
+Function:
+dma_block_monitor
+******************************************************************************************
+Parameters:
+const uint16_t block[] - block read from the I2S driver
+uint32_t size - number of conversions in the block
+******************************************************************************************
+Abstract:
+This function passes the corrected conversions of the block to monitor_conversion,
+notifies the task if the limits are exceeded and posts the finished capture. The block
+holds the swapped pairs, a trailing odd conversion is ignored.
+\****************************************************************************************/
+static void dma_block_monitor(const uint16_t block[], uint32_t size);
+
+/****************************************************************************************\
+Function:
+start_acquisition
+******************************************************************************************
+Parameters:
+uint16_t frequency - desired sampling frequency
+float duration - desired duration
+******************************************************************************************
+Abstract:
+This function resets the sample counters, the decimator and the oversampling accumulator
+and starts the configured backend at the conversion frequency. It returns false if the
+parameters are invalid or the conversion frequency exceeds the maximum of the backend,
+nothing is started then.
+\****************************************************************************************/
+static bool start_acquisition(uint16_t frequency, float duration);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global functions definitions															//
 //////////////////////////////////////////////////////////////////////////////////////////
 
-void measurement_init(adc1_channel_t channel, adc_atten_t attenuation, adc_bits_width_t width)
+void measurement_init(adc1_channel_t channel, adc_atten_t attenuation, adc_bits_width_t width,
+				measurement_backend backend)
 {
 	/* Initialize ADC */
 	adc1_config_width(width);
 	adc1_config_channel_atten(channel, attenuation);
-
-	/* Initialize timer */
-	timer_config_t config;
-	config.alarm_en = TIMER_ALARM_EN;
-	config.auto_reload = true;
-	config.divider = 16;
-	config.counter_dir = TIMER_COUNT_UP;
-	config.counter_en = TIMER_PAUSE;
-	config.intr_type = TIMER_INTR_LEVEL;
-	timer_isr_register(TIMER_GROUP_0, TIMER_0, measurement_timer_interrupt_function,
-				   	(void*)NULL, ESP_INTR_FLAG_IRAM, NULL);
-	timer_init(TIMER_GROUP_0, TIMER_0, &config);
-	current_status = MEASUREMENT_INITIALIZED;
+	measurement_channel = channel;
 
 	zero_val = 0;
 	for (uint8_t i = 0; i < ZERO_VAL_AVERAGING_SAMPLES_NO; ++i) {
-		zero_val += measurement_read(ACCELEROMETER_ADC_CHANNEL);
+		zero_val += measurement_read(channel);
 	}
 	zero_val /= ZERO_VAL_AVERAGING_SAMPLES_NO;
+	last_sample = zero_val;
+	memory_arena_init(&arena, arena_storage, sizeof(arena_storage));
+	event_capture_init(&capture, capture_storage, MEASUREMENT_CAPTURE_LEN,
+			MEASUREMENT_CAPTURE_PRE_LEN, MEASUREMENT_CAPTURE_POST_LEN);
 
+	/* Initialize the acquisition backend */
+	current_backend = backend;
+	if (MEASUREMENT_BACKEND_I2S_DMA == current_backend) {
+		dma_backend_init();
+	} else {
+		timer_backend_init();
+	}
+	current_status = MEASUREMENT_INITIALIZED;
 }
 /****************************************************************************************/
 
 uint16_t measurement_read(adc1_channel_t channel)
 {
+	/* ADC1 is owned by the I2S peripheral while the DMA capture runs */
+	if ((MEASUREMENT_BACKEND_I2S_DMA == current_backend) && is_dma_running) {
+		return last_sample;
+	}
 	return adc1_get_raw(channel);
 }
 /****************************************************************************************/
@@ -90,18 +364,15 @@ uint16_t * measurement_trigger(uint16_t frequency, float duration)
 {
 	if(duration > 0 && frequency > 0){
 	uint32_t counter = frequency*duration;
-	measurement_ptr = malloc(counter*sizeof(uint16_t));
-	max_measurement_number = counter;
-
-	uint64_t alarm_value = APB_CLK_FREQ/(TIMER_DIVIDER_VALUE*frequency);
-	timer_set_alarm_value(TIMER_GROUP_0, TIMER_0, alarm_value);
-	timer_set_divider(TIMER_GROUP_0, TIMER_0, TIMER_DIVIDER_VALUE);
-	timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0x00000000ULL);
-	timer_enable_intr(TIMER_GROUP_0, TIMER_0);
-	TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
-	timer_start(TIMER_GROUP_0, TIMER_0);
-	current_measurement = 0;
-	current_status = MEASUREMENT_ACTIVE;
+	memory_arena_reset(&arena);
+	measurement_ptr = memory_arena_alloc(&arena, counter*sizeof(uint16_t));
+	if (NULL == measurement_ptr) {
+		return NULL;
+	}
+	is_streaming = false;
+	if (!start_acquisition(frequency, duration)) {
+		measurement_ptr = NULL;
+	}
 	return measurement_ptr;
 	} else{
 		return NULL;
@@ -109,6 +380,189 @@ uint16_t * measurement_trigger(uint16_t frequency, float duration)
 }
 /****************************************************************************************/
 
+bool measurement_trigger_stream(uint16_t frequency, float duration)
+{
+	measurement_ptr = NULL;
+	sample_ring_buffer_init(&stream_ring, stream_ring_storage, MEASUREMENT_RING_BUFFER_LEN);
+	is_streaming = true;
+	return start_acquisition(frequency, duration);
+}
+/****************************************************************************************/
+
+uint32_t measurement_stream_read(uint16_t block[], uint32_t max_size)
+{
+	stream_consumer = xTaskGetCurrentTaskHandle();
+	while ((MEASUREMENT_ACTIVE == current_status) &&
+			(sample_ring_buffer_get_count(&stream_ring) < max_size)) {
+		ulTaskNotifyTake(pdTRUE, MEASUREMENT_STREAM_WAIT_TICKS);
+	}
+	return sample_ring_buffer_pop_block(&stream_ring, block, max_size);
+}
+/****************************************************************************************/
+
+bool measurement_set_decimation(uint8_t factor)
+{
+	if (MEASUREMENT_ACTIVE == current_status) {
+		return false;
+	}
+	if (factor <= 1) {
+		is_decimating = false;
+		return true;
+	}
+	is_decimating = decimator_init(&sampler_decimator, factor);
+	return is_decimating;
+}
+/****************************************************************************************/
+
+bool measurement_set_oversampling(uint8_t factor)
+{
+	if (MEASUREMENT_ACTIVE == current_status) {
+		return false;
+	}
+	oversampling_factor = 0;
+	oversampling_shift = 0;
+	if (factor <= 1) {
+		return true;
+	}
+	if ((factor < MEASUREMENT_MIN_OVERSAMPLING) || (factor > MEASUREMENT_MAX_OVERSAMPLING) ||
+			(0 != (factor & (factor - 1)))) {
+		return false;
+	}
+
+	/* the sum grows by a bit per doubling, the bits above the stored width are dropped */
+	uint8_t sum_bits = MEASUREMENT_CONVERSION_BITS;
+	for (uint8_t i = factor; i > 1; i >>= 1) {
+		++sum_bits;
+	}
+	if (sum_bits > MEASUREMENT_MAX_SAMPLE_BITS) {
+		oversampling_shift = sum_bits - MEASUREMENT_MAX_SAMPLE_BITS;
+	}
+	oversampling_factor = factor;
+	return true;
+}
+/****************************************************************************************/
+
+uint16_t measurement_get_sample_scale(void)
+{
+	return (0 != oversampling_factor) ? (oversampling_factor >> oversampling_shift) : 1;
+}
+/****************************************************************************************/
+
+void measurement_set_monitoring(uint16_t low, uint16_t high, measurement_monitor monitor,
+				uint16_t frequency, TaskHandle_t task)
+{
+	if (0 == frequency) {
+		return;
+	}
+	/* the limits of the whole range without the monitor detect nothing, the conversions
+	 * between the measurements are not started for them */
+	if ((0 == low) && (UINT16_MAX == high) && (NULL == monitor)) {
+		measurement_stop_monitoring();
+		return;
+	}
+	portENTER_CRITICAL(&monitoring_mux);
+	monitoring.low = low;
+	monitoring.high = high;
+	monitoring.monitor = monitor;
+	monitoring.frequency = frequency;
+	monitoring.rate = (MEASUREMENT_ACTIVE == current_status) ? acquisition_frequency :
+			frequency;
+	monitoring.phase = 0;
+	monitoring.task = task;
+	monitoring.max_val = 0;
+	event_capture_arm(&capture);
+	monitoring.is_active = true;
+	portEXIT_CRITICAL(&monitoring_mux);
+
+	/* the backend started by the measurement switches to the monitoring frequency once
+	 * the measurement is finished */
+	if (MEASUREMENT_ACTIVE == current_status) {
+		return;
+	}
+	if (MEASUREMENT_BACKEND_I2S_DMA == current_backend) {
+		dma_backend_start(frequency);
+	} else {
+		timer_backend_start(frequency);
+	}
+}
+/****************************************************************************************/
+
+void measurement_stop_monitoring(void)
+{
+	portENTER_CRITICAL(&monitoring_mux);
+	monitoring.is_active = false;
+	portEXIT_CRITICAL(&monitoring_mux);
+	/* the timer between the measurements is not left running until its next interrupt,
+	 * the measurement one pauses it once finished */
+	if ((MEASUREMENT_BACKEND_TIMER == current_backend) &&
+			(MEASUREMENT_ACTIVE != current_status)) {
+		timer_pause(TIMER_GROUP_0, TIMER_0);
+		timer_disable_intr(TIMER_GROUP_0, TIMER_0);
+	}
+}
+/****************************************************************************************/
+
+uint16_t measurement_get_monitoring_sample(void)
+{
+	return monitoring.exceeded_sample;
+}
+/****************************************************************************************/
+
+uint16_t measurement_get_monitoring_max(void)
+{
+	return monitoring.max_val;
+}
+/****************************************************************************************/
+
+void measurement_reset_monitoring_max(void)
+{
+	portENTER_CRITICAL(&monitoring_mux);
+	monitoring.max_val = 0;
+	portEXIT_CRITICAL(&monitoring_mux);
+}
+/****************************************************************************************/
+
+bool measurement_is_capture_ready(void)
+{
+	return EVENT_CAPTURE_FROZEN == event_capture_get_state(&capture);
+}
+/****************************************************************************************/
+
+uint16_t * measurement_read_capture(uint32_t *size, uint32_t *pre_count)
+{
+	*size = 0;
+	*pre_count = 0;
+	if (!measurement_is_capture_ready()) {
+		return NULL;
+	}
+	uint32_t capture_size = MEASUREMENT_CAPTURE_PRE_LEN + MEASUREMENT_CAPTURE_POST_LEN;
+	memory_arena_reset(&arena);
+	uint16_t *block = memory_arena_alloc(&arena, capture_size * sizeof(uint16_t));
+	if (NULL != block) {
+		*size = event_capture_read(&capture, block, capture_size, pre_count);
+	}
+	return block;
+}
+/****************************************************************************************/
+
+uint16_t measurement_get_capture_frequency(void)
+{
+	return (uint16_t)capture_frequency;
+}
+/****************************************************************************************/
+
+uint32_t measurement_get_arena_peak(void)
+{
+	return memory_arena_get_peak(&arena);
+}
+/****************************************************************************************/
+
+uint32_t measurement_get_lost_samples(void)
+{
+	return is_streaming ? stream_ring.overflow_count : 0;
+}
+/****************************************************************************************/
+
 measurement_status measurement_get_status(void)
 {
 	return current_status;
@@ -129,7 +583,77 @@ uint32_t measurement_get_size(void)
 
 uint16_t measurement_get_zero_val(void)
 {
-	return zero_val;
+	return zero_val * measurement_get_sample_scale();
+}
+/****************************************************************************************/
+
+void measurement_dma_task(void *pvParameter)
+{
+	while (true) {
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if ((MEASUREMENT_ACTIVE != current_status) && !monitoring.is_active) {
+			continue;
+		}
+
+		is_dma_running = true;
+		i2s_adc_enable(MEASUREMENT_I2S_PORT);
+		i2s_start(MEASUREMENT_I2S_PORT);
+		/* the blocks between the measurements are read for the monitoring only */
+		uint32_t carried = 0;
+		uint16_t carried_half = 0;
+		while ((MEASUREMENT_ACTIVE == current_status) || monitoring.is_active) {
+			/* the conversions come in the swapped pairs, the half of the pair ending the
+			 * read starts the next one, the pairs are taken whole */
+			dma_block[0] = carried_half;
+			int read_bytes = i2s_read_bytes(MEASUREMENT_I2S_PORT,
+					(char *)(dma_block + carried), sizeof(dma_block) - carried*sizeof(uint16_t),
+					portMAX_DELAY);
+			uint32_t count = carried + ((read_bytes > 0) ? read_bytes/sizeof(uint16_t) : 0);
+			uint32_t read_size = count & ~(uint32_t)0x1;
+			carried = count & 0x1;
+			carried_half = (0 != carried) ? dma_block[read_size] : 0;
+			if (0 == read_size) {
+				continue;
+			}
+			dma_block_monitor(dma_block, read_size);
+			if (MEASUREMENT_ACTIVE != current_status) {
+				continue;
+			}
+
+			if (is_decimating || (0 != oversampling_factor)) {
+				dma_block_reduce(dma_block, read_size);
+			} else {
+				uint32_t remaining = max_measurement_number - current_measurement;
+				uint32_t block_size = (remaining < read_size) ? remaining : read_size;
+				if (is_streaming) {
+					dma_block_stream(dma_block, block_size);
+				} else {
+					dma_block_copy(dma_block, measurement_ptr+current_measurement,
+							block_size);
+				}
+				current_measurement += block_size;
+			}
+			if (current_measurement < max_measurement_number) {
+				continue;
+			}
+
+			if (monitoring.is_active) {
+				i2s_set_sample_rates(MEASUREMENT_I2S_PORT, monitoring.frequency);
+			}
+			portENTER_CRITICAL(&monitoring_mux);
+			monitoring.rate = monitoring.frequency;
+			monitoring.phase = 0;
+			portEXIT_CRITICAL(&monitoring_mux);
+			current_status = MEASUREMENT_FINISHED;
+			if (NULL != stream_consumer) {
+				xTaskNotifyGive(stream_consumer);
+			}
+			controller_event_post(MEASUREMENT_FINISHED_EVENT);
+		}
+		i2s_stop(MEASUREMENT_I2S_PORT);
+		i2s_adc_disable(MEASUREMENT_I2S_PORT);
+		is_dma_running = false;
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -138,17 +662,297 @@ uint16_t measurement_get_zero_val(void)
 
 static void IRAM_ATTR measurement_timer_interrupt_function(void *param)
 {
-	if(current_measurement < max_measurement_number){
+	BaseType_t higher_priority_task_woken = pdFALSE;
+	if (MEASUREMENT_ACTIVE != current_status) {
+		/* conversion between the measurements, taken for the monitoring only */
 		TIMERG0.int_clr_timers.t0 = 1;
+		if (!monitoring.is_active) {
+			timer_pause(TIMER_GROUP_0, TIMER_0);
+			timer_disable_intr(TIMER_GROUP_0, TIMER_0);
+			return;
+		}
 		TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
-		*(measurement_ptr+current_measurement) = adc1_get_raw(ACCELEROMETER_ADC_CHANNEL);
-		++current_measurement;
+		signal_monitoring_from_isr(monitor_conversion(adc1_get_raw(measurement_channel)),
+				&higher_priority_task_woken);
+	} else if(current_measurement < max_measurement_number){
+		TIMERG0.int_clr_timers.t0 = 1;
+		TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
+		uint16_t sample = adc1_get_raw(measurement_channel);
+		signal_monitoring_from_isr(monitor_conversion(sample), &higher_priority_task_woken);
+		if (sampler_reduce(&sample)) {
+			if (is_streaming) {
+				sample_ring_buffer_push(&stream_ring, sample);
+			} else {
+				*(measurement_ptr+current_measurement) = sample;
+			}
+			++current_measurement;
+			if (is_streaming && (NULL != stream_consumer) &&
+					(0 == (current_measurement % MEASUREMENT_STREAM_NOTIFY_LEN))) {
+				vTaskNotifyGiveFromISR(stream_consumer, &higher_priority_task_woken);
+			}
+		}
 	} else{
 		TIMERG0.int_clr_timers.t0 = 1;
-		timer_pause(TIMER_GROUP_0, TIMER_0);
-		timer_disable_intr(TIMER_GROUP_0, TIMER_0);
+		if (monitoring.is_active) {
+			/* the timer goes on at the monitoring frequency */
+			TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
+			timer_set_alarm_value(TIMER_GROUP_0, TIMER_0,
+					TIMER_ALARM_VALUE(monitoring.frequency));
+		} else {
+			timer_pause(TIMER_GROUP_0, TIMER_0);
+			timer_disable_intr(TIMER_GROUP_0, TIMER_0);
+		}
+		portENTER_CRITICAL(&monitoring_mux);
+		monitoring.rate = monitoring.frequency;
+		monitoring.phase = 0;
+		portEXIT_CRITICAL(&monitoring_mux);
 		current_status = MEASUREMENT_FINISHED;
+		if (NULL != stream_consumer) {
+			vTaskNotifyGiveFromISR(stream_consumer, NULL);
+		}
+		controller_event_post_from_isr(MEASUREMENT_FINISHED_EVENT);
+	}
+	if (pdTRUE == higher_priority_task_woken) {
+		portYIELD_FROM_ISR();
+	}
+}
+/****************************************************************************************/
+
+static void timer_backend_init(void)
+{
+	timer_config_t config;
+	config.alarm_en = TIMER_ALARM_EN;
+	config.auto_reload = true;
+	config.divider = 16;
+	config.counter_dir = TIMER_COUNT_UP;
+	config.counter_en = TIMER_PAUSE;
+	config.intr_type = TIMER_INTR_LEVEL;
+	timer_isr_register(TIMER_GROUP_0, TIMER_0, measurement_timer_interrupt_function,
+				   	(void*)NULL, ESP_INTR_FLAG_IRAM, NULL);
+	timer_init(TIMER_GROUP_0, TIMER_0, &config);
+}
+/****************************************************************************************/
+
+static void timer_backend_start(uint32_t frequency)
+{
+	/* a running monitoring is paused before the counter is reset */
+	timer_pause(TIMER_GROUP_0, TIMER_0);
+	timer_set_alarm_value(TIMER_GROUP_0, TIMER_0, TIMER_ALARM_VALUE(frequency));
+	timer_set_divider(TIMER_GROUP_0, TIMER_0, TIMER_DIVIDER_VALUE);
+	timer_set_counter_value(TIMER_GROUP_0, TIMER_0, 0x00000000ULL);
+	timer_enable_intr(TIMER_GROUP_0, TIMER_0);
+	TIMERG0.hw_timer[0].config.alarm_en = TIMER_ALARM_EN;
+	timer_start(TIMER_GROUP_0, TIMER_0);
+}
+/****************************************************************************************/
+
+static void dma_backend_init(void)
+{
+	i2s_config_t config = {
+		.mode = I2S_MODE_MASTER | I2S_MODE_RX | I2S_MODE_ADC_BUILT_IN,
+		.sample_rate = 1000,
+		.bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+		.channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,
+		.communication_format = I2S_COMM_FORMAT_I2S_MSB,
+		.intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+		.dma_buf_count = MEASUREMENT_DMA_BUFFER_COUNT,
+		.dma_buf_len = MEASUREMENT_DMA_BUFFER_LEN,
+		.use_apll = false,
+	};
+	i2s_driver_install(MEASUREMENT_I2S_PORT, &config, 0, NULL);
+	i2s_set_adc_mode(ADC_UNIT_1, measurement_channel);
+	i2s_stop(MEASUREMENT_I2S_PORT);
+}
+/****************************************************************************************/
+
+static void dma_backend_start(uint32_t frequency)
+{
+	i2s_set_sample_rates(MEASUREMENT_I2S_PORT, frequency);
+	xTaskNotifyGive(get_task_handle(MEASUREMENT_DMA_TASK_HANDLE));
+}
+/****************************************************************************************/
+
+static void dma_block_copy(const uint16_t block[], uint16_t dest[], uint32_t size)
+{
+	for (uint32_t i = 0; i < size; ++i) {
+		dest[i] = block[i ^ 0x1] & MEASUREMENT_DMA_SAMPLE_MASK;
+	}
+}
+/****************************************************************************************/
+
+static void dma_block_stream(const uint16_t block[], uint32_t size)
+{
+	for (uint32_t i = 0; i < size; ++i) {
+		sample_ring_buffer_push(&stream_ring, block[i ^ 0x1] & MEASUREMENT_DMA_SAMPLE_MASK);
+	}
+	if (NULL != stream_consumer) {
+		xTaskNotifyGive(stream_consumer);
+	}
+}
+/****************************************************************************************/
+
+static void dma_block_reduce(const uint16_t block[], uint32_t size)
+{
+	for (uint32_t i = 0; (i < size) && (current_measurement < max_measurement_number); ++i) {
+		uint16_t sample = block[i ^ 0x1] & MEASUREMENT_DMA_SAMPLE_MASK;
+		if (!sampler_reduce(&sample)) {
+			continue;
+		}
+		if (is_streaming) {
+			sample_ring_buffer_push(&stream_ring, sample);
+		} else {
+			measurement_ptr[current_measurement] = sample;
+		}
+		++current_measurement;
+	}
+	if (is_streaming && (NULL != stream_consumer)) {
+		xTaskNotifyGive(stream_consumer);
+	}
+}
+/****************************************************************************************/
+
+static void dma_block_monitor(const uint16_t block[], uint32_t size)
+{
+	/* the swapped pairs are indexed, so only the whole ones are taken */
+	if (size < 2) {
+		return;
+	}
+	size &= ~(uint32_t)0x1;
+	last_sample = block[(size-1) ^ 0x1] & MEASUREMENT_DMA_SAMPLE_MASK;
+	for (uint32_t i = 0; (i < size) && monitoring.is_active; ++i) {
+		uint8_t result = monitor_conversion(block[i ^ 0x1] & MEASUREMENT_DMA_SAMPLE_MASK);
+		if (0 != (result & MONITORING_NOTIFY)) {
+			xTaskNotifyGive(monitoring.task);
+		}
+		if (0 != (result & MONITORING_CAPTURE_FROZEN)) {
+			controller_event_post(CAPTURE_FINISHED_EVENT);
+		}
+	}
+}
+/****************************************************************************************/
+
+static bool IRAM_ATTR sampler_reduce(uint16_t *sample)
+{
+	if (is_decimating && !decimator_push(&sampler_decimator, *sample, sample)) {
+		return false;
+	}
+	if (0 == oversampling_factor) {
+		return true;
+	}
+	oversampling_sum += *sample;
+	if (++oversampling_count < oversampling_factor) {
+		return false;
+	}
+	*sample = (uint16_t)((oversampling_sum + ((1UL << oversampling_shift) >> 1)) >>
+			oversampling_shift);
+	oversampling_sum = 0;
+	oversampling_count = 0;
+	return true;
+}
+/****************************************************************************************/
+
+static uint8_t IRAM_ATTR monitor_conversion(uint16_t conversion)
+{
+	uint8_t result = 0;
+	portENTER_CRITICAL(&monitoring_mux);
+	if (!monitoring.is_active) {
+		portEXIT_CRITICAL(&monitoring_mux);
+		return result;
+	}
+	if (conversion > monitoring.max_val) {
+		monitoring.max_val = conversion;
+	}
+	if ((conversion < monitoring.low) || (conversion > monitoring.high)) {
+		monitoring.exceeded_sample = conversion;
+		monitoring.low = 0;
+		monitoring.high = UINT16_MAX;
+		/* the exceeding conversion is the first one of the event, it ends the period */
+		event_capture_trigger(&capture);
+		capture_frequency = (monitoring.rate < monitoring.frequency) ? monitoring.rate :
+				monitoring.frequency;
+		if (monitoring.phase + monitoring.frequency < monitoring.rate) {
+			monitoring.phase = monitoring.rate - monitoring.frequency;
+		}
+		monitoring.is_active = (NULL != monitoring.monitor) ||
+				(EVENT_CAPTURE_TRIGGERED == capture.state);
+		result |= MONITORING_NOTIFY;
+	}
+	/* the conversions faster than the monitoring frequency end at most one period, the
+	 * slower ones several, so the monitor keeps its time at any conversion frequency */
+	monitoring.phase += monitoring.frequency;
+	if (monitoring.phase < monitoring.rate) {
+		portEXIT_CRITICAL(&monitoring_mux);
+		return result;
+	}
+	uint32_t periods = monitoring.phase / monitoring.rate;
+	monitoring.phase -= periods * monitoring.rate;
+	if (event_capture_push(&capture, conversion)) {
+		monitoring.is_active = (NULL != monitoring.monitor);
+		result |= MONITORING_CAPTURE_FROZEN;
+	}
+	if ((NULL != monitoring.monitor) && monitoring.monitor(conversion, periods)) {
+		result |= MONITORING_NOTIFY;
+	}
+	portEXIT_CRITICAL(&monitoring_mux);
+	return result;
+}
+/****************************************************************************************/
+
+static void IRAM_ATTR signal_monitoring_from_isr(uint8_t result,
+				BaseType_t *higher_priority_task_woken)
+{
+	if (0 != (result & MONITORING_NOTIFY)) {
+		vTaskNotifyGiveFromISR(monitoring.task, higher_priority_task_woken);
+	}
+	if (0 != (result & MONITORING_CAPTURE_FROZEN)) {
+		controller_event_post_from_isr(CAPTURE_FINISHED_EVENT);
+	}
+}
+/****************************************************************************************/
+
+static bool start_acquisition(uint16_t frequency, float duration)
+{
+	if (duration <= 0 || frequency == 0) {
+		return false;
+	}
+	uint32_t conversion_frequency = frequency;
+	if (is_decimating) {
+		conversion_frequency *= sampler_decimator.factor;
+	}
+	if (0 != oversampling_factor) {
+		conversion_frequency *= oversampling_factor;
+	}
+	if (conversion_frequency > ((MEASUREMENT_BACKEND_I2S_DMA == current_backend) ?
+			MEASUREMENT_DMA_MAX_CONVERSION_FREQUENCY :
+			MEASUREMENT_TIMER_MAX_CONVERSION_FREQUENCY)) {
+		return false;
+	}
+	if (MEASUREMENT_BACKEND_TIMER == current_backend) {
+		/* the monitoring conversions stop before the counters are reset */
+		timer_pause(TIMER_GROUP_0, TIMER_0);
+	}
+	max_measurement_number = frequency*duration;
+	current_measurement = 0;
+	if (is_decimating) {
+		decimator_reset(&sampler_decimator);
+	}
+	if (0 != oversampling_factor) {
+		oversampling_sum = 0;
+		oversampling_count = 0;
+	}
+	acquisition_frequency = conversion_frequency;
+	portENTER_CRITICAL(&monitoring_mux);
+	monitoring.rate = conversion_frequency;
+	monitoring.phase = 0;
+	portEXIT_CRITICAL(&monitoring_mux);
+	current_status = MEASUREMENT_ACTIVE;
+
+	if (MEASUREMENT_BACKEND_I2S_DMA == current_backend) {
+		dma_backend_start(conversion_frequency);
+	} else {
+		timer_backend_start(conversion_frequency);
 	}
+	return true;
 }
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
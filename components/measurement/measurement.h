@@ -7,11 +7,50 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "stdint.h"
+#include "stdbool.h"
 #include "driver/adc.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
+/** resolution of the adc conversions and the largest one of the stored samples **/
+#define MEASUREMENT_CONVERSION_BITS		(12)
+#define MEASUREMENT_MAX_SAMPLE_BITS		(16)
+
+/** oversampling factors, powers of two. The sum of the factor conversions is stored as
+ * one sample, reduced to MEASUREMENT_MAX_SAMPLE_BITS, so 4x gives 14 bit and 16x to 64x
+ * give 16 bit samples **/
+#define MEASUREMENT_MIN_OVERSAMPLING	((uint8_t)4)
+#define MEASUREMENT_MAX_OVERSAMPLING	((uint8_t)64)
+
+/** maximal conversion frequency, the requested one times the decimation and the
+ * oversampling factors, of the timer backend reading one conversion per alarm interrupt
+ * and of the I2S DMA one bounded by the SAR ADC **/
+#define MEASUREMENT_TIMER_MAX_CONVERSION_FREQUENCY	((uint32_t)50000)
+#define MEASUREMENT_DMA_MAX_CONVERSION_FREQUENCY	((uint32_t)2000000)
+
+/** event capture of the monitoring, the conversions passed to the monitor are kept before
+ * the one exceeding the limits and stored from it on **/
+#define MEASUREMENT_CAPTURE_PRE_LEN		((uint32_t)1024)
+#define MEASUREMENT_CAPTURE_POST_LEN	((uint32_t)1024)
+
+/** bytes reserved at boot for the samples of the buffered measurement and of the event
+ * capture, set by CONFIG_MEASUREMENT_ARENA_SIZE in menuconfig (the sdkconfig comes with
+ * freertos/FreeRTOS.h), the host build keeps the default **/
+#ifndef MEASUREMENT_ARENA_SIZE
+#ifdef CONFIG_MEASUREMENT_ARENA_SIZE
+#define MEASUREMENT_ARENA_SIZE			((uint32_t)CONFIG_MEASUREMENT_ARENA_SIZE)
+#else
+#define MEASUREMENT_ARENA_SIZE			((uint32_t)65536)
+#endif
+#endif
+
+/** samples of the longest buffered measurement, the frequency times the duration, 32768
+ * with the default arena, the longer requests are refused at the trigger write and have
+ * to be streamed **/
+#define MEASUREMENT_MAX_SAMPLES			(MEASUREMENT_ARENA_SIZE / (uint32_t)sizeof(uint16_t))
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global typedefs																		//
@@ -23,6 +62,18 @@ typedef enum{
 	MEASUREMENT_FINISHED
 } measurement_status;
 
+/** enum determining the acquisition backend used for the measurement **/
+typedef enum{
+	MEASUREMENT_BACKEND_TIMER = 0,
+	MEASUREMENT_BACKEND_I2S_DMA
+} measurement_backend;
+
+/** function of the monitoring called by the sampler with the raw conversions, each one
+ * standing for the number of the periods of the monitoring frequency it ends, more than
+ * one while the measurement converts slower. It returns true to notify the monitoring
+ * task **/
+typedef bool (*measurement_monitor)(uint16_t conversion, uint32_t periods);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -39,12 +90,15 @@ Parameters:
 adc_channel_t channel - chosen adc channel to initialize
 adc_atten_t attenuation - chosen attenuation defining the range of adc measurements
 adc_bits_width_t width - the resolution of adc measurements
+measurement_backend backend - acquisition backend, either one timer interrupt per sample
+or the I2S peripheral moving conversions to the DMA buffers
 ******************************************************************************************
 Abstract:
 This function initializes chosen adc channel to enable taking measurements with chosen
 parameters.
 \****************************************************************************************/
-void measurement_init(adc1_channel_t channel, adc_atten_t attenuation, adc_bits_width_t width);
+void measurement_init(adc1_channel_t channel, adc_atten_t attenuation, adc_bits_width_t width,
+				measurement_backend backend);
 
 /****************************************************************************************\
 Function:
@@ -69,10 +123,242 @@ float duration - desired duration
 Abstract:
 This function triggers measurement with the desired parameters. It configures the timer
 to be used for collecting adc conversion results into the buffer. It returns pointer to
-the stored measured values.
+the stored measured values, NULL if they do not fit in MEASUREMENT_ARENA_SIZE or the
+conversion frequency exceeds the maximum of the backend. The
+buffer is carved from the arena reserved at boot, it must not be freed and is valid
+until the next measurement is triggered or the event capture is read.
 \****************************************************************************************/
 uint16_t * measurement_trigger(uint16_t frequency, float duration);
 
+/****************************************************************************************\
+Function:
+measurement_trigger_stream
+******************************************************************************************
+Parameters:
+uint16_t frequency - desired frequency
+float duration - desired duration
+******************************************************************************************
+Abstract:
+This function triggers measurement in the streaming mode. No measurement buffer is
+allocated, the samples are passed through a fixed size ring buffer and have to be taken
+by the consumer with measurement_stream_read, so the duration is not limited by the
+available memory. It returns false if the parameters are invalid or the conversion
+frequency exceeds the maximum of the backend.
+\****************************************************************************************/
+bool measurement_trigger_stream(uint16_t frequency, float duration);
+
+/****************************************************************************************\
+Function:
+measurement_set_decimation
+******************************************************************************************
+Parameters:
+uint8_t factor - decimation factor, 0 or 1 for none, up to DECIMATOR_MAX_FACTOR
+******************************************************************************************
+Abstract:
+This function sets the decimation of the following measurements. The adc converts at the
+factor times the requested frequency, the conversions are low pass filtered by the
+polyphase FIR decimator within the sampler and only every factor-th filtered sample is
+stored or streamed, so the frequency and the size of the measurement are the ones
+requested. It must not be called from the interrupt. It returns false while the
+measurement is active and for the unsupported factor, which switches the decimation off.
+\****************************************************************************************/
+bool measurement_set_decimation(uint8_t factor);
+
+/****************************************************************************************\
+Function:
+measurement_set_oversampling
+******************************************************************************************
+Parameters:
+uint8_t factor - oversampling factor, 0 or 1 for none, power of two from
+MEASUREMENT_MIN_OVERSAMPLING to MEASUREMENT_MAX_OVERSAMPLING
+******************************************************************************************
+Abstract:
+This function sets the oversampling of the following measurements. The adc converts at
+the factor times the requested frequency, after the decimation if it is set, and every
+factor conversions are accumulated within the sampler into one sample. The averaging of
+the noise adds half a bit of the effective resolution per doubling of the factor, the
+samples are wider than the conversions by measurement_get_sample_scale. It must not be
+called from the interrupt. It returns false while the measurement is active and for the
+unsupported factor, which switches the oversampling off.
+\****************************************************************************************/
+bool measurement_set_oversampling(uint8_t factor);
+
+/****************************************************************************************\
+Function:
+measurement_get_sample_scale
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the number of the sample counts per adc count with the current
+oversampling, 1 without it. The sensitivity of the samples is the one of the adc divided
+by it.
+\****************************************************************************************/
+uint16_t measurement_get_sample_scale(void);
+
+/****************************************************************************************\
+Function:
+measurement_set_monitoring
+******************************************************************************************
+Parameters:
+uint16_t low - lowest conversion within the limits
+uint16_t high - highest conversion within the limits
+measurement_monitor monitor - function called with the conversions, NULL for none
+uint16_t frequency - conversion frequency of the monitoring between the measurements
+TaskHandle_t task - task notified when a conversion exceeds the limits or by the monitor
+******************************************************************************************
+Abstract:
+This function starts the monitoring within the sampler. Every adc conversion, the ones of
+the measurements before the decimation and the oversampling and the ones taken at the
+frequency between the measurements, is compared with the limits. The first conversion
+outside of them is kept for measurement_get_monitoring_sample, the limits are cleared,
+the task is notified and the event capture armed by this function is triggered. The
+monitor is called from the interrupt with the conversions at the monitoring frequency,
+the ones of the measurements are resampled to it, the faster conversions are passed once
+per monitoring period and the slower ones stand for the several periods they last. The monitoring runs until it is stopped or, without the monitor,
+until the limits are exceeded and the capture is complete. The conversions between the
+measurements run only while the monitoring is active, the limits of the whole range
+without the monitor stop it. It must not be called from the interrupt.
+\****************************************************************************************/
+void measurement_set_monitoring(uint16_t low, uint16_t high, measurement_monitor monitor,
+				uint16_t frequency, TaskHandle_t task);
+
+/****************************************************************************************\
+Function:
+measurement_stop_monitoring
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function stops the monitoring. The timer of the conversions between the
+measurements is paused at once, the I2S DMA ones stop after the block being read.
+\****************************************************************************************/
+void measurement_stop_monitoring(void);
+
+/****************************************************************************************\
+Function:
+measurement_get_monitoring_sample
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the conversion which exceeded the limits of the monitoring.
+\****************************************************************************************/
+uint16_t measurement_get_monitoring_sample(void);
+
+/****************************************************************************************\
+Function:
+measurement_get_monitoring_max
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the largest conversion monitored since the monitoring was set or
+since measurement_reset_monitoring_max.
+\****************************************************************************************/
+uint16_t measurement_get_monitoring_max(void);
+
+/****************************************************************************************\
+Function:
+measurement_reset_monitoring_max
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function resets the largest monitored conversion to 0.
+\****************************************************************************************/
+void measurement_reset_monitoring_max(void);
+
+/****************************************************************************************\
+Function:
+measurement_is_capture_ready
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns true when the event capture is complete and not read yet. The
+completion is posted to the controller as CAPTURE_FINISHED_EVENT.
+\****************************************************************************************/
+bool measurement_is_capture_ready(void);
+
+/****************************************************************************************\
+Function:
+measurement_read_capture
+******************************************************************************************
+Parameters:
+uint32_t *size - destination of the number of the read samples
+uint32_t *pre_count - destination of the number of the samples before the event
+******************************************************************************************
+Abstract:
+This function copies the complete event capture, up to MEASUREMENT_CAPTURE_PRE_LEN raw
+conversions before the one exceeding the limits and MEASUREMENT_CAPTURE_POST_LEN from it
+on, into the arena of the buffered measurement and releases the capture. It returns the
+pointer to the samples, valid like the one of measurement_trigger, or NULL if no capture
+is ready.
+\****************************************************************************************/
+uint16_t * measurement_read_capture(uint32_t *size, uint32_t *pre_count);
+
+/****************************************************************************************\
+Function:
+measurement_get_capture_frequency
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the sampling frequency of the event capture, the monitoring one
+or, if the limits were exceeded during a measurement, the one of the conversions passed
+to the monitor. The capture spanning the start or the end of a measurement mixes them.
+\****************************************************************************************/
+uint16_t measurement_get_capture_frequency(void);
+
+/****************************************************************************************\
+Function:
+measurement_stream_read
+******************************************************************************************
+Parameters:
+uint16_t block[] - destination for the samples
+uint32_t max_size - maximal number of samples to be read
+******************************************************************************************
+Abstract:
+This function blocks until max_size samples are available in the streaming ring buffer
+or the measurement is finished and then moves them into the block. It returns the number
+of read samples, 0 means the end of the stream. It has to be called from one task only.
+\****************************************************************************************/
+uint32_t measurement_stream_read(uint16_t block[], uint32_t max_size);
+
+/****************************************************************************************\
+Function:
+measurement_get_arena_peak
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the highest number of the bytes of MEASUREMENT_ARENA_SIZE used by
+the buffered measurements and the read event captures since the init.
+\****************************************************************************************/
+uint32_t measurement_get_arena_peak(void);
+
+/****************************************************************************************\
+Function:
+measurement_get_lost_samples
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the number of samples dropped because the streaming ring buffer
+was full.
+\****************************************************************************************/
+uint32_t measurement_get_lost_samples(void);
+
 /****************************************************************************************\
 Function:
 measurement_get_status
@@ -117,10 +403,25 @@ Parameters:
 None.
 ******************************************************************************************
 Abstract:
-This function returns zero value of the sensor from init phase.
+This function returns zero value of the sensor from init phase, in the sample counts of
+the current oversampling.
 \****************************************************************************************/
 uint16_t measurement_get_zero_val(void);
 
+/****************************************************************************************\
+Function:
+measurement_dma_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This is the task of the I2S DMA backend. It blocks until the measurement or the
+monitoring is started, then moves the DMA blocks into the measurement buffer until it is
+full and passes them to the monitoring while it is active.
+\****************************************************************************************/
+void measurement_dma_task(void *pvParameter);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,68 @@
+/** memory_arena.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "memory_arena.h"
+#include <stddef.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void memory_arena_init(memory_arena *arena, void *storage, uint32_t size)
+{
+	arena->storage = storage;
+	arena->size = size;
+	arena->used = 0;
+	arena->peak = 0;
+}
+/****************************************************************************************/
+
+void * memory_arena_alloc(memory_arena *arena, uint32_t size)
+{
+	/* the used bytes are kept aligned, so the next block starts aligned */
+	uint32_t aligned_size = (size + MEMORY_ARENA_ALIGNMENT - 1) &
+			~(MEMORY_ARENA_ALIGNMENT - 1);
+	if ((0 == size) || (aligned_size < size) || (aligned_size > arena->size - arena->used)) {
+		return NULL;
+	}
+	void *block = arena->storage + arena->used;
+	arena->used += aligned_size;
+	if (arena->used > arena->peak) {
+		arena->peak = arena->used;
+	}
+	return block;
+}
+/****************************************************************************************/
+
+void memory_arena_reset(memory_arena *arena)
+{
+	arena->used = 0;
+}
+/****************************************************************************************/
+
+uint32_t memory_arena_get_peak(const memory_arena *arena)
+{
+	return arena->peak;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,96 @@
+/** memory_arena.h **/
+
+#ifndef COMPONENTS_MEASUREMENT_MEMORY_ARENA_H_
+#define COMPONENTS_MEASUREMENT_MEMORY_ARENA_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** alignment of the carved blocks, enough for any type stored in them **/
+#define MEMORY_ARENA_ALIGNMENT			((uint32_t)8)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** bump allocator over the storage reserved at boot. The blocks are carved one after
+ * another and released all at once by the reset, so the storage never fragments and the
+ * allocation takes constant time. **/
+typedef struct _memory_arena{
+	uint8_t *storage;
+	uint32_t size;
+	uint32_t used;
+	/** highest use since the initialization **/
+	uint32_t peak;
+} memory_arena;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+memory_arena_init
+******************************************************************************************
+Parameters:
+memory_arena *arena - arena to be initialized
+void *storage - memory used by the arena, aligned to MEMORY_ARENA_ALIGNMENT
+uint32_t size - number of bytes of the storage
+******************************************************************************************
+Abstract:
+This function initializes the empty arena on top of the given storage.
+\****************************************************************************************/
+void memory_arena_init(memory_arena *arena, void *storage, uint32_t size);
+
+/****************************************************************************************\
+Function:
+memory_arena_alloc
+******************************************************************************************
+Parameters:
+memory_arena *arena - initialized arena
+uint32_t size - number of bytes of the block
+******************************************************************************************
+Abstract:
+This function carves the aligned block behind the last one. It returns NULL if the block
+does not fit in the rest of the storage.
+\****************************************************************************************/
+void * memory_arena_alloc(memory_arena *arena, uint32_t size);
+
+/****************************************************************************************\
+Function:
+memory_arena_reset
+******************************************************************************************
+Parameters:
+memory_arena *arena - initialized arena
+******************************************************************************************
+Abstract:
+This function releases all the carved blocks. They must not be used afterwards.
+\****************************************************************************************/
+void memory_arena_reset(memory_arena *arena);
+
+/****************************************************************************************\
+Function:
+memory_arena_get_peak
+******************************************************************************************
+Parameters:
+const memory_arena *arena - initialized arena
+******************************************************************************************
+Abstract:
+This function returns the highest number of the used bytes since the initialization.
+\****************************************************************************************/
+uint32_t memory_arena_get_peak(const memory_arena *arena);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_MEASUREMENT_MEMORY_ARENA_H_ */
@@ -0,0 +1,82 @@
+/** sample_ring_buffer.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "sample_ring_buffer.h"
+#include "freertos/FreeRTOS.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+void sample_ring_buffer_init(sample_ring_buffer *ring, uint16_t storage[], uint32_t capacity)
+{
+	ring->storage = storage;
+	ring->mask = capacity - 1;
+	ring->head = 0;
+	ring->tail = 0;
+	ring->overflow_count = 0;
+}
+/****************************************************************************************/
+
+bool IRAM_ATTR sample_ring_buffer_push(sample_ring_buffer *ring, uint16_t sample)
+{
+	uint32_t head = ring->head;
+	uint32_t tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+	if ((head - tail) > ring->mask) {
+		++ring->overflow_count;
+		return false;
+	}
+	ring->storage[head & ring->mask] = sample;
+	__atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+	return true;
+}
+/****************************************************************************************/
+
+uint32_t sample_ring_buffer_pop_block(sample_ring_buffer *ring, uint16_t block[],
+				uint32_t max_size)
+{
+	uint32_t tail = ring->tail;
+	uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+	uint32_t count = head - tail;
+	if (count > max_size) {
+		count = max_size;
+	}
+	for (uint32_t i = 0; i < count; ++i) {
+		block[i] = ring->storage[(tail + i) & ring->mask];
+	}
+	__atomic_store_n(&ring->tail, tail + count, __ATOMIC_RELEASE);
+	return count;
+}
+/****************************************************************************************/
+
+uint32_t sample_ring_buffer_get_count(sample_ring_buffer *ring)
+{
+	return __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE) -
+			__atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,98 @@
+/** sample_ring_buffer.h **/
+
+#ifndef COMPONENTS_MEASUREMENT_SAMPLE_RING_BUFFER_H_
+#define COMPONENTS_MEASUREMENT_SAMPLE_RING_BUFFER_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** single producer single consumer ring buffer of samples. The head is written only by
+ * the producer and the tail only by the consumer, so no lock is needed. **/
+typedef struct _sample_ring_buffer{
+	uint16_t *storage;
+	uint32_t mask;
+	volatile uint32_t head;
+	volatile uint32_t tail;
+	volatile uint32_t overflow_count;
+} sample_ring_buffer;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+sample_ring_buffer_init
+******************************************************************************************
+Parameters:
+sample_ring_buffer *ring - ring buffer to be initialized
+uint16_t storage[] - memory used by the ring buffer
+uint32_t capacity - number of samples in the storage, it has to be a power of two
+******************************************************************************************
+Abstract:
+This function initializes an empty ring buffer on top of the given storage.
+\****************************************************************************************/
+void sample_ring_buffer_init(sample_ring_buffer *ring, uint16_t storage[], uint32_t capacity);
+
+/****************************************************************************************\
+Function:
+sample_ring_buffer_push
+******************************************************************************************
+Parameters:
+sample_ring_buffer *ring - ring buffer to operate on
+uint16_t sample - sample to be stored
+******************************************************************************************
+Abstract:
+This function stores the sample in the ring buffer. It is called by the producer only and
+is safe to use from the interrupt. If the ring is full, the sample is dropped, the
+overflow counter is incremented and false is returned.
+\****************************************************************************************/
+bool sample_ring_buffer_push(sample_ring_buffer *ring, uint16_t sample);
+
+/****************************************************************************************\
+Function:
+sample_ring_buffer_pop_block
+******************************************************************************************
+Parameters:
+sample_ring_buffer *ring - ring buffer to operate on
+uint16_t block[] - destination for the samples
+uint32_t max_size - maximal number of samples to be copied
+******************************************************************************************
+Abstract:
+This function moves up to max_size samples from the ring buffer into the block. It is
+called by the consumer only and returns the number of copied samples.
+\****************************************************************************************/
+uint32_t sample_ring_buffer_pop_block(sample_ring_buffer *ring, uint16_t block[],
+				uint32_t max_size);
+
+/****************************************************************************************\
+Function:
+sample_ring_buffer_get_count
+******************************************************************************************
+Parameters:
+sample_ring_buffer *ring - ring buffer to operate on
+******************************************************************************************
+Abstract:
+This function returns the number of samples waiting in the ring buffer.
+\****************************************************************************************/
+uint32_t sample_ring_buffer_get_count(sample_ring_buffer *ring);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_MEASUREMENT_SAMPLE_RING_BUFFER_H_ */
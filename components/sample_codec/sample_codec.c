@@ -0,0 +1,202 @@
+/** sample_codec.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "sample_codec.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+zigzag_encode
+******************************************************************************************
+Parameters:
+uint16_t previous - predicted value
+uint16_t sample - actual value
+******************************************************************************************
+Abstract:
+This function maps the difference of the sample and the prediction, taken modulo 2^16,
+to an unsigned value, so small differences of both signs get small codes.
+\****************************************************************************************/
+static uint16_t zigzag_encode(uint16_t previous, uint16_t sample);
+
+/****************************************************************************************\
+Function:
+zigzag_decode
+******************************************************************************************
+Parameters:
+uint16_t previous - predicted value
+uint16_t code - zig-zag code of the difference
+******************************************************************************************
+Abstract:
+This function reverses zigzag_encode and returns the sample.
+\****************************************************************************************/
+static uint16_t zigzag_decode(uint16_t previous, uint16_t code);
+
+/****************************************************************************************\
+Function:
+bit_width
+******************************************************************************************
+Parameters:
+uint16_t value - value to be measured
+******************************************************************************************
+Abstract:
+This function returns the number of bits needed to store the value.
+\****************************************************************************************/
+static uint8_t bit_width(uint16_t value);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+uint32_t sample_codec_encode(const uint16_t samples[], uint32_t count, uint16_t zero_val,
+				uint8_t out[], uint32_t *out_len)
+{
+	uint32_t capacity = *out_len;
+	uint32_t used = 0;
+	uint32_t encoded = 0;
+	uint16_t previous = zero_val;
+
+	while (encoded < count) {
+		uint16_t residual[SAMPLE_CODEC_BLOCK_LEN];
+		uint8_t prefix_width[SAMPLE_CODEC_BLOCK_LEN];
+		uint32_t block_len = count - encoded;
+		if (block_len > SAMPLE_CODEC_BLOCK_LEN) {
+			block_len = SAMPLE_CODEC_BLOCK_LEN;
+		}
+
+		uint16_t prediction = previous;
+		uint8_t width = 0;
+		for (uint32_t i = 0; i < block_len; ++i) {
+			residual[i] = zigzag_encode(prediction, samples[encoded + i]);
+			prediction = samples[encoded + i];
+			uint8_t residual_width = bit_width(residual[i]);
+			if (residual_width > width) {
+				width = residual_width;
+			}
+			prefix_width[i] = width;
+		}
+
+		/** shorten the block if it does not fit into the rest of the destination **/
+		uint32_t len = block_len;
+		while ((len > 0) && (used + 1 + (len * prefix_width[len - 1] + 7) / 8 > capacity)) {
+			--len;
+		}
+		if (0 == len) {
+			break;
+		}
+
+		width = prefix_width[len - 1];
+		out[used++] = width;
+		uint32_t accumulator = 0;
+		uint8_t bits = 0;
+		for (uint32_t i = 0; i < len; ++i) {
+			accumulator |= (uint32_t)residual[i] << bits;
+			bits += width;
+			while (bits >= 8) {
+				out[used++] = (uint8_t)accumulator;
+				accumulator >>= 8;
+				bits -= 8;
+			}
+		}
+		if (bits > 0) {
+			out[used++] = (uint8_t)accumulator;
+		}
+
+		encoded += len;
+		previous = samples[encoded - 1];
+		if (len < block_len) {
+			break;
+		}
+	}
+
+	*out_len = used;
+	return encoded;
+}
+/****************************************************************************************/
+
+bool sample_codec_decode(const uint8_t in[], uint32_t in_len, uint32_t count,
+				uint16_t zero_val, uint16_t samples[])
+{
+	uint32_t pos = 0;
+	uint32_t decoded = 0;
+	uint16_t previous = zero_val;
+
+	while (decoded < count) {
+		uint32_t block_len = count - decoded;
+		if (block_len > SAMPLE_CODEC_BLOCK_LEN) {
+			block_len = SAMPLE_CODEC_BLOCK_LEN;
+		}
+		if (pos >= in_len) {
+			return false;
+		}
+		uint8_t width = in[pos++];
+		if ((width > SAMPLE_CODEC_MAX_BIT_WIDTH) ||
+				(pos + (block_len * width + 7) / 8 > in_len)) {
+			return false;
+		}
+
+		uint32_t mask = (1u << width) - 1;
+		uint32_t accumulator = 0;
+		uint8_t bits = 0;
+		for (uint32_t i = 0; i < block_len; ++i) {
+			while (bits < width) {
+				accumulator |= (uint32_t)in[pos++] << bits;
+				bits += 8;
+			}
+			previous = zigzag_decode(previous, (uint16_t)(accumulator & mask));
+			samples[decoded + i] = previous;
+			accumulator >>= width;
+			bits -= width;
+		}
+		decoded += block_len;
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t zigzag_encode(uint16_t previous, uint16_t sample)
+{
+	int16_t delta = (int16_t)(uint16_t)(sample - previous);
+	return (uint16_t)(((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15));
+}
+/****************************************************************************************/
+
+static uint16_t zigzag_decode(uint16_t previous, uint16_t code)
+{
+	uint16_t delta = (uint16_t)((code >> 1) ^ (uint16_t)(0 - (code & 1)));
+	return (uint16_t)(previous + delta);
+}
+/****************************************************************************************/
+
+static uint8_t bit_width(uint16_t value)
+{
+	uint8_t width = 0;
+	while (0 != value) {
+		++width;
+		value >>= 1;
+	}
+	return width;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
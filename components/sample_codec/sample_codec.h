@@ -0,0 +1,76 @@
+/** sample_codec.h **/
+
+#ifndef COMPONENTS_SAMPLE_CODEC_SAMPLE_CODEC_H_
+#define COMPONENTS_SAMPLE_CODEC_SAMPLE_CODEC_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** number of samples sharing one bit width byte **/
+#define SAMPLE_CODEC_BLOCK_LEN			(16)
+/** maximal bit width of the residual **/
+#define SAMPLE_CODEC_MAX_BIT_WIDTH		(16)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+sample_codec_encode
+******************************************************************************************
+Parameters:
+const uint16_t samples[] - samples to be encoded
+uint32_t count - number of samples
+uint16_t zero_val - value the first sample is predicted with
+uint8_t out[] - destination of the encoded bytes
+uint32_t *out_len - capacity of the destination on input, number of the encoded bytes on
+output
+******************************************************************************************
+Abstract:
+This function encodes the samples losslessly. The first sample is stored as the
+difference to zero_val and each next one as the difference to its predecessor. The
+differences are zig-zag mapped and bit packed in blocks of SAMPLE_CODEC_BLOCK_LEN, every
+block starts with a byte holding the bit width of the block. Encoding stops when the next
+sample does not fit into the destination. It returns the number of encoded samples.
+\****************************************************************************************/
+uint32_t sample_codec_encode(const uint16_t samples[], uint32_t count, uint16_t zero_val,
+				uint8_t out[], uint32_t *out_len);
+
+/****************************************************************************************\
+Function:
+sample_codec_decode
+******************************************************************************************
+Parameters:
+const uint8_t in[] - encoded bytes
+uint32_t in_len - number of the encoded bytes
+uint32_t count - number of samples to be decoded
+uint16_t zero_val - value the first sample was predicted with
+uint16_t samples[] - destination of the decoded samples
+******************************************************************************************
+Abstract:
+This function reverses sample_codec_encode. It returns false if the input is malformed
+or shorter than needed for count samples.
+\****************************************************************************************/
+bool sample_codec_decode(const uint8_t in[], uint32_t in_len, uint32_t count,
+				uint16_t zero_val, uint16_t samples[]);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_SAMPLE_CODEC_SAMPLE_CODEC_H_ */
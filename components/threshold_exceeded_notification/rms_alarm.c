@@ -0,0 +1,210 @@
+/** rms_alarm.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "rms_alarm.h"
+#include "freertos/FreeRTOS.h"
+#include <math.h>
+#include <string.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** limit of the level which is never reached **/
+#define RMS_ALARM_UNREACHABLE			(UINT64_MAX)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+level_limit
+******************************************************************************************
+Parameters:
+uint32_t window - length of the window in conversions
+int32_t rms - ac rms of the limit in adc counts
+******************************************************************************************
+Abstract:
+This function returns the limit of the ac rms in the compared domain, (window * rms)^2.
+\****************************************************************************************/
+static uint64_t level_limit(uint32_t window, int32_t rms);
+
+/****************************************************************************************\
+Function:
+evaluate_level
+******************************************************************************************
+Parameters:
+const rms_alarm *alarm - alarm with the filled window
+******************************************************************************************
+Abstract:
+This function returns the level of the window. The level above the current one is
+entered at its limit, the current one is left below its limit lowered by the
+hysteresis.
+\****************************************************************************************/
+static rms_alarm_level IRAM_ATTR evaluate_level(const rms_alarm *alarm);
+
+/****************************************************************************************\
+Function:
+complete_block
+******************************************************************************************
+Parameters:
+rms_alarm *alarm - alarm with the filled block
+******************************************************************************************
+Abstract:
+This function replaces the oldest block of the window by the filled one and evaluates
+the level once the window is filled. It returns true when the level changed.
+\****************************************************************************************/
+static bool IRAM_ATTR complete_block(rms_alarm *alarm);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool rms_alarm_init(rms_alarm *alarm, uint32_t window, uint16_t warning,
+				uint16_t alarm_level, uint16_t hysteresis, uint32_t hold_off)
+{
+	memset(alarm, 0, sizeof(rms_alarm));
+	if ((window < RMS_ALARM_BLOCKS) || (window > RMS_ALARM_MAX_WINDOW)) {
+		return false;
+	}
+	if ((warning > RMS_ALARM_MAX_LEVEL) || (alarm_level > RMS_ALARM_MAX_LEVEL) ||
+			((0 != warning) && (hysteresis >= warning)) ||
+			((0 != alarm_level) && (hysteresis >= alarm_level)) ||
+			((0 != warning) && (0 != alarm_level) && (alarm_level <= warning))) {
+		return false;
+	}
+
+	alarm->block_size = window / RMS_ALARM_BLOCKS;
+	alarm->window = alarm->block_size * RMS_ALARM_BLOCKS;
+	alarm->hold_off = hold_off;
+	alarm->warning_on = (0 != warning) ? level_limit(alarm->window, warning) :
+			RMS_ALARM_UNREACHABLE;
+	alarm->warning_off = level_limit(alarm->window, (int32_t)warning - hysteresis);
+	alarm->alarm_on = (0 != alarm_level) ? level_limit(alarm->window, alarm_level) :
+			RMS_ALARM_UNREACHABLE;
+	alarm->alarm_off = level_limit(alarm->window, (int32_t)alarm_level - hysteresis);
+	alarm->level = RMS_ALARM_NORMAL;
+	alarm->pending = RMS_ALARM_NORMAL;
+	return true;
+}
+/****************************************************************************************/
+
+bool IRAM_ATTR rms_alarm_push(rms_alarm *alarm, uint16_t conversion, uint32_t count)
+{
+	/* the repeated conversion is added to the blocks it spans, the level is evaluated
+	 * with each completed one */
+	bool is_changed = false;
+	while (count > 0) {
+		uint32_t taken = alarm->block_size - alarm->block_count;
+		if (taken > count) {
+			taken = count;
+		}
+		alarm->block_sum += (uint32_t)conversion * taken;
+		alarm->block_squares += (uint64_t)((uint32_t)conversion * conversion) * taken;
+		alarm->block_count += taken;
+		count -= taken;
+		if ((alarm->block_count == alarm->block_size) && complete_block(alarm)) {
+			is_changed = true;
+		}
+	}
+	return is_changed;
+}
+/****************************************************************************************/
+
+rms_alarm_level rms_alarm_get_level(const rms_alarm *alarm)
+{
+	return alarm->level;
+}
+/****************************************************************************************/
+
+float rms_alarm_get_rms(const rms_alarm *alarm)
+{
+	if (0 == alarm->window) {
+		return 0;
+	}
+	return sqrtf((float)alarm->power) / alarm->window;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool IRAM_ATTR complete_block(rms_alarm *alarm)
+{
+	/* the completed block replaces the oldest one in the window */
+	uint32_t i = alarm->next_block;
+	alarm->window_sum += alarm->block_sum - alarm->sums[i];
+	alarm->window_squares += alarm->block_squares - alarm->squares[i];
+	alarm->sums[i] = alarm->block_sum;
+	alarm->squares[i] = alarm->block_squares;
+	alarm->next_block = (i + 1 == RMS_ALARM_BLOCKS) ? 0 : i + 1;
+	alarm->block_count = 0;
+	alarm->block_sum = 0;
+	alarm->block_squares = 0;
+	if (alarm->filled_blocks < RMS_ALARM_BLOCKS) {
+		if (++alarm->filled_blocks < RMS_ALARM_BLOCKS) {
+			return false;
+		}
+	}
+
+	/* the mean is removed exactly, the squares never fall below the square of the sum */
+	uint64_t sum = alarm->window_sum;
+	alarm->power = alarm->window * alarm->window_squares - sum * sum;
+	rms_alarm_level level = evaluate_level(alarm);
+	if (level == alarm->level) {
+		alarm->pending = level;
+		alarm->pending_count = 0;
+		return false;
+	}
+	if (level != alarm->pending) {
+		alarm->pending = level;
+		alarm->pending_count = 0;
+	}
+	alarm->pending_count += alarm->block_size;
+	if (alarm->pending_count < alarm->hold_off) {
+		return false;
+	}
+	alarm->level = level;
+	alarm->pending_count = 0;
+	return true;
+}
+/****************************************************************************************/
+
+static uint64_t level_limit(uint32_t window, int32_t rms)
+{
+	if (rms <= 0) {
+		return 0;
+	}
+	uint64_t limit = (uint64_t)window * (uint32_t)rms;
+	return limit * limit;
+}
+/****************************************************************************************/
+
+static rms_alarm_level IRAM_ATTR evaluate_level(const rms_alarm *alarm)
+{
+	uint64_t power = alarm->power;
+	if ((power >= alarm->alarm_on) ||
+			((RMS_ALARM_ALARM == alarm->level) && (power >= alarm->alarm_off))) {
+		return RMS_ALARM_ALARM;
+	}
+	if ((power >= alarm->warning_on) ||
+			((RMS_ALARM_NORMAL != alarm->level) && (power >= alarm->warning_off) &&
+					(RMS_ALARM_UNREACHABLE != alarm->warning_on))) {
+		return RMS_ALARM_WARNING;
+	}
+	return RMS_ALARM_NORMAL;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,140 @@
+/** rms_alarm.h **/
+
+#ifndef COMPONENTS_THRESHOLD_EXCEEDED_NOTIFICATION_RMS_ALARM_H_
+#define COMPONENTS_THRESHOLD_EXCEEDED_NOTIFICATION_RMS_ALARM_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "stdint.h"
+#include "stdbool.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** number of the blocks the window is divided to, the window slides by one block **/
+#define RMS_ALARM_BLOCKS				((uint32_t)32)
+
+/** longest window in conversions and highest level, the squared sums of the 12 bit
+ * conversions over the window fit in the 64 bit comparison **/
+#define RMS_ALARM_MAX_WINDOW			((uint32_t)1 << 18)
+#define RMS_ALARM_MAX_LEVEL				((uint16_t)0x0fff)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** levels of the alarm, ordered by the severity **/
+typedef enum _rms_alarm_level{
+	RMS_ALARM_NORMAL = 0,
+	RMS_ALARM_WARNING = 1,
+	RMS_ALARM_ALARM = 2,
+} rms_alarm_level;
+
+/** alarm of the ac rms over the sliding window. The conversions are summed per block and
+ * the window keeps the sums of the last RMS_ALARM_BLOCKS blocks, so the work per
+ * conversion does not depend on the length of the window. The levels are compared as
+ * window^2 * rms^2 = window * sum of squares - sum^2, so no root is taken. **/
+typedef struct _rms_alarm{
+	uint32_t block_size;
+	uint32_t window;
+	uint32_t hold_off;
+	/** the limits of entering and leaving the levels in the compared domain **/
+	uint64_t warning_on;
+	uint64_t warning_off;
+	uint64_t alarm_on;
+	uint64_t alarm_off;
+	/** sums of the conversions of the block being filled **/
+	uint32_t block_count;
+	uint32_t block_sum;
+	uint64_t block_squares;
+	/** sums of the completed blocks and of the window **/
+	uint32_t sums[RMS_ALARM_BLOCKS];
+	uint64_t squares[RMS_ALARM_BLOCKS];
+	uint32_t next_block;
+	uint32_t filled_blocks;
+	uint32_t window_sum;
+	uint64_t window_squares;
+	/** evaluated state, the level waits the hold off in the pending one **/
+	volatile rms_alarm_level level;
+	rms_alarm_level pending;
+	uint32_t pending_count;
+	/** power of the window evaluated with the last completed block **/
+	uint64_t power;
+} rms_alarm;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+rms_alarm_init
+******************************************************************************************
+Parameters:
+rms_alarm *alarm - alarm to be initialized
+uint32_t window - length of the window in conversions, rounded to the whole blocks
+uint16_t warning - ac rms of the warning level in adc counts, 0 for none
+uint16_t alarm_level - ac rms of the alarm level in adc counts, 0 for none
+uint16_t hysteresis - drop of the ac rms below the level needed to leave it
+uint32_t hold_off - number of the conversions the new level has to last to be entered
+******************************************************************************************
+Abstract:
+This function sets the levels and clears the state to the normal level. It returns false
+if the window or the levels are out of the range, the set alarm level is not above the
+set warning one or the hysteresis is not below the set levels.
+\****************************************************************************************/
+bool rms_alarm_init(rms_alarm *alarm, uint32_t window, uint16_t warning,
+				uint16_t alarm_level, uint16_t hysteresis, uint32_t hold_off);
+
+/****************************************************************************************\
+Function:
+rms_alarm_push
+******************************************************************************************
+Parameters:
+rms_alarm *alarm - initialized alarm
+uint16_t conversion - next adc conversion
+uint32_t count - number of the conversions it stands for, more than one when the
+	conversions come slower than the ones the window is counted in
+******************************************************************************************
+Abstract:
+This function adds the conversion count times to the window and evaluates the level once
+per block, after the window is filled. It returns true when the level changed. It uses
+the integer arithmetic only and is safe to use from the interrupt.
+\****************************************************************************************/
+bool rms_alarm_push(rms_alarm *alarm, uint16_t conversion, uint32_t count);
+
+/****************************************************************************************\
+Function:
+rms_alarm_get_level
+******************************************************************************************
+Parameters:
+const rms_alarm *alarm - initialized alarm
+******************************************************************************************
+Abstract:
+This function returns the current level of the alarm.
+\****************************************************************************************/
+rms_alarm_level rms_alarm_get_level(const rms_alarm *alarm);
+
+/****************************************************************************************\
+Function:
+rms_alarm_get_rms
+******************************************************************************************
+Parameters:
+const rms_alarm *alarm - initialized alarm
+******************************************************************************************
+Abstract:
+This function returns the ac rms of the window in adc counts, as evaluated with the last
+completed block. It is 0 until the window is filled. The alarm fed by the interrupt is
+read from the copy taken under the lock of the push.
+\****************************************************************************************/
+float rms_alarm_get_rms(const rms_alarm *alarm);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* COMPONENTS_THRESHOLD_EXCEEDED_NOTIFICATION_RMS_ALARM_H_ */
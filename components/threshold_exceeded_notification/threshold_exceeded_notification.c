@@ -4,18 +4,19 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "threshold_exceeded_notification.h"
+#include "rms_alarm.h"
 #include "freertos/FreeRTOS.h"
 #include "esp_event_loop.h"
 
 #include "../measurement/measurement.h"
 #include "../ble_communication/ble_communication.h"
+#include "../../main/task_controller.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #define ATTEN_11_DB_MULTIPLIER 			((float)3.6)
 #define CONVERT_RAW_TO_VOLTAGE(x) 		((float)((x/4095)*ATTEN_11_DB_MULTIPLIER))
-#define ACCELEROMETER_ADC_CHANNEL 		(ADC1_CHANNEL_7)
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Local typedefs																		//
@@ -27,12 +28,24 @@
 /** threshold set on the init phase defining when the notification should be sent */
 static uint16_t threshold_exceeded_threshold = 0;
 
-/** maximal value of the adc read from the last reset */
-static uint16_t threshold_exceeded_max_val_from_reset = 0;
-
 /** the calibration val for the threshold evaluation. **/
 static uint16_t threshold_exceed_zero_val = 0;
 
+/** alarm of the windowed rms fed by the sampler, it replaces the threshold while set **/
+static volatile bool is_alarm_set = false;
+static rms_alarm threshold_alarm;
+/** spinlock of the alarm, the interrupt may push a conversion on the other core while the
+ * task replaces the alarm **/
+static portMUX_TYPE alarm_mux = portMUX_INITIALIZER_UNLOCKED;
+/** copy of the alarm taken by the threshold task under the spinlock, static as it does
+ * not fit its stack **/
+static rms_alarm alarm_snapshot;
+
+/** rate limiting of the alarm indications **/
+static TickType_t alarm_interval_ticks = 0;
+static TickType_t alarm_sent_ticks = 0;
+static rms_alarm_level alarm_sent_level = RMS_ALARM_NORMAL;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static functions prototypes															//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -45,10 +58,37 @@ Parameters:
 None.
 ******************************************************************************************
 Abstract:
-This function resets maximal stored value during monitoring to 0.
+This function resets maximal conversion monitored by the sampler to 0.
 \****************************************************************************************/
 static void reset_max_val(void);
 
+/****************************************************************************************\
+Function:
+alarm_monitor
+******************************************************************************************
+Parameters:
+uint16_t conversion - raw adc conversion
+uint32_t periods - number of the monitoring periods the conversion stands for
+******************************************************************************************
+Abstract:
+This is the monitor of the sampler passing the conversions to the alarm, it returns true
+when the level changed.
+\****************************************************************************************/
+static bool IRAM_ATTR alarm_monitor(uint16_t conversion, uint32_t periods);
+
+/****************************************************************************************\
+Function:
+send_alarm_level
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function waits until the minimal interval from the last indication passes and
+sends the current level, unless it is the one sent last.
+\****************************************************************************************/
+static void send_alarm_level(void);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global functions definitions															//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -63,19 +103,14 @@ void threshold_exceeded_init(uint16_t zero_val)
 void threshold_exceeded_task(void *pvParameter)
 {
 	while (true) {
-		if (0 != threshold_exceeded_threshold) {
-			int16_t result = measurement_read(ACCELEROMETER_ADC_CHANNEL);
-			if (abs(result-threshold_exceed_zero_val) > threshold_exceeded_threshold) {
-				threshold_exceeded_max_val_from_reset = result;
-				ble_communication_threshold_exceeded_notification_send(result);
-				threshold_exceeded_set_threshold(0);
-				vTaskSuspend(NULL);
-			} else if (result > threshold_exceeded_max_val_from_reset) {
-				threshold_exceeded_max_val_from_reset = result;
-			}
-			vTaskDelay(1 / portTICK_PERIOD_MS);
-		} else {
-			vTaskSuspend(NULL);
+		/* the sampler stops the monitoring on the first conversion out of the limits */
+		ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+		if (is_alarm_set) {
+			send_alarm_level();
+		} else if (0 != threshold_exceeded_threshold) {
+			threshold_exceeded_threshold = 0;
+			ble_communication_threshold_exceeded_notification_send(
+					measurement_get_monitoring_sample());
 		}
 	}
 }
@@ -89,20 +124,66 @@ void threshold_exceeded_reset(void)
 /****************************************************************************************/
 void threshold_exceeded_set_threshold(uint16_t threshold)
 {
+	is_alarm_set = false;
 	threshold_exceeded_threshold = threshold;
-	reset_max_val();
+	if (0 == threshold) {
+		measurement_stop_monitoring();
+		reset_max_val();
+		return;
+	}
+
+	int32_t low = (int32_t)threshold_exceed_zero_val - threshold;
+	int32_t high = (int32_t)threshold_exceed_zero_val + threshold;
+	measurement_set_monitoring((low < 0) ? 0 : low, (high > UINT16_MAX) ? UINT16_MAX : high,
+			NULL, THRESHOLD_EXCEEDED_MONITORING_FREQUENCY,
+			get_task_handle(THRESHOLD_EXCEEDED_TASK_HANDLE));
+}
+
+/****************************************************************************************/
+bool threshold_exceeded_set_alarm(const threshold_alarm_config *config)
+{
+	if ((0 == config->warning) && (0 == config->alarm)) {
+		threshold_exceeded_set_threshold(0);
+		return true;
+	}
+	uint32_t window = (uint32_t)config->window_ms * THRESHOLD_EXCEEDED_MONITORING_FREQUENCY /
+			1000;
+	uint32_t hold_off = (uint32_t)config->hold_off_ms *
+			THRESHOLD_EXCEEDED_MONITORING_FREQUENCY / 1000;
+	rms_alarm alarm;
+	if (!rms_alarm_init(&alarm, window, config->warning, config->alarm, config->hysteresis,
+			hold_off)) {
+		return false;
+	}
+
+	/* the alarm is replaced while the sampler does not feed it, the interrupt already
+	 * inside the push is not stopped by the monitoring flag, so the copy is made under the
+	 * spinlock */
+	measurement_stop_monitoring();
+	threshold_exceeded_threshold = 0;
+	portENTER_CRITICAL(&alarm_mux);
+	threshold_alarm = alarm;
+	portEXIT_CRITICAL(&alarm_mux);
+	alarm_interval_ticks = config->min_interval_ms / portTICK_PERIOD_MS;
+	alarm_sent_ticks = xTaskGetTickCount() - alarm_interval_ticks;
+	alarm_sent_level = RMS_ALARM_NORMAL;
+	is_alarm_set = true;
+	measurement_set_monitoring(0, UINT16_MAX, alarm_monitor,
+			THRESHOLD_EXCEEDED_MONITORING_FREQUENCY,
+			get_task_handle(THRESHOLD_EXCEEDED_TASK_HANDLE));
+	return true;
 }
 
 /****************************************************************************************/
 uint16_t threshold_exceeded_get_max_val_raw(void)
 {
-	return threshold_exceeded_max_val_from_reset;
+	return measurement_get_monitoring_max();
 }
 
 /****************************************************************************************/
 float threshold_exceeded_get_max_val_voltage(void)
 {
-	return CONVERT_RAW_TO_VOLTAGE(threshold_exceeded_max_val_from_reset);
+	return CONVERT_RAW_TO_VOLTAGE(measurement_get_monitoring_max());
 }
 
 /****************************************************************************************/
@@ -112,7 +193,38 @@ float threshold_exceeded_get_max_val_voltage(void)
 //////////////////////////////////////////////////////////////////////////////////////////
 static void reset_max_val(void)
 {
-	threshold_exceeded_max_val_from_reset = 0;
+	measurement_reset_monitoring_max();
+}
+
+/****************************************************************************************/
+static bool IRAM_ATTR alarm_monitor(uint16_t conversion, uint32_t periods)
+{
+	portENTER_CRITICAL(&alarm_mux);
+	bool is_changed = rms_alarm_push(&threshold_alarm, conversion, periods);
+	portEXIT_CRITICAL(&alarm_mux);
+	return is_changed;
+}
+
+/****************************************************************************************/
+static void send_alarm_level(void)
+{
+	TickType_t elapsed = xTaskGetTickCount() - alarm_sent_ticks;
+	if (elapsed < alarm_interval_ticks) {
+		vTaskDelay(alarm_interval_ticks - elapsed);
+	}
+	/* the level and the power of one window are copied under the spinlock of the push and
+	 * of the replacement of the alarm, the root is taken outside of it */
+	portENTER_CRITICAL(&alarm_mux);
+	alarm_snapshot = threshold_alarm;
+	portEXIT_CRITICAL(&alarm_mux);
+	rms_alarm_level level = rms_alarm_get_level(&alarm_snapshot);
+	if (!is_alarm_set || (level == alarm_sent_level)) {
+		return;
+	}
+	ble_communication_threshold_alarm_notification_send(level,
+			(uint16_t)(rms_alarm_get_rms(&alarm_snapshot) + 0.5f));
+	alarm_sent_level = level;
+	alarm_sent_ticks = xTaskGetTickCount();
 }
 
 /****************************************************************************************/
@@ -7,15 +7,32 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "stdint.h"
+#include "stdbool.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
+/** conversion frequency of the monitoring between the measurements, the measurements
+ * are monitored at their own conversion frequency. The conversions run only while the
+ * threshold or the alarm is set **/
+#define THRESHOLD_EXCEEDED_MONITORING_FREQUENCY	((uint16_t)10000)
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global typedefs																		//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+/** configuration of the alarm of the ac rms over the sliding window, the levels in adc
+ * counts and the times in ms. The warning or the alarm level 0 is not used, both 0 stop
+ * the alarm. **/
+typedef struct _threshold_alarm_config{
+	uint16_t window_ms;
+	uint16_t warning;
+	uint16_t alarm;
+	uint16_t hysteresis;
+	uint16_t hold_off_ms;
+	uint16_t min_interval_ms;
+} threshold_alarm_config;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -45,11 +62,14 @@ Parameters:
 void *pvParameter - standard task parameter 
 ******************************************************************************************
 Abstract:
-This is the main task for the threshold monitoring. If the task is active and the 
-threshold is non-zero valu the task checks the adc conversion result every 1 ms and 
-evaluates if the threshold was exceeded. If the threshold is a zero value, the task 
-suspends itself. It also stores tha max value during monitoring inside the module,
-and shares it with the get function.
+This is the main task for the threshold monitoring. The adc conversions are evaluated by
+the sampler, every one of the measurements and the ones taken at
+THRESHOLD_EXCEEDED_MONITORING_FREQUENCY between them. The task blocks until the sampler
+notifies it. For the threshold, it sends the first conversion exceeding it in the
+indication and clears the threshold, so the indication is sent once per setting. For the
+alarm, which runs continuously, it sends the level and the rms on every change of the
+level, at most once per the minimal interval. The changes within the interval are merged
+into the indication of the last level.
 \****************************************************************************************/
 void threshold_exceeded_task(void *pvParameter);
 
@@ -73,10 +93,27 @@ Parameters:
 uint16_t threshold - desired threshold for monitoring
 ******************************************************************************************
 Abstract:
-This function sets the desired threshold for monitoring.
+This function sets the desired threshold for monitoring and starts the monitoring in
+the sampler, the 0 threshold stops it. It replaces the alarm.
 \****************************************************************************************/
 void threshold_exceeded_set_threshold(uint16_t threshold);
 
+/****************************************************************************************\
+Function:
+threshold_exceeded_set_alarm
+******************************************************************************************
+Parameters:
+const threshold_alarm_config *config - configuration of the alarm
+******************************************************************************************
+Abstract:
+This function starts the alarm of the ac rms over the sliding window in the sampler at
+the normal level, it replaces the threshold. The level is entered when the rms reaches
+it for the hold off and left when the rms drops by the hysteresis below it for the hold
+off. It returns false and keeps the previous monitoring if the configuration is out of
+the range of rms_alarm_init.
+\****************************************************************************************/
+bool threshold_exceeded_set_alarm(const threshold_alarm_config *config);
+
 /****************************************************************************************\
 Function:
 threshold_exceeded_get_max_val_raw
@@ -85,7 +122,7 @@ Parameters:
 None.
 ******************************************************************************************
 Abstract:
-This function is a getter for the maximal stored value inside the module.
+This function is a getter for the maximal conversion monitored by the sampler.
 \****************************************************************************************/
 uint16_t threshold_exceeded_get_max_val_raw(void);
 
@@ -0,0 +1,879 @@
+/** benchmark.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/event_groups.h"
+#include "freertos/queue.h"
+#include "../main/task_controller.h"
+#include "../components/calculation/calculation.h"
+#include "../components/calculation/spectrum.h"
+#include "../components/calculation/integration.h"
+#include "../components/calculation/envelope.h"
+#include "../components/ble_communication/result_frame.h"
+#include "../components/sample_codec/sample_codec.h"
+#include "../components/measurement/decimator.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <getopt.h>
+#include <sys/utsname.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define BENCHMARK_MIN_SIZE				((uint32_t)256)
+#define BENCHMARK_MAX_SIZE				((uint32_t)262144)
+/** every size is measured for at least this time and this number of iterations **/
+#define DEFAULT_MIN_TIME				(0.2)
+#define MIN_ITERATIONS					((uint32_t)3)
+
+/** mtu of the frame benchmarks, the one requested by the gui **/
+#define BENCHMARK_MTU					((uint16_t)247)
+/** test signal, a sine with noise around the zero value of the sensor **/
+#define SIGNAL_OFFSET					((uint16_t)2048)
+#define SIGNAL_AMPLITUDE				(400.0)
+#define SIGNAL_PERIOD					(20.0)
+#define SIGNAL_NOISE					((uint32_t)32)
+/** further signals of the codec, the noise of one count on the zero value of the idle
+ * machine, the noise over the full range of the adc, the worst case of the codec, and the
+ * decaying bursts of the resonance excited by the impacts of a bearing fault **/
+#define SIGNAL_QUIET_NOISE				((uint32_t)1)
+#define SIGNAL_FULL_SCALE				((uint32_t)4096)
+#define SIGNAL_IMPACT_AMPLITUDE			(1500.0)
+#define SIGNAL_IMPACT_PERIOD			((uint32_t)100)
+#define SIGNAL_IMPACT_DECAY				(0.05)
+#define SIGNAL_RESONANCE_PERIOD			(4.0)
+/** sampling frequency the input is taken with **/
+#define SAMPLING_FREQUENCY				((uint16_t)1000)
+/** welch configuration of the psd benchmark **/
+#define WELCH_SEGMENT_SIZE				((uint32_t)1024)
+#define WELCH_OVERLAP					((uint8_t)50)
+#define CALCULATION_TIMEOUT_MS			((uint32_t)10000)
+/** decimation factor of the sampler benchmark, the cost per conversion does not depend
+ * on it **/
+#define BENCHMARK_DECIMATION			((uint8_t)8)
+/** former calculation, five tasks each walking the buffer for its factors. The rms and
+ * the range tasks slept vTaskDelay(1 / portTICK_PERIOD_MS) per sample, 0 ticks at the
+ * 100 Hz tick of the target, so they yield per sample, and the amplitude and the crest
+ * factor tasks polled the flags of their inputs every 100 ms **/
+#define FAN_OUT_TASKS					((uint8_t)5)
+#define FAN_OUT_SAMPLE_DELAY_TICKS		((TickType_t)0)
+#define FAN_OUT_POLL_MS					((uint32_t)100)
+#define FAN_OUT_RMS_FLAG				((EventBits_t)0x1 << 0)
+#define FAN_OUT_AVERAGE_FLAG			((EventBits_t)0x1 << 1)
+#define FAN_OUT_RANGE_FLAG				((EventBits_t)0x1 << 2)
+#define FAN_OUT_AMPLITUDE_FLAG			((EventBits_t)0x1 << 3)
+#define FAN_OUT_CREST_FLAG				((EventBits_t)0x1 << 4)
+#define FAN_OUT_ALL_FLAGS				((EventBits_t)0x1f)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** input signal of the benchmark, the recorded one is read by --waveform **/
+typedef enum{
+	BENCHMARK_SIGNAL_SINE = 0,
+	BENCHMARK_SIGNAL_QUIET,
+	BENCHMARK_SIGNAL_NOISE,
+	BENCHMARK_SIGNAL_IMPACTS,
+	BENCHMARK_SIGNAL_RECORDED
+} benchmark_signal;
+
+/** function running one iteration of the benchmark over size samples, it returns the
+ * number of bytes produced, 0 if the benchmark produces no output **/
+typedef uint32_t (*benchmark_function)(uint32_t size);
+
+typedef struct {
+	const char *name;
+	benchmark_function function;
+	/** largest size the kernel processes as a whole, larger inputs are not measured **/
+	uint32_t max_size;
+	/** sizes measured instead of the powers of two, terminated by 0, NULL for none **/
+	const uint32_t *sizes;
+	benchmark_signal signal;
+	/** the output encodes the samples, its record reports the compression ratio **/
+	bool is_encoder;
+} benchmark;
+
+/** object of the former calculation, filled by the fan out tasks **/
+typedef struct {
+	const uint16_t *data;
+	uint32_t size;
+	float rms;
+	float average;
+	uint16_t max_val;
+	uint16_t min_val;
+	uint16_t amplitude;
+	float crest_factor;
+} fan_out_obj;
+
+typedef struct {
+	double min_time;
+	const char *filter;
+	const char *output_path;
+	const char *waveform_path;
+} benchmark_config;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** input samples shared by all the benchmarks, the signal they hold **/
+static uint16_t *samples = NULL;
+static benchmark_signal samples_signal = BENCHMARK_SIGNAL_SINE;
+/** recorded signal, up to BENCHMARK_MAX_SIZE samples of the waveform **/
+static uint16_t *recorded = NULL;
+static uint32_t recorded_size = 0;
+/** destination of the encoded and decoded data **/
+static uint8_t *encoded = NULL;
+static uint16_t *decoded = NULL;
+
+/** position of the block source of the stream obj **/
+static uint32_t source_offset = 0;
+static uint32_t source_size = 0;
+
+/** queues of the fan out tasks and the flags of their finished factors **/
+static QueueHandle_t fan_out_queues[FAN_OUT_TASKS];
+static EventGroupHandle_t fan_out_events = NULL;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+parse_arguments
+******************************************************************************************
+Parameters:
+int argc, char *argv[] - command line
+benchmark_config *config - destination of the options
+******************************************************************************************
+Abstract:
+This function reads the command line options. It returns false on the invalid one.
+\****************************************************************************************/
+static bool parse_arguments(int argc, char *argv[], benchmark_config *config);
+
+/****************************************************************************************\
+Function:
+load_waveform
+******************************************************************************************
+Parameters:
+const char *path - text file of the adc counts separated by white space, as read by the
+simulator
+******************************************************************************************
+Abstract:
+This function reads up to BENCHMARK_MAX_SIZE samples of the recorded signal clamped to
+the range of the adc. It returns false if the file has no sample.
+\****************************************************************************************/
+static bool load_waveform(const char *path);
+
+/****************************************************************************************\
+Function:
+generate_samples
+******************************************************************************************
+Parameters:
+benchmark_signal signal - signal of the input
+uint32_t size - number of samples
+******************************************************************************************
+Abstract:
+This function fills the input with the signal. The sine has the pseudo random noise, so
+the codec sees the residuals of a real capture. The noise is seeded, every run uses the
+same input. The recorded signal is copied and repeated up to the size.
+\****************************************************************************************/
+static void generate_samples(benchmark_signal signal, uint32_t size);
+
+/****************************************************************************************\
+Function:
+now_ns
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the monotonic time in nanoseconds.
+\****************************************************************************************/
+static double now_ns(void);
+
+/****************************************************************************************\
+Function:
+now_cycles
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the time stamp counter of the x86 host, it counts the reference
+cycles of the nominal clock. It returns 0 on the hosts without the counter.
+\****************************************************************************************/
+static uint64_t now_cycles(void);
+
+/****************************************************************************************\
+Function:
+run_calculation
+******************************************************************************************
+Parameters:
+Calculation_obj_handle obj - object passed to the calculation task
+******************************************************************************************
+Abstract:
+This function triggers the calculation of the obj and waits until the calculation task
+reports it finished, so the measured time includes the hand over to the task as on the
+target.
+\****************************************************************************************/
+static void run_calculation(Calculation_obj_handle obj);
+
+/****************************************************************************************\
+Function:
+buffer_source
+******************************************************************************************
+Parameters:
+uint16_t block[] - destination of the block
+uint32_t max_size - capacity of the block
+******************************************************************************************
+Abstract:
+This function is the block source of the stream obj, it copies the next block of the
+input as measurement_stream_read copies it from the ring buffer.
+\****************************************************************************************/
+static uint32_t buffer_source(uint16_t block[], uint32_t max_size);
+
+/****************************************************************************************\
+Function:
+fan_out_task
+******************************************************************************************
+Parameters:
+void *pvParameter - index of the factor, the position of its flag
+******************************************************************************************
+Abstract:
+This task computes one factor of the former calculation as it did, the rms and the range
+walk the buffer and yield per sample, the amplitude and the crest factor wait for their
+inputs by polling. The finished factor sets its flag.
+\****************************************************************************************/
+static void fan_out_task(void *pvParameter);
+
+/****************************************************************************************\
+Function:
+bench_statistics, bench_single_pass, bench_fan_out, bench_calculation, bench_spectrum, bench_dft,
+bench_welch, bench_integration,
+bench_envelope, bench_frame_encode, bench_frame_encode_compressed, bench_codec_encode, bench_codec_decode,
+bench_decimator
+******************************************************************************************
+Parameters:
+uint32_t size - number of samples processed by the iteration
+******************************************************************************************
+Abstract:
+These functions run one iteration of the benchmarked kernel:
+statistics - single pass factors of the stream obj, no spectrum
+single_pass - the same at the sizes of the fan out
+fan_out - factors of the former five calculation tasks
+calculation - factors and amplitude spectrum of the buffered obj
+spectrum - amplitude spectrum, measured up to SPECTRUM_MAX_FFT_SIZE
+dft - the same by the direct O(N^2) transform, the cost the fft is compared with
+welch - power spectral density of the whole input
+integration - velocity rms and displacement peak to peak of the whole input
+envelope - envelope spectrum peaks of the whole input
+frame_encode - all the time results frames of the read characteristic
+frame_encode_compressed - all the compressed frames of the stream characteristic
+codec_encode, codec_decode - sample codec of the whole input, the encoder also of the
+quiet, the full scale noise, the impacts and the recorded signals
+decimator - sampler decimation of the whole input taken as the conversions
+\****************************************************************************************/
+static uint32_t bench_statistics(uint32_t size);
+static uint32_t bench_fan_out(uint32_t size);
+static uint32_t bench_calculation(uint32_t size);
+static uint32_t bench_spectrum(uint32_t size);
+static uint32_t bench_dft(uint32_t size);
+static uint32_t bench_welch(uint32_t size);
+static uint32_t bench_integration(uint32_t size);
+static uint32_t bench_envelope(uint32_t size);
+static uint32_t bench_frame_encode(uint32_t size);
+static uint32_t bench_frame_encode_compressed(uint32_t size);
+static uint32_t bench_codec_encode(uint32_t size);
+static uint32_t bench_codec_decode(uint32_t size);
+static uint32_t bench_decimator(uint32_t size);
+
+/****************************************************************************************\
+Function:
+run_benchmark
+******************************************************************************************
+Parameters:
+FILE *output - destination of the json record
+const benchmark *bench - benchmark to be run
+uint32_t size - number of samples
+const benchmark_config *config - minimal time of the measurement
+bool is_first - true if no record was written yet
+******************************************************************************************
+Abstract:
+This function repeats the iteration until the minimal time and the minimal number of
+iterations are reached and writes the json record of the measurement.
+\****************************************************************************************/
+static void run_benchmark(FILE *output, const benchmark *bench, uint32_t size,
+				const benchmark_config *config, bool is_first);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+	/** the sizes the former calculation tasks were compared at **/
+	static const uint32_t fan_out_sizes[] = {1000, 10000, 60000, 0};
+	static const benchmark benchmarks[] = {
+		{.name = "statistics", .function = bench_statistics,
+				.max_size = BENCHMARK_MAX_SIZE},
+		{.name = "single_pass", .function = bench_statistics,
+				.max_size = BENCHMARK_MAX_SIZE, .sizes = fan_out_sizes},
+		{.name = "fan_out", .function = bench_fan_out, .max_size = BENCHMARK_MAX_SIZE,
+				.sizes = fan_out_sizes},
+		{.name = "calculation", .function = bench_calculation,
+				.max_size = BENCHMARK_MAX_SIZE},
+		{.name = "spectrum", .function = bench_spectrum,
+				.max_size = SPECTRUM_MAX_FFT_SIZE},
+		{.name = "dft", .function = bench_dft, .max_size = SPECTRUM_MAX_FFT_SIZE},
+		{.name = "welch", .function = bench_welch, .max_size = BENCHMARK_MAX_SIZE},
+		{.name = "integration", .function = bench_integration,
+				.max_size = BENCHMARK_MAX_SIZE},
+		{.name = "envelope", .function = bench_envelope, .max_size = BENCHMARK_MAX_SIZE},
+		{.name = "frame_encode", .function = bench_frame_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_SINE,
+				.is_encoder = true},
+		{.name = "frame_encode_compressed", .function = bench_frame_encode_compressed,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_SINE,
+				.is_encoder = true},
+		{.name = "codec_encode", .function = bench_codec_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_SINE,
+				.is_encoder = true},
+		{.name = "codec_decode", .function = bench_codec_decode,
+				.max_size = BENCHMARK_MAX_SIZE},
+		{.name = "codec_encode_quiet", .function = bench_codec_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_QUIET,
+				.is_encoder = true},
+		{.name = "codec_encode_noise", .function = bench_codec_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_NOISE,
+				.is_encoder = true},
+		{.name = "codec_encode_impacts", .function = bench_codec_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_IMPACTS,
+				.is_encoder = true},
+		{.name = "codec_encode_recorded", .function = bench_codec_encode,
+				.max_size = BENCHMARK_MAX_SIZE, .signal = BENCHMARK_SIGNAL_RECORDED,
+				.is_encoder = true},
+		{.name = "decimator", .function = bench_decimator,
+				.max_size = BENCHMARK_MAX_SIZE},
+	};
+	benchmark_config config = {
+		.min_time = DEFAULT_MIN_TIME,
+		.filter = NULL,
+		.output_path = NULL,
+		.waveform_path = NULL,
+	};
+	if (!parse_arguments(argc, argv, &config)) {
+		fprintf(stderr, "usage: %s [--min-time S] [--filter NAME] [--output FILE] "
+				"[--waveform FILE]\n", argv[0]);
+		return 2;
+	}
+	FILE *output = stdout;
+	if ((NULL != config.output_path) && (NULL == (output = fopen(config.output_path, "w")))) {
+		fprintf(stderr, "%s can not be written\n", config.output_path);
+		return 2;
+	}
+
+	samples = malloc(BENCHMARK_MAX_SIZE * sizeof(uint16_t));
+	decoded = malloc(BENCHMARK_MAX_SIZE * sizeof(uint16_t));
+	/** the codec never needs more than the block bytes and 2 bytes per sample **/
+	encoded = malloc(BENCHMARK_MAX_SIZE * sizeof(uint16_t) +
+			BENCHMARK_MAX_SIZE / SAMPLE_CODEC_BLOCK_LEN + 1);
+	if ((NULL == samples) || (NULL == decoded) || (NULL == encoded)) {
+		fprintf(stderr, "no memory for %u samples\n", BENCHMARK_MAX_SIZE);
+		return 1;
+	}
+	if ((NULL != config.waveform_path) && !load_waveform(config.waveform_path)) {
+		fprintf(stderr, "waveform %s can not be read\n", config.waveform_path);
+		return 2;
+	}
+	generate_samples(BENCHMARK_SIGNAL_SINE, BENCHMARK_MAX_SIZE);
+
+	entry_event_group_creator();
+	calculation_init();
+	xTaskCreate(&calculation_task, "calculation_task", CALCULATION_TASK_STACK_SIZE, NULL, 5,
+			NULL);
+
+	struct utsname host;
+	uname(&host);
+	time_t date = time(NULL);
+	char date_text[32];
+	strftime(date_text, sizeof(date_text), "%Y-%m-%dT%H:%M:%S%z", localtime(&date));
+	fprintf(output, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"host_name\": \"%s\",\n"
+			"    \"machine\": \"%s\",\n    \"min_time\": %.3f,\n    \"mtu\": %u,\n"
+			"    \"fixed_point\": %s,\n    \"waveform\": \"%s\"\n  },\n  \"benchmarks\": [",
+			date_text, host.nodename, host.machine, config.min_time, BENCHMARK_MTU,
+			CALCULATION_FIXED_POINT ? "true" : "false",
+			(NULL != config.waveform_path) ? config.waveform_path : "");
+
+	bool is_first = true;
+	for (uint32_t i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); ++i) {
+		if ((NULL != config.filter) && (NULL == strstr(benchmarks[i].name, config.filter))) {
+			continue;
+		}
+		/** the recorded signal is measured up to its length only **/
+		uint32_t max_size = benchmarks[i].max_size;
+		if (BENCHMARK_SIGNAL_RECORDED == benchmarks[i].signal) {
+			max_size = (recorded_size < max_size) ? recorded_size : max_size;
+		}
+		if (benchmarks[i].signal != samples_signal) {
+			generate_samples(benchmarks[i].signal, BENCHMARK_MAX_SIZE);
+		}
+		const uint32_t *sizes = benchmarks[i].sizes;
+		for (uint32_t size = (NULL != sizes) ? *sizes : BENCHMARK_MIN_SIZE;
+				(0 != size) && (size <= max_size);
+				size = (NULL != sizes) ? *(++sizes) : 2 * size) {
+			run_benchmark(output, &benchmarks[i], size, &config, is_first);
+			is_first = false;
+		}
+	}
+	fprintf(output, "\n  ]\n}\n");
+
+	if (stdout != output) {
+		fclose(output);
+	}
+	free(samples);
+	free(decoded);
+	free(encoded);
+	free(recorded);
+	return 0;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool parse_arguments(int argc, char *argv[], benchmark_config *config)
+{
+	static const struct option options[] = {
+		{"min-time", required_argument, NULL, 't'},
+		{"filter", required_argument, NULL, 'n'},
+		{"output", required_argument, NULL, 'o'},
+		{"waveform", required_argument, NULL, 'w'},
+		{NULL, 0, NULL, 0}
+	};
+	int option;
+	while (-1 != (option = getopt_long(argc, argv, "t:n:o:w:", options, NULL))) {
+		switch (option) {
+		case 't':
+			config->min_time = atof(optarg);
+			break;
+		case 'n':
+			config->filter = optarg;
+			break;
+		case 'o':
+			config->output_path = optarg;
+			break;
+		case 'w':
+			config->waveform_path = optarg;
+			break;
+		default:
+			return false;
+		}
+	}
+	return config->min_time > 0;
+}
+/****************************************************************************************/
+
+static bool load_waveform(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (NULL == file) {
+		return false;
+	}
+	recorded = malloc(BENCHMARK_MAX_SIZE * sizeof(uint16_t));
+	long value;
+	while ((NULL != recorded) && (recorded_size < BENCHMARK_MAX_SIZE) &&
+			(1 == fscanf(file, "%ld", &value))) {
+		if (value < 0) {
+			value = 0;
+		} else if (value >= SIGNAL_FULL_SCALE) {
+			value = SIGNAL_FULL_SCALE - 1;
+		}
+		recorded[recorded_size++] = (uint16_t)value;
+	}
+	fclose(file);
+	return 0 != recorded_size;
+}
+/****************************************************************************************/
+
+static void generate_samples(benchmark_signal signal, uint32_t size)
+{
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		uint32_t random = seed >> 16;
+		switch (signal) {
+		case BENCHMARK_SIGNAL_QUIET:
+			samples[i] = (uint16_t)(SIGNAL_OFFSET + random % (2 * SIGNAL_QUIET_NOISE + 1) -
+					SIGNAL_QUIET_NOISE);
+			break;
+		case BENCHMARK_SIGNAL_NOISE:
+			samples[i] = (uint16_t)(random % SIGNAL_FULL_SCALE);
+			break;
+		case BENCHMARK_SIGNAL_IMPACTS: {
+			uint32_t since_impact = i % SIGNAL_IMPACT_PERIOD;
+			double noise = (double)(random % (2 * SIGNAL_NOISE + 1)) - SIGNAL_NOISE;
+			samples[i] = (uint16_t)lround(SIGNAL_OFFSET + noise + SIGNAL_IMPACT_AMPLITUDE *
+					exp(-SIGNAL_IMPACT_DECAY * since_impact) *
+					sin(2 * M_PI * since_impact / SIGNAL_RESONANCE_PERIOD));
+			break;
+		}
+		case BENCHMARK_SIGNAL_RECORDED:
+			samples[i] = recorded[i % recorded_size];
+			break;
+		default: {
+			double noise = (double)(random % (2 * SIGNAL_NOISE + 1)) - SIGNAL_NOISE;
+			samples[i] = (uint16_t)lround(SIGNAL_OFFSET +
+					SIGNAL_AMPLITUDE * sin(2 * M_PI * i / SIGNAL_PERIOD) + noise);
+			break;
+		}
+		}
+	}
+	samples_signal = signal;
+}
+/****************************************************************************************/
+
+static double now_ns(void)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+/****************************************************************************************/
+
+static uint64_t now_cycles(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+/****************************************************************************************/
+
+static void run_calculation(Calculation_obj_handle obj)
+{
+	EventGroupHandle_t events = get_event_group_handle();
+	xEventGroupClearBits(events, CALCULATION_FINISHED_EVENT);
+	calculation_calculate_factors(obj);
+	xEventGroupWaitBits(events, CALCULATION_FINISHED_EVENT, pdTRUE, pdFALSE,
+			CALCULATION_TIMEOUT_MS / portTICK_PERIOD_MS);
+}
+/****************************************************************************************/
+
+static uint32_t buffer_source(uint16_t block[], uint32_t max_size)
+{
+	uint32_t count = source_size - source_offset;
+	count = (count < max_size) ? count : max_size;
+	memcpy(block, &samples[source_offset], count * sizeof(uint16_t));
+	source_offset += count;
+	return count;
+}
+/****************************************************************************************/
+
+static uint32_t bench_statistics(uint32_t size)
+{
+	Calculation_obj_handle obj = calculation_new_stream_obj(buffer_source);
+	source_offset = 0;
+	source_size = size;
+	run_calculation(obj);
+	calculation_delete_obj(&obj);
+	return 0;
+}
+/****************************************************************************************/
+
+static void fan_out_task(void *pvParameter)
+{
+	uint8_t index = (uint8_t)(uintptr_t)pvParameter;
+	EventBits_t flag = (EventBits_t)0x1 << index;
+	while (true) {
+		fan_out_obj *obj;
+		if (!xQueueReceive(fan_out_queues[index], &obj, portMAX_DELAY)) {
+			continue;
+		}
+		if (FAN_OUT_RMS_FLAG == flag) {
+			float sum = 0;
+			for (uint32_t i = 0; i < obj->size; ++i) {
+				sum += pow(obj->data[i], 2.0);
+				vTaskDelay(FAN_OUT_SAMPLE_DELAY_TICKS);
+			}
+			obj->rms = sqrt(sum / obj->size);
+		} else if (FAN_OUT_AVERAGE_FLAG == flag) {
+			uint32_t sum = 0;
+			for (uint32_t i = 0; i < obj->size; ++i) {
+				sum += obj->data[i];
+			}
+			obj->average = sum / obj->size;
+		} else if (FAN_OUT_RANGE_FLAG == flag) {
+			obj->max_val = obj->data[0];
+			obj->min_val = obj->data[0];
+			for (uint32_t i = 0; i < obj->size; ++i) {
+				if (obj->data[i] > obj->max_val) {
+					obj->max_val = obj->data[i];
+				} else if (obj->data[i] < obj->min_val) {
+					obj->min_val = obj->data[i];
+				}
+				vTaskDelay(FAN_OUT_SAMPLE_DELAY_TICKS);
+			}
+		} else {
+			EventBits_t inputs = (FAN_OUT_AMPLITUDE_FLAG == flag) ?
+					(FAN_OUT_AVERAGE_FLAG | FAN_OUT_RANGE_FLAG) :
+					(FAN_OUT_RANGE_FLAG | FAN_OUT_RMS_FLAG);
+			while (inputs != (xEventGroupGetBits(fan_out_events) & inputs)) {
+				vTaskDelay(FAN_OUT_POLL_MS / portTICK_PERIOD_MS);
+			}
+			if (FAN_OUT_AMPLITUDE_FLAG == flag) {
+				obj->amplitude = (uint16_t)fmaxf(obj->max_val - obj->average,
+						obj->average - obj->min_val);
+			} else {
+				obj->crest_factor = obj->max_val / obj->rms;
+			}
+		}
+		xEventGroupSetBits(fan_out_events, flag);
+	}
+}
+/****************************************************************************************/
+
+static uint32_t bench_fan_out(uint32_t size)
+{
+	static fan_out_obj obj;
+	if (NULL == fan_out_events) {
+		fan_out_events = xEventGroupCreate();
+		for (uint8_t i = 0; i < FAN_OUT_TASKS; ++i) {
+			fan_out_queues[i] = xQueueCreate(1, sizeof(fan_out_obj *));
+			xTaskCreate(&fan_out_task, "fan_out_task", 2048, (void *)(uintptr_t)i, 5, NULL);
+		}
+	}
+	fan_out_obj *instance = &obj;
+	instance->data = samples;
+	instance->size = size;
+	xEventGroupClearBits(fan_out_events, FAN_OUT_ALL_FLAGS);
+	for (uint8_t i = 0; i < FAN_OUT_TASKS; ++i) {
+		xQueueSend(fan_out_queues[i], &instance, portMAX_DELAY);
+	}
+	xEventGroupWaitBits(fan_out_events, FAN_OUT_ALL_FLAGS, pdFALSE, pdTRUE,
+			CALCULATION_TIMEOUT_MS / portTICK_PERIOD_MS);
+	return 0;
+}
+/****************************************************************************************/
+
+static uint32_t bench_calculation(uint32_t size)
+{
+	Calculation_obj_handle obj = calculation_new_obj(samples, size);
+	run_calculation(obj);
+	calculation_delete_obj(&obj);
+	return 0;
+}
+/****************************************************************************************/
+
+static uint32_t bench_spectrum(uint32_t size)
+{
+	return spectrum_calculate(samples, size);
+}
+/****************************************************************************************/
+
+static uint32_t bench_dft(uint32_t size)
+{
+	/** table of the size, so the transform costs the multiplications only **/
+	static float dft_cos[SPECTRUM_MAX_FFT_SIZE];
+	static float dft_sin[SPECTRUM_MAX_FFT_SIZE];
+	static float windowed[SPECTRUM_MAX_FFT_SIZE];
+	static uint32_t table_size = 0;
+	if (table_size != size) {
+		for (uint32_t n = 0; n < size; ++n) {
+			dft_cos[n] = cosf(2 * (float)M_PI * n / size);
+			dft_sin[n] = sinf(2 * (float)M_PI * n / size);
+		}
+		table_size = size;
+	}
+
+	uint32_t sum = 0;
+	for (uint32_t n = 0; n < size; ++n) {
+		sum += samples[n];
+	}
+	float mean = (float)sum / size;
+	for (uint32_t n = 0; n < size; ++n) {
+		windowed[n] = (samples[n] - mean) * (0.5f - 0.5f * dft_cos[n]);
+	}
+	/** the amplitudes are stored to the encoded buffer **/
+	for (uint32_t k = 0; k <= size / 2; ++k) {
+		float re = 0;
+		float im = 0;
+		for (uint32_t n = 0, index = 0; n < size; ++n, index = (index + k) & (size - 1)) {
+			re += windowed[n] * dft_cos[index];
+			im -= windowed[n] * dft_sin[index];
+		}
+		float amplitude = sqrtf(re * re + im * im) * 4 / size;
+		memcpy(encoded + k * sizeof(float), &amplitude, sizeof(float));
+	}
+	return (size / 2 + 1) * sizeof(float);
+}
+/****************************************************************************************/
+
+static uint32_t bench_welch(uint32_t size)
+{
+	if (0 == spectrum_welch_start(WELCH_SEGMENT_SIZE, WELCH_OVERLAP, SPECTRUM_WINDOW_HANN,
+			SAMPLING_FREQUENCY)) {
+		return 0;
+	}
+	spectrum_welch_feed(samples, size);
+	return spectrum_welch_finish();
+}
+/****************************************************************************************/
+
+static uint32_t bench_integration(uint32_t size)
+{
+	float velocity_rms;
+	float displacement_peak_to_peak;
+	if (!integration_start(SAMPLING_FREQUENCY, CALCULATION_DEFAULT_SENSITIVITY)) {
+		return 0;
+	}
+	integration_feed(samples, size);
+	integration_finish(&velocity_rms, &displacement_peak_to_peak);
+	return 0;
+}
+/****************************************************************************************/
+
+static uint32_t bench_envelope(uint32_t size)
+{
+	envelope_peak peaks[ENVELOPE_PEAK_COUNT];
+	if (!envelope_start(SAMPLING_FREQUENCY, CALCULATION_DEFAULT_SENSITIVITY)) {
+		return 0;
+	}
+	envelope_feed(samples, size);
+	envelope_finish(peaks);
+	return sizeof(peaks);
+}
+/****************************************************************************************/
+
+static uint32_t bench_frame_encode(uint32_t size)
+{
+	uint16_t max_len = result_frame_get_max_len(BENCHMARK_MTU);
+	uint32_t bytes = 0;
+	uint32_t offset = 0;
+	while (offset < size) {
+		uint16_t frame_len = max_len;
+		offset += result_frame_encode(encoded, &frame_len, samples, sizeof(uint16_t), size,
+				offset);
+		bytes += frame_len;
+	}
+	return bytes;
+}
+/****************************************************************************************/
+
+static uint32_t bench_frame_encode_compressed(uint32_t size)
+{
+	uint16_t max_len = result_frame_get_max_len(BENCHMARK_MTU);
+	uint32_t bytes = 0;
+	uint32_t offset = 0;
+	while (offset < size) {
+		uint16_t frame_len = max_len;
+		offset += result_frame_encode_compressed(encoded, &frame_len, samples, size, offset,
+				SIGNAL_OFFSET);
+		bytes += frame_len;
+	}
+	return bytes;
+}
+/****************************************************************************************/
+
+static uint32_t bench_codec_encode(uint32_t size)
+{
+	uint32_t out_len = BENCHMARK_MAX_SIZE * sizeof(uint16_t) +
+			BENCHMARK_MAX_SIZE / SAMPLE_CODEC_BLOCK_LEN + 1;
+	sample_codec_encode(samples, size, SIGNAL_OFFSET, encoded, &out_len);
+	return out_len;
+}
+/****************************************************************************************/
+
+static uint32_t bench_codec_decode(uint32_t size)
+{
+	static uint32_t encoded_size = 0;
+	static uint32_t encoded_len = 0;
+	if (encoded_size != size) {
+		encoded_len = bench_codec_encode(size);
+		encoded_size = size;
+	}
+	if (!sample_codec_decode(encoded, encoded_len, size, SIGNAL_OFFSET, decoded)) {
+		fprintf(stderr, "codec_decode failed for %u samples\n", size);
+	}
+	return size * sizeof(uint16_t);
+}
+/****************************************************************************************/
+
+static uint32_t bench_decimator(uint32_t size)
+{
+	static decimator filter;
+	if ((BENCHMARK_DECIMATION != filter.factor) &&
+			!decimator_init(&filter, BENCHMARK_DECIMATION)) {
+		return 0;
+	}
+	decimator_reset(&filter);
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < size; ++i) {
+		if (decimator_push(&filter, samples[i], &decoded[count])) {
+			++count;
+		}
+	}
+	return count * sizeof(uint16_t);
+}
+/****************************************************************************************/
+
+static void run_benchmark(FILE *output, const benchmark *bench, uint32_t size,
+				const benchmark_config *config, bool is_first)
+{
+	/** warm up, also prepares the encoded input of the decoder **/
+	uint32_t bytes = bench->function(size);
+
+	uint32_t iterations = 0;
+	double best_ns = INFINITY;
+	double start = now_ns();
+	uint64_t start_cycles = now_cycles();
+	double elapsed = 0;
+	while ((iterations < MIN_ITERATIONS) || (elapsed < config->min_time * 1e9)) {
+		double iteration_start = now_ns();
+		bench->function(size);
+		double iteration_ns = now_ns() - iteration_start;
+		best_ns = (iteration_ns < best_ns) ? iteration_ns : best_ns;
+		++iterations;
+		elapsed = now_ns() - start;
+	}
+	double real_time = elapsed / iterations;
+	double cycles_per_sample = (double)(now_cycles() - start_cycles) / iterations / size;
+	/** raw samples of two bytes per encoded byte **/
+	double compression_ratio = (bench->is_encoder && (0 != bytes)) ?
+			(double)size * sizeof(uint16_t) / bytes : 0;
+
+	fprintf(stderr, "%-24s %7u %12.0f ns %8.2f ns/sample %8.2f cycles/sample", bench->name,
+			size, real_time, real_time / size, cycles_per_sample);
+	if (bench->is_encoder) {
+		fprintf(stderr, " %6.3f ratio", compression_ratio);
+	}
+	fprintf(stderr, "\n");
+	fprintf(output, "%s\n    {\n      \"name\": \"%s/%u\",\n      \"size\": %u,\n"
+			"      \"iterations\": %u,\n      \"real_time\": %.1f,\n      \"best_time\": %.1f,\n"
+			"      \"time_unit\": \"ns\",\n      \"ns_per_sample\": %.4f,\n"
+			"      \"cycles_per_sample\": %.2f,\n"
+			"      \"bytes_per_second\": %.0f,\n      \"output_bytes\": %u",
+			is_first ? "" : ",", bench->name, size, size, iterations, real_time, best_ns,
+			real_time / size, cycles_per_sample, size * sizeof(uint16_t) * 1e9 / real_time,
+			bytes);
+	if (bench->is_encoder) {
+		fprintf(output, ",\n      \"compression_ratio\": %.4f", compression_ratio);
+	}
+	fprintf(output, "\n    }");
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,795 @@
+/** ble_stack.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "fake_gatt.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "esp_log.h"
+#include "bt.h"
+#include "esp_bt_main.h"
+#include "esp_gap_ble_api.h"
+#include "esp_gatts_api.h"
+#include "esp_gatt_common_api.h"
+
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** the built in gap and gatt services take the handles below the first application one **/
+#define FIRST_APPLICATION_HANDLE	((uint16_t)0x28)
+
+#define MAX_SERVICES				(8)
+#define MAX_ATTRIBUTES				(64)
+#define MAX_ATTRIBUTE_VALUE_LEN		(64)
+#define EVENT_QUEUE_LENGTH			(64)
+#define RESPONSE_QUEUE_LENGTH		(4)
+#define RESPONSE_TIMEOUT_MS			(1000)
+#define DEFAULT_LINK_WINDOW			((uint16_t)16)
+#define MAX_LINK_WINDOW				((uint16_t)256)
+#define ATT_NOTIFICATION_HEADER_LEN	(3)
+#define ATT_READ_RSP_HEADER_LEN		(1)
+#define CONNECTION_ID				((uint16_t)0)
+
+#define STACK_TAG					"FAKE_GATT"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** event delivered to the firmware callbacks by the stack task **/
+typedef struct {
+	bool is_gap;
+	esp_gap_ble_cb_event_t gap_event;
+	esp_ble_gap_cb_param_t gap_param;
+	esp_gatts_cb_event_t event;
+	esp_gatt_if_t gatts_if;
+	esp_ble_gatts_cb_param_t param;
+	uint8_t value[ESP_GATT_MAX_ATTR_LEN];
+} stack_event;
+
+/** response of the firmware to the read or write of the client **/
+typedef struct {
+	uint32_t trans_id;
+	esp_gatt_status_t status;
+	uint16_t len;
+	uint8_t value[ESP_GATT_MAX_ATTR_LEN];
+} stack_response;
+
+typedef struct {
+	esp_gatt_if_t gatts_if;
+	uint16_t start_handle;
+	uint16_t num_handle;
+	uint16_t next_handle;
+	bool is_started;
+} stack_service;
+
+typedef struct {
+	uint16_t handle;
+	uint16_t len;
+	uint8_t value[MAX_ATTRIBUTE_VALUE_LEN];
+} stack_attribute;
+
+typedef struct {
+	uint16_t handle;
+	uint16_t len;
+	uint8_t value[FAKE_GATT_MAX_VALUE_LEN];
+} link_notification;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static esp_gap_ble_cb_t gap_callback = NULL;
+static esp_gatts_cb_t gatts_callback = NULL;
+static QueueHandle_t event_queue = NULL;
+static QueueHandle_t response_queue = NULL;
+
+/** attribute database, guarded by the stack lock **/
+static pthread_mutex_t stack_lock = PTHREAD_MUTEX_INITIALIZER;
+static stack_service services[MAX_SERVICES];
+static uint8_t service_count = 0;
+static stack_attribute attributes[MAX_ATTRIBUTES];
+static uint8_t attribute_count = 0;
+static uint16_t next_handle = FIRST_APPLICATION_HANDLE;
+static esp_gatt_if_t registered_ifs[MAX_SERVICES];
+static uint8_t registered_if_count = 0;
+static uint16_t local_mtu = FAKE_GATT_DEFAULT_MTU;
+static uint16_t connection_mtu = FAKE_GATT_DEFAULT_MTU;
+static bool is_connected = false;
+static uint32_t next_trans_id = 1;
+
+/** notifications sent by the firmware and not taken by the client yet **/
+static struct _link{
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	link_notification queue[MAX_LINK_WINDOW];
+	uint16_t head;
+	uint16_t count;
+	uint16_t window;
+	bool is_congested;
+	uint32_t congestion_count;
+} link = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.window = DEFAULT_LINK_WINDOW,
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+stack_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This task stands for the bluedroid task, it calls the registered callbacks with the
+queued events one after another.
+\****************************************************************************************/
+static void stack_task(void *pvParameter);
+
+/****************************************************************************************\
+Function:
+post_gatts_event
+******************************************************************************************
+Parameters:
+esp_gatts_cb_event_t event - gatt server event
+esp_gatt_if_t gatts_if - interface the event is delivered to
+const esp_ble_gatts_cb_param_t *param - parameters of the event
+const uint8_t value[] - written value of the write event, NULL for the other events
+******************************************************************************************
+Abstract:
+This function queues the event for the stack task.
+\****************************************************************************************/
+static void post_gatts_event(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+				const esp_ble_gatts_cb_param_t *param, const uint8_t value[]);
+
+/****************************************************************************************\
+Function:
+post_gatts_event_to_all
+******************************************************************************************
+Parameters:
+esp_gatts_cb_event_t event - gatt server event
+const esp_ble_gatts_cb_param_t *param - parameters of the event
+******************************************************************************************
+Abstract:
+This function queues the connection event once for every registered interface, as the
+stack does for the connect, mtu and congest events.
+\****************************************************************************************/
+static void post_gatts_event_to_all(esp_gatts_cb_event_t event,
+				const esp_ble_gatts_cb_param_t *param);
+
+/****************************************************************************************\
+Function:
+post_gap_event
+******************************************************************************************
+Parameters:
+esp_gap_ble_cb_event_t event - gap event
+******************************************************************************************
+Abstract:
+This function queues the successful completion of the gap operation.
+\****************************************************************************************/
+static void post_gap_event(esp_gap_ble_cb_event_t event);
+
+/****************************************************************************************\
+Function:
+find_service
+******************************************************************************************
+Parameters:
+uint16_t handle - service handle or handle of any attribute of the service
+******************************************************************************************
+Abstract:
+This function returns the service owning the handle or NULL. The stack lock has to be
+held.
+\****************************************************************************************/
+static stack_service * find_service(uint16_t handle);
+
+/****************************************************************************************\
+Function:
+allocate_handles
+******************************************************************************************
+Parameters:
+uint16_t service_handle - service of the new attribute
+uint16_t count - number of handles, two for the characteristic and one for descriptor
+******************************************************************************************
+Abstract:
+This function takes the handles from the service range, as the stack does when the add
+function is called. It returns the last of them, the value handle, or 0 if the service
+is full.
+\****************************************************************************************/
+static uint16_t allocate_handles(uint16_t service_handle, uint16_t count);
+
+/****************************************************************************************\
+Function:
+wait_response
+******************************************************************************************
+Parameters:
+uint32_t trans_id - transaction of the request
+stack_response *response - destination of the response
+******************************************************************************************
+Abstract:
+This function waits for the response of the firmware to the given transaction, the
+responses of the timed out transactions are dropped.
+\****************************************************************************************/
+static bool wait_response(uint32_t trans_id, stack_response *response);
+
+/****************************************************************************************\
+Function:
+get_deadline
+******************************************************************************************
+Parameters:
+uint32_t timeout_ms - timeout in milliseconds
+struct timespec *deadline - absolute time of the timeout
+******************************************************************************************
+Abstract:
+This function converts the timeout to the absolute time of the timed waits.
+\****************************************************************************************/
+static void get_deadline(uint32_t timeout_ms, struct timespec *deadline);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_bluedroid_init(void)
+{
+	event_queue = xQueueCreate(EVENT_QUEUE_LENGTH, sizeof(stack_event));
+	response_queue = xQueueCreate(RESPONSE_QUEUE_LENGTH, sizeof(stack_response));
+	return ((NULL != event_queue) && (NULL != response_queue)) ? ESP_OK : ESP_ERR_NO_MEM;
+}
+/****************************************************************************************/
+
+esp_err_t esp_bluedroid_enable(void)
+{
+	return (pdPASS == xTaskCreate(&stack_task, "btc_task", 4096, NULL, 19, NULL)) ?
+			ESP_OK : ESP_FAIL;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback)
+{
+	gap_callback = callback;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gap_set_device_name(const char *name)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t *adv_data)
+{
+	post_gap_event(adv_data->set_scan_rsp ? ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT :
+			ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t *adv_params)
+{
+	post_gap_event(ESP_GAP_BLE_ADV_START_COMPLETE_EVT);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu)
+{
+	if ((mtu < FAKE_GATT_DEFAULT_MTU) || (mtu > ESP_GATT_MAX_ATTR_LEN)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	local_mtu = mtu;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback)
+{
+	gatts_callback = callback;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id)
+{
+	pthread_mutex_lock(&stack_lock);
+	if (registered_if_count >= MAX_SERVICES) {
+		pthread_mutex_unlock(&stack_lock);
+		return ESP_ERR_NO_MEM;
+	}
+	esp_gatt_if_t gatts_if = (esp_gatt_if_t)(registered_if_count + 1);
+	registered_ifs[registered_if_count++] = gatts_if;
+	pthread_mutex_unlock(&stack_lock);
+
+	esp_ble_gatts_cb_param_t param = {.reg = {.status = ESP_GATT_OK, .app_id = app_id}};
+	post_gatts_event(ESP_GATTS_REG_EVT, gatts_if, &param, NULL);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_create_service(esp_gatt_if_t gatts_if, esp_gatt_srvc_id_t *service_id,
+				uint16_t num_handle)
+{
+	pthread_mutex_lock(&stack_lock);
+	if ((service_count >= MAX_SERVICES) || (0 == num_handle)) {
+		pthread_mutex_unlock(&stack_lock);
+		return ESP_ERR_NO_MEM;
+	}
+	stack_service *service = &services[service_count++];
+	service->gatts_if = gatts_if;
+	service->start_handle = next_handle;
+	service->num_handle = num_handle;
+	service->next_handle = next_handle + 1;
+	next_handle += num_handle;
+	pthread_mutex_unlock(&stack_lock);
+
+	esp_ble_gatts_cb_param_t param = {.create = {
+		.status = ESP_GATT_OK,
+		.service_handle = service->start_handle,
+		.service_id = *service_id
+	}};
+	post_gatts_event(ESP_GATTS_CREATE_EVT, gatts_if, &param, NULL);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle)
+{
+	pthread_mutex_lock(&stack_lock);
+	stack_service *service = find_service(service_handle);
+	if (NULL != service) {
+		service->is_started = true;
+	}
+	pthread_mutex_unlock(&stack_lock);
+	if (NULL == service) {
+		return ESP_ERR_INVALID_ARG;
+	}
+
+	esp_ble_gatts_cb_param_t param = {.start = {
+		.status = ESP_GATT_OK,
+		.service_handle = service_handle
+	}};
+	post_gatts_event(ESP_GATTS_START_EVT, service->gatts_if, &param, NULL);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_add_char(uint16_t service_handle, esp_bt_uuid_t *char_uuid,
+				esp_gatt_perm_t perm, esp_gatt_char_prop_t property, esp_attr_value_t *char_val,
+				esp_attr_control_t *control)
+{
+	pthread_mutex_lock(&stack_lock);
+	stack_service *service = find_service(service_handle);
+	uint16_t handle = allocate_handles(service_handle, 2);
+	if ((0 != handle) && (attribute_count < MAX_ATTRIBUTES)) {
+		stack_attribute *attribute = &attributes[attribute_count++];
+		attribute->handle = handle;
+		attribute->len = 0;
+		if ((NULL != char_val) && (NULL != char_val->attr_value)) {
+			attribute->len = (char_val->attr_len < MAX_ATTRIBUTE_VALUE_LEN) ?
+					char_val->attr_len : MAX_ATTRIBUTE_VALUE_LEN;
+			memcpy(attribute->value, char_val->attr_value, attribute->len);
+		}
+	}
+	pthread_mutex_unlock(&stack_lock);
+	if (0 == handle) {
+		ESP_LOGE(STACK_TAG, "No handle left for the characteristic of service 0x%04x",
+				service_handle);
+		return ESP_ERR_NO_MEM;
+	}
+
+	esp_ble_gatts_cb_param_t param = {.add_char = {
+		.status = ESP_GATT_OK,
+		.attr_handle = handle,
+		.service_handle = service_handle,
+		.char_uuid = *char_uuid
+	}};
+	post_gatts_event(ESP_GATTS_ADD_CHAR_EVT, service->gatts_if, &param, NULL);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_add_char_descr(uint16_t service_handle, esp_bt_uuid_t *descr_uuid,
+				esp_gatt_perm_t perm, esp_attr_value_t *char_descr_val, esp_attr_control_t *control)
+{
+	pthread_mutex_lock(&stack_lock);
+	stack_service *service = find_service(service_handle);
+	uint16_t handle = allocate_handles(service_handle, 1);
+	pthread_mutex_unlock(&stack_lock);
+	if (0 == handle) {
+		ESP_LOGE(STACK_TAG, "No handle left for the descriptor of service 0x%04x",
+				service_handle);
+		return ESP_ERR_NO_MEM;
+	}
+
+	esp_ble_gatts_cb_param_t param = {.add_char_descr = {
+		.status = ESP_GATT_OK,
+		.attr_handle = handle,
+		.service_handle = service_handle,
+		.descr_uuid = *descr_uuid
+	}};
+	post_gatts_event(ESP_GATTS_ADD_CHAR_DESCR_EVT, service->gatts_if, &param, NULL);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_get_attr_value(uint16_t attr_handle, uint16_t *length,
+				const uint8_t **value)
+{
+	esp_err_t result = ESP_ERR_NOT_FOUND;
+	pthread_mutex_lock(&stack_lock);
+	for (uint8_t i = 0; i < attribute_count; ++i) {
+		if (attributes[i].handle == attr_handle) {
+			*length = attributes[i].len;
+			*value = attributes[i].value;
+			result = ESP_OK;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&stack_lock);
+	return result;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id,
+				uint32_t trans_id, esp_gatt_status_t status, esp_gatt_rsp_t *rsp)
+{
+	stack_response response = {.trans_id = trans_id, .status = status};
+	if (NULL != rsp) {
+		response.len = (rsp->attr_value.len < ESP_GATT_MAX_ATTR_LEN) ?
+				rsp->attr_value.len : ESP_GATT_MAX_ATTR_LEN;
+		memcpy(response.value, rsp->attr_value.value, response.len);
+	}
+	return (pdPASS == xQueueSend(response_queue, &response, 0)) ? ESP_OK : ESP_FAIL;
+}
+/****************************************************************************************/
+
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id,
+				uint16_t attr_handle, uint16_t value_len, uint8_t *value, bool need_confirm)
+{
+	if (!is_connected) {
+		return ESP_ERR_INVALID_STATE;
+	}
+	/** longer values are truncated to the mtu, as by the stack **/
+	uint16_t max_len = connection_mtu - ATT_NOTIFICATION_HEADER_LEN;
+	if (value_len > max_len) {
+		ESP_LOGW(STACK_TAG, "Notification of %u bytes truncated to %u", value_len, max_len);
+		value_len = max_len;
+	}
+
+	pthread_mutex_lock(&link.lock);
+	if (link.count >= link.window) {
+		pthread_mutex_unlock(&link.lock);
+		return ESP_FAIL;
+	}
+	link_notification *notification = &link.queue[(link.head + link.count) % MAX_LINK_WINDOW];
+	notification->handle = attr_handle;
+	notification->len = value_len;
+	memcpy(notification->value, value, value_len);
+	++link.count;
+	/** the congest events are queued under the link lock, so they reach the firmware in
+	 * the order of the state changes, the end taken by the client can not overtake the
+	 * start. The stack task never takes the link lock **/
+	if ((link.count >= link.window) && !link.is_congested) {
+		link.is_congested = true;
+		++link.congestion_count;
+		esp_ble_gatts_cb_param_t param = {.congest = {
+			.conn_id = conn_id,
+			.congested = true
+		}};
+		post_gatts_event_to_all(ESP_GATTS_CONGEST_EVT, &param);
+	}
+	pthread_cond_broadcast(&link.cond);
+	pthread_mutex_unlock(&link.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+bool fake_gatt_wait_services(uint8_t count, uint32_t timeout_ms)
+{
+	TickType_t start = xTaskGetTickCount();
+	while (true) {
+		uint8_t started = 0;
+		pthread_mutex_lock(&stack_lock);
+		for (uint8_t i = 0; i < service_count; ++i) {
+			started += services[i].is_started ? 1 : 0;
+		}
+		pthread_mutex_unlock(&stack_lock);
+		if (started >= count) {
+			/** the events of the last service are still in the queue **/
+			while (0 != uxQueueMessagesWaiting(event_queue)) {
+				vTaskDelay(1);
+			}
+			return true;
+		}
+		if ((xTaskGetTickCount() - start) * portTICK_PERIOD_MS >= timeout_ms) {
+			return false;
+		}
+		vTaskDelay(1);
+	}
+}
+/****************************************************************************************/
+
+void fake_gatt_connect(uint16_t mtu)
+{
+	connection_mtu = (mtu < local_mtu) ? mtu : local_mtu;
+	if (connection_mtu < FAKE_GATT_DEFAULT_MTU) {
+		connection_mtu = FAKE_GATT_DEFAULT_MTU;
+	}
+	is_connected = true;
+
+	esp_ble_gatts_cb_param_t param = {.connect = {.conn_id = CONNECTION_ID}};
+	post_gatts_event_to_all(ESP_GATTS_CONNECT_EVT, &param);
+	if (FAKE_GATT_DEFAULT_MTU != connection_mtu) {
+		esp_ble_gatts_cb_param_t mtu_param = {.mtu = {
+			.conn_id = CONNECTION_ID,
+			.mtu = connection_mtu
+		}};
+		post_gatts_event_to_all(ESP_GATTS_MTU_EVT, &mtu_param);
+	}
+}
+/****************************************************************************************/
+
+void fake_gatt_disconnect(void)
+{
+	is_connected = false;
+	pthread_mutex_lock(&link.lock);
+	link.count = 0;
+	link.is_congested = false;
+	pthread_mutex_unlock(&link.lock);
+
+	esp_ble_gatts_cb_param_t param = {.disconnect = {
+		.conn_id = CONNECTION_ID,
+		.reason = 0x13
+	}};
+	post_gatts_event_to_all(ESP_GATTS_DISCONNECT_EVT, &param);
+}
+/****************************************************************************************/
+
+uint16_t fake_gatt_get_mtu(void)
+{
+	return connection_mtu;
+}
+/****************************************************************************************/
+
+esp_gatt_status_t fake_gatt_write(uint16_t handle, const uint8_t data[], uint16_t len,
+				bool need_rsp)
+{
+	if (len > connection_mtu - ATT_NOTIFICATION_HEADER_LEN) {
+		return ESP_GATT_ERROR;
+	}
+	pthread_mutex_lock(&stack_lock);
+	stack_service *service = find_service(handle);
+	uint32_t trans_id = next_trans_id++;
+	pthread_mutex_unlock(&stack_lock);
+	if (NULL == service) {
+		return ESP_GATT_INVALID_HANDLE;
+	}
+
+	esp_ble_gatts_cb_param_t param = {.write = {
+		.conn_id = CONNECTION_ID,
+		.trans_id = trans_id,
+		.handle = handle,
+		.need_rsp = need_rsp,
+		.len = len
+	}};
+	post_gatts_event(ESP_GATTS_WRITE_EVT, service->gatts_if, &param, data);
+	if (!need_rsp) {
+		return ESP_GATT_OK;
+	}
+	stack_response response;
+	return wait_response(trans_id, &response) ? response.status : ESP_GATT_ERROR;
+}
+/****************************************************************************************/
+
+esp_gatt_status_t fake_gatt_read(uint16_t handle, uint8_t data[], uint16_t *len)
+{
+	pthread_mutex_lock(&stack_lock);
+	stack_service *service = find_service(handle);
+	uint32_t trans_id = next_trans_id++;
+	pthread_mutex_unlock(&stack_lock);
+	if (NULL == service) {
+		return ESP_GATT_INVALID_HANDLE;
+	}
+
+	esp_ble_gatts_cb_param_t param = {.read = {
+		.conn_id = CONNECTION_ID,
+		.trans_id = trans_id,
+		.handle = handle,
+		.need_rsp = true
+	}};
+	post_gatts_event(ESP_GATTS_READ_EVT, service->gatts_if, &param, NULL);
+	stack_response response;
+	if (!wait_response(trans_id, &response)) {
+		return ESP_GATT_ERROR;
+	}
+	uint16_t max_len = connection_mtu - ATT_READ_RSP_HEADER_LEN;
+	*len = (response.len < max_len) ? response.len : max_len;
+	memcpy(data, response.value, *len);
+	return response.status;
+}
+/****************************************************************************************/
+
+bool fake_gatt_wait_notification(uint16_t *handle, uint8_t data[], uint16_t *len,
+				uint32_t timeout_ms)
+{
+	struct timespec deadline;
+	get_deadline(timeout_ms, &deadline);
+
+	pthread_mutex_lock(&link.lock);
+	while ((0 == link.count) &&
+			(ETIMEDOUT != pthread_cond_timedwait(&link.cond, &link.lock, &deadline))) {
+	}
+	if (0 == link.count) {
+		pthread_mutex_unlock(&link.lock);
+		return false;
+	}
+	link_notification *notification = &link.queue[link.head];
+	*handle = notification->handle;
+	*len = notification->len;
+	memcpy(data, notification->value, notification->len);
+	link.head = (link.head + 1) % MAX_LINK_WINDOW;
+	--link.count;
+	if (link.is_congested && (link.count <= link.window / 2)) {
+		link.is_congested = false;
+		esp_ble_gatts_cb_param_t param = {.congest = {
+			.conn_id = CONNECTION_ID,
+			.congested = false
+		}};
+		post_gatts_event_to_all(ESP_GATTS_CONGEST_EVT, &param);
+	}
+	pthread_mutex_unlock(&link.lock);
+	return true;
+}
+/****************************************************************************************/
+
+void fake_gatt_set_link_window(uint16_t frames)
+{
+	pthread_mutex_lock(&link.lock);
+	link.window = (0 == frames) ? 1 : ((frames > MAX_LINK_WINDOW) ? MAX_LINK_WINDOW : frames);
+	pthread_mutex_unlock(&link.lock);
+}
+/****************************************************************************************/
+
+uint32_t fake_gatt_get_congestion_count(void)
+{
+	pthread_mutex_lock(&link.lock);
+	uint32_t count = link.congestion_count;
+	pthread_mutex_unlock(&link.lock);
+	return count;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void stack_task(void *pvParameter)
+{
+	static stack_event event;
+	while (true) {
+		if (pdPASS != xQueueReceive(event_queue, &event, portMAX_DELAY)) {
+			continue;
+		}
+		if (event.is_gap) {
+			if (NULL != gap_callback) {
+				gap_callback(event.gap_event, &event.gap_param);
+			}
+		} else if (NULL != gatts_callback) {
+			if (ESP_GATTS_WRITE_EVT == event.event) {
+				event.param.write.value = event.value;
+			}
+			gatts_callback(event.event, event.gatts_if, &event.param);
+		}
+	}
+}
+/****************************************************************************************/
+
+static void post_gatts_event(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+				const esp_ble_gatts_cb_param_t *param, const uint8_t value[])
+{
+	stack_event queued;
+	memset(&queued, 0, sizeof(queued));
+	queued.event = event;
+	queued.gatts_if = gatts_if;
+	queued.param = *param;
+	if ((NULL != value) && (ESP_GATTS_WRITE_EVT == event)) {
+		memcpy(queued.value, value, param->write.len);
+	}
+	xQueueSend(event_queue, &queued, portMAX_DELAY);
+}
+/****************************************************************************************/
+
+static void post_gatts_event_to_all(esp_gatts_cb_event_t event,
+				const esp_ble_gatts_cb_param_t *param)
+{
+	pthread_mutex_lock(&stack_lock);
+	uint8_t count = registered_if_count;
+	esp_gatt_if_t ifs[MAX_SERVICES];
+	memcpy(ifs, registered_ifs, sizeof(ifs));
+	pthread_mutex_unlock(&stack_lock);
+
+	for (uint8_t i = 0; i < count; ++i) {
+		post_gatts_event(event, ifs[i], param, NULL);
+	}
+}
+/****************************************************************************************/
+
+static void post_gap_event(esp_gap_ble_cb_event_t event)
+{
+	stack_event queued;
+	memset(&queued, 0, sizeof(queued));
+	queued.is_gap = true;
+	queued.gap_event = event;
+	queued.gap_param.adv_start_cmpl.status = ESP_BT_STATUS_SUCCESS;
+	xQueueSend(event_queue, &queued, portMAX_DELAY);
+}
+/****************************************************************************************/
+
+static stack_service * find_service(uint16_t handle)
+{
+	for (uint8_t i = 0; i < service_count; ++i) {
+		if ((handle >= services[i].start_handle) &&
+				(handle < services[i].start_handle + services[i].num_handle)) {
+			return &services[i];
+		}
+	}
+	return NULL;
+}
+/****************************************************************************************/
+
+static uint16_t allocate_handles(uint16_t service_handle, uint16_t count)
+{
+	stack_service *service = find_service(service_handle);
+	if ((NULL == service) ||
+			(service->next_handle + count > service->start_handle + service->num_handle)) {
+		return 0;
+	}
+	service->next_handle += count;
+	return service->next_handle - 1;
+}
+/****************************************************************************************/
+
+static bool wait_response(uint32_t trans_id, stack_response *response)
+{
+	while (pdPASS == xQueueReceive(response_queue, response, pdMS_TO_TICKS(RESPONSE_TIMEOUT_MS))) {
+		if (response->trans_id == trans_id) {
+			return true;
+		}
+	}
+	ESP_LOGE(STACK_TAG, "No response to transaction %u", trans_id);
+	return false;
+}
+/****************************************************************************************/
+
+static void get_deadline(uint32_t timeout_ms, struct timespec *deadline)
+{
+	clock_gettime(CLOCK_REALTIME, deadline);
+	long long nsec = deadline->tv_nsec + (long long)timeout_ms * 1000000LL;
+	deadline->tv_sec += nsec / 1000000000LL;
+	deadline->tv_nsec = nsec % 1000000000LL;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
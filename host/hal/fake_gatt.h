@@ -0,0 +1,154 @@
+/** fake_gatt.h **/
+
+#ifndef HOST_HAL_FAKE_GATT_H_
+#define HOST_HAL_FAKE_GATT_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_gatts_api.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** default mtu of the att protocol, used until the client negotiates a bigger one **/
+#define FAKE_GATT_DEFAULT_MTU		((uint16_t)23)
+/** longest notification held in the link queue **/
+#define FAKE_GATT_MAX_VALUE_LEN		((uint16_t)512)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+fake_gatt_wait_services
+******************************************************************************************
+Parameters:
+uint8_t count - number of services which have to be started
+uint32_t timeout_ms - maximal time to wait
+******************************************************************************************
+Abstract:
+This function waits until the firmware started the given number of services. It returns
+false on the timeout.
+\****************************************************************************************/
+bool fake_gatt_wait_services(uint8_t count, uint32_t timeout_ms);
+
+/****************************************************************************************\
+Function:
+fake_gatt_connect
+******************************************************************************************
+Parameters:
+uint16_t mtu - mtu requested by the client, FAKE_GATT_DEFAULT_MTU skips the exchange
+******************************************************************************************
+Abstract:
+This function connects the simulated client. The connect event is followed by the mtu
+event carrying the smaller of the client and the local mtu, as after the exchange.
+\****************************************************************************************/
+void fake_gatt_connect(uint16_t mtu);
+
+/****************************************************************************************\
+Function:
+fake_gatt_disconnect
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function disconnects the simulated client and drops the pending notifications.
+\****************************************************************************************/
+void fake_gatt_disconnect(void);
+
+/****************************************************************************************\
+Function:
+fake_gatt_get_mtu
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the mtu of the connection.
+\****************************************************************************************/
+uint16_t fake_gatt_get_mtu(void);
+
+/****************************************************************************************\
+Function:
+fake_gatt_write
+******************************************************************************************
+Parameters:
+uint16_t handle - handle of the written attribute
+const uint8_t data[] - written value
+uint16_t len - length of the value
+bool need_rsp - true for the write request, false for the write command
+******************************************************************************************
+Abstract:
+This function writes the attribute as the client. The write request waits for the
+response of the firmware, the write command returns ESP_GATT_OK once it is queued.
+\****************************************************************************************/
+esp_gatt_status_t fake_gatt_write(uint16_t handle, const uint8_t data[], uint16_t len,
+				bool need_rsp);
+
+/****************************************************************************************\
+Function:
+fake_gatt_read
+******************************************************************************************
+Parameters:
+uint16_t handle - handle of the read attribute
+uint8_t data[] - destination of the value, at least ESP_GATT_MAX_ATTR_LEN long
+uint16_t *len - length of the read value
+******************************************************************************************
+Abstract:
+This function reads the attribute as the client and waits for the response of the
+firmware. The value is truncated to mtu - 1 as by the read response.
+\****************************************************************************************/
+esp_gatt_status_t fake_gatt_read(uint16_t handle, uint8_t data[], uint16_t *len);
+
+/****************************************************************************************\
+Function:
+fake_gatt_wait_notification
+******************************************************************************************
+Parameters:
+uint16_t *handle - handle of the notified attribute
+uint8_t data[] - destination of the value, at least FAKE_GATT_MAX_VALUE_LEN long
+uint16_t *len - length of the value
+uint32_t timeout_ms - maximal time to wait
+******************************************************************************************
+Abstract:
+This function takes the oldest notification or indication from the link queue. It
+returns false on the timeout.
+\****************************************************************************************/
+bool fake_gatt_wait_notification(uint16_t *handle, uint8_t data[], uint16_t *len,
+				uint32_t timeout_ms);
+
+/****************************************************************************************\
+Function:
+fake_gatt_set_link_window
+******************************************************************************************
+Parameters:
+uint16_t frames - notifications the link buffers before it reports congestion
+******************************************************************************************
+Abstract:
+This function sets the depth of the link queue. The congest event is sent when the queue
+is full and cleared when the client took half of it, sending to the full queue fails.
+\****************************************************************************************/
+void fake_gatt_set_link_window(uint16_t frames);
+
+/****************************************************************************************\
+Function:
+fake_gatt_get_congestion_count
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns how many times the link reported congestion.
+\****************************************************************************************/
+uint32_t fake_gatt_get_congestion_count(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* HOST_HAL_FAKE_GATT_H_ */
@@ -0,0 +1,625 @@
+/** freertos.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/queue.h"
+#include "freertos/semphr.h"
+#include "freertos/event_groups.h"
+#include "esp_timer.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define NS_PER_S			(1000000000LL)
+#define NS_PER_MS			(1000000LL)
+/** host stack of the task, painted so the high water mark can be found, the depth
+ * requested for the target is far too small for the host libraries **/
+#define SIM_TASK_STACK_SIZE	((size_t)512 * 1024)
+#define SIM_TASK_STACK_FILL	((uint8_t)0xa5)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** task is a posix thread with the notification value and the suspension flag, threads
+ * not created by xTaskCreate get their task structure on the first use **/
+struct sim_task {
+	pthread_t thread;
+	TaskFunction_t function;
+	void *parameters;
+	const char *name;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint32_t notify_value;
+	bool is_suspended;
+	/** painted host stack, the depth requested for the target and the frame of the
+	 * entry the usage of the task function is counted from **/
+	uint8_t *stack;
+	uint32_t stack_depth;
+	uint8_t *stack_start;
+};
+
+/** queue keeps the items in a ring, the mutex is a queue with zero sized items **/
+struct sim_queue {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	uint8_t *storage;
+	UBaseType_t length;
+	UBaseType_t item_size;
+	UBaseType_t head;
+	UBaseType_t count;
+};
+
+struct sim_event_group {
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	EventBits_t bits;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** task structure of the calling thread **/
+static __thread struct sim_task *current_task = NULL;
+
+/** monotonic time of the first call, the ticks and the timer count from it **/
+static struct timespec start_time;
+static pthread_once_t start_time_once = PTHREAD_ONCE_INIT;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+task_entry
+******************************************************************************************
+Parameters:
+void *arg - task structure of the new thread
+******************************************************************************************
+Abstract:
+This function is the posix thread entry binding the task structure to the thread before
+the task function is called.
+\****************************************************************************************/
+static void * task_entry(void *arg);
+
+/****************************************************************************************\
+Function:
+task_new
+******************************************************************************************
+Parameters:
+const char *name - name of the task
+******************************************************************************************
+Abstract:
+This function allocates and initializes the task structure.
+\****************************************************************************************/
+static struct sim_task * task_new(const char *name);
+
+/****************************************************************************************\
+Function:
+get_current_task
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the task structure of the calling thread, it is created for the
+threads of the simulator which were not started by xTaskCreate.
+\****************************************************************************************/
+static struct sim_task * get_current_task(void);
+
+/****************************************************************************************\
+Function:
+wait_for_resume
+******************************************************************************************
+Parameters:
+struct sim_task *task - task of the calling thread
+******************************************************************************************
+Abstract:
+This function blocks the calling thread while its task is suspended.
+\****************************************************************************************/
+static void wait_for_resume(struct sim_task *task);
+
+/****************************************************************************************\
+Function:
+init_start_time
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function stores the time of the simulator start.
+\****************************************************************************************/
+static void init_start_time(void);
+
+/****************************************************************************************\
+Function:
+get_deadline
+******************************************************************************************
+Parameters:
+TickType_t ticks - timeout in ticks
+struct timespec *deadline - absolute time of the timeout
+******************************************************************************************
+Abstract:
+This function converts the timeout to the absolute time used by the timed waits. It
+returns false for portMAX_DELAY, which waits forever.
+\****************************************************************************************/
+static bool get_deadline(TickType_t ticks, struct timespec *deadline);
+
+/****************************************************************************************\
+Function:
+wait_until
+******************************************************************************************
+Parameters:
+pthread_cond_t *cond - condition to wait for
+pthread_mutex_t *lock - locked mutex guarding the condition
+bool has_deadline - false to wait without the timeout
+const struct timespec *deadline - absolute time of the timeout
+******************************************************************************************
+Abstract:
+This function waits for the condition. It returns false when the deadline passed.
+\****************************************************************************************/
+static bool wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, bool has_deadline,
+				const struct timespec *deadline);
+
+/****************************************************************************************\
+Function:
+event_bits_match
+******************************************************************************************
+Parameters:
+EventBits_t current - bits set in the group
+EventBits_t bits - bits waited for
+BaseType_t wait_for_all - pdTRUE if all the bits have to be set
+******************************************************************************************
+Abstract:
+This function checks the wait condition of xEventGroupWaitBits.
+\****************************************************************************************/
+static bool event_bits_match(EventBits_t current, EventBits_t bits, BaseType_t wait_for_all);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+				void *parameters, UBaseType_t priority, TaskHandle_t *created_task)
+{
+	struct sim_task *task = task_new(name);
+	if (NULL == task) {
+		return pdFAIL;
+	}
+	task->function = function;
+	task->parameters = parameters;
+	task->stack_depth = stack_depth;
+	pthread_attr_t attributes;
+	pthread_attr_init(&attributes);
+	if (0 == posix_memalign((void **)&task->stack, sysconf(_SC_PAGESIZE), SIM_TASK_STACK_SIZE)) {
+		memset(task->stack, SIM_TASK_STACK_FILL, SIM_TASK_STACK_SIZE);
+		pthread_attr_setstack(&attributes, task->stack, SIM_TASK_STACK_SIZE);
+	} else {
+		task->stack = NULL;
+	}
+	/** handle is known before the task runs, as on the target with a higher priority **/
+	if (NULL != created_task) {
+		*created_task = task;
+	}
+	int result = pthread_create(&task->thread, &attributes, task_entry, task);
+	pthread_attr_destroy(&attributes);
+	if (0 != result) {
+		return pdFAIL;
+	}
+	pthread_detach(task->thread);
+	return pdPASS;
+}
+/****************************************************************************************/
+
+void vTaskDelay(TickType_t ticks)
+{
+	struct sim_task *task = get_current_task();
+	/* the delay of 0 ticks only yields, as on the target */
+	if (0 == ticks) {
+		sim_task_yield();
+		wait_for_resume(task);
+		return;
+	}
+	struct timespec delay = {
+		.tv_sec = (ticks * portTICK_PERIOD_MS) / 1000,
+		.tv_nsec = ((ticks * portTICK_PERIOD_MS) % 1000) * NS_PER_MS
+	};
+	while ((0 != nanosleep(&delay, &delay)) && (EINTR == errno)) {
+	}
+	wait_for_resume(task);
+}
+/****************************************************************************************/
+
+TickType_t xTaskGetTickCount(void)
+{
+	return (TickType_t)(esp_timer_get_time() / (1000 * portTICK_PERIOD_MS));
+}
+/****************************************************************************************/
+
+void vTaskSuspend(TaskHandle_t task)
+{
+	struct sim_task *current = get_current_task();
+	if (NULL == task) {
+		task = current;
+	}
+	pthread_mutex_lock(&task->lock);
+	task->is_suspended = true;
+	pthread_mutex_unlock(&task->lock);
+	/** other task is stopped at its next call of the kernel **/
+	if (task == current) {
+		wait_for_resume(current);
+	}
+}
+/****************************************************************************************/
+
+void vTaskResume(TaskHandle_t task)
+{
+	if (NULL == task) {
+		return;
+	}
+	pthread_mutex_lock(&task->lock);
+	task->is_suspended = false;
+	pthread_cond_broadcast(&task->cond);
+	pthread_mutex_unlock(&task->lock);
+}
+/****************************************************************************************/
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	return get_current_task();
+}
+/****************************************************************************************/
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+	if (NULL == task) {
+		task = get_current_task();
+	}
+	uint8_t *start = __atomic_load_n(&task->stack_start, __ATOMIC_ACQUIRE);
+	if ((NULL == task->stack) || (NULL == start)) {
+		return 0;
+	}
+	/* the stack grows down, the lowest byte written is the deepest one */
+	uint8_t *lowest = task->stack;
+	while ((lowest < start) && (SIM_TASK_STACK_FILL == *lowest)) {
+		++lowest;
+	}
+	size_t used = start - lowest;
+	return (used < task->stack_depth) ? (UBaseType_t)(task->stack_depth - used) : 0;
+}
+/****************************************************************************************/
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait)
+{
+	struct sim_task *task = get_current_task();
+	struct timespec deadline;
+	bool has_deadline = get_deadline(ticks_to_wait, &deadline);
+
+	pthread_mutex_lock(&task->lock);
+	while ((0 == task->notify_value) &&
+			wait_until(&task->cond, &task->lock, has_deadline, &deadline)) {
+	}
+	uint32_t value = task->notify_value;
+	if (0 != value) {
+		task->notify_value = (pdTRUE == clear_count_on_exit) ? 0 : value - 1;
+	}
+	pthread_mutex_unlock(&task->lock);
+	wait_for_resume(task);
+	return value;
+}
+/****************************************************************************************/
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+	if (NULL == task) {
+		return pdFAIL;
+	}
+	pthread_mutex_lock(&task->lock);
+	++task->notify_value;
+	pthread_cond_broadcast(&task->cond);
+	pthread_mutex_unlock(&task->lock);
+	return pdPASS;
+}
+/****************************************************************************************/
+
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken)
+{
+	xTaskNotifyGive(task);
+	if (NULL != higher_priority_task_woken) {
+		*higher_priority_task_woken = pdTRUE;
+	}
+}
+/****************************************************************************************/
+
+void sim_task_yield(void)
+{
+	sched_yield();
+}
+/****************************************************************************************/
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t item_size)
+{
+	struct sim_queue *queue = calloc(1, sizeof(struct sim_queue));
+	if (NULL == queue) {
+		return NULL;
+	}
+	queue->storage = calloc(length, (0 != item_size) ? item_size : 1);
+	if (NULL == queue->storage) {
+		free(queue);
+		return NULL;
+	}
+	queue->length = length;
+	queue->item_size = item_size;
+	pthread_mutex_init(&queue->lock, NULL);
+	pthread_cond_init(&queue->cond, NULL);
+	return queue;
+}
+/****************************************************************************************/
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticks_to_wait)
+{
+	struct timespec deadline;
+	bool has_deadline = get_deadline(ticks_to_wait, &deadline);
+
+	pthread_mutex_lock(&queue->lock);
+	while ((queue->count == queue->length) &&
+			wait_until(&queue->cond, &queue->lock, has_deadline, &deadline)) {
+	}
+	if (queue->count == queue->length) {
+		pthread_mutex_unlock(&queue->lock);
+		return pdFAIL;
+	}
+	if (0 != queue->item_size) {
+		UBaseType_t tail = (queue->head + queue->count) % queue->length;
+		memcpy(queue->storage + tail * queue->item_size, item, queue->item_size);
+	}
+	++queue->count;
+	pthread_cond_broadcast(&queue->cond);
+	pthread_mutex_unlock(&queue->lock);
+	return pdPASS;
+}
+/****************************************************************************************/
+
+BaseType_t xQueueSendFromISR(QueueHandle_t queue, const void *item,
+				BaseType_t *higher_priority_task_woken)
+{
+	if (NULL != higher_priority_task_woken) {
+		*higher_priority_task_woken = pdTRUE;
+	}
+	return xQueueSend(queue, item, 0);
+}
+/****************************************************************************************/
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t ticks_to_wait)
+{
+	struct timespec deadline;
+	bool has_deadline = get_deadline(ticks_to_wait, &deadline);
+
+	pthread_mutex_lock(&queue->lock);
+	while ((0 == queue->count) &&
+			wait_until(&queue->cond, &queue->lock, has_deadline, &deadline)) {
+	}
+	if (0 == queue->count) {
+		pthread_mutex_unlock(&queue->lock);
+		return pdFAIL;
+	}
+	if (0 != queue->item_size) {
+		memcpy(item, queue->storage + queue->head * queue->item_size, queue->item_size);
+	}
+	queue->head = (queue->head + 1) % queue->length;
+	--queue->count;
+	pthread_cond_broadcast(&queue->cond);
+	pthread_mutex_unlock(&queue->lock);
+	return pdPASS;
+}
+/****************************************************************************************/
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+	pthread_mutex_lock(&queue->lock);
+	UBaseType_t count = queue->count;
+	pthread_mutex_unlock(&queue->lock);
+	return count;
+}
+/****************************************************************************************/
+
+void vQueueDelete(QueueHandle_t queue)
+{
+	if (NULL == queue) {
+		return;
+	}
+	pthread_mutex_destroy(&queue->lock);
+	pthread_cond_destroy(&queue->cond);
+	free(queue->storage);
+	free(queue);
+}
+/****************************************************************************************/
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+	SemaphoreHandle_t mutex = xQueueCreate(1, 0);
+	if (NULL != mutex) {
+		xSemaphoreGive(mutex);
+	}
+	return mutex;
+}
+/****************************************************************************************/
+
+EventGroupHandle_t xEventGroupCreate(void)
+{
+	struct sim_event_group *group = calloc(1, sizeof(struct sim_event_group));
+	if (NULL != group) {
+		pthread_mutex_init(&group->lock, NULL);
+		pthread_cond_init(&group->cond, NULL);
+	}
+	return group;
+}
+/****************************************************************************************/
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	pthread_mutex_lock(&group->lock);
+	group->bits |= bits;
+	EventBits_t current = group->bits;
+	pthread_cond_broadcast(&group->cond);
+	pthread_mutex_unlock(&group->lock);
+	return current;
+}
+/****************************************************************************************/
+
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits,
+				BaseType_t *higher_priority_task_woken)
+{
+	xEventGroupSetBits(group, bits);
+	if (NULL != higher_priority_task_woken) {
+		*higher_priority_task_woken = pdTRUE;
+	}
+	return pdPASS;
+}
+/****************************************************************************************/
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits)
+{
+	pthread_mutex_lock(&group->lock);
+	EventBits_t previous = group->bits;
+	group->bits &= ~bits;
+	pthread_mutex_unlock(&group->lock);
+	return previous;
+}
+/****************************************************************************************/
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group)
+{
+	pthread_mutex_lock(&group->lock);
+	EventBits_t current = group->bits;
+	pthread_mutex_unlock(&group->lock);
+	return current;
+}
+/****************************************************************************************/
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+				BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait)
+{
+	struct timespec deadline;
+	bool has_deadline = get_deadline(ticks_to_wait, &deadline);
+
+	pthread_mutex_lock(&group->lock);
+	while (!event_bits_match(group->bits, bits, wait_for_all) &&
+			wait_until(&group->cond, &group->lock, has_deadline, &deadline)) {
+	}
+	EventBits_t current = group->bits;
+	if ((pdTRUE == clear_on_exit) && event_bits_match(current, bits, wait_for_all)) {
+		group->bits &= ~bits;
+	}
+	pthread_mutex_unlock(&group->lock);
+	wait_for_resume(get_current_task());
+	return current;
+}
+/****************************************************************************************/
+
+long long esp_timer_get_time(void)
+{
+	struct timespec now;
+	pthread_once(&start_time_once, init_start_time);
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return ((long long)(now.tv_sec - start_time.tv_sec) * NS_PER_S +
+			(now.tv_nsec - start_time.tv_nsec)) / 1000;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static void * task_entry(void *arg)
+{
+	current_task = arg;
+	__atomic_store_n(&current_task->stack_start, (uint8_t *)__builtin_frame_address(0),
+			__ATOMIC_RELEASE);
+	current_task->function(current_task->parameters);
+	return NULL;
+}
+/****************************************************************************************/
+
+static struct sim_task * task_new(const char *name)
+{
+	struct sim_task *task = calloc(1, sizeof(struct sim_task));
+	if (NULL != task) {
+		task->name = name;
+		pthread_mutex_init(&task->lock, NULL);
+		pthread_cond_init(&task->cond, NULL);
+	}
+	return task;
+}
+/****************************************************************************************/
+
+static struct sim_task * get_current_task(void)
+{
+	if (NULL == current_task) {
+		current_task = task_new("sim_thread");
+		current_task->thread = pthread_self();
+	}
+	return current_task;
+}
+/****************************************************************************************/
+
+static void wait_for_resume(struct sim_task *task)
+{
+	pthread_mutex_lock(&task->lock);
+	while (task->is_suspended) {
+		pthread_cond_wait(&task->cond, &task->lock);
+	}
+	pthread_mutex_unlock(&task->lock);
+}
+/****************************************************************************************/
+
+static void init_start_time(void)
+{
+	clock_gettime(CLOCK_MONOTONIC, &start_time);
+}
+/****************************************************************************************/
+
+static bool get_deadline(TickType_t ticks, struct timespec *deadline)
+{
+	if (portMAX_DELAY == ticks) {
+		return false;
+	}
+	clock_gettime(CLOCK_REALTIME, deadline);
+	long long nsec = deadline->tv_nsec + (long long)ticks * portTICK_PERIOD_MS * NS_PER_MS;
+	deadline->tv_sec += nsec / NS_PER_S;
+	deadline->tv_nsec = nsec % NS_PER_S;
+	return true;
+}
+/****************************************************************************************/
+
+static bool wait_until(pthread_cond_t *cond, pthread_mutex_t *lock, bool has_deadline,
+				const struct timespec *deadline)
+{
+	if (!has_deadline) {
+		pthread_cond_wait(cond, lock);
+		return true;
+	}
+	return ETIMEDOUT != pthread_cond_timedwait(cond, lock, deadline);
+}
+/****************************************************************************************/
+
+static bool event_bits_match(EventBits_t current, EventBits_t bits, BaseType_t wait_for_all)
+{
+	return (pdTRUE == wait_for_all) ? ((current & bits) == bits) : (0 != (current & bits));
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,24 @@
+/** bt.h - host simulator shim **/
+
+#ifndef HOST_HAL_BT_H_
+#define HOST_HAL_BT_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+typedef enum {
+	ESP_BT_MODE_IDLE = 0, ESP_BT_MODE_BLE = 1, ESP_BT_MODE_CLASSIC_BT = 2, ESP_BT_MODE_BTDM = 3
+} esp_bt_mode_t;
+
+typedef struct {
+	uint16_t controller_task_stack_size;
+	uint8_t controller_task_prio;
+} esp_bt_controller_config_t;
+
+#define BT_CONTROLLER_INIT_CONFIG_DEFAULT() { .controller_task_stack_size = 4096, \
+	.controller_task_prio = 22 }
+
+esp_err_t esp_bt_controller_init(esp_bt_controller_config_t *cfg);
+esp_err_t esp_bt_controller_enable(esp_bt_mode_t mode);
+
+#endif /* HOST_HAL_BT_H_ */
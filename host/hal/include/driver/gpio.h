@@ -0,0 +1,18 @@
+/** gpio.h - host simulator shim **/
+
+#ifndef HOST_HAL_DRIVER_GPIO_H_
+#define HOST_HAL_DRIVER_GPIO_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+#define GPIO_ID_PIN(n)		(n)
+
+typedef int gpio_num_t;
+typedef enum { GPIO_MODE_INPUT = 1, GPIO_MODE_OUTPUT = 2 } gpio_mode_t;
+
+void gpio_pad_select_gpio(uint8_t gpio_num);
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode);
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level);
+
+#endif /* HOST_HAL_DRIVER_GPIO_H_ */
@@ -0,0 +1,46 @@
+/** i2s.h - host simulator shim **/
+
+#ifndef HOST_HAL_DRIVER_I2S_H_
+#define HOST_HAL_DRIVER_I2S_H_
+
+#include <stddef.h>
+#include "freertos/FreeRTOS.h"
+#include "driver/adc.h"
+#include "esp_intr_alloc.h"
+
+typedef enum { I2S_NUM_0 = 0, I2S_NUM_1 = 1, I2S_NUM_MAX } i2s_port_t;
+
+#define I2S_MODE_MASTER				(1)
+#define I2S_MODE_SLAVE				(2)
+#define I2S_MODE_TX					(4)
+#define I2S_MODE_RX					(8)
+#define I2S_MODE_DAC_BUILT_IN		(16)
+#define I2S_MODE_ADC_BUILT_IN		(32)
+
+typedef enum { I2S_BITS_PER_SAMPLE_16BIT = 16 } i2s_bits_per_sample_t;
+typedef enum { I2S_CHANNEL_FMT_ONLY_LEFT = 3 } i2s_channel_fmt_t;
+typedef enum { I2S_COMM_FORMAT_I2S_MSB = 2 } i2s_comm_format_t;
+
+typedef struct {
+	int mode;
+	int sample_rate;
+	i2s_bits_per_sample_t bits_per_sample;
+	i2s_channel_fmt_t channel_format;
+	i2s_comm_format_t communication_format;
+	int intr_alloc_flags;
+	int dma_buf_count;
+	int dma_buf_len;
+	bool use_apll;
+} i2s_config_t;
+
+esp_err_t i2s_driver_install(i2s_port_t i2s_num, const i2s_config_t *i2s_config,
+				int queue_size, void *i2s_queue);
+esp_err_t i2s_set_adc_mode(adc_unit_t adc_unit, adc1_channel_t adc_channel);
+esp_err_t i2s_adc_enable(i2s_port_t i2s_num);
+esp_err_t i2s_adc_disable(i2s_port_t i2s_num);
+esp_err_t i2s_start(i2s_port_t i2s_num);
+esp_err_t i2s_stop(i2s_port_t i2s_num);
+esp_err_t i2s_set_sample_rates(i2s_port_t i2s_num, uint32_t rate);
+int i2s_read_bytes(i2s_port_t i2s_num, char *dest, size_t size, TickType_t ticks_to_wait);
+
+#endif /* HOST_HAL_DRIVER_I2S_H_ */
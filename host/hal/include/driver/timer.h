@@ -0,0 +1,54 @@
+/** timer.h - host simulator shim **/
+
+#ifndef HOST_HAL_DRIVER_TIMER_H_
+#define HOST_HAL_DRIVER_TIMER_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+typedef enum { TIMER_GROUP_0 = 0, TIMER_GROUP_1 = 1, TIMER_GROUP_MAX } timer_group_t;
+typedef enum { TIMER_0 = 0, TIMER_1 = 1, TIMER_MAX } timer_idx_t;
+typedef enum { TIMER_COUNT_DOWN = 0, TIMER_COUNT_UP = 1 } timer_count_dir_t;
+typedef enum { TIMER_PAUSE = 0, TIMER_START = 1 } timer_start_t;
+typedef enum { TIMER_ALARM_DIS = 0, TIMER_ALARM_EN = 1 } timer_alarm_t;
+typedef enum { TIMER_INTR_LEVEL = 0 } timer_intr_mode_t;
+
+typedef struct {
+	bool alarm_en;
+	bool counter_en;
+	timer_intr_mode_t intr_type;
+	timer_count_dir_t counter_dir;
+	bool auto_reload;
+	uint32_t divider;
+} timer_config_t;
+
+typedef void * timer_isr_handle_t;
+
+/** registers written directly by the interrupt routine, ignored by the simulator **/
+typedef struct {
+	struct {
+		struct {
+			uint32_t alarm_en;
+		} config;
+	} hw_timer[TIMER_MAX];
+	struct {
+		uint32_t t0;
+		uint32_t t1;
+	} int_clr_timers;
+} timg_dev_t;
+
+extern timg_dev_t TIMERG0;
+
+esp_err_t timer_init(timer_group_t group_num, timer_idx_t timer_num, const timer_config_t *config);
+esp_err_t timer_isr_register(timer_group_t group_num, timer_idx_t timer_num,
+				void (*fn)(void *), void *arg, int intr_alloc_flags, timer_isr_handle_t *handle);
+esp_err_t timer_set_alarm_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t alarm_value);
+esp_err_t timer_set_divider(timer_group_t group_num, timer_idx_t timer_num, uint32_t divider);
+esp_err_t timer_set_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t load_val);
+esp_err_t timer_enable_intr(timer_group_t group_num, timer_idx_t timer_num);
+esp_err_t timer_disable_intr(timer_group_t group_num, timer_idx_t timer_num);
+esp_err_t timer_start(timer_group_t group_num, timer_idx_t timer_num);
+esp_err_t timer_pause(timer_group_t group_num, timer_idx_t timer_num);
+
+#endif /* HOST_HAL_DRIVER_TIMER_H_ */
@@ -0,0 +1,11 @@
+/** esp_bt_main.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_BT_MAIN_H_
+#define HOST_HAL_ESP_BT_MAIN_H_
+
+#include "esp_err.h"
+
+esp_err_t esp_bluedroid_init(void);
+esp_err_t esp_bluedroid_enable(void);
+
+#endif /* HOST_HAL_ESP_BT_MAIN_H_ */
@@ -0,0 +1,15 @@
+/** esp_err.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_ERR_H_
+#define HOST_HAL_ESP_ERR_H_
+
+typedef int esp_err_t;
+
+#define ESP_OK					(0)
+#define ESP_FAIL				(-1)
+#define ESP_ERR_NO_MEM			(0x101)
+#define ESP_ERR_INVALID_ARG		(0x102)
+#define ESP_ERR_INVALID_STATE	(0x103)
+#define ESP_ERR_NOT_FOUND		(0x105)
+
+#endif /* HOST_HAL_ESP_ERR_H_ */
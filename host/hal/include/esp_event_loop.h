@@ -0,0 +1,10 @@
+/** esp_event_loop.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_EVENT_LOOP_H_
+#define HOST_HAL_ESP_EVENT_LOOP_H_
+
+#include "esp_event.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#endif /* HOST_HAL_ESP_EVENT_LOOP_H_ */
@@ -0,0 +1,86 @@
+/** esp_gap_ble_api.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_GAP_BLE_API_H_
+#define HOST_HAL_ESP_GAP_BLE_API_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_gatts_api.h"
+
+#define ESP_BLE_ADV_FLAG_GEN_DISC			(0x01 << 1)
+#define ESP_BLE_ADV_FLAG_BREDR_NOT_SPT		(0x01 << 2)
+
+typedef enum { ESP_BT_STATUS_SUCCESS = 0, ESP_BT_STATUS_FAIL } esp_bt_status_t;
+typedef enum { ADV_TYPE_IND = 0x00 } esp_ble_adv_type_t;
+typedef enum { BLE_ADDR_TYPE_PUBLIC = 0x00 } esp_ble_addr_type_t;
+typedef enum { ADV_CHNL_ALL = 0x07 } esp_ble_adv_channel_t;
+typedef enum { ADV_FILTER_ALLOW_SCAN_ANY_CON_ANY = 0x00 } esp_ble_adv_filter_t;
+
+typedef struct {
+	uint16_t adv_int_min;
+	uint16_t adv_int_max;
+	esp_ble_adv_type_t adv_type;
+	esp_ble_addr_type_t own_addr_type;
+	esp_bd_addr_t peer_addr;
+	esp_ble_addr_type_t peer_addr_type;
+	esp_ble_adv_channel_t channel_map;
+	esp_ble_adv_filter_t adv_filter_policy;
+} esp_ble_adv_params_t;
+
+typedef struct {
+	bool set_scan_rsp;
+	bool include_name;
+	bool include_txpower;
+	int min_interval;
+	int max_interval;
+	int appearance;
+	uint16_t manufacturer_len;
+	uint8_t *p_manufacturer_data;
+	uint16_t service_data_len;
+	uint8_t *p_service_data;
+	uint16_t service_uuid_len;
+	uint8_t *p_service_uuid;
+	uint8_t flag;
+} esp_ble_adv_data_t;
+
+typedef enum {
+	ESP_GAP_BLE_ADV_DATA_SET_COMPLETE_EVT = 0,
+	ESP_GAP_BLE_SCAN_RSP_DATA_SET_COMPLETE_EVT,
+	ESP_GAP_BLE_SCAN_PARAM_SET_COMPLETE_EVT,
+	ESP_GAP_BLE_SCAN_RESULT_EVT,
+	ESP_GAP_BLE_ADV_DATA_RAW_SET_COMPLETE_EVT,
+	ESP_GAP_BLE_SCAN_RSP_DATA_RAW_SET_COMPLETE_EVT,
+	ESP_GAP_BLE_ADV_START_COMPLETE_EVT,
+	ESP_GAP_BLE_SCAN_START_COMPLETE_EVT,
+	ESP_GAP_BLE_AUTH_CMPL_EVT,
+	ESP_GAP_BLE_KEY_EVT,
+	ESP_GAP_BLE_SEC_REQ_EVT,
+	ESP_GAP_BLE_PASSKEY_NOTIF_EVT,
+	ESP_GAP_BLE_PASSKEY_REQ_EVT,
+	ESP_GAP_BLE_OOB_REQ_EVT,
+	ESP_GAP_BLE_LOCAL_IR_EVT,
+	ESP_GAP_BLE_LOCAL_ER_EVT,
+	ESP_GAP_BLE_NC_REQ_EVT,
+	ESP_GAP_BLE_ADV_STOP_COMPLETE_EVT,
+	ESP_GAP_BLE_SCAN_STOP_COMPLETE_EVT,
+	ESP_GAP_BLE_SET_STATIC_RAND_ADDR_EVT,
+	ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT
+} esp_gap_ble_cb_event_t;
+
+typedef union {
+	struct ble_adv_start_cmpl_evt_param {
+		esp_bt_status_t status;
+	} adv_start_cmpl;
+	struct ble_adv_stop_cmpl_evt_param {
+		esp_bt_status_t status;
+	} adv_stop_cmpl;
+} esp_ble_gap_cb_param_t;
+
+typedef void (*esp_gap_ble_cb_t)(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
+
+esp_err_t esp_ble_gap_register_callback(esp_gap_ble_cb_t callback);
+esp_err_t esp_ble_gap_set_device_name(const char *name);
+esp_err_t esp_ble_gap_config_adv_data(esp_ble_adv_data_t *adv_data);
+esp_err_t esp_ble_gap_start_advertising(esp_ble_adv_params_t *adv_params);
+
+#endif /* HOST_HAL_ESP_GAP_BLE_API_H_ */
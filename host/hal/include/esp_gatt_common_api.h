@@ -0,0 +1,11 @@
+/** esp_gatt_common_api.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_GATT_COMMON_API_H_
+#define HOST_HAL_ESP_GATT_COMMON_API_H_
+
+#include <stdint.h>
+#include "esp_err.h"
+
+esp_err_t esp_ble_gatt_set_local_mtu(uint16_t mtu);
+
+#endif /* HOST_HAL_ESP_GATT_COMMON_API_H_ */
@@ -0,0 +1,201 @@
+/** esp_gatts_api.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_GATTS_API_H_
+#define HOST_HAL_ESP_GATTS_API_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "esp_err.h"
+
+#define ESP_GATT_IF_NONE					(0xff)
+#define ESP_UUID_LEN_16						(2)
+#define ESP_UUID_LEN_32						(4)
+#define ESP_UUID_LEN_128					(16)
+#define ESP_GATT_UUID_CHAR_CLIENT_CONFIG	(0x2902)
+#define ESP_GATT_MAX_ATTR_LEN				(600)
+
+#define ESP_GATT_PERM_READ					(1 << 0)
+#define ESP_GATT_PERM_WRITE					(1 << 4)
+
+#define ESP_GATT_CHAR_PROP_BIT_READ			(1 << 1)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE_NR		(1 << 2)
+#define ESP_GATT_CHAR_PROP_BIT_WRITE		(1 << 3)
+#define ESP_GATT_CHAR_PROP_BIT_NOTIFY		(1 << 4)
+#define ESP_GATT_CHAR_PROP_BIT_INDICATE		(1 << 5)
+
+#define ESP_GATT_RSP_BY_APP					(0)
+#define ESP_GATT_AUTO_RSP					(1)
+
+typedef uint8_t esp_gatt_if_t;
+typedef uint16_t esp_gatt_perm_t;
+typedef uint8_t esp_gatt_char_prop_t;
+typedef uint8_t esp_bd_addr_t[6];
+
+typedef enum {
+	ESP_GATT_OK = 0x00,
+	ESP_GATT_INVALID_HANDLE = 0x01,
+	ESP_GATT_INVALID_ATTR_LEN = 0x0d,
+	ESP_GATT_OUT_OF_RANGE = 0x7f,
+	ESP_GATT_ERROR = 0x85,
+	ESP_GATT_CONGESTED = 0x8f
+} esp_gatt_status_t;
+
+typedef struct {
+	uint16_t len;
+	union {
+		uint16_t uuid16;
+		uint32_t uuid32;
+		uint8_t uuid128[ESP_UUID_LEN_128];
+	} uuid;
+} __attribute__((packed)) esp_bt_uuid_t;
+
+typedef struct {
+	esp_bt_uuid_t uuid;
+	uint8_t inst_id;
+} __attribute__((packed)) esp_gatt_id_t;
+
+typedef struct {
+	esp_gatt_id_t id;
+	bool is_primary;
+} __attribute__((packed)) esp_gatt_srvc_id_t;
+
+typedef struct {
+	uint16_t attr_max_len;
+	uint16_t attr_len;
+	uint8_t *attr_value;
+} esp_attr_value_t;
+
+typedef struct {
+	uint8_t auto_rsp;
+} esp_attr_control_t;
+
+typedef struct {
+	uint8_t value[ESP_GATT_MAX_ATTR_LEN];
+	uint16_t handle;
+	uint16_t offset;
+	uint16_t len;
+	uint8_t auth_req;
+} esp_gatt_value_t;
+
+typedef union {
+	esp_gatt_value_t attr_value;
+	uint16_t handle;
+} esp_gatt_rsp_t;
+
+typedef enum {
+	ESP_GATTS_REG_EVT = 0,
+	ESP_GATTS_READ_EVT = 1,
+	ESP_GATTS_WRITE_EVT = 2,
+	ESP_GATTS_EXEC_WRITE_EVT = 3,
+	ESP_GATTS_MTU_EVT = 4,
+	ESP_GATTS_CONF_EVT = 5,
+	ESP_GATTS_UNREG_EVT = 6,
+	ESP_GATTS_CREATE_EVT = 7,
+	ESP_GATTS_ADD_INCL_SRVC_EVT = 8,
+	ESP_GATTS_ADD_CHAR_EVT = 9,
+	ESP_GATTS_ADD_CHAR_DESCR_EVT = 10,
+	ESP_GATTS_DELETE_EVT = 11,
+	ESP_GATTS_START_EVT = 12,
+	ESP_GATTS_STOP_EVT = 13,
+	ESP_GATTS_CONNECT_EVT = 14,
+	ESP_GATTS_DISCONNECT_EVT = 15,
+	ESP_GATTS_OPEN_EVT = 16,
+	ESP_GATTS_CANCEL_OPEN_EVT = 17,
+	ESP_GATTS_CLOSE_EVT = 18,
+	ESP_GATTS_LISTEN_EVT = 19,
+	ESP_GATTS_CONGEST_EVT = 20,
+	ESP_GATTS_RESPONSE_EVT = 21,
+	ESP_GATTS_CREAT_ATTR_TAB_EVT = 22,
+	ESP_GATTS_SET_ATTR_VAL_EVT = 23
+} esp_gatts_cb_event_t;
+
+typedef union {
+	struct gatts_reg_evt_param {
+		esp_gatt_status_t status;
+		uint16_t app_id;
+	} reg;
+	struct gatts_read_evt_param {
+		uint16_t conn_id;
+		uint32_t trans_id;
+		esp_bd_addr_t bda;
+		uint16_t handle;
+		uint16_t offset;
+		bool is_long;
+		bool need_rsp;
+	} read;
+	struct gatts_write_evt_param {
+		uint16_t conn_id;
+		uint32_t trans_id;
+		esp_bd_addr_t bda;
+		uint16_t handle;
+		uint16_t offset;
+		bool need_rsp;
+		bool is_prep;
+		uint16_t len;
+		uint8_t *value;
+	} write;
+	struct gatts_mtu_evt_param {
+		uint16_t conn_id;
+		uint16_t mtu;
+	} mtu;
+	struct gatts_conf_evt_param {
+		esp_gatt_status_t status;
+		uint16_t conn_id;
+	} conf;
+	struct gatts_create_evt_param {
+		esp_gatt_status_t status;
+		uint16_t service_handle;
+		esp_gatt_srvc_id_t service_id;
+	} create;
+	struct gatts_add_char_evt_param {
+		esp_gatt_status_t status;
+		uint16_t attr_handle;
+		uint16_t service_handle;
+		esp_bt_uuid_t char_uuid;
+	} add_char;
+	struct gatts_add_char_descr_evt_param {
+		esp_gatt_status_t status;
+		uint16_t attr_handle;
+		uint16_t service_handle;
+		esp_bt_uuid_t descr_uuid;
+	} add_char_descr;
+	struct gatts_start_evt_param {
+		esp_gatt_status_t status;
+		uint16_t service_handle;
+	} start;
+	struct gatts_connect_evt_param {
+		uint16_t conn_id;
+		esp_bd_addr_t remote_bda;
+	} connect;
+	struct gatts_disconnect_evt_param {
+		uint16_t conn_id;
+		esp_bd_addr_t remote_bda;
+		int reason;
+	} disconnect;
+	struct gatts_congest_evt_param {
+		uint16_t conn_id;
+		bool congested;
+	} congest;
+} esp_ble_gatts_cb_param_t;
+
+typedef void (*esp_gatts_cb_t)(esp_gatts_cb_event_t event, esp_gatt_if_t gatts_if,
+				esp_ble_gatts_cb_param_t *param);
+
+esp_err_t esp_ble_gatts_register_callback(esp_gatts_cb_t callback);
+esp_err_t esp_ble_gatts_app_register(uint16_t app_id);
+esp_err_t esp_ble_gatts_create_service(esp_gatt_if_t gatts_if, esp_gatt_srvc_id_t *service_id,
+				uint16_t num_handle);
+esp_err_t esp_ble_gatts_start_service(uint16_t service_handle);
+esp_err_t esp_ble_gatts_add_char(uint16_t service_handle, esp_bt_uuid_t *char_uuid,
+				esp_gatt_perm_t perm, esp_gatt_char_prop_t property, esp_attr_value_t *char_val,
+				esp_attr_control_t *control);
+esp_err_t esp_ble_gatts_add_char_descr(uint16_t service_handle, esp_bt_uuid_t *descr_uuid,
+				esp_gatt_perm_t perm, esp_attr_value_t *char_descr_val, esp_attr_control_t *control);
+esp_err_t esp_ble_gatts_get_attr_value(uint16_t attr_handle, uint16_t *length,
+				const uint8_t **value);
+esp_err_t esp_ble_gatts_send_response(esp_gatt_if_t gatts_if, uint16_t conn_id,
+				uint32_t trans_id, esp_gatt_status_t status, esp_gatt_rsp_t *rsp);
+esp_err_t esp_ble_gatts_send_indicate(esp_gatt_if_t gatts_if, uint16_t conn_id,
+				uint16_t attr_handle, uint16_t value_len, uint8_t *value, bool need_confirm);
+
+#endif /* HOST_HAL_ESP_GATTS_API_H_ */
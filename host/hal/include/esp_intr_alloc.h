@@ -0,0 +1,9 @@
+/** esp_intr_alloc.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_INTR_ALLOC_H_
+#define HOST_HAL_ESP_INTR_ALLOC_H_
+
+#define ESP_INTR_FLAG_LEVEL1		(1 << 1)
+#define ESP_INTR_FLAG_IRAM			(1 << 10)
+
+#endif /* HOST_HAL_ESP_INTR_ALLOC_H_ */
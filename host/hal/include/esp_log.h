@@ -0,0 +1,20 @@
+/** esp_log.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_LOG_H_
+#define HOST_HAL_ESP_LOG_H_
+
+#include <stdio.h>
+#include "esp_timer.h"
+
+/** the log lines go to stderr so the simulator report on stdout stays parseable **/
+#define ESP_LOG_LINE(letter, tag, format, ...) \
+	fprintf(stderr, letter " (%lld) %s: " format "\n", \
+			(long long)(esp_timer_get_time() / 1000), tag, ##__VA_ARGS__)
+
+#define ESP_LOGE(tag, format, ...)	ESP_LOG_LINE("E", tag, format, ##__VA_ARGS__)
+#define ESP_LOGW(tag, format, ...)	ESP_LOG_LINE("W", tag, format, ##__VA_ARGS__)
+#define ESP_LOGI(tag, format, ...)	ESP_LOG_LINE("I", tag, format, ##__VA_ARGS__)
+#define ESP_LOGD(tag, format, ...)	do { } while (0)
+#define ESP_LOGV(tag, format, ...)	do { } while (0)
+
+#endif /* HOST_HAL_ESP_LOG_H_ */
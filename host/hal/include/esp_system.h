@@ -0,0 +1,8 @@
+/** esp_system.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_SYSTEM_H_
+#define HOST_HAL_ESP_SYSTEM_H_
+
+#include "esp_err.h"
+
+#endif /* HOST_HAL_ESP_SYSTEM_H_ */
@@ -0,0 +1,11 @@
+/** esp_timer.h - host simulator shim **/
+
+#ifndef HOST_HAL_ESP_TIMER_H_
+#define HOST_HAL_ESP_TIMER_H_
+
+#include <stdint.h>
+
+/** microseconds since the start of the simulator, long long as %lld is used by the logs **/
+long long esp_timer_get_time(void);
+
+#endif /* HOST_HAL_ESP_TIMER_H_ */
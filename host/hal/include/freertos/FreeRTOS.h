@@ -0,0 +1,72 @@
+/** FreeRTOS.h - host simulator shim **/
+
+#ifndef HOST_HAL_FREERTOS_FREERTOS_H_
+#define HOST_HAL_FREERTOS_FREERTOS_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "esp_err.h"
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define configTICK_RATE_HZ			(1000)
+#define configMINIMAL_STACK_SIZE	(768)
+#define portTICK_PERIOD_MS			(1000 / configTICK_RATE_HZ)
+#define portMAX_DELAY				((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms)			((TickType_t)((ms) / portTICK_PERIOD_MS))
+#define pdTRUE						(1)
+#define pdFALSE						(0)
+#define pdPASS						(pdTRUE)
+#define pdFAIL						(pdFALSE)
+#define portYIELD_FROM_ISR()		sim_task_yield()
+#define IRAM_ATTR
+#define APB_CLK_FREQ				(80000000)
+/** spinlock of the critical section, the interrupts are the threads of the simulated
+ * peripherals **/
+#define portMUX_INITIALIZER_UNLOCKED	PTHREAD_MUTEX_INITIALIZER
+#define portENTER_CRITICAL(mux)		pthread_mutex_lock(mux)
+#define portEXIT_CRITICAL(mux)		pthread_mutex_unlock(mux)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef struct sim_task * TaskHandle_t;
+typedef struct sim_queue * QueueHandle_t;
+typedef struct sim_queue * SemaphoreHandle_t;
+typedef struct sim_event_group * EventGroupHandle_t;
+typedef uint32_t EventBits_t;
+typedef void (*TaskFunction_t)(void *);
+typedef pthread_mutex_t portMUX_TYPE;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+sim_task_yield
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function gives the processor to the other threads, it stands for the context
+switch requested at the end of the interrupt.
+\****************************************************************************************/
+void sim_task_yield(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+#endif /* HOST_HAL_FREERTOS_FREERTOS_H_ */
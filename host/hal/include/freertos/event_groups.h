@@ -0,0 +1,17 @@
+/** event_groups.h - host simulator shim **/
+
+#ifndef HOST_HAL_FREERTOS_EVENT_GROUPS_H_
+#define HOST_HAL_FREERTOS_EVENT_GROUPS_H_
+
+#include "FreeRTOS.h"
+
+EventGroupHandle_t xEventGroupCreate(void);
+EventBits_t xEventGroupSetBits(EventGroupHandle_t group, EventBits_t bits);
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t group, EventBits_t bits,
+				BaseType_t *higher_priority_task_woken);
+EventBits_t xEventGroupClearBits(EventGroupHandle_t group, EventBits_t bits);
+EventBits_t xEventGroupGetBits(EventGroupHandle_t group);
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t group, EventBits_t bits,
+				BaseType_t clear_on_exit, BaseType_t wait_for_all, TickType_t ticks_to_wait);
+
+#endif /* HOST_HAL_FREERTOS_EVENT_GROUPS_H_ */
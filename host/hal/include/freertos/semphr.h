@@ -0,0 +1,13 @@
+/** semphr.h - host simulator shim **/
+
+#ifndef HOST_HAL_FREERTOS_SEMPHR_H_
+#define HOST_HAL_FREERTOS_SEMPHR_H_
+
+#include "queue.h"
+
+/** the mutex is a queue of length one holding the token **/
+SemaphoreHandle_t xSemaphoreCreateMutex(void);
+#define xSemaphoreTake(semaphore, ticks_to_wait)	xQueueReceive((semaphore), NULL, (ticks_to_wait))
+#define xSemaphoreGive(semaphore)					xQueueSend((semaphore), NULL, 0)
+
+#endif /* HOST_HAL_FREERTOS_SEMPHR_H_ */
@@ -0,0 +1,22 @@
+/** task.h - host simulator shim **/
+
+#ifndef HOST_HAL_FREERTOS_TASK_H_
+#define HOST_HAL_FREERTOS_TASK_H_
+
+#include "FreeRTOS.h"
+
+BaseType_t xTaskCreate(TaskFunction_t function, const char *name, uint32_t stack_depth,
+				void *parameters, UBaseType_t priority, TaskHandle_t *created_task);
+void vTaskDelay(TickType_t ticks);
+TickType_t xTaskGetTickCount(void);
+void vTaskSuspend(TaskHandle_t task);
+void vTaskResume(TaskHandle_t task);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+/* bytes of the stack depth never used by the task, the depth less the deepest use of the
+ * task function on the host */
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task);
+uint32_t ulTaskNotifyTake(BaseType_t clear_count_on_exit, TickType_t ticks_to_wait);
+BaseType_t xTaskNotifyGive(TaskHandle_t task);
+void vTaskNotifyGiveFromISR(TaskHandle_t task, BaseType_t *higher_priority_task_woken);
+
+#endif /* HOST_HAL_FREERTOS_TASK_H_ */
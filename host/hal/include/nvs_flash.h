@@ -0,0 +1,10 @@
+/** nvs_flash.h - host simulator shim **/
+
+#ifndef HOST_HAL_NVS_FLASH_H_
+#define HOST_HAL_NVS_FLASH_H_
+
+#include "esp_err.h"
+
+esp_err_t nvs_flash_init(void);
+
+#endif /* HOST_HAL_NVS_FLASH_H_ */
@@ -0,0 +1,792 @@
+/** peripherals.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "sim_adc.h"
+#include "driver/adc.h"
+#include "driver/timer.h"
+#include "driver/i2s.h"
+#include "driver/gpio.h"
+#include "esp_timer.h"
+#include "nvs_flash.h"
+#include "nvs.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** sine converted when no waveform was given, 50 Hz at 1 kHz sampling **/
+#define DEFAULT_WAVEFORM_OFFSET		((uint16_t)2048)
+#define DEFAULT_WAVEFORM_PERIOD		(20.0)
+#define DEFAULT_WAVEFORM_AMPLITUDE	((uint16_t)400)
+#define MAX_WAVEFORM_LEN			((uint32_t)1 << 20)
+/** bearing fault waveform, about 2^18 conversions long, the impacts decay to e^-8 until
+ * the next one and the inner race ones are modulated to this depth **/
+#define FAULT_WAVEFORM_LEN			((double)((uint32_t)1 << 18))
+#define FAULT_DECAY_PER_PERIOD		(8.0)
+#define FAULT_MODULATION_DEPTH		(0.5)
+
+/** seed of the generator of the adc noise, the runs are repeatable **/
+#define NOISE_SEED					(0x9e3779b97f4a7c15ULL)
+
+/** real time interrupts are delivered in batches, one batch per this period **/
+#define TIMER_BATCH_PERIOD_US		(1000LL)
+/** unpaced interrupts give the other threads the processor after this many calls **/
+#define TIMER_YIELD_INTERVAL		((uint32_t)64)
+
+/** the I2S ADC samples carry the channel number in the upper nibble **/
+#define I2S_CHANNEL_SHIFT			(12)
+
+/** the nvs is kept in memory for the run of the simulator, the names have at most 15
+ * characters as on the device **/
+#define NVS_MAX_NAMESPACES			(4)
+#define NVS_MAX_ENTRIES				(16)
+#define NVS_MAX_NAME_LEN			(16)
+#define NVS_MAX_BLOB_LEN			(256)
+/** the handle holds the index of the namespace and the open mode **/
+#define NVS_HANDLE_MODE_SHIFT		(8)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** waveform converted by the adc, in adc counts before the rounding of the conversion **/
+static float *waveform = NULL;
+static uint32_t waveform_len = 0;
+static uint32_t waveform_pos = 0;
+static uint64_t conversion_count = 0;
+static pthread_mutex_t adc_lock = PTHREAD_MUTEX_INITIALIZER;
+static bool is_realtime = true;
+
+/** gaussian noise added to the waveform before the conversion **/
+static double noise_rms = 0;
+static uint64_t noise_state = NOISE_SEED;
+
+/** timer group 0 registers written by the interrupt routine **/
+timg_dev_t TIMERG0;
+
+/** state of the timer 0 of the group 0, the only one used by the firmware **/
+static struct _sim_timer{
+	pthread_t thread;
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	void (*isr)(void *);
+	void *isr_arg;
+	uint64_t alarm_value;
+	uint32_t divider;
+	bool is_intr_enabled;
+	bool is_running;
+} sim_timer = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.divider = 2,
+};
+
+/** state of the I2S ADC mode, the conversions are written in the swapped pairs and the
+ * read ending inside a pair keeps its other half for the next one **/
+static struct _sim_i2s{
+	adc1_channel_t channel;
+	uint32_t sample_rate;
+	bool is_running;
+	long long next_sample_time;
+	uint32_t read_sizes[SIM_ADC_MAX_READ_SIZES];
+	uint8_t read_size_count;
+	uint8_t next_read_size;
+	bool is_half_pair;
+	uint16_t half_pair;
+} sim_i2s = {
+	.sample_rate = 1000,
+};
+
+/** entries of the nvs **/
+static struct _sim_nvs{
+	pthread_mutex_t lock;
+	char namespaces[NVS_MAX_NAMESPACES][NVS_MAX_NAME_LEN];
+	uint8_t namespace_count;
+	struct {
+		uint8_t namespace_index;
+		char key[NVS_MAX_NAME_LEN];
+		uint8_t value[NVS_MAX_BLOB_LEN];
+		size_t len;
+	} entries[NVS_MAX_ENTRIES];
+	uint8_t entry_count;
+} sim_nvs = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+next_conversion
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the next value of the waveform with the noise, rounded and clamped
+to the range of the adc. The default sine is generated on the first call if no waveform
+was set.
+\****************************************************************************************/
+static uint16_t next_conversion(void);
+
+/****************************************************************************************\
+Function:
+next_noise
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the next value of the standard normal noise, by the Box-Muller
+transform of the xorshift generator. It is called with the adc lock held.
+\****************************************************************************************/
+static double next_noise(void);
+
+/****************************************************************************************\
+Function:
+timer_thread
+******************************************************************************************
+Parameters:
+void *arg - not used
+******************************************************************************************
+Abstract:
+This thread stands for the timer interrupt. While the timer runs it calls the registered
+routine once per alarm period, in real time it catches up with the elapsed time once per
+millisecond.
+\****************************************************************************************/
+static void * timer_thread(void *arg);
+
+/****************************************************************************************\
+Function:
+sleep_until
+******************************************************************************************
+Parameters:
+long long time_us - esp_timer_get_time value to wake up at
+******************************************************************************************
+Abstract:
+This function sleeps until the given time.
+\****************************************************************************************/
+static void sleep_until(long long time_us);
+
+/****************************************************************************************\
+Function:
+find_nvs_entry
+******************************************************************************************
+Parameters:
+nvs_handle handle - handle of the opened namespace
+const char *key - key of the entry
+******************************************************************************************
+Abstract:
+This function returns the index of the entry of the namespace, or NVS_MAX_ENTRIES if
+there is none. The nvs lock has to be taken.
+\****************************************************************************************/
+static uint8_t find_nvs_entry(nvs_handle handle, const char *key);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+bool sim_adc_load_waveform(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (NULL == file) {
+		return false;
+	}
+	float *values = malloc(MAX_WAVEFORM_LEN * sizeof(float));
+	uint32_t len = 0;
+	long value;
+	while ((NULL != values) && (len < MAX_WAVEFORM_LEN) && (1 == fscanf(file, "%ld", &value))) {
+		if (value < 0) {
+			value = 0;
+		} else if (value > SIM_ADC_MAX_VALUE) {
+			value = SIM_ADC_MAX_VALUE;
+		}
+		values[len++] = (float)value;
+	}
+	fclose(file);
+	if (0 == len) {
+		free(values);
+		return false;
+	}
+
+	pthread_mutex_lock(&adc_lock);
+	free(waveform);
+	waveform = values;
+	waveform_len = len;
+	waveform_pos = 0;
+	pthread_mutex_unlock(&adc_lock);
+	return true;
+}
+/****************************************************************************************/
+
+void sim_adc_generate_sine(uint16_t offset, uint16_t amplitude, double period)
+{
+	uint32_t periods = 1;
+	while ((periods < 1000) && (fabs(periods * period - round(periods * period)) > 1e-6)) {
+		++periods;
+	}
+	uint32_t len = (uint32_t)round(periods * period);
+	if ((len < 1) || (len > MAX_WAVEFORM_LEN)) {
+		len = MAX_WAVEFORM_LEN;
+	}
+	float *values = malloc(len * sizeof(float));
+	if (NULL == values) {
+		return;
+	}
+	for (uint32_t i = 0; i < len; ++i) {
+		values[i] = (float)(offset + amplitude * sin(2 * M_PI * i / period));
+	}
+
+	pthread_mutex_lock(&adc_lock);
+	free(waveform);
+	waveform = values;
+	waveform_len = len;
+	waveform_pos = 0;
+	pthread_mutex_unlock(&adc_lock);
+}
+/****************************************************************************************/
+
+void sim_adc_generate_bearing_fault(uint16_t offset, uint16_t amplitude,
+				double resonance_period, double fault_period, double modulation_period)
+{
+	if ((fault_period < 1) || (resonance_period <= 0)) {
+		return;
+	}
+	uint32_t impacts = (uint32_t)fmax(round(FAULT_WAVEFORM_LEN / fault_period), 1);
+	uint32_t len = (uint32_t)round(impacts * fault_period);
+	if ((len < 1) || (len > MAX_WAVEFORM_LEN)) {
+		return;
+	}
+	float *values = malloc(len * sizeof(float));
+	if (NULL == values) {
+		return;
+	}
+	double decay = FAULT_DECAY_PER_PERIOD / fault_period;
+	for (uint32_t i = 0; i < len; ++i) {
+		/* the ring of the last impact and the tail of the one before */
+		double value = offset;
+		double last = floor(i / fault_period);
+		for (double k = last; (k >= last - 1) && (k >= 0); --k) {
+			double impact_time = k * fault_period;
+			double t = i - impact_time;
+			double strength = amplitude;
+			if (0 != modulation_period) {
+				strength *= (1 + FAULT_MODULATION_DEPTH *
+						cos(2 * M_PI * impact_time / modulation_period)) /
+						(1 + FAULT_MODULATION_DEPTH);
+			}
+			value += strength * exp(-decay * t) * sin(2 * M_PI * t / resonance_period);
+		}
+		values[i] = (float)value;
+	}
+
+	pthread_mutex_lock(&adc_lock);
+	free(waveform);
+	waveform = values;
+	waveform_len = len;
+	waveform_pos = 0;
+	pthread_mutex_unlock(&adc_lock);
+}
+/****************************************************************************************/
+
+void sim_adc_generate_spike(uint16_t offset, uint16_t amplitude, uint32_t period)
+{
+	if ((period < 1) || (period > MAX_WAVEFORM_LEN)) {
+		return;
+	}
+	float *values = malloc(period * sizeof(float));
+	if (NULL == values) {
+		return;
+	}
+	for (uint32_t i = 0; i < period; ++i) {
+		values[i] = offset;
+	}
+	values[period / 2] += amplitude;
+
+	pthread_mutex_lock(&adc_lock);
+	free(waveform);
+	waveform = values;
+	waveform_len = period;
+	waveform_pos = 0;
+	pthread_mutex_unlock(&adc_lock);
+}
+/****************************************************************************************/
+
+void sim_adc_set_noise(double rms)
+{
+	pthread_mutex_lock(&adc_lock);
+	noise_rms = rms;
+	noise_state = NOISE_SEED;
+	pthread_mutex_unlock(&adc_lock);
+}
+/****************************************************************************************/
+
+void sim_adc_set_realtime(bool realtime)
+{
+	is_realtime = realtime;
+}
+/****************************************************************************************/
+
+uint64_t sim_adc_get_conversion_count(void)
+{
+	pthread_mutex_lock(&adc_lock);
+	uint64_t count = conversion_count;
+	pthread_mutex_unlock(&adc_lock);
+	return count;
+}
+/****************************************************************************************/
+
+void sim_adc_set_dma_read_sizes(const uint32_t sizes[], uint8_t count)
+{
+	count = (NULL == sizes) ? 0 : count;
+	count = (count > SIM_ADC_MAX_READ_SIZES) ? SIM_ADC_MAX_READ_SIZES : count;
+	for (uint8_t i = 0; i < count; ++i) {
+		sim_i2s.read_sizes[i] = sizes[i];
+	}
+	sim_i2s.next_read_size = 0;
+	sim_i2s.read_size_count = count;
+}
+/****************************************************************************************/
+
+uint32_t sim_adc_get_dma_sample_rate(void)
+{
+	return sim_i2s.sample_rate;
+}
+/****************************************************************************************/
+
+esp_err_t adc1_config_width(adc_bits_width_t width_bit)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t adc1_config_channel_atten(adc1_channel_t channel, adc_atten_t atten)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+int adc1_get_raw(adc1_channel_t channel)
+{
+	return next_conversion();
+}
+/****************************************************************************************/
+
+esp_err_t timer_init(timer_group_t group_num, timer_idx_t timer_num, const timer_config_t *config)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.divider = config->divider;
+	sim_timer.is_running = config->counter_en;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_isr_register(timer_group_t group_num, timer_idx_t timer_num,
+				void (*fn)(void *), void *arg, int intr_alloc_flags, timer_isr_handle_t *handle)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	bool is_first = (NULL == sim_timer.isr);
+	sim_timer.isr = fn;
+	sim_timer.isr_arg = arg;
+	pthread_mutex_unlock(&sim_timer.lock);
+	if (is_first && (0 != pthread_create(&sim_timer.thread, NULL, timer_thread, NULL))) {
+		return ESP_FAIL;
+	}
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_set_alarm_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t alarm_value)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.alarm_value = alarm_value;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_set_divider(timer_group_t group_num, timer_idx_t timer_num, uint32_t divider)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.divider = divider;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_set_counter_value(timer_group_t group_num, timer_idx_t timer_num, uint64_t load_val)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_enable_intr(timer_group_t group_num, timer_idx_t timer_num)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.is_intr_enabled = true;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_disable_intr(timer_group_t group_num, timer_idx_t timer_num)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.is_intr_enabled = false;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_start(timer_group_t group_num, timer_idx_t timer_num)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.is_running = true;
+	pthread_cond_broadcast(&sim_timer.cond);
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t timer_pause(timer_group_t group_num, timer_idx_t timer_num)
+{
+	pthread_mutex_lock(&sim_timer.lock);
+	sim_timer.is_running = false;
+	pthread_mutex_unlock(&sim_timer.lock);
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_driver_install(i2s_port_t i2s_num, const i2s_config_t *i2s_config,
+				int queue_size, void *i2s_queue)
+{
+	sim_i2s.sample_rate = i2s_config->sample_rate;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_set_adc_mode(adc_unit_t adc_unit, adc1_channel_t adc_channel)
+{
+	sim_i2s.channel = adc_channel;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_adc_enable(i2s_port_t i2s_num)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_adc_disable(i2s_port_t i2s_num)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_start(i2s_port_t i2s_num)
+{
+	sim_i2s.is_running = true;
+	sim_i2s.next_sample_time = esp_timer_get_time();
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_stop(i2s_port_t i2s_num)
+{
+	sim_i2s.is_running = false;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t i2s_set_sample_rates(i2s_port_t i2s_num, uint32_t rate)
+{
+	if (0 == rate) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	sim_i2s.sample_rate = rate;
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+int i2s_read_bytes(i2s_port_t i2s_num, char *dest, size_t size, TickType_t ticks_to_wait)
+{
+	if (!sim_i2s.is_running) {
+		return -1;
+	}
+	uint16_t *block = (uint16_t *)dest;
+	uint32_t count = size / sizeof(uint16_t);
+	if (0 != sim_i2s.read_size_count) {
+		uint32_t read_size = sim_i2s.read_sizes[sim_i2s.next_read_size];
+		sim_i2s.next_read_size = (sim_i2s.next_read_size + 1) % sim_i2s.read_size_count;
+		count = (read_size < count) ? read_size : count;
+	}
+	/** the samples of each pair are swapped, as written by the DMA **/
+	for (uint32_t i = 0; i < count; ++i) {
+		if (sim_i2s.is_half_pair) {
+			block[i] = sim_i2s.half_pair;
+			sim_i2s.is_half_pair = false;
+			continue;
+		}
+		sim_i2s.half_pair = next_conversion() | (sim_i2s.channel << I2S_CHANNEL_SHIFT);
+		block[i] = next_conversion() | (sim_i2s.channel << I2S_CHANNEL_SHIFT);
+		sim_i2s.is_half_pair = true;
+	}
+	if (is_realtime) {
+		sim_i2s.next_sample_time += (long long)count * 1000000 / sim_i2s.sample_rate;
+		sleep_until(sim_i2s.next_sample_time);
+	}
+	return count * sizeof(uint16_t);
+}
+/****************************************************************************************/
+
+void gpio_pad_select_gpio(uint8_t gpio_num)
+{
+}
+/****************************************************************************************/
+
+esp_err_t gpio_set_direction(gpio_num_t gpio_num, gpio_mode_t mode)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t gpio_set_level(gpio_num_t gpio_num, uint32_t level)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t nvs_flash_init(void)
+{
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+esp_err_t nvs_open(const char *name, nvs_open_mode open_mode, nvs_handle *out_handle)
+{
+	if ((NULL == name) || (strlen(name) >= NVS_MAX_NAME_LEN) || (NULL == out_handle)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	esp_err_t result = ESP_OK;
+	pthread_mutex_lock(&sim_nvs.lock);
+	uint8_t index = 0;
+	while ((index < sim_nvs.namespace_count) &&
+			(0 != strcmp(sim_nvs.namespaces[index], name))) {
+		++index;
+	}
+	if (index == sim_nvs.namespace_count) {
+		/* the namespace is created by the first read write open */
+		if (NVS_READONLY == open_mode) {
+			result = ESP_ERR_NVS_NOT_FOUND;
+		} else if (NVS_MAX_NAMESPACES == sim_nvs.namespace_count) {
+			result = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+		} else {
+			strcpy(sim_nvs.namespaces[sim_nvs.namespace_count++], name);
+		}
+	}
+	pthread_mutex_unlock(&sim_nvs.lock);
+	*out_handle = index | ((nvs_handle)open_mode << NVS_HANDLE_MODE_SHIFT);
+	return result;
+}
+/****************************************************************************************/
+
+esp_err_t nvs_get_blob(nvs_handle handle, const char *key, void *out_value, size_t *length)
+{
+	esp_err_t result = ESP_OK;
+	pthread_mutex_lock(&sim_nvs.lock);
+	uint8_t index = find_nvs_entry(handle, key);
+	if (NVS_MAX_ENTRIES == index) {
+		result = ESP_ERR_NVS_NOT_FOUND;
+	} else if (NULL == out_value) {
+		/* only the length is queried */
+		*length = sim_nvs.entries[index].len;
+	} else if (*length < sim_nvs.entries[index].len) {
+		result = ESP_ERR_NVS_INVALID_LENGTH;
+	} else {
+		*length = sim_nvs.entries[index].len;
+		memcpy(out_value, sim_nvs.entries[index].value, *length);
+	}
+	pthread_mutex_unlock(&sim_nvs.lock);
+	return result;
+}
+/****************************************************************************************/
+
+esp_err_t nvs_set_blob(nvs_handle handle, const char *key, const void *value, size_t length)
+{
+	if ((NULL == key) || (strlen(key) >= NVS_MAX_NAME_LEN)) {
+		return ESP_ERR_INVALID_ARG;
+	}
+	if (NVS_READWRITE != (handle >> NVS_HANDLE_MODE_SHIFT)) {
+		return ESP_ERR_NVS_READ_ONLY;
+	}
+	esp_err_t result = ESP_OK;
+	pthread_mutex_lock(&sim_nvs.lock);
+	uint8_t index = find_nvs_entry(handle, key);
+	if (NVS_MAX_ENTRIES == index) {
+		index = sim_nvs.entry_count;
+	}
+	if ((NVS_MAX_ENTRIES == index) || (length > NVS_MAX_BLOB_LEN)) {
+		result = ESP_ERR_NVS_NOT_ENOUGH_SPACE;
+	} else {
+		if (index == sim_nvs.entry_count) {
+			++sim_nvs.entry_count;
+		}
+		sim_nvs.entries[index].namespace_index = (uint8_t)handle;
+		strcpy(sim_nvs.entries[index].key, key);
+		memcpy(sim_nvs.entries[index].value, value, length);
+		sim_nvs.entries[index].len = length;
+	}
+	pthread_mutex_unlock(&sim_nvs.lock);
+	return result;
+}
+/****************************************************************************************/
+
+esp_err_t nvs_commit(nvs_handle handle)
+{
+	/* the entries are kept in memory, there is nothing to be written */
+	return ESP_OK;
+}
+/****************************************************************************************/
+
+void nvs_close(nvs_handle handle)
+{
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static uint16_t next_conversion(void)
+{
+	if (0 == waveform_len) {
+		sim_adc_generate_sine(DEFAULT_WAVEFORM_OFFSET, DEFAULT_WAVEFORM_AMPLITUDE,
+				DEFAULT_WAVEFORM_PERIOD);
+	}
+	pthread_mutex_lock(&adc_lock);
+	double value = waveform[waveform_pos];
+	if (0 != noise_rms) {
+		value += noise_rms * next_noise();
+	}
+	if (++waveform_pos >= waveform_len) {
+		waveform_pos = 0;
+	}
+	++conversion_count;
+	pthread_mutex_unlock(&adc_lock);
+	return (uint16_t)fmin(fmax(round(value), 0), SIM_ADC_MAX_VALUE);
+}
+/****************************************************************************************/
+
+static double next_noise(void)
+{
+	double uniform[2];
+	for (uint8_t i = 0; i < 2; ++i) {
+		noise_state ^= noise_state >> 12;
+		noise_state ^= noise_state << 25;
+		noise_state ^= noise_state >> 27;
+		/* 53 random bits, never 0 so the logarithm is finite */
+		uniform[i] = ((noise_state * 0x2545f4914f6cdd1dULL >> 11) + 1) / 9007199254740993.0;
+	}
+	return sqrt(-2 * log(uniform[0])) * cos(2 * M_PI * uniform[1]);
+}
+/****************************************************************************************/
+
+static void * timer_thread(void *arg)
+{
+	while (true) {
+		pthread_mutex_lock(&sim_timer.lock);
+		while (!(sim_timer.is_running && sim_timer.is_intr_enabled)) {
+			pthread_cond_wait(&sim_timer.cond, &sim_timer.lock);
+		}
+		uint64_t alarm_value = sim_timer.alarm_value;
+		double period_us = (double)alarm_value * sim_timer.divider * 1e6 / APB_CLK_FREQ;
+		pthread_mutex_unlock(&sim_timer.lock);
+
+		long long start = esp_timer_get_time();
+		uint64_t calls = 0;
+		bool is_running = true;
+		bool is_period_changed = false;
+		bool was_realtime = is_realtime;
+		while (is_running) {
+			uint64_t due = calls + TIMER_YIELD_INTERVAL;
+			if (is_realtime) {
+				/* the calls made at full speed are not caught up by the real time */
+				if (!was_realtime) {
+					start = esp_timer_get_time();
+					calls = 0;
+				}
+				due = (uint64_t)((esp_timer_get_time() - start) / period_us) + 1;
+			}
+			was_realtime = is_realtime;
+			while (is_running && (calls < due)) {
+				sim_timer.isr(sim_timer.isr_arg);
+				++calls;
+				pthread_mutex_lock(&sim_timer.lock);
+				is_running = sim_timer.is_running && sim_timer.is_intr_enabled;
+				/* the alarm changed by the interrupt restarts with the new period */
+				is_period_changed = (alarm_value != sim_timer.alarm_value);
+				pthread_mutex_unlock(&sim_timer.lock);
+				if (is_period_changed) {
+					break;
+				}
+			}
+			if (is_period_changed) {
+				break;
+			}
+			if (!is_running) {
+				break;
+			}
+			if (is_realtime) {
+				sleep_until(esp_timer_get_time() + TIMER_BATCH_PERIOD_US);
+			} else {
+				sched_yield();
+			}
+		}
+	}
+	return NULL;
+}
+/****************************************************************************************/
+
+static void sleep_until(long long time_us)
+{
+	long long delay = time_us - esp_timer_get_time();
+	if (delay > 0) {
+		struct timespec duration = {
+			.tv_sec = delay / 1000000,
+			.tv_nsec = (delay % 1000000) * 1000
+		};
+		nanosleep(&duration, NULL);
+	}
+}
+/****************************************************************************************/
+
+static uint8_t find_nvs_entry(nvs_handle handle, const char *key)
+{
+	uint8_t namespace_index = (uint8_t)handle;
+	for (uint8_t i = 0; i < sim_nvs.entry_count; ++i) {
+		if ((namespace_index == sim_nvs.entries[i].namespace_index) &&
+				(0 == strcmp(sim_nvs.entries[i].key, key))) {
+			return i;
+		}
+	}
+	return NVS_MAX_ENTRIES;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
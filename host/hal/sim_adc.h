@@ -0,0 +1,163 @@
+/** sim_adc.h **/
+
+#ifndef HOST_HAL_SIM_ADC_H_
+#define HOST_HAL_SIM_ADC_H_
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include <stdint.h>
+#include <stdbool.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#define SIM_ADC_MAX_VALUE		((uint16_t)0x0fff)
+/** longest pattern of the sizes of the I2S DMA reads **/
+#define SIM_ADC_MAX_READ_SIZES	((uint8_t)16)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+sim_adc_load_waveform
+******************************************************************************************
+Parameters:
+const char *path - text file with one adc value per line
+******************************************************************************************
+Abstract:
+This function loads the waveform converted by the simulated adc. Every conversion, by
+adc1_get_raw, the timer interrupt or the I2S DMA, returns the next value of the waveform
+and the waveform is repeated when its end is reached. It returns false if the file can
+not be read or holds no values.
+\****************************************************************************************/
+bool sim_adc_load_waveform(const char *path);
+
+/****************************************************************************************\
+Function:
+sim_adc_generate_sine
+******************************************************************************************
+Parameters:
+uint16_t offset - value of 0g acceleration
+uint16_t amplitude - amplitude of the sine in adc counts
+double period - period of the sine in conversions
+******************************************************************************************
+Abstract:
+This function fills the waveform with the sine, one whole number of periods long so it
+can be repeated without a phase jump.
+\****************************************************************************************/
+void sim_adc_generate_sine(uint16_t offset, uint16_t amplitude, double period);
+
+/****************************************************************************************\
+Function:
+sim_adc_generate_bearing_fault
+******************************************************************************************
+Parameters:
+uint16_t offset - value of 0g acceleration
+uint16_t amplitude - amplitude of the strongest impact in adc counts
+double resonance_period - period of the resonance excited by the impacts in conversions
+double fault_period - period of the impacts in conversions, 1/bpfo or 1/bpfi
+double modulation_period - period of the impact amplitude modulation in conversions, the
+	shaft rotation carrying the inner race defect through the load zone, 0 for none
+******************************************************************************************
+Abstract:
+This function fills the waveform with the signal of the rolling bearing defect. Every
+impact rings the resonance with the exponentially decaying sine, which is the high
+frequency burst repeating at the fault frequency. The outer race defect is stationary,
+so all the impacts are equal. The inner race one rotates with the shaft and its impacts
+are modulated, the envelope spectrum gets the sidebands at the shaft frequency. The
+waveform is a whole number of fault periods long, rounded to the conversion.
+\****************************************************************************************/
+void sim_adc_generate_bearing_fault(uint16_t offset, uint16_t amplitude,
+				double resonance_period, double fault_period, double modulation_period);
+
+/****************************************************************************************\
+Function:
+sim_adc_generate_spike
+******************************************************************************************
+Parameters:
+uint16_t offset - value of 0g acceleration
+uint16_t amplitude - height of the spike in adc counts
+uint32_t period - period of the spikes in conversions
+******************************************************************************************
+Abstract:
+This function fills the waveform with the constant offset and a single conversion of the
+spike in the middle of every period, the shortest event the adc can see.
+\****************************************************************************************/
+void sim_adc_generate_spike(uint16_t offset, uint16_t amplitude, uint32_t period);
+
+/****************************************************************************************\
+Function:
+sim_adc_set_noise
+******************************************************************************************
+Parameters:
+double rms - rms of the gaussian noise in adc counts, 0 for none
+******************************************************************************************
+Abstract:
+This function sets the noise added to every conversion of the waveform before it is
+rounded, as the noise of the analog front end. The generated waveforms keep their values
+unrounded for it, so the noise dithers the quantization. The noise sequence restarts
+with every call.
+\****************************************************************************************/
+void sim_adc_set_noise(double rms);
+
+/****************************************************************************************\
+Function:
+sim_adc_set_realtime
+******************************************************************************************
+Parameters:
+bool is_realtime - true to pace the conversions by the configured sampling frequency
+******************************************************************************************
+Abstract:
+This function selects if the timer interrupt and the I2S DMA deliver the conversions at
+the sampling frequency or as fast as the host can run them.
+\****************************************************************************************/
+void sim_adc_set_realtime(bool is_realtime);
+
+/****************************************************************************************\
+Function:
+sim_adc_get_conversion_count
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the number of conversions done since the start.
+\****************************************************************************************/
+uint64_t sim_adc_get_conversion_count(void);
+
+/****************************************************************************************\
+Function:
+sim_adc_set_dma_read_sizes
+******************************************************************************************
+Parameters:
+const uint32_t sizes[] - largest numbers of the conversions returned by the successive
+	reads, repeated in turn, NULL for the whole requested reads
+uint8_t count - number of the sizes, at most SIM_ADC_MAX_READ_SIZES
+******************************************************************************************
+Abstract:
+This function makes the I2S DMA reads return less than requested, as the driver does
+when its buffer is not yet filled. The odd sizes end the reads inside the swapped pair of
+the conversions, its other half is returned first by the next read.
+\****************************************************************************************/
+void sim_adc_set_dma_read_sizes(const uint32_t sizes[], uint8_t count);
+
+/****************************************************************************************\
+Function:
+sim_adc_get_dma_sample_rate
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns the sample rate the I2S DMA converts at.
+\****************************************************************************************/
+uint32_t sim_adc_get_dma_sample_rate(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+#endif /* HOST_HAL_SIM_ADC_H_ */
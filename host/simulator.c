@@ -0,0 +1,3221 @@
+/** simulator.c **/
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Includes																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_timer.h"
+#include "hal/sim_adc.h"
+#include "hal/fake_gatt.h"
+#include "../main/task_controller.h"
+#include "../components/ble_communication/result_frame.h"
+#include "../components/sample_codec/sample_codec.h"
+#include "../components/calculation/calculation.h"
+#include "../components/calculation/spectrum.h"
+#include "../components/calculation/envelope.h"
+#include "../components/measurement/decimator.h"
+#include "../components/measurement/sample_ring_buffer.h"
+#include "../components/measurement/measurement.h"
+#include "../components/ble_communication/ble_communication.h"
+#include "../components/threshold_exceeded_notification/threshold_exceeded_notification.h"
+#include "../components/threshold_exceeded_notification/rms_alarm.h"
+#include "nvs.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <malloc.h>
+#include <unistd.h>
+#include <sched.h>
+#include <math.h>
+#include <float.h>
+#include <limits.h>
+#include <getopt.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Macros																				//
+//////////////////////////////////////////////////////////////////////////////////////////
+/** attribute handles of the firmware, the same as used by the gui **/
+#define THRESHOLD_EXCEEDED_HANDLE		((uint16_t)0x2a)
+#define THRESHOLD_EXCEEDED_WRITE_VAL	(0x01)
+#define THRESHOLD_ALARM_WRITE_VAL		(0x02)
+#define RMS_VALUE_HANDLE				((uint16_t)0x58)
+#define AVERAGE_VALUE_HANDLE			((uint16_t)0x5a)
+#define MAX_VALUE_HANDLE				((uint16_t)0x5c)
+#define MIN_VALUE_HANDLE				((uint16_t)0x5e)
+#define AMPLITUDE_VALUE_HANDLE			((uint16_t)0x60)
+#define CREST_FACTOR_VALUE_HANDLE		((uint16_t)0x62)
+#define AC_RMS_VALUE_HANDLE				((uint16_t)0x64)
+#define PEAK_VALUE_HANDLE				((uint16_t)0x66)
+#define PEAK_TO_PEAK_VALUE_HANDLE		((uint16_t)0x68)
+#define AC_CREST_FACTOR_VALUE_HANDLE	((uint16_t)0x6a)
+#define VELOCITY_RMS_VALUE_HANDLE		((uint16_t)0x6c)
+#define DISPLACEMENT_PEAK_TO_PEAK_VALUE_HANDLE	((uint16_t)0x6e)
+#define SKEWNESS_VALUE_HANDLE			((uint16_t)0x70)
+#define KURTOSIS_VALUE_HANDLE			((uint16_t)0x72)
+#define TRIGGER_MEASUREMENT_HANDLE		((uint16_t)0x86)
+#define TIME_RESULTS_HANDLE				((uint16_t)0xb4)
+#define TIME_RESULTS_STREAM_HANDLE		((uint16_t)0xb7)
+#define TIME_RESULTS_STREAM_CCC_HANDLE	((uint16_t)0xb8)
+#define FFT_RESULTS_HANDLE				((uint16_t)0xe2)
+#define ENVELOPE_PEAKS_HANDLE			((uint16_t)0xe5)
+#define BAND_TABLE_HANDLE				((uint16_t)0xe8)
+#define BAND_RMS_HANDLE					((uint16_t)0xeb)
+#define SERVICES_NO						((uint8_t)5)
+
+#define MEASUREMENT_TRIGGER_WRITE_VAL			(0x01)
+#define MEASUREMENT_STREAM_TRIGGER_WRITE_VAL	(0x02)
+#define STREAM_ENCODING_RAW_WRITE_VAL			(0x00)
+#define STREAM_ENCODING_COMPRESSED_WRITE_VAL	(0x01)
+
+#define DEFAULT_FREQUENCY				((uint16_t)1000)
+#define DEFAULT_DURATION				(1.0f)
+#define DEFAULT_MTU						((uint16_t)247)
+#define DEFAULT_SIGNAL_FREQUENCY		(50.0)
+#define DEFAULT_SIGNAL_OFFSET			((uint16_t)2048)
+#define DEFAULT_SIGNAL_AMPLITUDE		((uint16_t)400)
+#define DEFAULT_LINK_WINDOW				((uint16_t)16)
+/** bearing fault, the impacts ring the resonance in the middle of the envelope band and
+ * the inner race defect is modulated by the shaft rotation **/
+#define DEFAULT_FAULT_FREQUENCY			(37.0)
+#define FAULT_RESONANCE_RELATIVE		(0.25)
+#define FAULT_SHAFT_FREQUENCY			(10.0)
+/** the fault is checked when the envelope spectrum of the measurement resolves the shaft
+ * sidebands of its frequency **/
+#define ENVELOPE_MIN_RESOLVED_BINS		(4)
+
+#define STARTUP_TIMEOUT_MS				((uint32_t)5000)
+/** time given to the calculation and the transfer on top of the measurement duration **/
+#define RESULT_TIMEOUT_MS				((uint32_t)10000)
+#define FRAME_TIMEOUT_MS				((uint32_t)2000)
+#define FLOAT_TOLERANCE					(1e-3)
+/** sensitivity the firmware is built with, CALCULATION_DEFAULT_SENSITIVITY **/
+#define SENSITIVITY						(0.0244140625)
+#define STANDARD_GRAVITY_MM_S2			(9806.65)
+/** severity band of the integration, the second order butterworth high pass after every
+ * integration and the low pass of the acceleration, used below 0.45 of the sampling **/
+#define INTEGRATION_LOW_FREQUENCY		(10.0)
+#define INTEGRATION_HIGH_FREQUENCY		(1000.0)
+#define INTEGRATION_MAX_RELATIVE_FREQUENCY	(0.45)
+/** the integrator deviates from 1/w by up to 2 % below 0.3 of the sampling frequency, the
+ * displacement is integrated twice and its sampled extremes miss the peaks of the sine by
+ * up to 1 - cos(pi*f/fs) **/
+#define INTEGRATION_TOLERANCE			(0.025)
+/** stream capture of the repeated sine has the same statistics as the buffered one **/
+#define STREAM_RMS_TOLERANCE			(0.02)
+/** capture streamed while the next trigger replaces it, the short link window keeps the
+ * stream running until the trigger is taken. The replacing measurement runs in real time,
+ * its indication is not dropped by the link full of the stream frames. **/
+#define STREAM_ABORT_CHECK_SAMPLES		((uint32_t)1000)
+#define STREAM_ABORT_CHECK_FREQUENCY	((uint16_t)1000)
+#define STREAM_ABORT_CHECK_WINDOW		((uint16_t)2)
+#define STREAM_ABORT_CHECK_DELAY_MS		((uint32_t)50)
+/** band rms of the signal band and the whole spectrum against the ac rms of the sine, the
+ * Hann window weights the cycles of the sine unevenly **/
+#define BAND_RMS_TOLERANCE				(0.02)
+/** band rms between the harmonics relative to the signal band **/
+#define BAND_RMS_LEAKAGE				(0.01)
+/** the signal band spans at least the main lobe of the Hann window, the sine is checked
+ * when the transform holds enough of its cycles **/
+#define BAND_SIGNAL_RELATIVE_WIDTH		(0.1)
+#define BAND_MIN_SIGNAL_BINS			(3)
+#define BAND_MIN_SIGNAL_CYCLES			(4)
+/** overlap of the Hann segments averaged for the band features without the psd **/
+#define BAND_SEGMENT_OVERLAP			((uint8_t)50)
+/** statistics of the calculation against the two pass reference in double, on the
+ * buffers of the sizes the former calculation tasks were measured with **/
+#define STATISTICS_CHECK_MAX_SIZE		((uint32_t)60000)
+#define STATISTICS_CHECK_SIGNALS		((uint8_t)4)
+#define STATISTICS_TOLERANCE			(2e-3)
+/** multi tone input of the amplitude spectrum, the bin centered tones near the full scale
+ * and below two adc counts and the tone between the bins which leaks the most. The bins
+ * are compared with the direct transform, the leakage bins also to the floor of the float
+ * transform relative to the largest tone **/
+#define SPECTRUM_CHECK_TONES			((uint8_t)3)
+#define SPECTRUM_CHECK_OFFSET			(2048.0)
+#define SPECTRUM_TONE_TOLERANCE			(1e-3)
+#define SPECTRUM_SMALL_TONE_TOLERANCE	(3e-2)
+#define SPECTRUM_FLOAT_FLOOR			(1e-6)
+/** bins on both sides of a tone counted as the tone **/
+#define SPECTRUM_TONE_BINS				((uint32_t)2)
+/** welch estimation of the white noise and the tone against the double precision one of
+ * the same segments, the input is fed in the blocks not aligned to them. The bins are
+ * compared above the floor of the float transform, the square of the amplitude one,
+ * relative to the largest bin. The variance of the noise and the power of the tone
+ * between the bins are integrated from the density **/
+#define WELCH_CHECK_SIZE				((uint32_t)8192)
+#define WELCH_CHECK_SEGMENT				((uint32_t)256)
+#define WELCH_CHECK_OVERLAP				((uint8_t)50)
+#define WELCH_CHECK_FREQUENCY			((uint16_t)1000)
+#define WELCH_CHECK_BLOCK_LEN			((uint32_t)100)
+#define WELCH_CHECK_NOISE				(1000.0)
+#define WELCH_CHECK_TONE_AMPLITUDE		(1500.0)
+#define WELCH_CHECK_TONE_FREQUENCY		(127.0)
+#define WELCH_TOLERANCE					(2e-3)
+#define WELCH_POWER_TOLERANCE			(5e-2)
+/** bins on both sides of the tone integrated for its power, the main lobe of the flat
+ * top window **/
+#define WELCH_TONE_BINS					((uint32_t)5)
+/** half width in Hz of the band around the tone starting after the first transform **/
+#define WELCH_BAND_HALF_WIDTH			(5.0f)
+/** the producer task pushes the samples through the small ring to the simulator, which
+ * takes them in the blocks, and retries the dropped ones **/
+#define RING_CHECK_SAMPLES				((uint32_t)1000000)
+#define RING_CHECK_CAPACITY				((uint32_t)1024)
+#define RING_CHECK_BLOCK_LEN			((uint32_t)256)
+#define RING_CHECK_BURST_OVERFLOW		((uint32_t)100)
+#define RING_CHECK_TIMEOUT_MS			((uint32_t)20000)
+/** the results are framed at every mtu, their counts end before, on and behind the
+ * capacity of the first frame and of FRAME_CHECK_FRAMES frames, so the no more frame is
+ * the full one, the single element one and the empty one of the empty result **/
+#define FRAME_CHECK_MIN_MTU				((uint16_t)23)
+#define FRAME_CHECK_MAX_MTU				((uint16_t)517)
+#define FRAME_CHECK_FRAMES				((uint32_t)3)
+#define FRAME_CHECK_MAX_COUNT			((uint32_t)8192)
+#define FRAME_CHECK_ZERO_VAL			((uint16_t)DEFAULT_SIGNAL_OFFSET)
+/** response of the decimator is measured by the sines converted at the frequencies
+ * relative to the output sampling frequency, the passband ones up to
+ * DECIMATOR_PASSBAND_RELATIVE and the stopband ones aliased into the passband **/
+#define DECIMATOR_CHECK_AMPLITUDE		(2000.0)
+#define DECIMATOR_CHECK_OUTPUTS			((uint32_t)1024)
+#define DECIMATOR_PASSBAND_STEP			(0.04)
+#define DECIMATOR_MAX_RIPPLE_DB			(0.02)
+#define DECIMATOR_MIN_REJECTION_DB		(60.0)
+/** the small sine in the gaussian noise of the adc is measured without and with the
+ * oversampling, the averaging of the independent noise of the conversions raises the snr
+ * by 10*log10(factor) **/
+#define OVERSAMPLING_CHECK_FACTOR		((uint8_t)16)
+#define OVERSAMPLING_CHECK_AMPLITUDE	((uint16_t)4)
+#define OVERSAMPLING_CHECK_NOISE_RMS	(2.0)
+#define OVERSAMPLING_CHECK_MIN_SAMPLES	((uint32_t)500)
+#define OVERSAMPLING_SNR_MARGIN_DB		(1.0)
+/** the single conversion spike over the constant offset is monitored with the thresholds
+ * above and below it, they keep the margin of the initial sine amplitude for the zero
+ * value measured on it. The monitoring is watched for the number of the spike periods **/
+#define THRESHOLD_CHECK_SPIKE			((uint16_t)1200)
+#define THRESHOLD_CHECK_LOW				((uint16_t)600)
+#define THRESHOLD_CHECK_HIGH			((uint16_t)1800)
+#define THRESHOLD_CHECK_PERIOD			((uint32_t)1000)
+#define THRESHOLD_CHECK_PERIODS			((uint32_t)3)
+/** time without the conversions after which the monitoring is taken as stopped **/
+#define THRESHOLD_CHECK_STALL_MS		((uint32_t)250)
+/** the alarm of the windowed rms is driven by the sines of the rms between and above its
+ * levels in adc counts and by the spikes, which must not raise it **/
+#define ALARM_CHECK_WINDOW_MS			((uint16_t)100)
+#define ALARM_CHECK_WARNING				((uint16_t)100)
+#define ALARM_CHECK_ALARM				((uint16_t)200)
+#define ALARM_CHECK_HYSTERESIS			((uint16_t)20)
+#define ALARM_CHECK_HOLD_OFF_MS			((uint16_t)20)
+#define ALARM_CHECK_INTERVAL_MS			((uint16_t)300)
+#define ALARM_CHECK_SIGNAL_PERIOD		(100.0)
+#define ALARM_CHECK_WINDOWS				((uint32_t)5)
+/** bursts of the sine half as long as the alarm window, one per second of the measurement
+ * converting at the tenth of the monitoring frequency. The window keeping its time holds
+ * the whole burst and leaves the normal level, the window counted in the conversions of
+ * the measurement would hold the twentieth of it and stay below the warning **/
+#define ALARM_BURST_FREQUENCY			((uint16_t)1000)
+#define ALARM_BURST_PERIOD				((uint32_t)1000)
+#define ALARM_BURST_LEN					((uint32_t)50)
+#define ALARM_BURST_AMPLITUDE			((uint16_t)500)
+#define ALARM_BURST_SIGNAL_PERIOD		(10.0)
+#define ALARM_BURST_DURATION			(2.0f)
+#define ALARM_BURST_READ_SIZE			((uint32_t)10)
+/** recorded shock replayed through the adc, the ringing of the structure decaying after
+ * the impact in the middle of the recording, which starts at the spike over the offset **/
+#define CAPTURE_CHECK_LEN				((uint32_t)8192)
+#define CAPTURE_CHECK_RING_PERIOD		(20.0)
+#define CAPTURE_CHECK_DECAY				(150.0)
+/** hand off of the I2S DMA blocks, the ramp of the conversions is read by the sizes ending
+ * inside the swapped pairs and short of the block and the odd number of the samples ends
+ * the measurement inside the block. The monitoring runs at its own rate around the
+ * measurements, the channel is the one of main.c **/
+#define DMA_CHECK_CHANNEL				(ADC1_CHANNEL_7)
+#define DMA_CHECK_RAMP_LEN				((uint32_t)4096)
+#define DMA_CHECK_FREQUENCY				((uint16_t)1024)
+#define DMA_CHECK_SAMPLES				((uint32_t)1025)
+#define DMA_CHECK_MONITORING_FREQUENCY	((uint16_t)2000)
+#define DMA_CHECK_STREAM_BLOCK_LEN		((uint32_t)100)
+#define DMA_CHECK_TIMEOUT_MS			((uint32_t)10000)
+/** soak of the measurement cycles of the sizes which would fragment the heap, every
+ * SOAK_CAPTURE_INTERVAL-th one is the event capture of the spike **/
+#define SOAK_CAPTURE_INTERVAL			((uint32_t)4)
+#define SOAK_WARM_UP_CYCLES				((uint32_t)SOAK_CAPTURE_INTERVAL)
+#define SOAK_PROGRESS_CYCLES			((uint32_t)10000)
+/** frequency whose conversions, decimated and oversampled by the maximal factors, exceed
+ * the maximum of both backends **/
+#define UNSUPPORTED_CHECK_FREQUENCY		((uint16_t)10000)
+/** overlap of the welch segments of the stream measurement in percents **/
+#define STREAM_SEGMENT_OVERLAP			((uint8_t)50)
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Local typedefs																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** enum determining the generated bearing defect **/
+typedef enum {
+	FAULT_NONE = 0,
+	FAULT_OUTER_RACE,
+	FAULT_INNER_RACE
+} bearing_fault;
+
+typedef struct {
+	uint16_t frequency;
+	float duration;
+	uint16_t mtu;
+	uint16_t link_window;
+	double signal_frequency;
+	bearing_fault fault;
+	double fault_frequency;
+	const char *waveform_path;
+	bool is_realtime;
+	uint8_t decimation;
+	uint8_t oversampling;
+	uint32_t soak_cycles;
+	uint32_t latency_cycles;
+} simulation_config;
+
+typedef struct {
+	float rms;
+	float average;
+	uint16_t max_val;
+	uint16_t min_val;
+	uint16_t amplitude;
+	float crest_factor;
+	float ac_rms;
+	float peak;
+	float peak_to_peak;
+	float ac_crest_factor;
+	float velocity_rms;
+	float displacement_peak_to_peak;
+	float skewness;
+	float kurtosis;
+} calculated_values;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static variables																		//
+//////////////////////////////////////////////////////////////////////////////////////////
+static uint32_t failures = 0;
+
+/** error of the last measurement indicated as failed, 0 for none **/
+static uint8_t measurement_error = 0;
+
+/** ring of the producer and consumer check and the pushes the producer retried, they are
+ * read after the producer released is_ring_produced **/
+static sample_ring_buffer check_ring;
+static uint32_t ring_retries = 0;
+static bool is_ring_produced = false;
+
+/** sizes of the I2S DMA reads of the hand off check **/
+static const uint32_t dma_check_read_sizes[] = {1, 3, 510, 7, 512, 2, 255, 64};
+/** samples the stream task of the hand off check took from the ring, read after it
+ * released is_dma_streamed **/
+static uint16_t dma_streamed[DMA_CHECK_SAMPLES + DMA_CHECK_STREAM_BLOCK_LEN];
+static uint32_t dma_streamed_count = 0;
+static bool is_dma_streamed = false;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/** entry point of the firmware, defined in main/main.c **/
+void app_main(void);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions prototypes															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+/****************************************************************************************\
+Function:
+parse_arguments
+******************************************************************************************
+Parameters:
+int argc, char *argv[] - command line
+simulation_config *config - destination of the options
+******************************************************************************************
+Abstract:
+This function reads the command line options. It returns false on the invalid one.
+\****************************************************************************************/
+static bool parse_arguments(int argc, char *argv[], simulation_config *config);
+
+/****************************************************************************************\
+Function:
+firmware_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This task runs app_main, as the main task of the target does.
+\****************************************************************************************/
+static void firmware_task(void *pvParameter);
+
+/****************************************************************************************\
+Function:
+trigger_measurement
+******************************************************************************************
+Parameters:
+uint8_t command - buffered or stream measurement command
+const simulation_config *config - frequency and duration of the measurement
+uint16_t segment_size - welch segment of the Hann windowed spectrum, 0 for none
+uint16_t *zero_val - zero value sent with the finished indication
+******************************************************************************************
+Abstract:
+This function writes the trigger characteristic and waits for the indication of the
+finished calculation. It returns the latency in microseconds or a negative value on the
+timeout and the failed measurement, whose error is kept in measurement_error.
+\****************************************************************************************/
+static long long trigger_measurement(uint8_t command, const simulation_config *config,
+				uint16_t segment_size, uint16_t *zero_val);
+
+/****************************************************************************************\
+Function:
+write_trigger
+******************************************************************************************
+Parameters:
+uint8_t command - buffered or stream measurement command
+const simulation_config *config - frequency and duration of the measurement
+uint16_t segment_size - welch segment of the Hann windowed spectrum, 0 for none
+******************************************************************************************
+Abstract:
+This function writes the trigger characteristic without waiting for the measurement.
+\****************************************************************************************/
+static void write_trigger(uint8_t command, const simulation_config *config,
+				uint16_t segment_size);
+
+/****************************************************************************************\
+Function:
+decimator_gain
+******************************************************************************************
+Parameters:
+decimator *filter - initialized decimator
+double relative_frequency - frequency of the converted sine relative to the output
+	sampling frequency
+******************************************************************************************
+Abstract:
+This function passes the sine of DECIMATOR_CHECK_AMPLITUDE through the decimator and
+returns the amplitude of the decimated samples at the frequency the sine is aliased to,
+relative to the converted one. The amplitude is taken by the Hann windowed projection of
+DECIMATOR_CHECK_OUTPUTS samples with the mean removed.
+\****************************************************************************************/
+static double decimator_gain(decimator *filter, double relative_frequency);
+
+/****************************************************************************************\
+Function:
+check_decimator_response
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function checks the passband ripple and the rejection of the aliases falling into
+the passband for every decimation factor.
+\****************************************************************************************/
+static void check_decimator_response(void);
+
+/****************************************************************************************\
+Function:
+ring_check_sample
+******************************************************************************************
+Parameters:
+uint32_t index - index of the sample in the sequence
+******************************************************************************************
+Abstract:
+This function returns the sample of the sequence pushed through the ring, it changes
+with every index, so a lost or reordered sample is found.
+\****************************************************************************************/
+static uint16_t ring_check_sample(uint32_t index);
+
+/****************************************************************************************\
+Function:
+ring_producer_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This task pushes RING_CHECK_SAMPLES samples of the sequence into the ring, the sample
+dropped by the full ring is counted and pushed again after the yield, the finished task
+is suspended.
+\****************************************************************************************/
+static void ring_producer_task(void *pvParameter);
+
+/****************************************************************************************\
+Function:
+check_ring_buffer
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function takes the samples of the producer task in blocks and checks they come in
+order, none is lost, their sums are the pushed ones and the overflow counter equals the
+dropped pushes. The burst over the capacity without the consumer must then drop the
+samples behind the capacity and count them.
+\****************************************************************************************/
+static void check_ring_buffer(void);
+
+/****************************************************************************************\
+Function:
+round_trip_result_frames
+******************************************************************************************
+Parameters:
+uint16_t mtu - mtu the frames are limited by
+uint8_t element_size - size of one element in bytes, 1 or 2
+bool is_compressed - true for the frames compressed by the sample codec
+const void *data - elements of the result
+uint32_t total_count - number of elements of the result, up to FRAME_CHECK_MAX_COUNT
+uint32_t *frames - number of the encoded frames
+******************************************************************************************
+Abstract:
+This function encodes the result frame by frame, decodes every frame and checks it fits
+the mtu, its header continues the previous one and only the last frame is marked no
+more. It returns true if all the frames are valid and the decoded elements equal the
+encoded ones.
+\****************************************************************************************/
+static bool round_trip_result_frames(uint16_t mtu, uint8_t element_size, bool is_compressed,
+				const void *data, uint32_t total_count, uint32_t *frames);
+
+/****************************************************************************************\
+Function:
+check_result_frames
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function round trips the uint16 samples, the uint8 elements and the compressed
+samples through the result frames at every mtu from FRAME_CHECK_MIN_MTU to
+FRAME_CHECK_MAX_MTU. The raw results must also take the least number of frames.
+\****************************************************************************************/
+static void check_result_frames(void);
+
+/****************************************************************************************\
+Function:
+generate_statistics_signal
+******************************************************************************************
+Parameters:
+uint8_t signal - index of the signal, below STATISTICS_CHECK_SIGNALS
+uint16_t data[] - destination of the samples
+uint32_t size - number of samples
+******************************************************************************************
+Abstract:
+This function fills the buffer with the seeded signal and returns its name: the noisy
+sine around the zero value, the full scale noise which stresses the width of the sums,
+the quiet noise of one count on the dc bias which stresses the cancellation of the
+variance, and the constant full scale whose variance is 0.
+\****************************************************************************************/
+static const char * generate_statistics_signal(uint8_t signal, uint16_t data[],
+				uint32_t size);
+
+/****************************************************************************************\
+Function:
+check_statistics
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function passes the signals of 1000, 10000 and 60000 samples to the calculation task
+and checks every factor against the reference computed in double by two passes about the
+mean. It runs before the first measurement, while the controller keeps no object.
+\****************************************************************************************/
+static void check_statistics(void);
+
+/****************************************************************************************\
+Function:
+check_spectrum_accuracy
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function calculates the amplitude spectrum of the multi tone input with the spectrum
+module, decodes the dB codes and compares every bin with the direct transform of
+power_spectrum. The tones are checked against their generated amplitudes and the bins
+away from them, the leakage of the Hann window, against the reference bins. It runs
+before the firmware starts, which uses the same module.
+\****************************************************************************************/
+static void check_spectrum_accuracy(void);
+
+/****************************************************************************************\
+Function:
+welch_reference
+******************************************************************************************
+Parameters:
+const uint16_t data[] - samples
+uint32_t size - number of samples
+spectrum_window window - window of the segments
+double psd[] - destination of WELCH_CHECK_SEGMENT/2 + 1 bins
+******************************************************************************************
+Abstract:
+This function estimates the one sided power spectral density in adc counts^2/Hz as the
+module does, in double precision with the direct transform. The segments of the size
+WELCH_CHECK_SEGMENT overlapping by WELCH_CHECK_OVERLAP percents are detrended, windowed
+and their power averaged. It returns the number of the segments.
+\****************************************************************************************/
+static uint32_t welch_reference(const uint16_t data[], uint32_t size, spectrum_window window,
+				double psd[]);
+
+/****************************************************************************************\
+Function:
+check_welch_accuracy
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function estimates the density of the white noise with the Hann window and of the
+tone with the flat top window by the spectrum module and compares the decoded bins with
+welch_reference. The variance of the noise and the power of the tone are integrated from
+the density. The band power of the tone starting after the first transform is averaged
+over the segments of the whole capture, the amplitude spectrum of the first transform is
+kept. It runs before the firmware starts.
+\****************************************************************************************/
+static void check_welch_accuracy(void);
+
+/****************************************************************************************\
+Function:
+sample_scale
+******************************************************************************************
+Parameters:
+uint8_t oversampling - oversampling factor, 0 or 1 for none
+******************************************************************************************
+Abstract:
+This function returns the sample counts per adc count of the oversampled samples, the
+sums of the conversions reduced to MEASUREMENT_MAX_SAMPLE_BITS.
+\****************************************************************************************/
+static uint16_t sample_scale(uint8_t oversampling);
+
+/****************************************************************************************\
+Function:
+measure_snr
+******************************************************************************************
+Parameters:
+const simulation_config *config - frequency, duration and oversampling of the measurement
+uint16_t samples[] - destination of the served samples
+double *mean - mean of the served samples
+******************************************************************************************
+Abstract:
+This function generates the sine of OVERSAMPLING_CHECK_AMPLITUDE at the conversion
+frequency with the noise of OVERSAMPLING_CHECK_NOISE_RMS, takes the buffered measurement
+and returns the snr of the served samples in dB. The sine is fitted by the least squares
+at its frequency, the rest is the noise. It returns NAN if the samples were not served.
+\****************************************************************************************/
+static double measure_snr(const simulation_config *config, uint16_t samples[], double *mean);
+
+/****************************************************************************************\
+Function:
+check_stream_replaced
+******************************************************************************************
+Parameters:
+const simulation_config *config - link window and real time restored at the end
+******************************************************************************************
+Abstract:
+This function streams the capture and writes the next trigger after its first frame. The
+stream must end with the empty aborted frame at the offset of the received samples
+instead of sending the samples of the new capture.
+\****************************************************************************************/
+static void check_stream_replaced(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+check_oversampling_snr
+******************************************************************************************
+Parameters:
+const simulation_config *config - frequency, duration and oversampling of the measurement,
+	OVERSAMPLING_CHECK_FACTOR is taken if no oversampling was set
+uint16_t samples[] - buffer of the served samples
+******************************************************************************************
+Abstract:
+This function checks the gain of the snr of the noisy sine by the oversampling and the
+width of the oversampled samples. It replaces the converted waveform.
+\****************************************************************************************/
+static void check_oversampling_snr(const simulation_config *config, uint16_t samples[]);
+
+/****************************************************************************************\
+Function:
+set_threshold
+******************************************************************************************
+Parameters:
+uint16_t threshold - threshold of the monitoring in adc counts, 0 to stop it
+******************************************************************************************
+Abstract:
+This function writes the threshold to the threshold exceeded characteristic.
+\****************************************************************************************/
+static void set_threshold(uint16_t threshold);
+
+/****************************************************************************************\
+Function:
+set_alarm
+******************************************************************************************
+Parameters:
+uint16_t warning - ac rms of the warning level in adc counts
+uint16_t alarm - ac rms of the alarm level in adc counts
+******************************************************************************************
+Abstract:
+This function writes the version 2 alarm configuration with the levels and the
+ALARM_CHECK window, hysteresis, hold off and interval to the threshold characteristic.
+\****************************************************************************************/
+static void set_alarm(uint16_t warning, uint16_t alarm);
+
+/****************************************************************************************\
+Function:
+watch_threshold
+******************************************************************************************
+Parameters:
+uint32_t conversions - number of the conversions to watch
+uint8_t data[] - value of the indication
+uint16_t *len - length of the indication
+******************************************************************************************
+Abstract:
+This function waits until the conversions are taken, until they stop or until the
+indication of the threshold characteristic comes. It returns true and stores the value
+if it came.
+\****************************************************************************************/
+static bool watch_threshold(uint32_t conversions, uint8_t data[], uint16_t *len);
+
+/****************************************************************************************\
+Function:
+wait_alarm
+******************************************************************************************
+Parameters:
+rms_alarm_level *level - level of the indication
+uint16_t *rms - rms of the indication in adc counts
+******************************************************************************************
+Abstract:
+This function waits for the alarm indication up to RESULT_TIMEOUT_MS. It returns false
+if none came.
+\****************************************************************************************/
+static bool wait_alarm(rms_alarm_level *level, uint16_t *rms);
+
+/****************************************************************************************\
+Function:
+wait_event
+******************************************************************************************
+Parameters:
+uint16_t *exceeded_value - destination of the conversion indicated by the threshold
+uint16_t *zero_val - zero value sent with the finished calculation of the event capture
+******************************************************************************************
+Abstract:
+This function waits for the threshold indication and for the calculation of the event
+capture which follows it, in any order. It returns false if either did not come.
+\****************************************************************************************/
+static bool wait_event(uint16_t *exceeded_value, uint16_t *zero_val);
+
+/****************************************************************************************\
+Function:
+check_rms_alarm
+******************************************************************************************
+Parameters:
+const simulation_config *config - measurement taken while the alarm runs
+******************************************************************************************
+Abstract:
+This function checks the alarm of the windowed rms. The spikes must not raise it, the
+sines must enter the levels and leave them with the hysteresis and the indications must
+keep the minimal interval. It replaces the converted waveform.
+\****************************************************************************************/
+static void check_rms_alarm(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+check_alarm_during_measurement
+******************************************************************************************
+Parameters:
+const simulation_config *config - configuration of the run
+******************************************************************************************
+Abstract:
+This function checks that the alarm window keeps its time while the measurement
+converts slower than the monitoring frequency. The bursts of the sine shorter than the
+window, seen between the measurements as too short, must leave the normal level during
+the measurement at ALARM_BURST_FREQUENCY. It replaces the converted waveform.
+\****************************************************************************************/
+static void check_alarm_during_measurement(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+check_threshold_monitoring
+******************************************************************************************
+Parameters:
+const simulation_config *config - measurement taken while the monitoring runs
+******************************************************************************************
+Abstract:
+This function checks the monitoring of the single conversion spike by the sampler, the
+threshold above it must stay quiet through the measurement and the conversions after it
+and the threshold below it must indicate the spike. It replaces the converted waveform.
+\****************************************************************************************/
+static void check_threshold_monitoring(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+check_event_capture
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function replays the recorded shock with the threshold below its first conversion.
+The capture served by the time results must hold the recording around that conversion,
+MEASUREMENT_CAPTURE_PRE_LEN conversions before it and MEASUREMENT_CAPTURE_POST_LEN from
+it on, and the calculated values must be the ones of the capture. It replaces the
+converted waveform.
+\****************************************************************************************/
+static void check_event_capture(void);
+
+/****************************************************************************************\
+Function:
+dma_check_monitor
+******************************************************************************************
+Parameters:
+uint16_t conversion - raw adc conversion
+uint32_t periods - number of the monitoring periods the conversion stands for
+******************************************************************************************
+Abstract:
+This is the monitor keeping the monitoring of the hand off check running, it never
+notifies.
+\****************************************************************************************/
+static bool dma_check_monitor(uint16_t conversion, uint32_t periods);
+
+/****************************************************************************************\
+Function:
+dma_stream_task
+******************************************************************************************
+Parameters:
+void *pvParameter - standard parameter for freertos task
+******************************************************************************************
+Abstract:
+This task starts the stream measurement of DMA_CHECK_SAMPLES samples and takes them from
+the ring in blocks until the measurement is finished and the ring is empty, the finished
+task is suspended.
+\****************************************************************************************/
+static void dma_stream_task(void *pvParameter);
+
+/****************************************************************************************\
+Function:
+is_ramp
+******************************************************************************************
+Parameters:
+const uint16_t samples[] - samples of the converted ramp
+uint32_t count - number of the samples
+******************************************************************************************
+Abstract:
+This function returns true if every sample follows the previous one on the ramp of
+DMA_CHECK_RAMP_LEN conversions, so none was lost, repeated or reordered.
+\****************************************************************************************/
+static bool is_ramp(const uint16_t samples[], uint32_t count);
+
+/****************************************************************************************\
+Function:
+wait_conversions_stalled
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function waits until no conversion is taken for THRESHOLD_CHECK_STALL_MS.
+\****************************************************************************************/
+static void wait_conversions_stalled(void);
+
+/****************************************************************************************\
+Function:
+check_dma_hand_off
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function runs the I2S DMA backend in any build. The ramp is read by the partial and
+odd sized reads, the buffered and the streamed measurement must get exactly their
+samples in order and the DMA must return to the monitoring rate after the measurement.
+The backend of the build is initialized again at the end. It replaces the converted
+waveform.
+\****************************************************************************************/
+static void check_dma_hand_off(void);
+
+/****************************************************************************************\
+Function:
+check_soak
+******************************************************************************************
+Parameters:
+const simulation_config *config - frequency of the measurements and number of the cycles
+******************************************************************************************
+Abstract:
+This function runs the measurement cycles of the changing sizes and the event captures
+of the spike between them. Every cycle must be indicated and neither the heap nor its
+part in use may grow after the warm up cycles, as the buffers and the objects of the
+calculation are carved from the memory reserved at boot. It replaces the converted
+waveform.
+\****************************************************************************************/
+static void check_soak(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+report_latency
+******************************************************************************************
+Parameters:
+const simulation_config *config - frequency and duration of the measurements and their
+	number
+******************************************************************************************
+Abstract:
+This function repeats the buffered measurement and reports the shortest, the mean and
+the longest trigger to indication latency of the main loop of the build, woken by the
+events or polling them every CONTROLLER_POLL_PERIOD_MS. Every measurement must be
+indicated.
+\****************************************************************************************/
+static void report_latency(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+read_calculated_values
+******************************************************************************************
+Parameters:
+calculated_values *values - destination of the values
+******************************************************************************************
+Abstract:
+This function reads all the calculated values characteristics.
+\****************************************************************************************/
+static bool read_calculated_values(calculated_values *values);
+
+/****************************************************************************************\
+Function:
+read_envelope_peaks
+******************************************************************************************
+Parameters:
+envelope_peak peaks[] - destination of the BLE_ENVELOPE_PEAK_COUNT peaks
+******************************************************************************************
+Abstract:
+This function reads the envelope peaks characteristic and converts the peaks to Hz and g.
+\****************************************************************************************/
+static bool read_envelope_peaks(envelope_peak peaks[]);
+
+/****************************************************************************************\
+Function:
+write_band_table
+******************************************************************************************
+Parameters:
+const uint16_t edges[] - low and high edge of every band in Hz
+uint8_t count - number of the bands
+******************************************************************************************
+Abstract:
+This function writes the band table characteristic by the write request and returns the
+status of the response.
+\****************************************************************************************/
+static esp_gatt_status_t write_band_table(const uint16_t edges[], uint8_t count);
+
+/****************************************************************************************\
+Function:
+read_band_table
+******************************************************************************************
+Parameters:
+uint16_t edges[] - destination of the low and high edge of BLE_BAND_MAX bands
+******************************************************************************************
+Abstract:
+This function reads the band table characteristic and returns the number of the bands,
+0 if the read fails.
+\****************************************************************************************/
+static uint8_t read_band_table(uint16_t edges[]);
+
+/****************************************************************************************\
+Function:
+read_band_rms
+******************************************************************************************
+Parameters:
+double rms[] - destination of the rms of BLE_BAND_MAX bands in g
+******************************************************************************************
+Abstract:
+This function reads the band rms characteristic and returns the number of the bands, 0
+if the read fails or no band was calculated.
+\****************************************************************************************/
+static uint8_t read_band_rms(double rms[]);
+
+/****************************************************************************************\
+Function:
+power_spectrum
+******************************************************************************************
+Parameters:
+const uint16_t samples[] - samples of the capture
+uint32_t count - number of the samples
+double power[] - destination of SPECTRUM_MAX_BINS bins
+******************************************************************************************
+Abstract:
+This function calculates the reference of the band features in double by the direct
+transform of the segments of the largest power of two number of samples not exceeding
+count and SPECTRUM_MAX_FFT_SIZE, overlapping by BAND_SEGMENT_OVERLAP percents over the
+whole capture, with the mean of every segment removed and the Hann window applied as the
+firmware does. Every bin holds its share of the mean square in ADC counts averaged over
+the segments, the one sided bins count twice. It returns the transform size, 0 for less
+than 4 samples.
+\****************************************************************************************/
+static uint32_t power_spectrum(const uint16_t samples[], uint32_t count, double power[]);
+
+/****************************************************************************************\
+Function:
+band_rms
+******************************************************************************************
+Parameters:
+const double power[] - bins of power_spectrum
+uint32_t fft_size - transform size returned by power_spectrum
+uint16_t frequency - sampling frequency
+uint16_t low, high - edges of the band in Hz, the high one excluded
+double sensitivity - g per sample count
+******************************************************************************************
+Abstract:
+This function returns the rms of the band in g.
+\****************************************************************************************/
+static double band_rms(const double power[], uint32_t fft_size, uint16_t frequency,
+				uint16_t low, uint16_t high, double sensitivity);
+
+/****************************************************************************************\
+Function:
+envelope_resolution
+******************************************************************************************
+Parameters:
+const simulation_config *config - frequency and duration of the measurement
+******************************************************************************************
+Abstract:
+This function returns the bin width of the envelope spectrum of the measurement, the
+segment of the decimated envelope or its largest power of two part for the short one.
+\****************************************************************************************/
+static double envelope_resolution(const simulation_config *config);
+
+/****************************************************************************************\
+Function:
+has_peak_at
+******************************************************************************************
+Parameters:
+const envelope_peak peaks[] - peaks of the envelope spectrum
+uint8_t count - number of the searched peaks
+double frequency - expected frequency
+double tolerance - allowed deviation in Hz
+******************************************************************************************
+Abstract:
+This function returns true if one of the first count peaks lies at the frequency.
+\****************************************************************************************/
+static bool has_peak_at(const envelope_peak peaks[], uint8_t count, double frequency,
+				double tolerance);
+
+/****************************************************************************************\
+Function:
+read_frames
+******************************************************************************************
+Parameters:
+uint16_t handle - handle of the read characteristic
+uint8_t element_size - size of the element in bytes
+void *result - destination of the elements
+uint32_t max_count - capacity of the destination in elements
+uint32_t *reads - number of the read requests
+******************************************************************************************
+Abstract:
+This function reads the result frames until the last one and returns the number of the
+received elements.
+\****************************************************************************************/
+static uint32_t read_frames(uint16_t handle, uint8_t element_size, void *result,
+				uint32_t max_count, uint32_t *reads);
+
+/****************************************************************************************\
+Function:
+receive_stream
+******************************************************************************************
+Parameters:
+uint16_t samples[] - destination of the samples
+uint32_t max_count - capacity of the destination
+bool is_compressed - true for the compressed encoding of the stream
+uint32_t *payload_bytes - number of the received bytes of the frames
+uint32_t *frames - number of the received notifications
+******************************************************************************************
+Abstract:
+This function subscribes the time results stream in the encoding, decodes the notified
+frames until the last one and unsubscribes. It returns the number of the received
+samples.
+\****************************************************************************************/
+static uint32_t receive_stream(uint16_t samples[], uint32_t max_count, bool is_compressed,
+				uint32_t *payload_bytes, uint32_t *frames);
+
+/****************************************************************************************\
+Function:
+check
+******************************************************************************************
+Parameters:
+bool condition - result of the check
+const char *description - what was checked
+******************************************************************************************
+Abstract:
+This function reports the check and counts the failures.
+\****************************************************************************************/
+static void check(bool condition, const char *description);
+
+/****************************************************************************************\
+Function:
+is_close
+******************************************************************************************
+Parameters:
+double value - checked value
+double expected - expected value
+double tolerance - relative tolerance
+******************************************************************************************
+Abstract:
+This function compares the values with the relative tolerance.
+\****************************************************************************************/
+static bool is_close(double value, double expected, double tolerance);
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Global functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char *argv[])
+{
+	simulation_config config = {
+		.frequency = DEFAULT_FREQUENCY,
+		.duration = DEFAULT_DURATION,
+		.mtu = DEFAULT_MTU,
+		.link_window = DEFAULT_LINK_WINDOW,
+		.signal_frequency = DEFAULT_SIGNAL_FREQUENCY,
+		.fault = FAULT_NONE,
+		.fault_frequency = DEFAULT_FAULT_FREQUENCY,
+		.waveform_path = NULL,
+		.is_realtime = true,
+		.decimation = 0,
+		.oversampling = 0,
+		.soak_cycles = 0,
+		.latency_cycles = 0,
+	};
+	if (!parse_arguments(argc, argv, &config)) {
+		fprintf(stderr, "usage: %s [--waveform FILE] [--frequency HZ] [--duration S] "
+				"[--signal HZ] [--fault bpfo|bpfi] [--fault-frequency HZ] [--mtu BYTES] "
+				"[--link-window FRAMES] [--decimation FACTOR] [--oversampling FACTOR] "
+				"[--soak CYCLES] [--latency CYCLES] [--fast]\n",
+				argv[0]);
+		return 2;
+	}
+	check_decimator_response();
+	check_ring_buffer();
+	check_result_frames();
+	check_spectrum_accuracy();
+	check_welch_accuracy();
+
+	/** the checks of the sine apply to the generated sine only, the signals are generated
+	 * at the conversion frequency, the decimation and the oversampling times the sampling
+	 * one. The oversampled samples are wider than the adc counts **/
+	bool is_generated = (NULL == config.waveform_path) && (FAULT_NONE == config.fault);
+	double conversion_frequency = (double)config.frequency *
+			((config.decimation > 1) ? config.decimation : 1) *
+			((config.oversampling > 1) ? config.oversampling : 1);
+	double sensitivity = SENSITIVITY / sample_scale(config.oversampling);
+	if (FAULT_NONE != config.fault) {
+		sim_adc_generate_bearing_fault(DEFAULT_SIGNAL_OFFSET, DEFAULT_SIGNAL_AMPLITUDE,
+				conversion_frequency / (FAULT_RESONANCE_RELATIVE * config.frequency),
+				conversion_frequency / config.fault_frequency,
+				(FAULT_INNER_RACE == config.fault) ?
+						conversion_frequency / FAULT_SHAFT_FREQUENCY : 0);
+	} else if (is_generated) {
+		sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET, DEFAULT_SIGNAL_AMPLITUDE,
+				conversion_frequency / config.signal_frequency);
+	} else if (!sim_adc_load_waveform(config.waveform_path)) {
+		fprintf(stderr, "waveform %s can not be read\n", config.waveform_path);
+		return 2;
+	}
+	sim_adc_set_realtime(config.is_realtime);
+	fake_gatt_set_link_window(config.link_window);
+
+	/** firmware start and connection **/
+	xTaskCreate(&firmware_task, "main", 4096, NULL, 1, NULL);
+	if (!fake_gatt_wait_services(SERVICES_NO, STARTUP_TIMEOUT_MS)) {
+		fprintf(stderr, "services were not started\n");
+		return 1;
+	}
+	/** the services start within the initialization, the calculation is initialized when
+	 * the tasks created after it exist **/
+	for (uint32_t t = 0; (t < STARTUP_TIMEOUT_MS) &&
+			(NULL == get_task_handle(BLE_STREAM_TASK_HANDLE)); ++t) {
+		usleep(1000);
+	}
+	fake_gatt_connect(config.mtu);
+	check_statistics();
+	printf("frequency %u Hz, duration %.3f s, mtu %u, %s, %s pacing\n", config.frequency,
+			config.duration, fake_gatt_get_mtu(),
+			(FAULT_OUTER_RACE == config.fault) ? "outer race fault" :
+			(FAULT_INNER_RACE == config.fault) ? "inner race fault" :
+			is_generated ? "generated sine" : config.waveform_path,
+			config.is_realtime ? "real time" : "no");
+	if ((config.decimation > 1) || (config.oversampling > 1)) {
+		printf("decimation by %u, oversampling by %u, conversions at %.0f Hz\n",
+				(config.decimation > 1) ? config.decimation : 1,
+				(config.oversampling > 1) ? config.oversampling : 1, conversion_frequency);
+	}
+
+	/** the buffered measurement is limited to the arena, the longer one is refused at the
+	 * write (checked below) and the measurements here are shortened to fit it **/
+	if ((uint32_t)(config.frequency * config.duration) > MEASUREMENT_MAX_SAMPLES) {
+		config.duration = (float)MEASUREMENT_MAX_SAMPLES / config.frequency;
+		printf("duration limited to %.3f s, %u buffered samples at most\n", config.duration,
+				MEASUREMENT_MAX_SAMPLES);
+	}
+
+	/** the latency mode measures the main loop only **/
+	if (0 != config.latency_cycles) {
+		report_latency(&config);
+		fake_gatt_disconnect();
+		printf("%s, %u failed checks\n", (0 == failures) ? "PASS" : "FAIL", failures);
+		return (0 == failures) ? 0 : 1;
+	}
+
+	uint32_t expected_count = (uint32_t)(config.frequency * config.duration);
+	uint16_t *polled = calloc(expected_count + 1, sizeof(uint16_t));
+	uint16_t *streamed = calloc(expected_count + 1, sizeof(uint16_t));
+	if ((NULL == polled) || (NULL == streamed)) {
+		fprintf(stderr, "no memory for %u samples\n", expected_count);
+		return 1;
+	}
+
+	/** band table, the default one is replaced by the signal band, the whole spectrum and
+	 * the band between the second and the third harmonic, the invalid ones are refused **/
+	uint16_t edges[2 * BLE_BAND_MAX];
+	uint8_t band_count = read_band_table(edges);
+	check((0 != band_count) && (45 == edges[0]) && (55 == edges[1]), "default band table read");
+	const uint16_t inverted_edges[] = {100, 50};
+	uint8_t odd_value[] = {0x00, 0x01, 0x00};
+	check((ESP_GATT_OK != write_band_table(inverted_edges, 1)) &&
+			(ESP_GATT_OK != fake_gatt_write(BAND_TABLE_HANDLE, odd_value, sizeof(odd_value),
+					true)), "invalid band tables refused");
+	uint32_t fft_size = SPECTRUM_MAX_FFT_SIZE;
+	while ((fft_size > 1) && (fft_size > expected_count)) {
+		fft_size >>= 1;
+	}
+	double band_width = fmax(BAND_SIGNAL_RELATIVE_WIDTH * config.signal_frequency,
+			BAND_MIN_SIGNAL_BINS * (double)config.frequency / fft_size);
+	const uint16_t test_edges[] = {
+		(uint16_t)fmax(config.signal_frequency - band_width, 0),
+		(uint16_t)(config.signal_frequency + band_width) + 1,
+		0, config.frequency / 2 + 1,
+		(uint16_t)(2.5 * config.signal_frequency), (uint16_t)(3.5 * config.signal_frequency)
+	};
+	uint8_t test_count = sizeof(test_edges) / (2 * sizeof(test_edges[0]));
+	check(ESP_GATT_OK == write_band_table(test_edges, test_count), "band table written");
+	band_count = read_band_table(edges);
+	check((test_count == band_count) && (0 == memcmp(edges, test_edges, sizeof(test_edges))),
+			"band table read back");
+	nvs_handle nvs;
+	uint8_t stored[sizeof(test_edges)];
+	size_t stored_len = sizeof(stored);
+	check((ESP_OK == nvs_open(BLE_BAND_TABLE_NVS_NAMESPACE, NVS_READONLY, &nvs)) &&
+			(ESP_OK == nvs_get_blob(nvs, BLE_BAND_TABLE_NVS_KEY, stored, &stored_len)) &&
+			(sizeof(stored) == stored_len), "band table stored in nvs");
+	nvs_close(nvs);
+
+	/** buffered measurement **/
+	uint16_t zero_val = 0;
+	long long latency = trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, &config, 0,
+			&zero_val);
+	check(latency >= 0, "buffered measurement finished");
+	if (latency < 0) {
+		return 1;
+	}
+	printf("trigger to indication latency %lld us, zero value %u\n", latency, zero_val);
+
+	calculated_values values;
+	check(read_calculated_values(&values), "calculated values read");
+
+	uint32_t reads = 0;
+	long long start = esp_timer_get_time();
+	uint32_t count = read_frames(TIME_RESULTS_HANDLE, sizeof(uint16_t), polled,
+			expected_count, &reads);
+	long long read_time = esp_timer_get_time() - start;
+	check(count == expected_count, "all samples read");
+	printf("read %u samples in %u frames, %lld us\n", count, reads, read_time);
+
+	/** the statistics of the served samples match the calculated values **/
+	if ((count == expected_count) && (0 != count)) {
+		double sum = 0;
+		double sum_of_squares = 0;
+		uint16_t max_val = 0;
+		uint16_t min_val = UINT16_MAX;
+		for (uint32_t i = 0; i < count; ++i) {
+			sum += polled[i];
+			sum_of_squares += (double)polled[i] * polled[i];
+			max_val = (polled[i] > max_val) ? polled[i] : max_val;
+			min_val = (polled[i] < min_val) ? polled[i] : min_val;
+		}
+		double average = sum / count;
+		double rms = sqrt(sum_of_squares / count);
+		printf("rms %.3f, average %.3f, max %u, min %u, amplitude %u, crest factor %.4f\n",
+				values.rms, values.average, values.max_val, values.min_val, values.amplitude,
+				values.crest_factor);
+		check(is_close(values.rms, rms, FLOAT_TOLERANCE), "rms of the served samples");
+		check(is_close(values.average, average, FLOAT_TOLERANCE), "average of the served samples");
+		check((values.max_val == max_val) && (values.min_val == min_val),
+				"extremes of the served samples");
+		check(is_close(values.crest_factor, max_val / rms, FLOAT_TOLERANCE),
+				"crest factor of the served samples");
+
+		/** ac factors about the mean of the served samples, in g **/
+		double ac_rms = sqrt(fmax(sum_of_squares / count - average * average, 0));
+		double peak = fmax(max_val - average, average - min_val);
+		printf("ac rms %.4f g, peak %.4f g, peak to peak %.4f g, ac crest factor %.4f\n",
+				values.ac_rms, values.peak, values.peak_to_peak, values.ac_crest_factor);
+		check(is_close(values.ac_rms, ac_rms * sensitivity, FLOAT_TOLERANCE),
+				"ac rms of the served samples");
+		check(is_close(values.peak, peak * sensitivity, FLOAT_TOLERANCE),
+				"peak of the served samples");
+		check(is_close(values.peak_to_peak, (max_val - min_val) * sensitivity, FLOAT_TOLERANCE),
+				"peak to peak of the served samples");
+		check(is_close(values.ac_crest_factor, (0 != ac_rms) ? peak / ac_rms : 0,
+				FLOAT_TOLERANCE), "ac crest factor of the served samples");
+
+		/** skewness and kurtosis against the second pass about the mean in double **/
+		double moment2 = 0;
+		double moment3 = 0;
+		double moment4 = 0;
+		for (uint32_t i = 0; i < count; ++i) {
+			double deviation = polled[i] - average;
+			moment2 += deviation * deviation;
+			moment3 += deviation * deviation * deviation;
+			moment4 += deviation * deviation * deviation * deviation;
+		}
+		double skewness = 0;
+		double kurtosis = 0;
+		if (moment2 > 0) {
+			skewness = sqrt((double)count) * moment3 / pow(moment2, 1.5);
+			kurtosis = count * moment4 / (moment2 * moment2);
+		}
+		printf("skewness %.4f, kurtosis %.4f\n", values.skewness, values.kurtosis);
+		check(is_close(values.skewness, skewness, FLOAT_TOLERANCE),
+				"skewness of the served samples");
+		check(is_close(values.kurtosis, kurtosis, FLOAT_TOLERANCE),
+				"kurtosis of the served samples");
+	}
+
+	/** velocity and displacement of the sine, a = A*sin(w*t), v = -A/w*cos(w*t) and
+	 * d = -A/w^2*sin(w*t) **/
+	printf("velocity rms %.4f mm/s, displacement peak to peak %.3f um\n",
+			values.velocity_rms, values.displacement_peak_to_peak);
+	if (is_generated) {
+		double omega = 2 * M_PI * config.signal_frequency;
+		double acceleration = DEFAULT_SIGNAL_AMPLITUDE * SENSITIVITY * STANDARD_GRAVITY_MM_S2;
+		double high_pass = 1 / sqrt(1 + pow(INTEGRATION_LOW_FREQUENCY / config.signal_frequency, 4));
+		double low_pass = 1;
+		if (INTEGRATION_HIGH_FREQUENCY < INTEGRATION_MAX_RELATIVE_FREQUENCY * config.frequency) {
+			low_pass = 1 / sqrt(1 + pow(config.signal_frequency / INTEGRATION_HIGH_FREQUENCY, 4));
+		}
+		check(is_close(values.velocity_rms,
+				acceleration * low_pass * high_pass / omega / sqrt(2), INTEGRATION_TOLERANCE),
+				"velocity rms of the sine");
+		check(is_close(values.displacement_peak_to_peak,
+				2 * acceleration * low_pass * high_pass * high_pass / (omega * omega) * 1000,
+				2 * INTEGRATION_TOLERANCE + 1 - cos(M_PI * config.signal_frequency / config.frequency)),
+				"displacement peak to peak of the sine");
+	}
+
+	/** plain and compressed stream of the same capture, the loopback throughput of the
+	 * three transfers is compared, the time of the stream includes the subscription **/
+	uint32_t payload_bytes = 0;
+	uint32_t stream_frames = 0;
+	start = esp_timer_get_time();
+	uint32_t stream_count = receive_stream(streamed, expected_count, false, &payload_bytes,
+			&stream_frames);
+	long long raw_stream_time = esp_timer_get_time() - start;
+	check((stream_count == count) && (0 == memcmp(polled, streamed, count * sizeof(uint16_t))),
+			"plain streamed samples equal to the read ones");
+	memset(streamed, 0, expected_count * sizeof(uint16_t));
+	uint32_t compressed_frames = 0;
+	start = esp_timer_get_time();
+	stream_count = receive_stream(streamed, expected_count, true, &payload_bytes,
+			&compressed_frames);
+	long long stream_time = esp_timer_get_time() - start;
+	check((stream_count == count) && (0 == memcmp(polled, streamed, count * sizeof(uint16_t))),
+			"streamed samples equal to the read ones");
+	printf("streamed %u samples in %u bytes (%.2f bytes per sample), %lld us, "
+			"%u congestions\n", stream_count, payload_bytes,
+			stream_count ? (double)payload_bytes / stream_count : 0.0, stream_time,
+			fake_gatt_get_congestion_count());
+	printf("loopback throughput at mtu %u: read polled %.0f samples/s in %u round trips, "
+			"stream %.0f samples/s in %u notifications, compressed stream %.0f samples/s in "
+			"%u notifications\n", fake_gatt_get_mtu(),
+			(0 != read_time) ? count * 1e6 / read_time : 0.0, reads,
+			(0 != raw_stream_time) ? count * 1e6 / raw_stream_time : 0.0, stream_frames,
+			(0 != stream_time) ? count * 1e6 / stream_time : 0.0, compressed_frames);
+
+	/** spectrum of the capture **/
+	static uint16_t magnitude[SPECTRUM_MAX_BINS];
+	uint32_t bins = read_frames(FFT_RESULTS_HANDLE, sizeof(uint16_t), magnitude,
+			SPECTRUM_MAX_BINS, &reads);
+	check(bins > 1, "spectrum read");
+	if (bins > 1) {
+		uint32_t peak = 1;
+		for (uint32_t i = 1; i < bins; ++i) {
+			peak = (magnitude[i] > magnitude[peak]) ? i : peak;
+		}
+		double resolution = (double)config.frequency / (2 * (bins - 1));
+		printf("spectrum of %u bins, peak %.2f Hz\n", bins, peak * resolution);
+		if (is_generated) {
+			check(fabs(peak * resolution - config.signal_frequency) <= resolution,
+					"spectrum peak at the signal frequency");
+		}
+	}
+
+	/** envelope spectrum of the capture, the fault frequency is the largest peak and for
+	 * the inner race the shaft modulation, its own line or one of the sidebands, is among
+	 * the peaks **/
+	envelope_peak peaks[BLE_ENVELOPE_PEAK_COUNT];
+	double resolution = envelope_resolution(&config);
+	check(read_envelope_peaks(peaks), "envelope peaks read");
+	printf("envelope peaks, resolution %.2f Hz:", resolution);
+	for (uint8_t i = 0; i < BLE_ENVELOPE_PEAK_COUNT; ++i) {
+		printf(" %.1f Hz %.4f g%s", peaks[i].frequency, peaks[i].amplitude,
+				(BLE_ENVELOPE_PEAK_COUNT - 1 == i) ? "\n" : ",");
+	}
+	bool is_fault_resolved = (FAULT_NONE != config.fault) &&
+			(config.fault_frequency >= ENVELOPE_MIN_RESOLVED_BINS * resolution);
+	if ((FAULT_NONE != config.fault) && !is_fault_resolved) {
+		printf("fault frequency is not resolved by the short measurement\n");
+	}
+	if (is_fault_resolved) {
+		check(has_peak_at(peaks, 1, config.fault_frequency, resolution),
+				"largest envelope peak at the fault frequency");
+	}
+	if (is_fault_resolved && (FAULT_INNER_RACE == config.fault)) {
+		check(has_peak_at(peaks, BLE_ENVELOPE_PEAK_COUNT, FAULT_SHAFT_FREQUENCY, resolution) ||
+				has_peak_at(peaks, BLE_ENVELOPE_PEAK_COUNT,
+						config.fault_frequency - FAULT_SHAFT_FREQUENCY, resolution) ||
+				has_peak_at(peaks, BLE_ENVELOPE_PEAK_COUNT,
+						config.fault_frequency + FAULT_SHAFT_FREQUENCY, resolution),
+				"envelope shaft modulation of the inner race fault");
+	}
+
+	/** band features of the whole capture against the direct transform of the segments of
+	 * the served samples, for the sine the signal band and the whole spectrum hold its ac
+	 * rms **/
+	static double power[SPECTRUM_MAX_BINS];
+	double rms[BLE_BAND_MAX];
+	fft_size = power_spectrum(polled, count, power);
+	check((0 != fft_size) && (band_count == read_band_rms(rms)), "band rms read");
+	if ((0 != fft_size) && (band_count == read_band_rms(rms))) {
+		printf("band rms of %u samples:", fft_size);
+		bool is_equal = true;
+		for (uint8_t i = 0; i < band_count; ++i) {
+			double reference = band_rms(power, fft_size, config.frequency, edges[2*i],
+					edges[2*i + 1], sensitivity);
+			is_equal = is_equal && (fabs(rms[i] - reference) <=
+					BLE_BAND_RMS_UNIT / 2 + FLOAT_TOLERANCE * reference);
+			printf(" %u-%u Hz %.3f g%s", edges[2*i], edges[2*i + 1], rms[i],
+					(band_count - 1 == i) ? "\n" : ",");
+		}
+		check(is_equal, "band rms of the served samples");
+		bool is_sine_resolved = is_generated && (config.signal_frequency * fft_size >=
+				BAND_MIN_SIGNAL_CYCLES * (double)config.frequency);
+		if (is_generated && !is_sine_resolved) {
+			printf("sine is not resolved by the short measurement\n");
+		}
+		if (is_sine_resolved) {
+			double ac_rms = values.ac_rms;
+			check(is_close(rms[0], ac_rms, BAND_RMS_TOLERANCE) &&
+					is_close(rms[1], ac_rms, BAND_RMS_TOLERANCE),
+					"band rms of the sine in its band and the whole spectrum");
+			check(rms[2] <= BAND_RMS_LEAKAGE * rms[0], "band rms between the harmonics");
+		}
+	}
+
+	/** streaming measurement, the samples are consumed by the calculation directly, the
+	 * welch segment of the size of the buffered spectrum gives the band features **/
+	calculated_values stream_values;
+	latency = trigger_measurement(MEASUREMENT_STREAM_TRIGGER_WRITE_VAL, &config,
+			(uint16_t)fft_size, &zero_val);
+	check(latency >= 0, "stream measurement finished");
+	if (latency >= 0) {
+		printf("stream measurement latency %lld us\n", latency);
+		check(read_calculated_values(&stream_values), "stream calculated values read");
+		if (is_generated) {
+			check(is_close(stream_values.rms, values.rms, STREAM_RMS_TOLERANCE),
+					"stream rms equal to the buffered one");
+			check(is_close(stream_values.velocity_rms, values.velocity_rms, STREAM_RMS_TOLERANCE),
+					"stream velocity rms equal to the buffered one");
+			check(is_close(stream_values.kurtosis, values.kurtosis, STREAM_RMS_TOLERANCE),
+					"stream kurtosis equal to the buffered one");
+			double stream_rms[BLE_BAND_MAX];
+			bool is_equal = (0 != fft_size) && (band_count == read_band_rms(stream_rms));
+			for (uint8_t i = 0; is_equal && (i < band_count); ++i) {
+				is_equal = is_close(stream_rms[i], rms[i], STREAM_RMS_TOLERANCE);
+			}
+			check(is_equal, "stream band rms equal to the buffered one");
+		}
+		envelope_peak stream_peaks[BLE_ENVELOPE_PEAK_COUNT];
+		check(read_envelope_peaks(stream_peaks), "stream envelope peaks read");
+		if (is_fault_resolved) {
+			check(has_peak_at(stream_peaks, 1, peaks[0].frequency, resolution),
+					"stream envelope peak equal to the buffered one");
+		}
+	}
+
+	/** the conversions faster than any backend takes and the buffered samples over the arena
+	 * are refused by the indication **/
+	simulation_config unsupported = config;
+	unsupported.frequency = UNSUPPORTED_CHECK_FREQUENCY;
+	unsupported.duration = (float)MEASUREMENT_MAX_SAMPLES / UNSUPPORTED_CHECK_FREQUENCY;
+	unsupported.decimation = DECIMATOR_MAX_FACTOR;
+	unsupported.oversampling = MEASUREMENT_MAX_OVERSAMPLING;
+	latency = trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, &unsupported, 0, &zero_val);
+	check((latency < 0) && (BLE_MEASUREMENT_ERROR_NOT_SUPPORTED == measurement_error),
+			"measurement of the unsupported conversion frequency indicated as failed");
+	simulation_config too_long = config;
+	too_long.duration = 2.0f * MEASUREMENT_MAX_SAMPLES / config.frequency;
+	latency = trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, &too_long, 0, &zero_val);
+	check((latency < 0) && (BLE_MEASUREMENT_ERROR_TOO_LONG == measurement_error),
+			"buffered measurement longer than the arena indicated as failed");
+	/** the refused trigger written while the accepted one is pending leaves it as written **/
+	write_trigger(MEASUREMENT_TRIGGER_WRITE_VAL, &config, 0);
+	write_trigger(MEASUREMENT_TRIGGER_WRITE_VAL, &too_long, 0);
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	bool is_finished = false;
+	bool is_failed = false;
+	bool is_refused = false;
+	while ((!(is_finished || is_failed) || !is_refused) &&
+			fake_gatt_wait_notification(&handle, data, &len,
+					(uint32_t)(config.duration * 1000) + RESULT_TIMEOUT_MS)) {
+		if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (2 == len)) {
+			is_finished = true;
+		} else if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (1 == len)) {
+			is_refused = is_refused || (BLE_MEASUREMENT_ERROR_TOO_LONG == data[0]);
+			is_failed = is_failed || (BLE_MEASUREMENT_ERROR_TOO_LONG != data[0]);
+		}
+	}
+	check(is_finished && !is_failed && is_refused,
+			"pending measurement kept by the refused trigger");
+
+	check_stream_replaced(&config);
+	check_oversampling_snr(&config, polled);
+	check_threshold_monitoring(&config);
+	check_rms_alarm(&config);
+	check_alarm_during_measurement(&config);
+	check_event_capture();
+	if (0 != config.soak_cycles) {
+		check_soak(&config);
+	}
+	check_dma_hand_off();
+
+	/** the deepest calculation was run by now **/
+	UBaseType_t stack_unused = uxTaskGetStackHighWaterMark(
+			get_task_handle(CALCULATION_TASK_HANDLE));
+	printf("calculation task stack: %u of %u bytes never used\n", stack_unused,
+			CALCULATION_TASK_STACK_SIZE);
+	check(stack_unused > 0, "calculation task stack not exhausted");
+	fake_gatt_disconnect();
+	printf("%s, %u failed checks\n", (0 == failures) ? "PASS" : "FAIL", failures);
+	free(polled);
+	free(streamed);
+	return (0 == failures) ? 0 : 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Static functions definitions															//
+//////////////////////////////////////////////////////////////////////////////////////////
+
+static bool parse_arguments(int argc, char *argv[], simulation_config *config)
+{
+	static const struct option options[] = {
+		{"waveform", required_argument, NULL, 'w'},
+		{"frequency", required_argument, NULL, 'f'},
+		{"duration", required_argument, NULL, 'd'},
+		{"signal", required_argument, NULL, 's'},
+		{"fault", required_argument, NULL, 'b'},
+		{"fault-frequency", required_argument, NULL, 'r'},
+		{"mtu", required_argument, NULL, 'm'},
+		{"link-window", required_argument, NULL, 'l'},
+		{"decimation", required_argument, NULL, 'c'},
+		{"oversampling", required_argument, NULL, 'o'},
+		{"soak", required_argument, NULL, 'k'},
+		{"latency", required_argument, NULL, 't'},
+		{"fast", no_argument, NULL, 'x'},
+		{NULL, 0, NULL, 0}
+	};
+	int option;
+	while (-1 != (option = getopt_long(argc, argv, "w:f:d:s:b:r:m:l:c:o:k:t:x", options,
+			NULL))) {
+		switch (option) {
+		case 'w':
+			config->waveform_path = optarg;
+			break;
+		case 'f':
+			config->frequency = (uint16_t)atoi(optarg);
+			break;
+		case 'd':
+			config->duration = (float)atof(optarg);
+			break;
+		case 's':
+			config->signal_frequency = atof(optarg);
+			break;
+		case 'b':
+			if (0 == strcmp(optarg, "bpfo")) {
+				config->fault = FAULT_OUTER_RACE;
+			} else if (0 == strcmp(optarg, "bpfi")) {
+				config->fault = FAULT_INNER_RACE;
+			} else {
+				return false;
+			}
+			break;
+		case 'r':
+			config->fault_frequency = atof(optarg);
+			break;
+		case 'm':
+			config->mtu = (uint16_t)atoi(optarg);
+			break;
+		case 'l':
+			config->link_window = (uint16_t)atoi(optarg);
+			break;
+		case 'c':
+			config->decimation = (uint8_t)atoi(optarg);
+			break;
+		case 'o':
+			config->oversampling = (uint8_t)atoi(optarg);
+			break;
+		case 'k':
+			config->soak_cycles = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 't':
+			config->latency_cycles = (uint32_t)strtoul(optarg, NULL, 10);
+			break;
+		case 'x':
+			config->is_realtime = false;
+			break;
+		default:
+			return false;
+		}
+	}
+	return (0 != config->frequency) && (config->duration > 0) &&
+			(config->signal_frequency > 0) && (config->fault_frequency > 0) &&
+			(config->mtu >= FAKE_GATT_DEFAULT_MTU) &&
+			(config->decimation <= DECIMATOR_MAX_FACTOR) &&
+			((config->oversampling <= 1) ||
+			((config->oversampling >= MEASUREMENT_MIN_OVERSAMPLING) &&
+			(config->oversampling <= MEASUREMENT_MAX_OVERSAMPLING) &&
+			(0 == (config->oversampling & (config->oversampling - 1)))));
+}
+/****************************************************************************************/
+
+static void firmware_task(void *pvParameter)
+{
+	app_main();
+}
+/****************************************************************************************/
+
+static long long trigger_measurement(uint8_t command, const simulation_config *config,
+				uint16_t segment_size, uint16_t *zero_val)
+{
+	long long start = esp_timer_get_time();
+	write_trigger(command, config, segment_size);
+
+	uint32_t timeout = (uint32_t)(config->duration * 1000) + RESULT_TIMEOUT_MS;
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	measurement_error = 0;
+	while (fake_gatt_wait_notification(&handle, data, &len, timeout)) {
+		if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (2 == len)) {
+			*zero_val = (uint16_t)(data[0] << 8 | data[1]);
+			return esp_timer_get_time() - start;
+		}
+		if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (1 == len)) {
+			measurement_error = data[0];
+			return -1;
+		}
+	}
+	return -1;
+}
+/****************************************************************************************/
+
+static void write_trigger(uint8_t command, const simulation_config *config,
+				uint16_t segment_size)
+{
+	uint32_t duration;
+	memcpy(&duration, &config->duration, sizeof(duration));
+	uint8_t value[] = {0x00, command,
+		(uint8_t)(config->frequency >> 8), (uint8_t)config->frequency,
+		(uint8_t)(duration >> 24), (uint8_t)(duration >> 16),
+		(uint8_t)(duration >> 8), (uint8_t)duration,
+		(uint8_t)(segment_size >> 8), (uint8_t)segment_size,
+		STREAM_SEGMENT_OVERLAP, SPECTRUM_WINDOW_HANN, config->decimation,
+		config->oversampling};
+	fake_gatt_write(TRIGGER_MEASUREMENT_HANDLE, value, sizeof(value), false);
+}
+/****************************************************************************************/
+
+static double decimator_gain(decimator *filter, double relative_frequency)
+{
+	static double output[DECIMATOR_CHECK_OUTPUTS];
+	decimator_reset(filter);
+	uint32_t count = 0;
+	for (uint32_t n = 0; count < DECIMATOR_CHECK_OUTPUTS; ++n) {
+		double value = DEFAULT_SIGNAL_OFFSET + DECIMATOR_CHECK_AMPLITUDE *
+				sin(2 * M_PI * relative_frequency * n / filter->factor);
+		uint16_t sample;
+		if (decimator_push(filter, (uint16_t)round(value), &sample)) {
+			output[count++] = sample;
+		}
+	}
+
+	double mean = 0;
+	for (uint32_t m = 0; m < count; ++m) {
+		mean += output[m];
+	}
+	mean /= count;
+	double aliased = fabs(relative_frequency - round(relative_frequency));
+	double re = 0;
+	double im = 0;
+	double window_sum = 0;
+	for (uint32_t m = 0; m < count; ++m) {
+		double window = 0.5 - 0.5 * cos(2 * M_PI * m / count);
+		re += window * (output[m] - mean) * cos(2 * M_PI * aliased * m);
+		im -= window * (output[m] - mean) * sin(2 * M_PI * aliased * m);
+		window_sum += window;
+	}
+	return 2 * sqrt(re * re + im * im) / window_sum / DECIMATOR_CHECK_AMPLITUDE;
+}
+/****************************************************************************************/
+
+static void check_decimator_response(void)
+{
+	static decimator filter;
+	static const double alias_offsets[] = {-0.38, -0.25, -0.1, 0.1, 0.25, 0.38};
+	double max_ripple = 0;
+	double min_rejection = INFINITY;
+	bool is_initialized = true;
+	for (uint8_t factor = 2; factor <= DECIMATOR_MAX_FACTOR; ++factor) {
+		is_initialized = is_initialized && decimator_init(&filter, factor);
+		double min_gain = INFINITY;
+		double max_gain = 0;
+		for (double f = DECIMATOR_PASSBAND_STEP / 2; f <= DECIMATOR_PASSBAND_RELATIVE;
+				f += DECIMATOR_PASSBAND_STEP) {
+			double gain = decimator_gain(&filter, f);
+			min_gain = fmin(min_gain, gain);
+			max_gain = fmax(max_gain, gain);
+		}
+		max_ripple = fmax(max_ripple, 20 * log10(max_gain / min_gain));
+
+		/** the conversions near the multiples of the output sampling frequency alias into
+		 * the passband **/
+		for (uint8_t k = 1; k <= factor / 2; ++k) {
+			for (uint8_t i = 0; i < sizeof(alias_offsets) / sizeof(alias_offsets[0]); ++i) {
+				double f = k + alias_offsets[i];
+				if ((f >= DECIMATOR_STOPBAND_RELATIVE) && (f <= factor / 2.0)) {
+					min_rejection = fmin(min_rejection,
+							-20 * log10(decimator_gain(&filter, f)));
+				}
+			}
+		}
+	}
+	printf("decimator passband ripple %.4f dB, alias rejection %.1f dB\n", max_ripple,
+			min_rejection);
+	check(is_initialized, "decimator of every factor designed");
+	check(max_ripple <= DECIMATOR_MAX_RIPPLE_DB, "decimator passband ripple");
+	check(min_rejection >= DECIMATOR_MIN_REJECTION_DB, "decimator alias rejection");
+}
+/****************************************************************************************/
+
+static uint16_t ring_check_sample(uint32_t index)
+{
+	return (uint16_t)((index * 2654435761u) >> 16);
+}
+/****************************************************************************************/
+
+static void ring_producer_task(void *pvParameter)
+{
+	for (uint32_t i = 0; i < RING_CHECK_SAMPLES; ++i) {
+		while (!sample_ring_buffer_push(&check_ring, ring_check_sample(i))) {
+			ring_retries++;
+			vTaskDelay(0);
+		}
+	}
+	__atomic_store_n(&is_ring_produced, true, __ATOMIC_RELEASE);
+	vTaskSuspend(NULL);
+}
+/****************************************************************************************/
+
+static void check_ring_buffer(void)
+{
+	static uint16_t storage[RING_CHECK_CAPACITY];
+	uint16_t block[RING_CHECK_BLOCK_LEN];
+	sample_ring_buffer_init(&check_ring, storage, RING_CHECK_CAPACITY);
+	xTaskCreate(&ring_producer_task, "ring_producer", 2048, NULL, 5, NULL);
+
+	/** the consumer takes the blocks while the producer runs **/
+	uint32_t received = 0;
+	bool is_ordered = true;
+	uint64_t sum = 0;
+	uint64_t sum_of_squares = 0;
+	long long start = esp_timer_get_time();
+	while ((received < RING_CHECK_SAMPLES) &&
+			(esp_timer_get_time() - start < RING_CHECK_TIMEOUT_MS * 1000LL)) {
+		uint32_t count = sample_ring_buffer_pop_block(&check_ring, block,
+				RING_CHECK_BLOCK_LEN);
+		for (uint32_t i = 0; i < count; ++i) {
+			is_ordered = is_ordered && (ring_check_sample(received + i) == block[i]);
+			sum += block[i];
+			sum_of_squares += (uint64_t)block[i] * block[i];
+		}
+		received += count;
+		if (0 == count) {
+			sched_yield();
+		}
+	}
+	while (!__atomic_load_n(&is_ring_produced, __ATOMIC_ACQUIRE) &&
+			(esp_timer_get_time() - start < RING_CHECK_TIMEOUT_MS * 1000LL)) {
+		usleep(1000);
+	}
+	uint64_t expected_sum = 0;
+	uint64_t expected_sum_of_squares = 0;
+	for (uint32_t i = 0; i < RING_CHECK_SAMPLES; ++i) {
+		uint16_t sample = ring_check_sample(i);
+		expected_sum += sample;
+		expected_sum_of_squares += (uint64_t)sample * sample;
+	}
+	printf("ring of %u samples passed %u samples in %lld us, %u pushes retried\n",
+			RING_CHECK_CAPACITY, received, esp_timer_get_time() - start, ring_retries);
+	check((RING_CHECK_SAMPLES == received) && is_ordered && is_ring_produced &&
+			(0 == sample_ring_buffer_get_count(&check_ring)),
+			"ring passed all samples in order");
+	check((expected_sum == sum) && (expected_sum_of_squares == sum_of_squares),
+			"sums of the samples passed by the ring");
+	check(ring_retries == check_ring.overflow_count, "ring overflows counted");
+
+	/** the burst without the consumer keeps the first samples **/
+	uint32_t overflow_count = check_ring.overflow_count;
+	uint32_t pushed = 0;
+	for (uint32_t i = 0; i < RING_CHECK_CAPACITY + RING_CHECK_BURST_OVERFLOW; ++i) {
+		pushed += sample_ring_buffer_push(&check_ring, ring_check_sample(i)) ? 1 : 0;
+	}
+	received = 0;
+	is_ordered = true;
+	uint32_t count;
+	while (0 != (count = sample_ring_buffer_pop_block(&check_ring, block,
+			RING_CHECK_BLOCK_LEN))) {
+		for (uint32_t i = 0; i < count; ++i) {
+			is_ordered = is_ordered && (ring_check_sample(received + i) == block[i]);
+		}
+		received += count;
+	}
+	check((RING_CHECK_CAPACITY == pushed) && (RING_CHECK_CAPACITY == received) &&
+			is_ordered && (RING_CHECK_BURST_OVERFLOW == check_ring.overflow_count - overflow_count),
+			"ring burst over the capacity dropped and counted");
+}
+/****************************************************************************************/
+
+static bool round_trip_result_frames(uint16_t mtu, uint8_t element_size, bool is_compressed,
+				const void *data, uint32_t total_count, uint32_t *frames)
+{
+	static uint16_t decoded[FRAME_CHECK_MAX_COUNT];
+	uint8_t frame[FRAME_CHECK_MAX_MTU];
+	uint16_t max_len = result_frame_get_max_len(mtu);
+	uint32_t offset = 0;
+	bool is_valid = (total_count <= FRAME_CHECK_MAX_COUNT);
+	result_frame_header header = {.control = RESULT_FRAME_FIRST};
+	*frames = 0;
+	while (is_valid && (RESULT_FRAME_NO_MORE != header.control)) {
+		uint16_t len = max_len;
+		uint32_t count = is_compressed ?
+				result_frame_encode_compressed(frame, &len, data, total_count, offset,
+						FRAME_CHECK_ZERO_VAL) :
+				result_frame_encode(frame, &len, data, element_size, total_count, offset);
+		++*frames;
+		const uint8_t *payload = result_frame_decode(frame, len, element_size, &header);
+		/** only the empty result is sent in the frame without elements **/
+		result_frame_control control = (offset + count >= total_count) ?
+				RESULT_FRAME_NO_MORE : (0 == offset) ? RESULT_FRAME_FIRST : RESULT_FRAME_MORE;
+		is_valid = (NULL != payload) && (len <= max_len) && (header.control == control) &&
+				(header.offset == offset) && (header.count == count) &&
+				(header.is_compressed == is_compressed) &&
+				((0 != count) || (0 == total_count));
+		if (is_valid && is_compressed) {
+			uint16_t zero_val = (uint16_t)(payload[0] | payload[1] << 8);
+			is_valid = sample_codec_decode(payload + RESULT_FRAME_ZERO_VAL_LEN,
+					len - RESULT_FRAME_HEADER_LEN - RESULT_FRAME_ZERO_VAL_LEN, count, zero_val,
+					decoded + offset);
+		} else if (is_valid) {
+			for (uint32_t i = 0; i < count; ++i) {
+				decoded[offset + i] = (sizeof(uint16_t) == element_size) ?
+						(uint16_t)(payload[2*i] | payload[2*i + 1] << 8) : payload[i];
+			}
+		}
+		offset += count;
+	}
+	for (uint32_t i = 0; is_valid && (i < total_count); ++i) {
+		is_valid = (decoded[i] == ((sizeof(uint16_t) == element_size) ?
+				((const uint16_t *)data)[i] : ((const uint8_t *)data)[i]));
+	}
+	return is_valid && (offset == total_count);
+}
+/****************************************************************************************/
+
+static void check_result_frames(void)
+{
+	static uint16_t samples[FRAME_CHECK_MAX_COUNT];
+	static uint16_t signal[FRAME_CHECK_MAX_COUNT];
+	static uint8_t elements[FRAME_CHECK_MAX_COUNT];
+	uint8_t frame[FRAME_CHECK_MAX_MTU];
+	generate_statistics_signal(0, signal, FRAME_CHECK_MAX_COUNT);
+	for (uint32_t i = 0; i < FRAME_CHECK_MAX_COUNT; ++i) {
+		samples[i] = ring_check_sample(i);
+		elements[i] = (uint8_t)ring_check_sample(i);
+	}
+
+	/** uint16 samples, uint8 elements and the compressed samples **/
+	static const char *descriptions[] = {"raw frames of uint16 samples round trip at every mtu",
+			"raw frames of uint8 elements round trip at every mtu",
+			"compressed frames round trip at every mtu"};
+	const void *data[] = {samples, elements, signal};
+	static const uint8_t element_sizes[] = {sizeof(uint16_t), sizeof(uint8_t),
+			sizeof(uint16_t)};
+	uint32_t total_frames = 0;
+	for (uint8_t encoding = 0; encoding < 3; ++encoding) {
+		bool is_compressed = (2 == encoding);
+		uint16_t failed_mtu = 0;
+		for (uint16_t mtu = FRAME_CHECK_MIN_MTU; mtu <= FRAME_CHECK_MAX_MTU; ++mtu) {
+			/** capacity of the first frame, the compressed one depends on the samples **/
+			uint16_t len = result_frame_get_max_len(mtu);
+			uint32_t capacity = is_compressed ?
+					result_frame_encode_compressed(frame, &len, signal, FRAME_CHECK_MAX_COUNT,
+							0, FRAME_CHECK_ZERO_VAL) :
+					result_frame_encode(frame, &len, data[encoding], element_sizes[encoding],
+							FRAME_CHECK_MAX_COUNT, 0);
+			uint32_t counts[] = {0, 1, capacity - 1, capacity, capacity + 1,
+					FRAME_CHECK_FRAMES * capacity, FRAME_CHECK_FRAMES * capacity + 1};
+			for (uint8_t i = 0; i < sizeof(counts) / sizeof(counts[0]); ++i) {
+				uint32_t frames;
+				bool is_valid = round_trip_result_frames(mtu, element_sizes[encoding],
+						is_compressed, data[encoding], counts[i], &frames);
+				if (!is_compressed) {
+					uint32_t least_frames = (0 == counts[i]) ? 1 :
+							(counts[i] + capacity - 1) / capacity;
+					is_valid = is_valid && (least_frames == frames);
+				}
+				if (!is_valid && (0 == failed_mtu)) {
+					failed_mtu = mtu;
+					printf("%s failed at mtu %u for %u elements\n", descriptions[encoding], mtu,
+							counts[i]);
+				}
+				total_frames += frames;
+			}
+		}
+		check(0 == failed_mtu, descriptions[encoding]);
+	}
+	printf("result frames at mtu %u to %u round tripped in %u frames\n", FRAME_CHECK_MIN_MTU,
+			FRAME_CHECK_MAX_MTU, total_frames);
+}
+/****************************************************************************************/
+
+static const char * generate_statistics_signal(uint8_t signal, uint16_t data[],
+				uint32_t size)
+{
+	static const char *names[STATISTICS_CHECK_SIGNALS] = {"noisy sine", "full scale noise",
+			"quiet dc", "constant"};
+	uint32_t seed = 1;
+	for (uint32_t i = 0; i < size; ++i) {
+		seed = seed * 1103515245 + 12345;
+		uint32_t random = seed >> 16;
+		switch (signal) {
+		case 0:
+			data[i] = (uint16_t)lround(DEFAULT_SIGNAL_OFFSET + DEFAULT_SIGNAL_AMPLITUDE *
+					sin(2 * M_PI * i / 20.0) + (double)(random % 65) - 32);
+			break;
+		case 1:
+			data[i] = (uint16_t)(random % (SIM_ADC_MAX_VALUE + 1));
+			break;
+		case 2:
+			data[i] = (uint16_t)(DEFAULT_SIGNAL_OFFSET + random % 3 - 1);
+			break;
+		default:
+			data[i] = SIM_ADC_MAX_VALUE;
+			break;
+		}
+	}
+	return names[signal];
+}
+/****************************************************************************************/
+
+static void check_spectrum_accuracy(void)
+{
+	static const double tone_bins[SPECTRUM_CHECK_TONES] = {100, 300, 512.5};
+	static const double tone_amplitudes[SPECTRUM_CHECK_TONES] = {1500, 1.5, 200};
+	static const double tone_phases[SPECTRUM_CHECK_TONES] = {0, 1.1, 0.3};
+	static uint16_t data[SPECTRUM_MAX_FFT_SIZE];
+	static double power[SPECTRUM_MAX_BINS];
+	uint32_t size = SPECTRUM_MAX_FFT_SIZE;
+	for (uint32_t n = 0; n < size; ++n) {
+		double value = SPECTRUM_CHECK_OFFSET;
+		for (uint8_t i = 0; i < SPECTRUM_CHECK_TONES; ++i) {
+			value += tone_amplitudes[i] * sin(2 * M_PI * tone_bins[i] * n / size +
+					tone_phases[i]);
+		}
+		data[n] = (uint16_t)lround(value);
+	}
+	spectrum_init();
+	spectrum_set_sample_scale(1);
+	uint32_t bins = spectrum_calculate(data, size);
+	check((size / 2 + 1 == bins) && (size == power_spectrum(data, size, power)),
+			"multi tone spectrum calculated");
+	if (size / 2 + 1 != bins) {
+		return;
+	}
+
+	/** the sum of the squared Hann window is 3/8 of its length, so the amplitude of the
+	 * mean square of the reference bin is sqrt(3*power), the nyquist component is not a
+	 * sine and its amplitude is sqrt(3*power/2) **/
+	const uint16_t *codes = spectrum_get_magnitude_ptr();
+	double floor = SPECTRUM_FLOAT_FLOOR * tone_amplitudes[0];
+	double tone_error = 0;
+	double leakage_error = 0;
+	double leakage = 0;
+	bool is_tone_equal = true;
+	bool is_leakage_equal = true;
+	for (uint32_t k = 1; k < bins; ++k) {
+		double amplitude = (0 == codes[k]) ? 0 : pow(10, ((double)codes[k] /
+				SPECTRUM_DB_CODE_SCALE - SPECTRUM_DB_OFFSET) / 20);
+		double reference = sqrt(((bins - 1 == k) ? 1.5 : 3) * power[k]);
+		double error = fabs(amplitude - reference);
+		bool is_tone = false;
+		for (uint8_t i = 0; i < SPECTRUM_CHECK_TONES; ++i) {
+			is_tone = is_tone || (fabs(k - tone_bins[i]) <= SPECTRUM_TONE_BINS);
+		}
+		if (is_tone) {
+			tone_error = fmax(tone_error, error / reference);
+			is_tone_equal = is_tone_equal &&
+					(error <= SPECTRUM_TONE_TOLERANCE * reference + floor);
+		} else {
+			leakage = fmax(leakage, reference);
+			leakage_error = fmax(leakage_error, error);
+			is_leakage_equal = is_leakage_equal &&
+					(error <= SPECTRUM_TONE_TOLERANCE * reference + floor);
+		}
+	}
+	printf("multi tone spectrum of %u samples, tone bins within %.2e, leakage up to "
+			"%.1f dB within %.2e counts\n", size, tone_error,
+			20 * log10(fmax(leakage, DBL_MIN) / tone_amplitudes[0]), leakage_error);
+	check(is_tone_equal, "multi tone bins equal to the reference dft");
+	check(is_leakage_equal, "multi tone leakage equal to the reference dft");
+
+	/** bin centered tones keep their amplitude, the full scale one and the small one **/
+	bool is_amplitude_equal = true;
+	for (uint8_t i = 0; i < SPECTRUM_CHECK_TONES; ++i) {
+		uint32_t k = (uint32_t)tone_bins[i];
+		if (k != tone_bins[i]) {
+			continue;
+		}
+		double amplitude = pow(10, ((double)codes[k] / SPECTRUM_DB_CODE_SCALE -
+				SPECTRUM_DB_OFFSET) / 20);
+		is_amplitude_equal = is_amplitude_equal && is_close(amplitude, tone_amplitudes[i],
+				(tone_amplitudes[i] < 2) ? SPECTRUM_SMALL_TONE_TOLERANCE : SPECTRUM_TONE_TOLERANCE);
+		printf("tone at bin %u, amplitude %.4f of %.4f counts\n", k, amplitude,
+				tone_amplitudes[i]);
+	}
+	check(is_amplitude_equal, "multi tone amplitudes");
+}
+/****************************************************************************************/
+
+static uint32_t welch_reference(const uint16_t data[], uint32_t size, spectrum_window window,
+				double psd[])
+{
+	static const double flat_top[] = {0.21557895, 0.41663158, 0.277263158, 0.083578947,
+			0.006947368};
+	uint32_t length = WELCH_CHECK_SEGMENT;
+	uint32_t step = length - (length * WELCH_CHECK_OVERLAP) / 100;
+	double window_values[WELCH_CHECK_SEGMENT];
+	double window_power = 0;
+	for (uint32_t n = 0; n < length; ++n) {
+		double value = 0.5 - 0.5 * cos(2 * M_PI * n / length);
+		if (SPECTRUM_WINDOW_FLAT_TOP == window) {
+			value = 0;
+			for (uint32_t i = 0; i < sizeof(flat_top) / sizeof(flat_top[0]); ++i) {
+				value += ((i & 0x1) ? -1 : 1) * flat_top[i] * cos(2 * M_PI * i * n / length);
+			}
+		}
+		window_values[n] = value;
+		window_power += value * value;
+	}
+
+	uint32_t segments = 0;
+	for (uint32_t k = 0; k <= length / 2; ++k) {
+		psd[k] = 0;
+	}
+	for (uint32_t start = 0; start + length <= size; start += step, ++segments) {
+		double mean = 0;
+		for (uint32_t n = 0; n < length; ++n) {
+			mean += data[start + n];
+		}
+		mean /= length;
+		for (uint32_t k = 0; k <= length / 2; ++k) {
+			double re = 0;
+			double im = 0;
+			for (uint32_t n = 0; n < length; ++n) {
+				double value = (data[start + n] - mean) * window_values[n];
+				double phase = 2 * M_PI * ((k * n) % length) / length;
+				re += value * cos(phase);
+				im -= value * sin(phase);
+			}
+			psd[k] += re * re + im * im;
+		}
+	}
+	for (uint32_t k = 0; (0 != segments) && (k <= length / 2); ++k) {
+		psd[k] *= (((0 == k) || (length / 2 == k)) ? 1 : 2) /
+				(segments * (double)WELCH_CHECK_FREQUENCY * window_power);
+	}
+	return segments;
+}
+/****************************************************************************************/
+
+static void check_welch_accuracy(void)
+{
+	static uint16_t data[WELCH_CHECK_SIZE];
+	double psd[WELCH_CHECK_SEGMENT / 2 + 1];
+	double resolution = (double)WELCH_CHECK_FREQUENCY / WELCH_CHECK_SEGMENT;
+	spectrum_init();
+	spectrum_set_sample_scale(1);
+	for (uint8_t signal = 0; signal < 2; ++signal) {
+		/** uniform white noise and the tone between the bins **/
+		bool is_noise = (0 == signal);
+		spectrum_window window = is_noise ? SPECTRUM_WINDOW_HANN : SPECTRUM_WINDOW_FLAT_TOP;
+		uint32_t seed = 1;
+		double sum = 0;
+		double sum_of_squares = 0;
+		for (uint32_t n = 0; n < WELCH_CHECK_SIZE; ++n) {
+			seed = seed * 1103515245 + 12345;
+			double value = is_noise ?
+					WELCH_CHECK_NOISE * (((seed >> 16) & 0x7fff) / 16383.5 - 1) :
+					WELCH_CHECK_TONE_AMPLITUDE *
+							sin(2 * M_PI * WELCH_CHECK_TONE_FREQUENCY * n / WELCH_CHECK_FREQUENCY);
+			data[n] = (uint16_t)lround(SPECTRUM_CHECK_OFFSET + value);
+			sum += data[n];
+			sum_of_squares += (double)data[n] * data[n];
+		}
+		double variance = sum_of_squares / WELCH_CHECK_SIZE -
+				(sum / WELCH_CHECK_SIZE) * (sum / WELCH_CHECK_SIZE);
+
+		uint32_t bins = spectrum_welch_start(WELCH_CHECK_SEGMENT, WELCH_CHECK_OVERLAP, window,
+				WELCH_CHECK_FREQUENCY);
+		for (uint32_t n = 0; n < WELCH_CHECK_SIZE; n += WELCH_CHECK_BLOCK_LEN) {
+			spectrum_welch_feed(data + n, (WELCH_CHECK_SIZE - n < WELCH_CHECK_BLOCK_LEN) ?
+					WELCH_CHECK_SIZE - n : WELCH_CHECK_BLOCK_LEN);
+		}
+		bool is_calculated = (bins == spectrum_welch_finish()) && (0 != bins) &&
+				(0 != welch_reference(data, WELCH_CHECK_SIZE, window, psd));
+		check(is_calculated, is_noise ? "welch psd of the white noise calculated" :
+				"welch psd of the tone calculated");
+		if (!is_calculated) {
+			continue;
+		}
+
+		/** the density of the bins is integrated over their width, the tone by the bins of
+		 * the main lobe **/
+		const uint16_t *codes = spectrum_get_magnitude_ptr();
+		uint32_t tone_bin = (uint32_t)lround(WELCH_CHECK_TONE_FREQUENCY / resolution);
+		double floor = 0;
+		for (uint32_t k = 0; k < bins; ++k) {
+			floor = fmax(floor, psd[k] * SPECTRUM_FLOAT_FLOOR * SPECTRUM_FLOAT_FLOOR);
+		}
+		double max_error = 0;
+		double power = 0;
+		bool is_equal = true;
+		for (uint32_t k = 0; k < bins; ++k) {
+			double density = (0 == codes[k]) ? 0 : pow(10, ((double)codes[k] /
+					SPECTRUM_DB_CODE_SCALE - SPECTRUM_DB_OFFSET) / 10);
+			double error = fabs(density - psd[k]);
+			max_error = (psd[k] > floor) ? fmax(max_error, error / psd[k]) : max_error;
+			is_equal = is_equal && (error <= WELCH_TOLERANCE * psd[k] + floor);
+			if (is_noise || ((k + WELCH_TONE_BINS >= tone_bin) &&
+					(k <= tone_bin + WELCH_TONE_BINS))) {
+				power += density * resolution;
+			}
+		}
+		double expected = is_noise ? variance :
+				WELCH_CHECK_TONE_AMPLITUDE * WELCH_CHECK_TONE_AMPLITUDE / 2;
+		printf("welch psd of the %s, %u bins within %.2e, power %.1f of %.1f counts^2\n",
+				is_noise ? "white noise" : "tone", bins, max_error, power, expected);
+		check(is_equal, is_noise ? "welch psd of the white noise equal to the reference" :
+				"welch psd of the tone equal to the reference");
+		check(is_close(power, expected, WELCH_POWER_TOLERANCE), is_noise ?
+				"variance of the white noise integrated from the psd" :
+				"power of the tone integrated from the psd");
+	}
+
+	/** the tone is expected in the share of the window power of every segment after its
+	 * start **/
+	uint32_t onset = SPECTRUM_MAX_FFT_SIZE;
+	for (uint32_t n = 0; n < WELCH_CHECK_SIZE; ++n) {
+		double value = (n < onset) ? 0 : WELCH_CHECK_TONE_AMPLITUDE *
+				sin(2 * M_PI * WELCH_CHECK_TONE_FREQUENCY * n / WELCH_CHECK_FREQUENCY);
+		data[n] = (uint16_t)lround(SPECTRUM_CHECK_OFFSET + value);
+	}
+	uint32_t step = SPECTRUM_MAX_FFT_SIZE -
+			(SPECTRUM_MAX_FFT_SIZE * WELCH_CHECK_OVERLAP) / 100;
+	double share = 0;
+	uint32_t segments = 0;
+	for (uint32_t start = 0; start + SPECTRUM_MAX_FFT_SIZE <= WELCH_CHECK_SIZE;
+			start += step, ++segments) {
+		double window_power = 0;
+		double tone_power = 0;
+		for (uint32_t n = 0; n < SPECTRUM_MAX_FFT_SIZE; ++n) {
+			double window = 0.5 - 0.5 * cos(2 * M_PI * n / SPECTRUM_MAX_FFT_SIZE);
+			window_power += window * window;
+			tone_power += (start + n < onset) ? 0 : window * window;
+		}
+		share += tone_power / window_power;
+	}
+	double expected = WELCH_CHECK_TONE_AMPLITUDE * WELCH_CHECK_TONE_AMPLITUDE / 2 *
+			share / segments;
+	spectrum_welch_start(SPECTRUM_MAX_FFT_SIZE, WELCH_CHECK_OVERLAP, SPECTRUM_WINDOW_HANN,
+			WELCH_CHECK_FREQUENCY);
+	spectrum_welch_feed(data, WELCH_CHECK_SIZE);
+	uint32_t bins = spectrum_calculate(data, WELCH_CHECK_SIZE);
+	bool is_averaged = (segments == spectrum_welch_finish_bands());
+	double power = spectrum_band_mean_square(
+			WELCH_CHECK_TONE_FREQUENCY - WELCH_BAND_HALF_WIDTH,
+			WELCH_CHECK_TONE_FREQUENCY + WELCH_BAND_HALF_WIDTH, WELCH_CHECK_FREQUENCY);
+	uint32_t tone_bin = (uint32_t)lround(WELCH_CHECK_TONE_FREQUENCY * SPECTRUM_MAX_FFT_SIZE /
+			WELCH_CHECK_FREQUENCY);
+	printf("band power of the tone after %u samples over %u segments %.1f of %.1f "
+			"counts^2\n", onset, segments, power, expected);
+	check(is_averaged && is_close(power, expected, WELCH_POWER_TOLERANCE),
+			"band power of the tone averaged over the whole capture");
+	check((SPECTRUM_MAX_BINS == bins) && (bins == spectrum_get_bin_count()) &&
+			(0 == spectrum_get_magnitude_ptr()[tone_bin]),
+			"amplitude spectrum of the first transform kept with the band power");
+}
+/****************************************************************************************/
+
+static void check_statistics(void)
+{
+	static const uint32_t sizes[] = {1000, 10000, STATISTICS_CHECK_MAX_SIZE};
+	static uint16_t data[STATISTICS_CHECK_MAX_SIZE];
+	bool is_finished = true;
+	bool is_equal = true;
+	for (uint8_t k = 0; k < sizeof(sizes) / sizeof(sizes[0]); ++k) {
+		for (uint8_t signal = 0; signal < STATISTICS_CHECK_SIGNALS; ++signal) {
+			uint32_t size = sizes[k];
+			const char *name = generate_statistics_signal(signal, data, size);
+
+			/** reference, the moments are taken about the mean of the first pass **/
+			double sum = 0;
+			double sum_of_squares = 0;
+			uint16_t max_val = 0;
+			uint16_t min_val = UINT16_MAX;
+			for (uint32_t i = 0; i < size; ++i) {
+				sum += data[i];
+				sum_of_squares += (double)data[i] * data[i];
+				max_val = (data[i] > max_val) ? data[i] : max_val;
+				min_val = (data[i] < min_val) ? data[i] : min_val;
+			}
+			double average = sum / size;
+			double moment2 = 0;
+			double moment3 = 0;
+			double moment4 = 0;
+			for (uint32_t i = 0; i < size; ++i) {
+				double deviation = data[i] - average;
+				moment2 += deviation * deviation;
+				moment3 += deviation * deviation * deviation;
+				moment4 += deviation * deviation * deviation * deviation;
+			}
+			double rms = sqrt(sum_of_squares / size);
+			double ac_rms = sqrt(moment2 / size);
+			double peak = fmax(max_val - average, average - min_val);
+			double skewness = (moment2 > 0) ? sqrt((double)size) * moment3 / pow(moment2, 1.5) : 0;
+			double kurtosis = (moment2 > 0) ? size * moment4 / (moment2 * moment2) : 0;
+
+			Calculation_obj_handle obj = calculation_new_obj(data, size);
+			if (NULL == obj) {
+				is_finished = false;
+				continue;
+			}
+			calculation_calculate_factors(obj);
+			for (uint32_t t = 0; (t < RESULT_TIMEOUT_MS) &&
+					(CALCULATION_FINISHED != calculation_get_state(obj)); ++t) {
+				usleep(1000);
+			}
+			if (CALCULATION_FINISHED != calculation_get_state(obj)) {
+				/** the task may still use the obj, it is not returned to the pool **/
+				is_finished = false;
+				continue;
+			}
+#define FACTOR(factor)	((double)CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj, \
+				(factor))))
+			double values[] = {
+				FACTOR(CALCULATION_RMS), FACTOR(CALCULATION_AVERAGE),
+				FACTOR(CALCULATION_CREST_FACTOR), FACTOR(CALCULATION_AC_RMS) / SENSITIVITY,
+				FACTOR(CALCULATION_PEAK) / SENSITIVITY,
+				FACTOR(CALCULATION_PEAK_TO_PEAK) / SENSITIVITY,
+				FACTOR(CALCULATION_AC_CREST_FACTOR), FACTOR(CALCULATION_KURTOSIS),
+				(double)CALCULATION_SIGNED_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+						CALCULATION_SKEWNESS))
+			};
+#undef FACTOR
+			double references[] = {
+				rms, average, max_val / rms, ac_rms, peak, max_val - min_val,
+				(ac_rms > 0) ? peak / ac_rms : 0, kurtosis, skewness
+			};
+			bool is_signal_equal =
+					(max_val == calculation_get_factor(obj, CALCULATION_MAXVAL).integer_type) &&
+					(min_val == calculation_get_factor(obj, CALCULATION_MINVAL).integer_type) &&
+					(abs((int)calculation_get_factor(obj, CALCULATION_AMPLITUDE).integer_type -
+							(int)peak) <= 1);
+			for (uint8_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i) {
+				is_signal_equal = is_signal_equal &&
+						is_close(values[i], references[i], STATISTICS_TOLERANCE);
+			}
+			if (!is_signal_equal) {
+				printf("statistics of the %s of %u samples: rms %.4f/%.4f, ac rms %.4f/%.4f, "
+						"skewness %.4f/%.4f, kurtosis %.4f/%.4f\n", name, size, values[0], rms,
+						values[3], ac_rms, values[8], skewness, values[7], kurtosis);
+			}
+			is_equal = is_equal && is_signal_equal;
+			calculation_delete_obj(&obj);
+		}
+	}
+	check(is_finished, "statistics of the reference signals calculated");
+	check(is_equal, "statistics equal to the two pass reference");
+}
+/****************************************************************************************/
+
+static uint16_t sample_scale(uint8_t oversampling)
+{
+	uint16_t scale = 1;
+	for (uint8_t factor = oversampling; factor > 1; factor >>= 1) {
+		scale <<= 1;
+	}
+	uint16_t max_scale = 1 << (MEASUREMENT_MAX_SAMPLE_BITS - MEASUREMENT_CONVERSION_BITS);
+	return (scale > max_scale) ? max_scale : scale;
+}
+/****************************************************************************************/
+
+static double measure_snr(const simulation_config *config, uint16_t samples[], double *mean)
+{
+	double conversion_frequency = (double)config->frequency *
+			((config->decimation > 1) ? config->decimation : 1) *
+			((config->oversampling > 1) ? config->oversampling : 1);
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET, OVERSAMPLING_CHECK_AMPLITUDE,
+			conversion_frequency / config->signal_frequency);
+	sim_adc_set_noise(OVERSAMPLING_CHECK_NOISE_RMS);
+	uint16_t zero_val = 0;
+	uint32_t reads = 0;
+	uint32_t expected_count = (uint32_t)(config->frequency * config->duration);
+	if ((trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, config, 0, &zero_val) < 0) ||
+			(expected_count != read_frames(TIME_RESULTS_HANDLE, sizeof(uint16_t), samples,
+					expected_count, &reads))) {
+		return NAN;
+	}
+
+	/** least squares of the cosine and the sine about the mean, the 2x2 normal equations **/
+	*mean = 0;
+	for (uint32_t i = 0; i < expected_count; ++i) {
+		*mean += samples[i];
+	}
+	*mean /= expected_count;
+	double cc = 0;
+	double ss = 0;
+	double cs = 0;
+	double xc = 0;
+	double xs = 0;
+	for (uint32_t i = 0; i < expected_count; ++i) {
+		double phase = 2 * M_PI * config->signal_frequency * i / config->frequency;
+		double x = samples[i] - *mean;
+		cc += cos(phase) * cos(phase);
+		ss += sin(phase) * sin(phase);
+		cs += cos(phase) * sin(phase);
+		xc += x * cos(phase);
+		xs += x * sin(phase);
+	}
+	double determinant = cc * ss - cs * cs;
+	double a = (xc * ss - xs * cs) / determinant;
+	double b = (xs * cc - xc * cs) / determinant;
+	double signal = 0;
+	double noise = 0;
+	for (uint32_t i = 0; i < expected_count; ++i) {
+		double phase = 2 * M_PI * config->signal_frequency * i / config->frequency;
+		double fit = a * cos(phase) + b * sin(phase);
+		double residual = samples[i] - *mean - fit;
+		signal += fit * fit;
+		noise += residual * residual;
+	}
+	return (noise > 0) ? 10 * log10(signal / noise) : INFINITY;
+}
+/****************************************************************************************/
+
+static void check_stream_replaced(const simulation_config *config)
+{
+	simulation_config replaced = *config;
+	replaced.frequency = STREAM_ABORT_CHECK_FREQUENCY;
+	replaced.duration = (float)STREAM_ABORT_CHECK_SAMPLES / STREAM_ABORT_CHECK_FREQUENCY;
+	replaced.decimation = 0;
+	replaced.oversampling = 0;
+	uint16_t zero_val;
+	if (trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, &replaced, 0, &zero_val) < 0) {
+		check(false, "capture of the replaced stream measured");
+		return;
+	}
+
+	fake_gatt_set_link_window(STREAM_ABORT_CHECK_WINDOW);
+	uint8_t encoding = STREAM_ENCODING_RAW_WRITE_VAL;
+	uint8_t subscribe[] = {0x01, 0x00};
+	uint8_t unsubscribe[] = {0x00, 0x00};
+	fake_gatt_write(TIME_RESULTS_STREAM_HANDLE, &encoding, sizeof(encoding), true);
+	fake_gatt_write(TIME_RESULTS_STREAM_CCC_HANDLE, subscribe, sizeof(subscribe), true);
+
+	/** the frames queued before the trigger was taken still carry the old capture **/
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	uint32_t count = 0;
+	bool is_triggered = false;
+	bool is_finished = false;
+	bool is_consistent = true;
+	result_frame_header header = {.control = RESULT_FRAME_FIRST};
+	while (((RESULT_FRAME_NO_MORE != header.control) || !is_finished) &&
+			fake_gatt_wait_notification(&handle, data, &len,
+					(uint32_t)(replaced.duration * 1000) + RESULT_TIMEOUT_MS)) {
+		if (TRIGGER_MEASUREMENT_HANDLE == handle) {
+			is_finished = is_finished || (2 == len);
+			continue;
+		}
+		if ((TIME_RESULTS_STREAM_HANDLE != handle) ||
+				(RESULT_FRAME_NO_MORE == header.control)) {
+			continue;
+		}
+		const uint8_t *payload = result_frame_decode(data, len, sizeof(uint16_t), &header);
+		if ((NULL == payload) || (header.offset != count)) {
+			is_consistent = false;
+			break;
+		}
+		count += header.count;
+		if (!is_triggered) {
+			sim_adc_set_realtime(true);
+			write_trigger(MEASUREMENT_TRIGGER_WRITE_VAL, &replaced, 0);
+			usleep(STREAM_ABORT_CHECK_DELAY_MS * 1000);
+			is_triggered = true;
+		}
+	}
+	fake_gatt_write(TIME_RESULTS_STREAM_CCC_HANDLE, unsubscribe, sizeof(unsubscribe), true);
+	fake_gatt_set_link_window(config->link_window);
+	sim_adc_set_realtime(config->is_realtime);
+	printf("stream aborted after %u of %u samples\n", count, STREAM_ABORT_CHECK_SAMPLES);
+	check(is_consistent && is_finished && header.is_aborted && (0 == header.count) &&
+			(count < STREAM_ABORT_CHECK_SAMPLES),
+			"stream of the replaced capture ended by the aborted frame");
+}
+/****************************************************************************************/
+
+static void check_oversampling_snr(const simulation_config *config, uint16_t samples[])
+{
+	uint32_t expected_count = (uint32_t)(config->frequency * config->duration);
+	if (expected_count < OVERSAMPLING_CHECK_MIN_SAMPLES) {
+		printf("oversampling snr is not resolved by the short measurement\n");
+		return;
+	}
+	simulation_config plain = *config;
+	plain.oversampling = 0;
+	simulation_config oversampled = *config;
+	if (oversampled.oversampling <= 1) {
+		oversampled.oversampling = OVERSAMPLING_CHECK_FACTOR;
+	}
+
+	double plain_mean = 0;
+	double oversampled_mean = 0;
+	double plain_snr = measure_snr(&plain, samples, &plain_mean);
+	double oversampled_snr = measure_snr(&oversampled, samples, &oversampled_mean);
+	sim_adc_set_noise(0);
+	check(!isnan(plain_snr) && !isnan(oversampled_snr), "noisy sine measured");
+	if (isnan(plain_snr) || isnan(oversampled_snr)) {
+		return;
+	}
+
+	uint16_t scale = sample_scale(oversampled.oversampling);
+	double expected_gain = 10 * log10(oversampled.oversampling);
+	printf("sine of %u counts in %.1f counts rms noise, snr %.2f dB, oversampled by %u "
+			"%.2f dB, %.1f bit samples\n", OVERSAMPLING_CHECK_AMPLITUDE,
+			OVERSAMPLING_CHECK_NOISE_RMS, plain_snr, oversampled.oversampling, oversampled_snr,
+			MEASUREMENT_CONVERSION_BITS + log2(scale));
+	check(oversampled_snr - plain_snr >= expected_gain - OVERSAMPLING_SNR_MARGIN_DB,
+			"snr gain of the oversampling");
+	check(is_close(oversampled_mean, plain_mean * scale, FLOAT_TOLERANCE),
+			"oversampled samples widened by the sample scale");
+}
+/****************************************************************************************/
+
+static void set_threshold(uint16_t threshold)
+{
+	uint8_t value[] = {0x00, THRESHOLD_EXCEEDED_WRITE_VAL, (uint8_t)(threshold >> 8),
+		(uint8_t)threshold};
+	fake_gatt_write(THRESHOLD_EXCEEDED_HANDLE, value, sizeof(value), false);
+}
+/****************************************************************************************/
+
+static void set_alarm(uint16_t warning, uint16_t alarm)
+{
+	const uint16_t fields[] = {ALARM_CHECK_WINDOW_MS, warning, alarm, ALARM_CHECK_HYSTERESIS,
+		ALARM_CHECK_HOLD_OFF_MS, ALARM_CHECK_INTERVAL_MS};
+	uint8_t value[2 + sizeof(fields)] = {0x00, THRESHOLD_ALARM_WRITE_VAL};
+	for (uint8_t i = 0; i < sizeof(fields) / sizeof(fields[0]); ++i) {
+		value[2 + 2*i] = (uint8_t)(fields[i] >> 8);
+		value[3 + 2*i] = (uint8_t)fields[i];
+	}
+	fake_gatt_write(THRESHOLD_EXCEEDED_HANDLE, value, sizeof(value), false);
+}
+/****************************************************************************************/
+
+static bool watch_threshold(uint32_t conversions, uint8_t data[], uint16_t *len)
+{
+	uint64_t target = sim_adc_get_conversion_count() + conversions;
+	long long deadline = esp_timer_get_time() + (long long)conversions * 1000000 /
+			THRESHOLD_EXCEEDED_MONITORING_FREQUENCY + RESULT_TIMEOUT_MS * 1000LL;
+	uint64_t count = sim_adc_get_conversion_count();
+	long long progress_time = esp_timer_get_time();
+	uint16_t handle;
+	while ((count < target) && (esp_timer_get_time() < deadline)) {
+		if (fake_gatt_wait_notification(&handle, data, len, 1) &&
+				(THRESHOLD_EXCEEDED_HANDLE == handle)) {
+			return true;
+		}
+		if (count != sim_adc_get_conversion_count()) {
+			count = sim_adc_get_conversion_count();
+			progress_time = esp_timer_get_time();
+		} else if (esp_timer_get_time() - progress_time > THRESHOLD_CHECK_STALL_MS * 1000LL) {
+			break;
+		}
+	}
+	return false;
+}
+/****************************************************************************************/
+
+static bool wait_alarm(rms_alarm_level *level, uint16_t *rms)
+{
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	while (fake_gatt_wait_notification(&handle, data, &len, RESULT_TIMEOUT_MS)) {
+		if ((THRESHOLD_EXCEEDED_HANDLE == handle) && (4 == len) &&
+				(THRESHOLD_ALARM_WRITE_VAL == data[0])) {
+			*level = (rms_alarm_level)data[1];
+			*rms = (uint16_t)(data[2] << 8 | data[3]);
+			return true;
+		}
+	}
+	return false;
+}
+/****************************************************************************************/
+
+static bool wait_event(uint16_t *exceeded_value, uint16_t *zero_val)
+{
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	bool is_indicated = false;
+	bool is_calculated = false;
+	while ((!is_indicated || !is_calculated) &&
+			fake_gatt_wait_notification(&handle, data, &len, RESULT_TIMEOUT_MS)) {
+		if ((THRESHOLD_EXCEEDED_HANDLE == handle) && (2 == len)) {
+			*exceeded_value = (uint16_t)(data[0] << 8 | data[1]);
+			is_indicated = true;
+		} else if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (2 == len)) {
+			*zero_val = (uint16_t)(data[0] << 8 | data[1]);
+			is_calculated = true;
+		}
+	}
+	return is_indicated && is_calculated;
+}
+/****************************************************************************************/
+
+static void check_threshold_monitoring(const simulation_config *config)
+{
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t len = 0;
+	uint16_t spike_value = DEFAULT_SIGNAL_OFFSET + THRESHOLD_CHECK_SPIKE;
+	sim_adc_generate_spike(DEFAULT_SIGNAL_OFFSET, THRESHOLD_CHECK_SPIKE,
+			THRESHOLD_CHECK_PERIOD);
+
+	/** the spikes within the threshold, between and within the measurement **/
+	set_threshold(THRESHOLD_CHECK_HIGH);
+	bool is_quiet = !watch_threshold(THRESHOLD_CHECK_PERIODS * THRESHOLD_CHECK_PERIOD,
+			data, &len);
+	uint16_t zero_val = 0;
+	check(trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, config, 0, &zero_val) >= 0,
+			"measurement finished during the monitoring");
+	measurement_reset_monitoring_max();
+	is_quiet = is_quiet && !watch_threshold(THRESHOLD_CHECK_PERIODS * THRESHOLD_CHECK_PERIOD,
+			data, &len);
+	check(is_quiet, "no indication within the threshold");
+	check(spike_value == measurement_get_monitoring_max(),
+			"monitoring goes on after the measurement");
+
+	/** the first spike over the threshold, its event capture is calculated too **/
+	set_threshold(THRESHOLD_CHECK_LOW);
+	uint16_t exceeded_value = 0;
+	bool is_indicated = wait_event(&exceeded_value, &zero_val);
+	printf("threshold %u, spike of one conversion to %u, %s %u\n", THRESHOLD_CHECK_LOW,
+			spike_value, is_indicated ? "indicated" : "not indicated", exceeded_value);
+	check(is_indicated && (spike_value == exceeded_value),
+			"single conversion spike over the threshold indicated");
+	is_quiet = !watch_threshold(THRESHOLD_CHECK_PERIODS * THRESHOLD_CHECK_PERIOD,
+			data, &len);
+	check(is_quiet, "one indication per threshold setting");
+}
+/****************************************************************************************/
+
+static void check_rms_alarm(const simulation_config *config)
+{
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t len = 0;
+	uint32_t window = (uint32_t)ALARM_CHECK_WINDOW_MS * THRESHOLD_EXCEEDED_MONITORING_FREQUENCY /
+			1000;
+	rms_alarm_level level = RMS_ALARM_NORMAL;
+	uint16_t rms = 0;
+
+	/** the spikes of one conversion do not raise the rms of the window to the warning **/
+	sim_adc_generate_spike(DEFAULT_SIGNAL_OFFSET, THRESHOLD_CHECK_SPIKE,
+			THRESHOLD_CHECK_PERIOD);
+	set_alarm(ALARM_CHECK_WARNING, ALARM_CHECK_ALARM);
+	check(!watch_threshold(ALARM_CHECK_WINDOWS * window, data, &len),
+			"no alarm by the single conversion spikes");
+
+	/** the warning is entered and kept within the hysteresis, also during the
+	 * measurement **/
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET, ALARM_CHECK_WARNING * 2, ALARM_CHECK_SIGNAL_PERIOD);
+	bool is_indicated = wait_alarm(&level, &rms);
+	printf("alarm of the sine of %.0f counts rms, level %u, rms %u\n",
+			ALARM_CHECK_WARNING * M_SQRT2, level, rms);
+	check(is_indicated && (RMS_ALARM_WARNING == level) && (rms >= ALARM_CHECK_WARNING),
+			"warning level entered");
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET,
+			(uint16_t)((ALARM_CHECK_WARNING - ALARM_CHECK_HYSTERESIS / 4) * M_SQRT2),
+			ALARM_CHECK_SIGNAL_PERIOD);
+	uint16_t zero_val = 0;
+	check(trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, config, 0, &zero_val) >= 0,
+			"measurement finished during the alarm");
+	check(!watch_threshold(ALARM_CHECK_WINDOWS * window, data, &len),
+			"warning level kept within the hysteresis");
+
+	/** the alarm and the drop to the normal level, the second indication waits for the
+	 * interval **/
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET, ALARM_CHECK_ALARM * 2, ALARM_CHECK_SIGNAL_PERIOD);
+	is_indicated = wait_alarm(&level, &rms);
+	long long alarm_time = esp_timer_get_time();
+	check(is_indicated && (RMS_ALARM_ALARM == level) && (rms >= ALARM_CHECK_ALARM),
+			"alarm level entered");
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET,
+			(uint16_t)((ALARM_CHECK_WARNING - 2 * ALARM_CHECK_HYSTERESIS) * M_SQRT2),
+			ALARM_CHECK_SIGNAL_PERIOD);
+	is_indicated = wait_alarm(&level, &rms);
+	long long interval = esp_timer_get_time() - alarm_time;
+	printf("normal level indicated %lld us after the alarm, rms %u\n", interval, rms);
+	check(is_indicated && (RMS_ALARM_NORMAL == level) &&
+			(rms < ALARM_CHECK_WARNING - ALARM_CHECK_HYSTERESIS), "normal level entered");
+	/** the interval is counted in the ticks, the indications are received with the jitter **/
+	check(interval >= (ALARM_CHECK_INTERVAL_MS - portTICK_PERIOD_MS) * 1000LL,
+			"alarm indications rate limited");
+
+	/** both levels 0 stop the alarm and the conversions between the measurements **/
+	set_alarm(0, 0);
+	sim_adc_generate_sine(DEFAULT_SIGNAL_OFFSET, ALARM_CHECK_ALARM * 2, ALARM_CHECK_SIGNAL_PERIOD);
+	check(!watch_threshold(ALARM_CHECK_WINDOWS * window, data, &len), "alarm stopped");
+	uint64_t count = sim_adc_get_conversion_count();
+	usleep(THRESHOLD_CHECK_STALL_MS * 1000);
+	check(count == sim_adc_get_conversion_count(),
+			"no conversions between the measurements without the monitoring");
+}
+/****************************************************************************************/
+
+static void check_alarm_during_measurement(const simulation_config *config)
+{
+	char path[] = "/tmp/vibration_sensor_burst_XXXXXX";
+	int fd = mkstemp(path);
+	FILE *file = (fd >= 0) ? fdopen(fd, "w") : NULL;
+	if (NULL == file) {
+		check(false, "alarm bursts written");
+		return;
+	}
+	for (uint32_t i = 0; i < ALARM_BURST_PERIOD; ++i) {
+		double value = DEFAULT_SIGNAL_OFFSET;
+		if (i < ALARM_BURST_LEN) {
+			value += ALARM_BURST_AMPLITUDE * sin(2 * M_PI * i / ALARM_BURST_SIGNAL_PERIOD);
+		}
+		fprintf(file, "%u\n", (uint16_t)round(value));
+	}
+	fclose(file);
+	bool is_loaded = sim_adc_load_waveform(path);
+	unlink(path);
+	check(is_loaded, "alarm bursts replayed");
+	if (!is_loaded) {
+		return;
+	}
+
+	/** the level of the bursts lasts a fraction of their period, the conversions are paced
+	 * and read in short blocks, so the task reads it before the next conversions pass it **/
+	const uint32_t read_sizes[] = {ALARM_BURST_READ_SIZE};
+	sim_adc_set_realtime(true);
+	sim_adc_set_dma_read_sizes(read_sizes, 1);
+
+	/** the bursts between the measurements are too short, the measurement stretches them
+	 * to the half of the window **/
+	set_alarm(ALARM_CHECK_WARNING, ALARM_CHECK_ALARM);
+	simulation_config slow = *config;
+	slow.frequency = ALARM_BURST_FREQUENCY;
+	slow.duration = ALARM_BURST_DURATION;
+	slow.decimation = 0;
+	slow.oversampling = 0;
+	write_trigger(MEASUREMENT_TRIGGER_WRITE_VAL, &slow, 0);
+	uint8_t data[FAKE_GATT_MAX_VALUE_LEN];
+	uint16_t handle;
+	uint16_t len;
+	bool is_finished = false;
+	rms_alarm_level level = RMS_ALARM_NORMAL;
+	uint16_t rms = 0;
+	while ((!is_finished || (RMS_ALARM_NORMAL == level)) &&
+			fake_gatt_wait_notification(&handle, data, &len, RESULT_TIMEOUT_MS)) {
+		if ((THRESHOLD_EXCEEDED_HANDLE == handle) && (4 == len) &&
+				(THRESHOLD_ALARM_WRITE_VAL == data[0]) && (RMS_ALARM_NORMAL == level)) {
+			level = (rms_alarm_level)data[1];
+			rms = (uint16_t)(data[2] << 8 | data[3]);
+		} else if ((TRIGGER_MEASUREMENT_HANDLE == handle) && (2 == len)) {
+			is_finished = true;
+		}
+	}
+	printf("bursts of %u of %u conversions at %u Hz, level %u, rms %u\n", ALARM_BURST_LEN,
+			ALARM_BURST_PERIOD, ALARM_BURST_FREQUENCY, level, rms);
+	check(is_finished && (RMS_ALARM_NORMAL != level),
+			"alarm window kept in time during the slower measurement");
+	set_alarm(0, 0);
+	sim_adc_set_dma_read_sizes(NULL, 0);
+	sim_adc_set_realtime(config->is_realtime);
+}
+/****************************************************************************************/
+
+static void check_event_capture(void)
+{
+	/** the recording is written as the text file of the conversions and replayed **/
+	static uint16_t recording[CAPTURE_CHECK_LEN];
+	static uint16_t captured[MEASUREMENT_CAPTURE_PRE_LEN + MEASUREMENT_CAPTURE_POST_LEN + 1];
+	uint32_t impact = CAPTURE_CHECK_LEN / 2;
+	char path[] = "/tmp/vibration_sensor_shock_XXXXXX";
+	int fd = mkstemp(path);
+	FILE *file = (fd >= 0) ? fdopen(fd, "w") : NULL;
+	if (NULL == file) {
+		check(false, "shock recording written");
+		return;
+	}
+	for (uint32_t i = 0; i < CAPTURE_CHECK_LEN; ++i) {
+		double value = DEFAULT_SIGNAL_OFFSET;
+		if (i >= impact) {
+			double t = i - impact;
+			value += THRESHOLD_CHECK_SPIKE * exp(-t / CAPTURE_CHECK_DECAY) *
+					cos(2 * M_PI * t / CAPTURE_CHECK_RING_PERIOD);
+		}
+		recording[i] = (uint16_t)fmin(fmax(round(value), 0), SIM_ADC_MAX_VALUE);
+		fprintf(file, "%u\n", recording[i]);
+	}
+	fclose(file);
+	bool is_loaded = sim_adc_load_waveform(path);
+	unlink(path);
+	check(is_loaded, "shock recording replayed");
+	if (!is_loaded) {
+		return;
+	}
+
+	/** the impact is indicated at once, the capture after the conversions following it **/
+	uint16_t exceeded_value = 0;
+	uint16_t zero_val = 0;
+	set_threshold(THRESHOLD_CHECK_LOW);
+	check(wait_event(&exceeded_value, &zero_val) && (recording[impact] == exceeded_value),
+			"shock indicated and its event capture calculated");
+
+	uint32_t reads = 0;
+	uint32_t count = read_frames(TIME_RESULTS_HANDLE, sizeof(uint16_t), captured,
+			sizeof(captured) / sizeof(captured[0]), &reads);
+	printf("event capture of %u samples, zero value %u\n", count, zero_val);
+	bool is_equal = (MEASUREMENT_CAPTURE_PRE_LEN + MEASUREMENT_CAPTURE_POST_LEN == count);
+	uint16_t max_val = 0;
+	for (uint32_t i = 0; is_equal && (i < count); ++i) {
+		is_equal = (recording[(impact - MEASUREMENT_CAPTURE_PRE_LEN + i) % CAPTURE_CHECK_LEN] ==
+				captured[i]);
+		max_val = (captured[i] > max_val) ? captured[i] : max_val;
+	}
+	check(is_equal, "event capture holds the recording around the shock");
+	calculated_values values;
+	bool is_read = read_calculated_values(&values);
+	printf("calculated max %u, ac rms %.4f g, kurtosis %.2f\n", values.max_val, values.ac_rms,
+			values.kurtosis);
+	check(is_read && (max_val == values.max_val) &&
+			(recording[impact] == values.max_val), "calculated values of the event capture");
+}
+/****************************************************************************************/
+
+static bool dma_check_monitor(uint16_t conversion, uint32_t periods)
+{
+	return false;
+}
+/****************************************************************************************/
+
+static void dma_stream_task(void *pvParameter)
+{
+	uint32_t count = 0;
+	if (measurement_trigger_stream(DMA_CHECK_FREQUENCY,
+			(float)DMA_CHECK_SAMPLES / DMA_CHECK_FREQUENCY)) {
+		uint32_t capacity = sizeof(dma_streamed) / sizeof(dma_streamed[0]);
+		uint32_t read;
+		do {
+			uint32_t block_len = (capacity - count < DMA_CHECK_STREAM_BLOCK_LEN) ?
+					capacity - count : DMA_CHECK_STREAM_BLOCK_LEN;
+			read = measurement_stream_read(dma_streamed + count, block_len);
+			count += read;
+		} while ((count < capacity) &&
+				((0 != read) || (MEASUREMENT_ACTIVE == measurement_get_status())));
+	}
+	dma_streamed_count = count;
+	__atomic_store_n(&is_dma_streamed, true, __ATOMIC_RELEASE);
+	vTaskSuspend(NULL);
+}
+/****************************************************************************************/
+
+static bool is_ramp(const uint16_t samples[], uint32_t count)
+{
+	for (uint32_t i = 1; i < count; ++i) {
+		if (samples[i] != (samples[i - 1] + 1) % DMA_CHECK_RAMP_LEN) {
+			return false;
+		}
+	}
+	return true;
+}
+/****************************************************************************************/
+
+static void wait_conversions_stalled(void)
+{
+	uint64_t count;
+	do {
+		count = sim_adc_get_conversion_count();
+		usleep(THRESHOLD_CHECK_STALL_MS * 1000);
+	} while (count != sim_adc_get_conversion_count());
+}
+/****************************************************************************************/
+
+static void check_dma_hand_off(void)
+{
+	/** the monitoring left set by the client runs on the backend of the build, it is
+	 * stopped before the backend is initialized again under it **/
+	set_threshold(0);
+	wait_conversions_stalled();
+
+	char path[] = "/tmp/vibration_sensor_ramp_XXXXXX";
+	int fd = mkstemp(path);
+	FILE *file = (fd >= 0) ? fdopen(fd, "w") : NULL;
+	if (NULL == file) {
+		check(false, "dma ramp written");
+		return;
+	}
+	for (uint32_t i = 0; i < DMA_CHECK_RAMP_LEN; ++i) {
+		fprintf(file, "%u\n", i);
+	}
+	fclose(file);
+	bool is_loaded = sim_adc_load_waveform(path);
+	unlink(path);
+	check(is_loaded, "dma ramp replayed");
+	if (!is_loaded) {
+		return;
+	}
+	sim_adc_set_noise(0);
+	sim_adc_set_dma_read_sizes(dma_check_read_sizes,
+			sizeof(dma_check_read_sizes) / sizeof(dma_check_read_sizes[0]));
+	measurement_init(DMA_CHECK_CHANNEL, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+			MEASUREMENT_BACKEND_I2S_DMA);
+	measurement_set_monitoring(0, UINT16_MAX, dma_check_monitor,
+			DMA_CHECK_MONITORING_FREQUENCY, NULL);
+
+	/** the buffered measurement ends inside the block and the DMA goes on at the
+	 * monitoring rate **/
+	uint16_t *samples = measurement_trigger(DMA_CHECK_FREQUENCY,
+			(float)DMA_CHECK_SAMPLES / DMA_CHECK_FREQUENCY);
+	long long start = esp_timer_get_time();
+	while ((NULL != samples) && (MEASUREMENT_ACTIVE == measurement_get_status()) &&
+			(esp_timer_get_time() - start < DMA_CHECK_TIMEOUT_MS * 1000LL)) {
+		usleep(1000);
+	}
+	check((NULL != samples) && (MEASUREMENT_FINISHED == measurement_get_status()) &&
+			is_ramp(samples, DMA_CHECK_SAMPLES),
+			"buffered dma samples of the partial reads complete and in order");
+	check(DMA_CHECK_MONITORING_FREQUENCY == sim_adc_get_dma_sample_rate(),
+			"dma back at the monitoring rate after the measurement");
+
+	/** the streamed one passes the same samples through the ring **/
+	xTaskCreate(&dma_stream_task, "dma_stream", 2048, NULL, 5, NULL);
+	start = esp_timer_get_time();
+	while (!__atomic_load_n(&is_dma_streamed, __ATOMIC_ACQUIRE) &&
+			(esp_timer_get_time() - start < DMA_CHECK_TIMEOUT_MS * 1000LL)) {
+		usleep(1000);
+	}
+	printf("dma reads of %u sizes, %u samples buffered, %u streamed\n",
+			(uint32_t)(sizeof(dma_check_read_sizes) / sizeof(dma_check_read_sizes[0])),
+			(NULL != samples) ? DMA_CHECK_SAMPLES : 0, dma_streamed_count);
+	check(is_dma_streamed && (DMA_CHECK_SAMPLES == dma_streamed_count) &&
+			is_ramp(dma_streamed, dma_streamed_count),
+			"streamed dma samples of the partial reads complete and in order");
+
+	/** the backend of the build takes over once the DMA stopped **/
+	measurement_stop_monitoring();
+	wait_conversions_stalled();
+	sim_adc_set_dma_read_sizes(NULL, 0);
+	measurement_init(DMA_CHECK_CHANNEL, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12, ACQUISITION_BACKEND);
+}
+/****************************************************************************************/
+
+static void report_latency(const simulation_config *config)
+{
+	long long min_latency = LLONG_MAX;
+	long long max_latency = 0;
+	long long sum = 0;
+	uint32_t indicated = 0;
+	for (uint32_t i = 0; i < config->latency_cycles; ++i) {
+		uint16_t zero_val = 0;
+		long long latency = trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, config, 0,
+				&zero_val);
+		if (latency < 0) {
+			continue;
+		}
+		min_latency = (latency < min_latency) ? latency : min_latency;
+		max_latency = (latency > max_latency) ? latency : max_latency;
+		sum += latency;
+		++indicated;
+	}
+	if (0 != CONTROLLER_POLL_PERIOD_MS) {
+		printf("main loop polling every %u ms", CONTROLLER_POLL_PERIOD_MS);
+	} else {
+		printf("main loop woken by the events");
+	}
+	printf(", %u of %u measurements of %u samples indicated, trigger to indication "
+			"latency min %lld us, mean %lld us, max %lld us\n", indicated,
+			config->latency_cycles, (uint32_t)(config->frequency * config->duration),
+			(0 != indicated) ? min_latency : 0, (0 != indicated) ? sum / indicated : 0,
+			max_latency);
+	check(indicated == config->latency_cycles, "all latency measurements indicated");
+}
+/****************************************************************************************/
+
+static void check_soak(const simulation_config *config)
+{
+	/** the sizes in samples, none of them fits in the hole left by the previous one **/
+	static const uint16_t sizes[] = {16, 1000, 250, 2000, 64, 500};
+	simulation_config cycle = *config;
+	uint32_t indicated = 0;
+	uint32_t captures = 0;
+	struct mallinfo2 warm_heap = {0};
+	long long start = esp_timer_get_time();
+	sim_adc_generate_spike(DEFAULT_SIGNAL_OFFSET, THRESHOLD_CHECK_SPIKE, THRESHOLD_CHECK_PERIOD);
+	for (uint32_t i = 0; i < config->soak_cycles; ++i) {
+		uint16_t exceeded_value = 0;
+		uint16_t zero_val = 0;
+		bool is_indicated;
+		if (SOAK_CAPTURE_INTERVAL - 1 == i % SOAK_CAPTURE_INTERVAL) {
+			set_threshold(THRESHOLD_CHECK_LOW);
+			is_indicated = wait_event(&exceeded_value, &zero_val);
+			captures++;
+		} else {
+			cycle.duration = (float)sizes[i % (sizeof(sizes) / sizeof(sizes[0]))] /
+					config->frequency;
+			is_indicated = trigger_measurement(MEASUREMENT_TRIGGER_WRITE_VAL, &cycle, 0,
+					&zero_val) >= 0;
+		}
+		indicated += is_indicated ? 1 : 0;
+		if (SOAK_WARM_UP_CYCLES - 1 == i) {
+			warm_heap = mallinfo2();
+		}
+		if (0 == (i + 1) % SOAK_PROGRESS_CYCLES) {
+			struct mallinfo2 heap = mallinfo2();
+			printf("soak cycle %u, heap of %zu bytes, %zu in use\n", i + 1, heap.arena,
+					heap.uordblks);
+		}
+	}
+	struct mallinfo2 heap = mallinfo2();
+	printf("soak of %u cycles, %u captures, %lld us\n", config->soak_cycles, captures,
+			esp_timer_get_time() - start);
+	printf("heap of %zu bytes, %zu in use after the warm up, %zu and %zu at the end, "
+			"arena peak %u of %u bytes\n", warm_heap.arena, warm_heap.uordblks, heap.arena,
+			heap.uordblks, measurement_get_arena_peak(), MEASUREMENT_ARENA_SIZE);
+	check(indicated == config->soak_cycles, "all soak cycles indicated");
+	check((config->soak_cycles <= SOAK_WARM_UP_CYCLES) ||
+			((heap.arena <= warm_heap.arena) && (heap.uordblks <= warm_heap.uordblks)),
+			"heap not grown by the soak cycles");
+	check(measurement_get_arena_peak() <= MEASUREMENT_ARENA_SIZE, "arena peak within its size");
+}
+/****************************************************************************************/
+
+static bool read_calculated_values(calculated_values *values)
+{
+	static const uint16_t handles[] = {RMS_VALUE_HANDLE, AVERAGE_VALUE_HANDLE,
+			MAX_VALUE_HANDLE, MIN_VALUE_HANDLE, AMPLITUDE_VALUE_HANDLE,
+			CREST_FACTOR_VALUE_HANDLE, AC_RMS_VALUE_HANDLE, PEAK_VALUE_HANDLE,
+			PEAK_TO_PEAK_VALUE_HANDLE, AC_CREST_FACTOR_VALUE_HANDLE, VELOCITY_RMS_VALUE_HANDLE,
+			DISPLACEMENT_PEAK_TO_PEAK_VALUE_HANDLE, SKEWNESS_VALUE_HANDLE,
+			KURTOSIS_VALUE_HANDLE};
+	uint8_t raw[sizeof(handles) / sizeof(handles[0])][ESP_GATT_MAX_ATTR_LEN];
+	for (uint8_t i = 0; i < sizeof(handles) / sizeof(handles[0]); ++i) {
+		uint16_t len = 0;
+		if ((ESP_GATT_OK != fake_gatt_read(handles[i], raw[i], &len)) || (sizeof(float) != len)) {
+			return false;
+		}
+	}
+	/** the integer values are sent in the low bytes of the float sized characteristic **/
+	memcpy(&values->rms, raw[0], sizeof(float));
+	memcpy(&values->average, raw[1], sizeof(float));
+	values->max_val = (uint16_t)(raw[2][0] | raw[2][1] << 8);
+	values->min_val = (uint16_t)(raw[3][0] | raw[3][1] << 8);
+	values->amplitude = (uint16_t)(raw[4][0] | raw[4][1] << 8);
+	memcpy(&values->crest_factor, raw[5], sizeof(float));
+	memcpy(&values->ac_rms, raw[6], sizeof(float));
+	memcpy(&values->peak, raw[7], sizeof(float));
+	memcpy(&values->peak_to_peak, raw[8], sizeof(float));
+	memcpy(&values->ac_crest_factor, raw[9], sizeof(float));
+	memcpy(&values->velocity_rms, raw[10], sizeof(float));
+	memcpy(&values->displacement_peak_to_peak, raw[11], sizeof(float));
+	memcpy(&values->skewness, raw[12], sizeof(float));
+	memcpy(&values->kurtosis, raw[13], sizeof(float));
+	return true;
+}
+/****************************************************************************************/
+
+static bool read_envelope_peaks(envelope_peak peaks[])
+{
+	uint8_t raw[ESP_GATT_MAX_ATTR_LEN];
+	uint16_t len = 0;
+	if ((ESP_GATT_OK != fake_gatt_read(ENVELOPE_PEAKS_HANDLE, raw, &len)) ||
+			(BLE_ENVELOPE_PEAK_COUNT * 2 * sizeof(uint16_t) != len)) {
+		return false;
+	}
+	for (uint8_t i = 0; i < BLE_ENVELOPE_PEAK_COUNT; ++i) {
+		const uint8_t *peak = raw + i * 2 * sizeof(uint16_t);
+		peaks[i].frequency = (uint16_t)(peak[0] | peak[1] << 8) * BLE_ENVELOPE_FREQUENCY_UNIT;
+		peaks[i].amplitude = (uint16_t)(peak[2] | peak[3] << 8) * BLE_ENVELOPE_AMPLITUDE_UNIT;
+	}
+	return true;
+}
+/****************************************************************************************/
+
+static esp_gatt_status_t write_band_table(const uint16_t edges[], uint8_t count)
+{
+	uint8_t value[BLE_BAND_MAX * 2 * sizeof(uint16_t)];
+	for (uint8_t i = 0; i < 2 * count; ++i) {
+		value[2*i] = (uint8_t)edges[i];
+		value[2*i + 1] = (uint8_t)(edges[i] >> 8);
+	}
+	return fake_gatt_write(BAND_TABLE_HANDLE, value, 2 * count * sizeof(uint16_t), true);
+}
+/****************************************************************************************/
+
+static uint8_t read_band_table(uint16_t edges[])
+{
+	uint8_t raw[ESP_GATT_MAX_ATTR_LEN];
+	uint16_t len = 0;
+	if ((ESP_GATT_OK != fake_gatt_read(BAND_TABLE_HANDLE, raw, &len)) ||
+			(0 != len % (2 * sizeof(uint16_t))) || (len > BLE_BAND_MAX * 2 * sizeof(uint16_t))) {
+		return 0;
+	}
+	for (uint16_t i = 0; i < len / sizeof(uint16_t); ++i) {
+		edges[i] = (uint16_t)(raw[2*i] | raw[2*i + 1] << 8);
+	}
+	return (uint8_t)(len / (2 * sizeof(uint16_t)));
+}
+/****************************************************************************************/
+
+static uint8_t read_band_rms(double rms[])
+{
+	uint8_t raw[ESP_GATT_MAX_ATTR_LEN];
+	uint16_t len = 0;
+	if ((ESP_GATT_OK != fake_gatt_read(BAND_RMS_HANDLE, raw, &len)) ||
+			(0 != len % sizeof(uint16_t)) || (len > BLE_BAND_MAX * sizeof(uint16_t))) {
+		return 0;
+	}
+	for (uint16_t i = 0; i < len / sizeof(uint16_t); ++i) {
+		rms[i] = (uint16_t)(raw[2*i] | raw[2*i + 1] << 8) * BLE_BAND_RMS_UNIT;
+	}
+	return (uint8_t)(len / sizeof(uint16_t));
+}
+/****************************************************************************************/
+
+static uint32_t power_spectrum(const uint16_t samples[], uint32_t count, double power[])
+{
+	uint32_t fft_size = SPECTRUM_MAX_FFT_SIZE;
+	while ((fft_size >= 4) && (fft_size > count)) {
+		fft_size >>= 1;
+	}
+	if (fft_size < 4) {
+		return 0;
+	}
+
+	/** the rotation of the bin is stepped by the index modulo the transform size, so the
+	 * phase stays exact for the long transforms and is taken from the table **/
+	static double table_cos[SPECTRUM_MAX_FFT_SIZE];
+	static double table_sin[SPECTRUM_MAX_FFT_SIZE];
+	static double windowed[SPECTRUM_MAX_FFT_SIZE];
+	double window_power = 0;
+	for (uint32_t n = 0; n < fft_size; ++n) {
+		double window = 0.5 - 0.5 * cos(2 * M_PI * n / fft_size);
+		window_power += window * window;
+		table_cos[n] = cos(2 * M_PI * n / fft_size);
+		table_sin[n] = sin(2 * M_PI * n / fft_size);
+	}
+	for (uint32_t k = 0; k <= fft_size / 2; ++k) {
+		power[k] = 0;
+	}
+
+	uint32_t step = fft_size - (fft_size * BAND_SEGMENT_OVERLAP) / 100;
+	uint32_t segments = 0;
+	for (uint32_t start = 0; start + fft_size <= count; start += step, ++segments) {
+		double mean = 0;
+		for (uint32_t n = 0; n < fft_size; ++n) {
+			mean += samples[start + n];
+		}
+		mean /= fft_size;
+		for (uint32_t n = 0; n < fft_size; ++n) {
+			windowed[n] = (samples[start + n] - mean) * (0.5 - 0.5 * table_cos[n]);
+		}
+		for (uint32_t k = 0; k <= fft_size / 2; ++k) {
+			double re = 0;
+			double im = 0;
+			uint32_t index = 0;
+			for (uint32_t n = 0; n < fft_size; ++n) {
+				re += windowed[n] * table_cos[index];
+				im -= windowed[n] * table_sin[index];
+				index = (index + k) % fft_size;
+			}
+			power[k] += (re * re + im * im) / (fft_size * window_power) *
+					(((0 == k) || (fft_size / 2 == k)) ? 1 : 2);
+		}
+	}
+	for (uint32_t k = 0; k <= fft_size / 2; ++k) {
+		power[k] /= segments;
+	}
+	return fft_size;
+}
+/****************************************************************************************/
+
+static double band_rms(const double power[], uint32_t fft_size, uint16_t frequency,
+				uint16_t low, uint16_t high, double sensitivity)
+{
+	double resolution = (double)frequency / fft_size;
+	double sum = 0;
+	for (uint32_t k = 0; k <= fft_size / 2; ++k) {
+		if ((k * resolution >= low) && (k * resolution < high)) {
+			sum += power[k];
+		}
+	}
+	return sqrt(sum) * sensitivity;
+}
+/****************************************************************************************/
+
+static double envelope_resolution(const simulation_config *config)
+{
+	uint32_t count = (uint32_t)(config->frequency * config->duration);
+	uint32_t decimated = (count > ENVELOPE_SETTLING_SAMPLES) ?
+			(count - ENVELOPE_SETTLING_SAMPLES) / ENVELOPE_DECIMATION : 0;
+	uint32_t fft_size = ENVELOPE_SEGMENT_SIZE;
+	while ((fft_size > 1) && (fft_size > decimated)) {
+		fft_size >>= 1;
+	}
+	return (double)config->frequency / ENVELOPE_DECIMATION / fft_size;
+}
+/****************************************************************************************/
+
+static bool has_peak_at(const envelope_peak peaks[], uint8_t count, double frequency,
+				double tolerance)
+{
+	for (uint8_t i = 0; i < count; ++i) {
+		if ((0 != peaks[i].amplitude) && (fabs(peaks[i].frequency - frequency) <= tolerance)) {
+			return true;
+		}
+	}
+	return false;
+}
+/****************************************************************************************/
+
+static uint32_t read_frames(uint16_t handle, uint8_t element_size, void *result,
+				uint32_t max_count, uint32_t *reads)
+{
+	uint8_t frame[ESP_GATT_MAX_ATTR_LEN];
+	uint32_t count = 0;
+	result_frame_header header = {.control = RESULT_FRAME_FIRST};
+	*reads = 0;
+	while (RESULT_FRAME_NO_MORE != header.control) {
+		uint16_t len = 0;
+		if (ESP_GATT_OK != fake_gatt_read(handle, frame, &len)) {
+			break;
+		}
+		++*reads;
+		const uint8_t *payload = result_frame_decode(frame, len, element_size, &header);
+		if ((NULL == payload) || (header.offset != count) ||
+				(header.offset + header.count > max_count)) {
+			break;
+		}
+		memcpy((uint8_t *)result + header.offset * element_size, payload,
+				header.count * element_size);
+		count += header.count;
+	}
+	return count;
+}
+/****************************************************************************************/
+
+static uint32_t receive_stream(uint16_t samples[], uint32_t max_count, bool is_compressed,
+				uint32_t *payload_bytes, uint32_t *frames)
+{
+	uint8_t encoding = is_compressed ? STREAM_ENCODING_COMPRESSED_WRITE_VAL :
+			STREAM_ENCODING_RAW_WRITE_VAL;
+	uint8_t subscribe[] = {0x01, 0x00};
+	uint8_t unsubscribe[] = {0x00, 0x00};
+	uint8_t frame[FAKE_GATT_MAX_VALUE_LEN];
+	uint32_t count = 0;
+	*payload_bytes = 0;
+	*frames = 0;
+
+	fake_gatt_write(TIME_RESULTS_STREAM_HANDLE, &encoding, sizeof(encoding), true);
+	fake_gatt_write(TIME_RESULTS_STREAM_CCC_HANDLE, subscribe, sizeof(subscribe), true);
+	result_frame_header header = {.control = RESULT_FRAME_FIRST};
+	while (RESULT_FRAME_NO_MORE != header.control) {
+		uint16_t handle;
+		uint16_t len;
+		if (!fake_gatt_wait_notification(&handle, frame, &len, FRAME_TIMEOUT_MS)) {
+			break;
+		}
+		if (TIME_RESULTS_STREAM_HANDLE != handle) {
+			continue;
+		}
+		*payload_bytes += len;
+		++*frames;
+		const uint8_t *payload = result_frame_decode(frame, len, sizeof(uint16_t), &header);
+		if ((NULL == payload) || (is_compressed != header.is_compressed) ||
+				(header.offset != count) || (header.offset + header.count > max_count)) {
+			break;
+		}
+		if (is_compressed) {
+			uint16_t zero_val = (uint16_t)(payload[0] | payload[1] << 8);
+			if (!sample_codec_decode(payload + RESULT_FRAME_ZERO_VAL_LEN,
+					len - RESULT_FRAME_HEADER_LEN - RESULT_FRAME_ZERO_VAL_LEN, header.count,
+					zero_val, samples + header.offset)) {
+				break;
+			}
+		} else {
+			for (uint16_t i = 0; i < header.count; ++i) {
+				samples[header.offset + i] = (uint16_t)(payload[2*i] | payload[2*i + 1] << 8);
+			}
+		}
+		count += header.count;
+	}
+	fake_gatt_write(TIME_RESULTS_STREAM_CCC_HANDLE, unsubscribe, sizeof(unsubscribe), true);
+	return count;
+}
+/****************************************************************************************/
+
+static void check(bool condition, const char *description)
+{
+	if (!condition) {
+		++failures;
+	}
+	printf("%s: %s\n", condition ? "ok" : "FAILED", description);
+}
+/****************************************************************************************/
+
+static bool is_close(double value, double expected, double tolerance)
+{
+	return fabs(value - expected) <= tolerance * fmax(fabs(expected), 1.0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//End of file																			//
+//////////////////////////////////////////////////////////////////////////////////////////
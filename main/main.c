@@ -9,6 +9,8 @@
 #include "esp_system.h"
 #include "esp_event.h"
 #include "esp_event_loop.h"
+#include "esp_log.h"
+#include "esp_timer.h"
 #include "nvs_flash.h"
 
 /** application includes */
@@ -17,12 +19,20 @@
 #include "../components/threshold_exceeded_notification/threshold_exceeded_notification.h"
 #include "../components/measurement/measurement.h"
 #include "../components/calculation/calculation.h"
+#include "../components/calculation/spectrum.h"
 #include "task_controller.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #define ACCELEROMETER_ADC_CHANNEL	(ADC1_CHANNEL_7)
+#ifndef ACQUISITION_BACKEND
+#define ACQUISITION_BACKEND			(MEASUREMENT_BACKEND_TIMER)
+#endif
+#ifndef ACCELEROMETER_SENSITIVITY
+#define ACCELEROMETER_SENSITIVITY	(CALCULATION_DEFAULT_SENSITIVITY)
+#endif
+#define CONTROLLER_TAG				"CONTROLLER"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Local typedefs																		//
@@ -44,6 +54,19 @@ This function calls the init functions.
 \****************************************************************************************/
 void entry_initialization(void);
 
+/****************************************************************************************\
+Function:
+get_band_config
+******************************************************************************************
+Parameters:
+calculation_band_config *config - destination of the bands
+******************************************************************************************
+Abstract:
+This function fills the band configuration of the calculation from the requested band
+table, limited to CALCULATION_MAX_BANDS bands.
+\****************************************************************************************/
+static void get_band_config(calculation_band_config *config);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -59,62 +82,228 @@ void app_main(){
 
 	/** local task variables **/
 	uint16_t * measurement_ptr = NULL;
-	uint16_t no_of_samples = 0;
+	uint32_t no_of_samples = 0;
 	Calculation_obj_handle obj = NULL;
+	int64_t trigger_timestamp = 0;
 
-	/** main loop **/
+	/** main loop, woken up by the events posted by the modules **/
 	while (true) {
-		if (ble_communication_is_threshold_exceed_monitoring_requested()) {
+#if CONTROLLER_POLL_PERIOD_MS
+		vTaskDelay(CONTROLLER_POLL_PERIOD_MS / portTICK_PERIOD_MS);
+		EventBits_t events = xEventGroupClearBits(get_event_group_handle(),
+				ALL_CONTROLLER_EVENTS);
+#else
+		EventBits_t events = xEventGroupWaitBits(get_event_group_handle(),
+				ALL_CONTROLLER_EVENTS, pdTRUE, pdFALSE, portMAX_DELAY);
+#endif
+
+		if ((events & THRESHOLD_MONITORING_REQUESTED_EVENT)
+				&& ble_communication_is_threshold_exceed_monitoring_requested()) {
 			/** threshold exceeded monitoring control **/
-			vTaskSuspend(get_task_handle(THRESHOLD_EXCEEDED_TASK_HANDLE));
-			threshold_exceeded_set_threshold(
-					ble_communication_get_threshold_exceed_monitoring_val());
-			vTaskResume(get_task_handle(THRESHOLD_EXCEEDED_TASK_HANDLE));
+			if (ble_communication_is_threshold_alarm_requested()) {
+				threshold_alarm_config alarm_config;
+				ble_communication_get_threshold_alarm_config(&alarm_config);
+				if (!threshold_exceeded_set_alarm(&alarm_config)) {
+					ESP_LOGE(CONTROLLER_TAG, "Alarm configuration not supported");
+				}
+			} else {
+				threshold_exceeded_set_threshold(
+						ble_communication_get_threshold_exceed_monitoring_val());
+			}
 			ble_communication_threshold_exceeded_monitoring_handled();
 		}
 
-		if (ble_communication_is_measurement_requested()) {
+		if ((events & MEASUREMENT_REQUESTED_EVENT)
+				&& ble_communication_is_measurement_requested()
+				&& (MEASUREMENT_ACTIVE != measurement_get_status())
+				&& (CALCULATION_IN_PROGRESS != calculation_get_state(obj))) {
 			/** prepare local variables **/
-			free(measurement_ptr);
+			trigger_timestamp = esp_timer_get_time();
+			calculation_delete_obj(&obj);
+			ble_communication_update_time_measured_data(NULL, 0, 0);
+			ble_communication_update_fft_data(NULL, 0);
 			measurement_ptr = NULL;
 			no_of_samples = 0;
 
+			/** the request is taken before any indication, so the next one written by the
+			 * client after the indication is not cleared with it **/
+			calculation_psd_config psd_config = {
+				.segment_size = ble_communication_get_requested_segment_size(),
+				.overlap = ble_communication_get_requested_segment_overlap(),
+				.window = ble_communication_get_requested_segment_window(),
+				.frequency = ble_communication_get_requested_measurement_frequency()
+			};
+			float duration = ble_communication_get_requested_measurement_duration();
+			bool is_stream = ble_communication_is_stream_measurement_requested();
+			uint8_t decimation = ble_communication_get_requested_decimation();
+			uint8_t oversampling = ble_communication_get_requested_oversampling();
+			ble_communication_measurement_request_handled();
+
 			/** measurement trigger **/
-			measurement_ptr = measurement_trigger(
-					ble_communication_get_requested_measurement_frequency(),
-					ble_communication_get_requested_measurement_duration());
-			no_of_samples = measurement_get_size();
+			calculation_band_config band_config;
+			get_band_config(&band_config);
+			bool is_sampler_set = measurement_set_decimation(decimation) &&
+					measurement_set_oversampling(oversampling);
+			/** the oversampled samples are wider than the adc counts **/
+			calculation_set_sensitivity(ACCELEROMETER_SENSITIVITY /
+					measurement_get_sample_scale());
+			spectrum_set_sample_scale(measurement_get_sample_scale());
+			if (!is_sampler_set) {
+				ESP_LOGE(CONTROLLER_TAG, "Decimation by %u with oversampling by %u not "
+						"supported", decimation, oversampling);
+				ble_communication_measurement_failed_notification_send(
+						BLE_MEASUREMENT_ERROR_NOT_SUPPORTED);
+			} else if (is_stream) {
+				obj = calculation_new_stream_obj(measurement_stream_read);
+				if (NULL != obj) {
+					calculation_set_psd_config(obj, &psd_config);
+					calculation_set_band_config(obj, &band_config);
+					calculation_set_frequency(obj, psd_config.frequency);
+				}
+				if (NULL != obj &&
+						measurement_trigger_stream(psd_config.frequency, duration)) {
+					/** stream is consumed by the calculation during the capture **/
+					calculation_calculate_factors(obj);
+				} else {
+					ESP_LOGE(CONTROLLER_TAG, "Stream measurement trigger failed");
+					ble_communication_measurement_failed_notification_send((NULL == obj) ?
+							BLE_MEASUREMENT_ERROR_NO_MEMORY :
+							BLE_MEASUREMENT_ERROR_NOT_SUPPORTED);
+					calculation_delete_obj(&obj);
+				}
+			} else {
+				measurement_ptr = measurement_trigger(psd_config.frequency, duration);
+				/** the size is the one of the last measurement when none was started **/
+				if (NULL != measurement_ptr) {
+					no_of_samples = measurement_get_size();
+					obj = calculation_new_obj(measurement_ptr, no_of_samples);
+				}
+				if (NULL == measurement_ptr || NULL == obj) {
+					ESP_LOGE(CONTROLLER_TAG, "Measurement trigger failed");
+					ble_communication_measurement_failed_notification_send(
+							(NULL == measurement_ptr) ? BLE_MEASUREMENT_ERROR_NOT_SUPPORTED :
+							BLE_MEASUREMENT_ERROR_NO_MEMORY);
+					calculation_delete_obj(&obj);
+					measurement_ptr = NULL;
+					no_of_samples = 0;
+				} else {
+					calculation_set_psd_config(obj, &psd_config);
+					calculation_set_band_config(obj, &band_config);
+					calculation_set_frequency(obj, psd_config.frequency);
+				}
+			}
+		}
+
+		if ((events & CAPTURE_FINISHED_EVENT)
+				&& measurement_is_capture_ready()
+				&& (MEASUREMENT_ACTIVE != measurement_get_status())
+				&& (CALCULATION_IN_PROGRESS != calculation_get_state(obj))) {
+			/** event capture analysis, its results replace the ones of the measurement **/
+			trigger_timestamp = esp_timer_get_time();
+			calculation_delete_obj(&obj);
+			ble_communication_update_time_measured_data(NULL, 0, 0);
+			ble_communication_update_fft_data(NULL, 0);
+			uint32_t pre_count = 0;
+			measurement_ptr = measurement_read_capture(&no_of_samples, &pre_count);
+
+			/** the capture holds the raw conversions **/
+			measurement_set_oversampling(0);
+			calculation_set_sensitivity(ACCELEROMETER_SENSITIVITY);
+			spectrum_set_sample_scale(1);
 			obj = calculation_new_obj(measurement_ptr, no_of_samples);
-			if (NULL != measurement_ptr && NULL != obj) {
-				ble_communication_measurement_request_handled();
+			if (0 == no_of_samples || NULL == obj) {
+				ESP_LOGE(CONTROLLER_TAG, "Event capture analysis failed");
+				calculation_delete_obj(&obj);
+			} else {
+				calculation_band_config band_config;
+				get_band_config(&band_config);
+				calculation_set_band_config(obj, &band_config);
+				calculation_set_frequency(obj, measurement_get_capture_frequency());
+				ESP_LOGI(CONTROLLER_TAG, "Event captured, %u samples at %u Hz, %u before "
+						"the event", no_of_samples, measurement_get_capture_frequency(),
+						pre_count);
+				calculation_calculate_factors(obj);
 			}
-		} else if ((MEASUREMENT_FINISHED == measurement_get_status())
+		}
+
+		if ((events & MEASUREMENT_FINISHED_EVENT)
+				&& (MEASUREMENT_FINISHED == measurement_get_status())
 				&& (CALCULATION_INITIALIZED == calculation_get_state(obj))) {
 			/** calculation trigger **/
+			ESP_LOGI(CONTROLLER_TAG, "Measurement finished after %lld us",
+					esp_timer_get_time() - trigger_timestamp);
 			calculation_calculate_factors(obj);
-		} else if ((MEASUREMENT_FINISHED == measurement_get_status())
+		}
+
+		if ((events & CALCULATION_FINISHED_EVENT)
 				&& (CALCULATION_FINISHED == calculation_get_state(obj))) {
 			/** results update **/
+			ESP_LOGI(CONTROLLER_TAG, "Calculation of %u samples finished after %lld us, "
+					"%u samples lost", calculation_get_size(obj),
+					esp_timer_get_time() - trigger_timestamp,
+					measurement_get_lost_samples());
+			ESP_LOGD(CONTROLLER_TAG, "Calculation task stack high water mark %u bytes",
+					uxTaskGetStackHighWaterMark(get_task_handle(CALCULATION_TASK_HANDLE)));
 			ble_communication_update_time_measured_data(measurement_ptr,
-					no_of_samples);
+					no_of_samples, measurement_get_zero_val());
+			ble_communication_update_fft_data(spectrum_get_magnitude_ptr(),
+					spectrum_get_bin_count());
 			ble_communication_update_calculated_value(RMS_VALUE,
-					(calculation_get_factor(obj, CALCULATION_RMS).float_type));
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj, CALCULATION_RMS)));
 			ble_communication_update_calculated_value(AVERAGE_VALUE,
-					calculation_get_factor(obj, CALCULATION_AVERAGE).float_type);
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj, CALCULATION_AVERAGE)));
 			ble_communication_update_calculated_value(MIN_VALUE,
 					calculation_get_factor(obj, CALCULATION_MINVAL).float_type);
 			ble_communication_update_calculated_value(MAX_VALUE,
 					calculation_get_factor(obj, CALCULATION_MAXVAL).float_type);
 			ble_communication_update_calculated_value(CREST_FACTOR_VALUE,
-					calculation_get_factor(obj, CALCULATION_CREST_FACTOR).float_type);
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_CREST_FACTOR)));
 			ble_communication_update_calculated_value(AMPLITUDE_VALUE,
 					calculation_get_factor(obj, CALCULATION_AMPLITUDE).float_type);
+			ble_communication_update_calculated_value(AC_RMS_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj, CALCULATION_AC_RMS)));
+			ble_communication_update_calculated_value(PEAK_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj, CALCULATION_PEAK)));
+			ble_communication_update_calculated_value(PEAK_TO_PEAK_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_PEAK_TO_PEAK)));
+			ble_communication_update_calculated_value(AC_CREST_FACTOR_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_AC_CREST_FACTOR)));
+			ble_communication_update_calculated_value(VELOCITY_RMS_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_VELOCITY_RMS)));
+			ble_communication_update_calculated_value(DISPLACEMENT_PEAK_TO_PEAK_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_DISPLACEMENT_PEAK_TO_PEAK)));
+			ble_communication_update_calculated_value(SKEWNESS_VALUE,
+					CALCULATION_SIGNED_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_SKEWNESS)));
+			ble_communication_update_calculated_value(KURTOSIS_VALUE,
+					CALCULATION_FACTOR_TO_FLOAT(calculation_get_factor(obj,
+							CALCULATION_KURTOSIS)));
+			const envelope_peak *peaks = calculation_get_envelope_peaks(obj);
+			for (uint8_t i = 0; i < ENVELOPE_PEAK_COUNT; ++i) {
+				ble_communication_update_envelope_peak(i, peaks[i].frequency,
+						peaks[i].amplitude);
+			}
+			ble_communication_update_band_rms(calculation_get_band_rms(obj),
+					calculation_get_band_count(obj));
 
 			calculation_delete_obj(&obj);
 			ble_communication_calculation_completed_notification_send(measurement_get_zero_val());
-		}
+			ESP_LOGI(CONTROLLER_TAG, "Trigger to indication latency %lld us",
+					esp_timer_get_time() - trigger_timestamp);
 
-		vTaskDelay(500 / portTICK_PERIOD_MS);
+			/** request received during the previous cycle is handled now **/
+			if (ble_communication_is_measurement_requested()) {
+				controller_event_post(MEASUREMENT_REQUESTED_EVENT);
+			}
+			if (measurement_is_capture_ready()) {
+				controller_event_post(CAPTURE_FINISHED_EVENT);
+			}
+		}
 	}
 }
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -123,12 +312,29 @@ void app_main(){
 
 void entry_initialization(void)
 {
+	entry_event_group_creator();
 	nvs_flash_init();
 	heartbeat_init();
 	ble_communication_init();
-	measurement_init(ACCELEROMETER_ADC_CHANNEL, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12);
+	measurement_init(ACCELEROMETER_ADC_CHANNEL, ADC_ATTEN_DB_11, ADC_WIDTH_BIT_12,
+			ACQUISITION_BACKEND);
+	calculation_init();
+	calculation_set_sensitivity(ACCELEROMETER_SENSITIVITY);
 	threshold_exceeded_init(measurement_get_zero_val());
 }
+/****************************************************************************************/
+
+static void get_band_config(calculation_band_config *config)
+{
+	/** the table is copied at once, the client may write the next one meanwhile **/
+	uint16_t low[CALCULATION_MAX_BANDS];
+	uint16_t high[CALCULATION_MAX_BANDS];
+	config->count = ble_communication_get_bands(low, high, CALCULATION_MAX_BANDS);
+	for (uint8_t i = 0; i < config->count; ++i) {
+		config->bands[i].low = low[i];
+		config->bands[i].high = high[i];
+	}
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file																			//
@@ -10,6 +10,8 @@
 #include "../components/heartbeat/heartbeat.h"
 #include "../components/threshold_exceeded_notification/threshold_exceeded_notification.h"
 #include "../components/calculation/calculation.h"
+#include "../components/measurement/measurement.h"
+#include "../components/ble_communication/ble_communication.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
@@ -26,6 +28,9 @@
 /** array conatining the handles to each created task **/
 static TaskHandle_t task_handle_array[TASK_HANDLE_SIZE] = { NULL };
 
+/** event group used by the modules to wake up the controller **/
+static EventGroupHandle_t controller_event_group = NULL;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static functions prototypes															//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -34,22 +39,24 @@ static TaskHandle_t task_handle_array[TASK_HANDLE_SIZE] = { NULL };
 //Global functions definitions															//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+void entry_event_group_creator(void)
+{
+	controller_event_group = xEventGroupCreate();
+}
+/****************************************************************************************/
+
 void entry_task_creator(void)
 {
 	xTaskCreate(&heartbeat_task, "heartbeat_task", configMINIMAL_STACK_SIZE, NULL,
 				   	5, &(task_handle_array[HEARTBEAT_TASK_HANDLE]));
 	xTaskCreate(&threshold_exceeded_task, "threshold_exceeded_task", 2048, NULL,
 				   	5, &(task_handle_array[THRESHOLD_EXCEEDED_TASK_HANDLE]));
-	xTaskCreate(&calculation_rms, "calculation_rms_task", 2048, NULL, 5,
-				   	&(task_handle_array[CALCULATION_RMS_TASK_HANDLE]));
-	xTaskCreate(&calculation_average, "calculation_average_task", 2048, NULL,
-				   	5, &(task_handle_array[CALCULATION_AVERAGE_TASK_HANDLE]));
-	xTaskCreate(&calculation_range, "calculation_range_task", 2048, NULL,
-				   	5, &(task_handle_array[CALCULATION_RANGE_TASK_HANDLE]));
-	xTaskCreate(&calculation_amplitude, "calculation_amplitude_task", 2048, NULL,
-				   	5, &(task_handle_array[CALCULATION_AMPLITUDE_TASK_HANDLE]));
-	xTaskCreate(&calculation_crest_factor, "calculation_crest_factor_task", 2048, NULL,
-				   	5, &(task_handle_array[CALCULATION_CREST_FACTOR_TASK_HANDLE]));
+	xTaskCreate(&calculation_task, "calculation_task", CALCULATION_TASK_STACK_SIZE,
+				   	NULL, 5, &(task_handle_array[CALCULATION_TASK_HANDLE]));
+	xTaskCreate(&measurement_dma_task, "measurement_dma_task", 2048, NULL, 6,
+				   	&(task_handle_array[MEASUREMENT_DMA_TASK_HANDLE]));
+	xTaskCreate(&ble_communication_stream_task, "ble_stream_task", 2048, NULL, 5,
+				   	&(task_handle_array[BLE_STREAM_TASK_HANDLE]));
 }
 /****************************************************************************************/
 
@@ -57,6 +64,33 @@ TaskHandle_t get_task_handle(task_handle task_hnd)
 {
 	return task_handle_array[task_hnd];
 }
+/****************************************************************************************/
+
+EventGroupHandle_t get_event_group_handle(void)
+{
+	return controller_event_group;
+}
+/****************************************************************************************/
+
+void controller_event_post(controller_event event)
+{
+	if (NULL != controller_event_group) {
+		xEventGroupSetBits(controller_event_group, event);
+	}
+}
+/****************************************************************************************/
+
+void IRAM_ATTR controller_event_post_from_isr(controller_event event)
+{
+	BaseType_t higher_priority_task_woken = pdFALSE;
+	if (NULL != controller_event_group) {
+		xEventGroupSetBitsFromISR(controller_event_group, event,
+						&higher_priority_task_woken);
+	}
+	if (pdTRUE == higher_priority_task_woken) {
+		portYIELD_FROM_ISR();
+	}
+}
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Static functions definitions															//
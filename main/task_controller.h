@@ -7,11 +7,25 @@
 //Includes																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 #include "esp_event_loop.h"
+#include "freertos/event_groups.h"
 
 //////////////////////////////////////////////////////////////////////////////////////////
 //Macros																				//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+/** stack of the calculation task in bytes. The deepest path, the factors with the welch
+ * psd, the envelope and the band rms, used 3512 bytes measured by
+ * uxTaskGetStackHighWaterMark in the host simulator, the rest is the margin for the
+ * frames of the target and the context saved by the interrupts **/
+#define CALCULATION_TASK_STACK_SIZE		(6144)
+
+/** period of the main loop polling the events in ms, as the former loop did every 500 ms,
+ * 0 for the loop woken by each event. The polling one is kept to compare the latency of
+ * both in the host simulator **/
+#ifndef CONTROLLER_POLL_PERIOD_MS
+#define CONTROLLER_POLL_PERIOD_MS		(0)
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global typedefs																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -20,14 +34,22 @@
 typedef enum{
 	HEARTBEAT_TASK_HANDLE = 0,
 	THRESHOLD_EXCEEDED_TASK_HANDLE = 1,
-	CALCULATION_RMS_TASK_HANDLE = 2,
-	CALCULATION_AVERAGE_TASK_HANDLE = 3,
-	CALCULATION_RANGE_TASK_HANDLE = 4,
-	CALCULATION_AMPLITUDE_TASK_HANDLE = 5,
-	CALCULATION_CREST_FACTOR_TASK_HANDLE = 6,
-	TASK_HANDLE_SIZE = 7
+	CALCULATION_TASK_HANDLE = 2,
+	MEASUREMENT_DMA_TASK_HANDLE = 3,
+	BLE_STREAM_TASK_HANDLE = 4,
+	TASK_HANDLE_SIZE = 5
 } task_handle;
 
+/** enum defining bits of the controller event group **/
+typedef enum{
+	MEASUREMENT_REQUESTED_EVENT = (1 << 0),
+	MEASUREMENT_FINISHED_EVENT = (1 << 1),
+	CALCULATION_FINISHED_EVENT = (1 << 2),
+	THRESHOLD_MONITORING_REQUESTED_EVENT = (1 << 3),
+	CAPTURE_FINISHED_EVENT = (1 << 4),
+	ALL_CONTROLLER_EVENTS = 0x1f
+} controller_event;
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //Global variables																		//
 //////////////////////////////////////////////////////////////////////////////////////////
@@ -36,6 +58,19 @@ typedef enum{
 //Global functions prototypes															//
 //////////////////////////////////////////////////////////////////////////////////////////
 
+/****************************************************************************************\
+Function:
+entry_event_group_creator
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function creates the controller event group. It should be called before any module
+which posts the controller events is initialized.
+\****************************************************************************************/
+void entry_event_group_creator(void);
+
 /****************************************************************************************\
 Function:
 entry_task_creator
@@ -60,6 +95,43 @@ This function return handle to the desired task handle.
 \****************************************************************************************/
 TaskHandle_t get_task_handle(task_handle task_hnd);
 
+/****************************************************************************************\
+Function:
+get_event_group_handle
+******************************************************************************************
+Parameters:
+None.
+******************************************************************************************
+Abstract:
+This function returns handle to the controller event group.
+\****************************************************************************************/
+EventGroupHandle_t get_event_group_handle(void);
+
+/****************************************************************************************\
+Function:
+controller_event_post
+******************************************************************************************
+Parameters:
+controller_event event - event to be posted
+******************************************************************************************
+Abstract:
+This function posts the event to the controller waking it up. It must not be called from
+the interrupt context.
+\****************************************************************************************/
+void controller_event_post(controller_event event);
+
+/****************************************************************************************\
+Function:
+controller_event_post_from_isr
+******************************************************************************************
+Parameters:
+controller_event event - event to be posted
+******************************************************************************************
+Abstract:
+Interrupt safe version of controller_event_post.
+\****************************************************************************************/
+void controller_event_post_from_isr(controller_event event);
+
 //////////////////////////////////////////////////////////////////////////////////////////
 //End of file										//
 //////////////////////////////////////////////////////////////////////////////////////////